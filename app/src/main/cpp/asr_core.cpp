@@ -0,0 +1,664 @@
+#include "asr_core.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iterator>
+
+#include "audio_chunk_store.h"
+#include "compute_pool.h"
+#include "native_log.h"
+#include "native_metrics.h"
+#include "pcm_convert.h"
+
+#define LOG_TAG "WhisperAndroid"
+#define LOGD(...) AMBIENT_LOG_DEBUG(LOG_TAG, __VA_ARGS__)
+
+// Mock decoder output tables; a real decoder would write tokens straight into the arena
+struct WordTiming {
+    const char* word;
+    float start_time;
+    float end_time;
+    float confidence;
+};
+
+static const float CLEAR_SPEECH_LOG_PROBS[] = {-0.1f, -0.15f, -0.12f, -0.18f, -0.2f, -0.15f, -0.25f, -0.22f, -0.28f, -0.3f, -0.25f, -0.32f, -0.35f, -0.4f, -0.3f, -0.38f, -0.42f, -0.45f, -0.4f, -0.48f, -0.5f, -0.45f, -0.52f, -0.55f, -0.5f, -0.58f, -0.6f, -0.55f, -0.62f, -0.65f, -0.6f, -0.68f, -0.7f, -0.65f, -0.72f, -0.75f, -0.7f, -0.78f, -0.8f, -0.75f, -0.82f, -0.85f, -0.8f, -0.88f, -0.9f, -0.85f, -0.92f, -0.95f, -0.9f, -0.98f, -1.0f};
+static const float CONVERSATION_LOG_PROBS[] = {-0.15f, -0.2f, -0.18f, -0.25f, -0.3f, -0.25f, -0.35f, -0.32f, -0.4f, -0.45f, -0.4f, -0.5f, -0.55f, -0.5f, -0.6f, -0.65f, -0.6f, -0.7f, -0.75f, -0.7f, -0.8f, -0.85f, -0.8f, -0.9f, -0.95f, -0.9f, -1.0f, -1.05f, -1.0f, -1.1f, -1.15f, -1.1f, -1.2f, -1.25f, -1.2f, -1.3f, -1.35f, -1.3f, -1.4f, -1.45f, -1.4f, -1.5f, -1.55f, -1.5f, -1.6f, -1.65f, -1.6f, -1.7f, -1.75f, -1.7f, -1.8f, -1.85f, -1.8f, -1.9f, -1.95f, -1.9f, -2.0f};
+static const float QUIET_SPEECH_LOG_PROBS[] = {-0.2f, -0.25f, -0.22f, -0.3f, -0.35f, -0.3f, -0.4f, -0.37f, -0.45f, -0.5f, -0.45f, -0.55f, -0.6f, -0.55f, -0.65f, -0.7f, -0.65f, -0.75f, -0.8f, -0.75f, -0.85f, -0.9f, -0.85f, -0.95f, -1.0f, -0.95f, -1.05f, -1.1f, -1.05f, -1.15f, -1.2f, -1.15f, -1.25f, -1.3f, -1.25f, -1.35f, -1.4f, -1.35f, -1.45f, -1.5f, -1.45f, -1.55f, -1.6f, -1.55f, -1.65f, -1.7f, -1.65f, -1.75f, -1.8f, -1.75f, -1.85f, -1.9f, -1.85f, -1.95f, -2.0f, -1.95f, -2.05f, -2.1f, -2.05f, -2.15f, -2.2f, -2.15f, -2.25f, -2.3f, -2.25f, -2.35f, -2.4f, -2.35f, -2.45f, -2.5f, -2.45f, -2.55f, -2.6f, -2.55f, -2.65f, -2.7f, -2.65f, -2.75f, -2.8f, -2.75f, -2.85f, -2.9f, -2.85f, -2.95f, -3.0f, -2.95f, -3.05f, -3.1f, -3.05f, -3.15f, -3.2f, -3.15f, -3.25f, -3.3f, -3.25f, -3.35f, -3.4f, -3.35f, -3.45f, -3.5f, -3.45f, -3.55f, -3.6f, -3.55f, -3.65f, -3.7f, -3.65f, -3.75f, -3.8f, -3.75f, -3.85f, -3.9f, -3.85f, -3.95f, -4.0f, -3.95f, -4.05f, -4.1f, -4.05f, -4.15f, -4.2f, -4.15f, -4.25f, -4.3f, -4.25f, -4.35f, -4.4f, -4.35f, -4.45f, -4.5f, -4.45f, -4.55f, -4.6f, -4.55f, -4.65f, -4.7f, -4.65f, -4.75f, -4.8f, -4.75f, -4.85f, -4.9f, -4.85f, -4.95f, -5.0f};
+static const float BACKGROUND_LOG_PROBS[] = {-0.3f, -0.35f, -0.32f, -0.4f, -0.45f, -0.4f, -0.5f, -0.47f, -0.55f, -0.6f, -0.55f, -0.65f, -0.7f, -0.65f, -0.75f, -0.8f, -0.75f, -0.85f, -0.9f, -0.85f, -0.95f, -1.0f, -0.95f, -1.05f, -1.1f, -1.05f, -1.15f, -1.2f, -1.15f, -1.25f, -1.3f, -1.25f, -1.35f, -1.4f, -1.35f, -1.45f, -1.5f, -1.45f, -1.55f, -1.6f, -1.55f, -1.65f, -1.7f, -1.65f, -1.75f, -1.8f, -1.75f, -1.85f, -1.9f, -1.85f, -1.95f, -2.0f, -1.95f, -2.05f, -2.1f, -2.05f, -2.15f, -2.2f, -2.15f, -2.25f, -2.3f, -2.25f, -2.35f, -2.4f, -2.35f, -2.45f, -2.5f, -2.45f, -2.55f, -2.6f, -2.55f, -2.65f, -2.7f, -2.65f, -2.75f, -2.8f, -2.75f, -2.85f, -2.9f, -2.85f, -2.95f, -3.0f, -2.95f, -3.05f, -3.1f, -3.05f, -3.15f, -3.2f, -3.15f, -3.25f, -3.3f, -3.25f, -3.35f, -3.4f, -3.35f, -3.45f, -3.5f, -3.45f, -3.55f, -3.6f, -3.55f, -3.65f, -3.7f, -3.65f, -3.75f, -3.8f, -3.75f, -3.85f, -3.9f, -3.85f, -3.95f, -4.0f, -3.95f, -4.05f, -4.1f, -4.05f, -4.15f, -4.2f, -4.15f, -4.25f, -4.3f, -4.25f, -4.35f, -4.4f, -4.35f, -4.45f, -4.5f, -4.45f, -4.55f, -4.6f, -4.55f, -4.65f, -4.7f, -4.65f, -4.75f, -4.8f, -4.75f, -4.85f, -4.9f, -4.85f, -4.95f, -5.0f, -4.95f, -5.05f, -5.1f, -5.05f, -5.15f, -5.2f, -5.15f, -5.25f, -5.3f, -5.25f, -5.35f, -5.4f, -5.35f, -5.45f, -5.5f, -5.45f, -5.55f, -5.6f, -5.55f, -5.65f, -5.7f, -5.65f, -5.75f, -5.8f, -5.75f, -5.85f, -5.9f, -5.85f, -5.95f, -6.0f};
+static const float NO_SPEECH_LOG_PROBS[] = {-2.0f, -2.5f, -3.0f};
+
+static const WordTiming CLEAR_SPEECH_WORDS[] = {
+    {"Hello", 0.0f, 0.5f, 0.9f},
+    {"this", 0.5f, 0.8f, 0.85f},
+    {"is", 0.8f, 1.0f, 0.8f},
+    {"a", 1.0f, 1.1f, 0.75f},
+    {"test", 1.1f, 1.4f, 0.88f},
+    {"of", 1.4f, 1.6f, 0.7f},
+    {"the", 1.6f, 1.8f, 0.75f},
+    {"speech", 1.8f, 2.2f, 0.9f},
+    {"recognition", 2.2f, 2.8f, 0.87f},
+    {"system", 2.8f, 3.2f, 0.85f},
+    {"How", 3.2f, 3.5f, 0.9f},
+    {"are", 3.5f, 3.7f, 0.8f},
+    {"you", 3.7f, 3.9f, 0.85f},
+    {"feeling", 3.9f, 4.3f, 0.88f},
+    {"today", 4.3f, 4.7f, 0.87f}
+};
+
+static const WordTiming CONVERSATION_WORDS[] = {
+    {"The", 0.0f, 0.3f, 0.9f},
+    {"patient", 0.3f, 0.8f, 0.88f},
+    {"is", 0.8f, 1.0f, 0.8f},
+    {"responding", 1.0f, 1.6f, 0.85f},
+    {"well", 1.6f, 1.9f, 0.87f},
+    {"to", 1.9f, 2.1f, 0.75f},
+    {"treatment", 2.1f, 2.7f, 0.9f},
+    {"No", 2.7f, 2.9f, 0.9f},
+    {"complications", 2.9f, 3.6f, 0.88f},
+    {"observed", 3.6f, 4.2f, 0.85f}
+};
+
+static const WordTiming QUIET_SPEECH_WORDS[] = {
+    {"Patient", 0.0f, 0.8f, 0.85f},
+    {"resting", 0.8f, 1.6f, 0.8f},
+    {"comfortably", 1.6f, 2.8f, 0.82f},
+    {"No", 2.8f, 3.0f, 0.9f},
+    {"acute", 3.0f, 3.6f, 0.88f},
+    {"distress", 3.6f, 4.4f, 0.85f},
+    {"Continue", 4.4f, 5.2f, 0.87f},
+    {"monitoring", 5.2f, 6.4f, 0.83f},
+    {"vital", 6.4f, 6.8f, 0.9f},
+    {"signs", 6.8f, 7.2f, 0.88f},
+    {"every", 7.2f, 7.8f, 0.8f},
+    {"four", 7.8f, 8.2f, 0.85f},
+    {"hours", 8.2f, 8.8f, 0.87f}
+};
+
+// Mock decoder output: the best hypothesis for a chunk
+struct MockHypothesis {
+    const char* text;
+    const float* log_probs;
+    size_t prob_count;
+    const WordTiming* words;
+    size_t word_count;
+};
+
+template <size_t P, size_t W>
+static MockHypothesis hypothesis(const char* text, const float (&log_probs)[P], const WordTiming (&words)[W]) {
+    return {text, log_probs, P, words, W};
+}
+
+// Appends one decoded result to the arena. Log probabilities are scaled as
+// they are copied, and aligned words are laid out space-joined so the flat
+// JNI format can hand them over as a single string. A null text makes the
+// text those words.
+static InferenceResult emitResult(ResultArena& arena, const char* text,
+                                  const float* log_probs, size_t prob_count,
+                                  const WordTiming* words, size_t word_count, float prob_scale) {
+    InferenceResult result;
+    if (text) {
+        result.text = arena.appendText(text);
+    }
+    
+    result.log_probs.offset = arena.floats.size();
+    result.log_probs.length = prob_count;
+    for (size_t i = 0; i < prob_count; i++) {
+        arena.floats.push_back(log_probs[i] * prob_scale);
+    }
+    
+    result.words.offset = arena.chars.size();
+    result.alignments.offset = arena.alignments.size();
+    result.alignments.length = word_count;
+    for (size_t i = 0; i < word_count; i++) {
+        if (i > 0) {
+            arena.chars.push_back(' ');
+        }
+        AlignmentInfo align;
+        align.word.offset = arena.chars.size();
+        align.word.length = std::strlen(words[i].word);
+        align.start_time = words[i].start_time;
+        align.end_time = words[i].end_time;
+        align.confidence = words[i].confidence;
+        arena.chars.append(words[i].word, align.word.length);
+        arena.alignments.push_back(align);
+    }
+    result.words.length = arena.chars.size() - result.words.offset;
+    arena.chars.push_back('\0');
+    if (!text) {
+        result.text = result.words;
+    }
+    return result;
+}
+
+// Mock token entropy. The mock only knows the chosen token's probability p,
+// so the rest of the mass is taken as spread evenly over this many rivals.
+static constexpr float MOCK_RIVAL_TOKENS = 16.0f;
+
+static float mockEntropy(float log_prob) {
+    const float p = std::exp(log_prob);
+    const float rest = 1.0f - p;
+    return rest > 0.0f ? -p * log_prob - rest * std::log(rest / MOCK_RIVAL_TOKENS) : 0.0f;
+}
+
+// Beam width of every token under the decoder config, added to stats. The
+// mock tables already hold the best hypothesis, so the width changes the
+// cost of a chunk but not its text.
+static void accountDecode(const float* log_probs, size_t count, const DecoderConfig& config, DecodeStats& stats) {
+    const int widest = std::max(config.beam_size, 1);
+    int beam = 1;
+    int confident = 0;
+    for (size_t i = 0; i < count; i++) {
+        int width = 1;
+        if (config.mode == DecodeMode::BEAM) {
+            width = widest;
+        } else if (config.mode == DecodeMode::ADAPTIVE) {
+            if (log_probs[i] < config.widen_log_prob || mockEntropy(log_probs[i]) > config.widen_entropy) {
+                // Re-decode this token with the wider beam
+                beam = std::min(beam * 2, widest);
+                confident = 0;
+            } else if (beam > 1 && ++confident >= config.narrow_after) {
+                beam = 1;
+                confident = 0;
+            }
+            width = beam;
+        }
+        stats.hypotheses += static_cast<uint64_t>(width);
+        stats.beam_tokens += width > 1;
+    }
+    stats.tokens += count;
+}
+
+// Generate transcription based on audio characteristics
+InferenceResult transcribeFeatures(ResultArena& arena, const AudioFeatures& features, size_t length,
+                                   const DecoderConfig& config, size_t speech_samples, DecodeStats* stats) {
+    StageTimer timer(MetricStage::ENCODE);
+    const float rms = features.rms;
+    const float max_amplitude = features.max_amplitude;
+    const int zero_crossings = features.zero_crossings;
+    const float spectral_centroid = features.spectral_centroid;
+    
+    // Determine if audio contains speech; features cover only the speech part of a flushed window
+    bool has_speech = rms > 0.01f && static_cast<size_t>(zero_crossings) > std::min(length, speech_samples) / 100;
+    
+    // Log audio analysis
+    LOGD("Audio analysis: RMS=%.4f, MaxAmp=%.4f, ZeroCrossings=%d, SpectralCentroid=%.2f, HasSpeech=%s", 
+         rms, max_amplitude, zero_crossings, spectral_centroid, has_speech ? "true" : "false");
+    
+    // Apply confidence based on audio quality
+    float audio_quality = std::min(1.0f, rms * 10.0f);
+    float confidence_factor = audio_quality * (has_speech ? 1.0f : 0.1f);
+    
+    MockHypothesis best;
+    
+    if (has_speech) {
+        // Simulate real speech recognition with pattern-based transcription
+        // This analyzes audio patterns to generate more realistic transcriptions
+        
+        // Calculate speech characteristics
+        float speech_energy = rms * 100.0f; // Scale up for analysis
+        float frequency_content = spectral_centroid;
+        int speech_complexity = zero_crossings / 100; // Normalize zero crossings
+        float speech_duration = static_cast<float>(length) / ASR_SAMPLE_RATE; // Duration in seconds
+        
+        // Generate transcriptions based on audio patterns
+        if (speech_energy > 2.0f && frequency_content > 50.0f && speech_complexity > 20) {
+            // High energy, high frequency, complex - likely clear speech
+            const char* transcription;
+            if (speech_duration > 2.0f) {
+                transcription = "Hello, this is a test of the speech recognition system. How are you feeling today?";
+            } else if (speech_duration > 1.0f) {
+                transcription = "Good morning, patient is doing well. Blood pressure is normal.";
+            } else {
+                transcription = "Yes, I understand. Thank you.";
+            }
+            best = hypothesis(transcription, CLEAR_SPEECH_LOG_PROBS, CLEAR_SPEECH_WORDS);
+        } else if (speech_energy > 1.0f && frequency_content > 30.0f) {
+            // Medium energy - likely normal conversation
+            const char* transcription;
+            if (speech_complexity > 15) {
+                transcription = "The patient is responding well to treatment. No complications observed.";
+            } else if (speech_duration > 1.5f) {
+                transcription = "I need to check the patient's vital signs and update the chart.";
+            } else {
+                transcription = "Vital signs are stable. Continue current medication.";
+            }
+            best = hypothesis(transcription, CONVERSATION_LOG_PROBS, CONVERSATION_WORDS);
+        } else if (speech_energy > 0.5f) {
+            // Low energy - likely quiet speech or background
+            const char* transcription;
+            if (speech_duration > 2.0f) {
+                transcription = "Patient resting comfortably. No acute distress. Continue monitoring vital signs every four hours.";
+            } else if (speech_duration > 1.0f) {
+                transcription = "Everything looks good. No changes needed.";
+            } else {
+                transcription = "Okay, thank you.";
+            }
+            best = hypothesis(transcription, QUIET_SPEECH_LOG_PROBS, QUIET_SPEECH_WORDS);
+        } else {
+            // Very low energy - likely background noise or very quiet speech
+            best = hypothesis("Patient resting comfortably. No acute distress. Continue monitoring vital signs every four hours.",
+                              BACKGROUND_LOG_PROBS, QUIET_SPEECH_WORDS);
+        }
+    } else {
+        // No speech detected
+        best = {"[No speech detected]", NO_SPEECH_LOG_PROBS, std::size(NO_SPEECH_LOG_PROBS), nullptr, 0};
+    }
+    
+    // Early exit: tokens are emitted in time order, spread evenly over the
+    // hypothesis's words, and decoding stops at the first one past the end
+    // of speech. Dropped words take the punctuated text with them, so the
+    // text becomes the words that remain.
+    size_t prob_count = best.prob_count;
+    size_t word_count = best.word_count;
+    const double speech_seconds = static_cast<double>(speech_samples) / ASR_SAMPLE_RATE;
+    if (config.early_exit && speech_samples < length && word_count > 0) {
+        const double span = best.words[word_count - 1].end_time;
+        while (word_count > 0 && best.words[word_count - 1].start_time >= speech_seconds) {
+            word_count--;
+        }
+        prob_count = std::min(prob_count, static_cast<size_t>(std::ceil(speech_seconds / span * prob_count)));
+    }
+    const bool exited = prob_count < best.prob_count;
+    InferenceResult result = emitResult(arena, word_count < best.word_count ? nullptr : best.text,
+                                        best.log_probs, prob_count, best.words, word_count, confidence_factor);
+    if (stats) {
+        stats->chunks++;
+        stats->early_exits += exited;
+        stats->skipped_tokens += best.prob_count - prob_count;
+        accountDecode(arena.floats.data() + result.log_probs.offset, prob_count, config, *stats);
+    }
+    
+    // Log transcription result
+    LOGD("Generated transcription: \"%s\" (confidence_factor=%.3f)", 
+         arena.c_str(result.text), confidence_factor);
+    return result;
+}
+
+ConfidenceSummary summarizeConfidence(const ResultArena& arena, const InferenceResult& result) {
+    ConfidenceSummary summary;
+    const float* log_probs = arena.floats.data() + result.log_probs.offset;
+    const size_t count = result.log_probs.length;
+    if (count > 0) {
+        double sum = 0.0;
+        float min_log_prob = log_probs[0];
+        for (size_t i = 0; i < count; i++) {
+            sum += log_probs[i];
+            min_log_prob = std::min(min_log_prob, log_probs[i]);
+        }
+        summary.mean_log_prob = static_cast<float>(sum / count);
+        summary.min_log_prob = min_log_prob;
+        // Mean token probability through a sigmoid centred on 0.5
+        const float probability = std::exp(summary.mean_log_prob);
+        summary.confidence = 1.0f / (1.0f + std::exp(-probability * 10.0f + 5.0f));
+    }
+
+    const AlignmentInfo* aligns = arena.alignments.data() + result.alignments.offset;
+    if (result.alignments.length > 0) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < result.alignments.length; i++) {
+            sum += aligns[i].confidence;
+        }
+        summary.word_confidence = sum / result.alignments.length;
+    }
+    return summary;
+}
+
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t abs_bits = bits & 0x7FFFFFFFu;
+    if (abs_bits >= 0x7F800000u) {
+        // Inf stays inf, NaN stays a quiet NaN
+        return static_cast<uint16_t>(sign | 0x7C00u | (abs_bits > 0x7F800000u ? 0x200u : 0u));
+    }
+    if (abs_bits >= 0x477FF000u) {
+        // Rounds past the largest half
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (abs_bits < 0x38800000u) {
+        // Subnormal half: shift the full mantissa into place, round to nearest even
+        if (abs_bits < 0x33000000u) {
+            return static_cast<uint16_t>(sign);
+        }
+        const uint32_t shift = 126 - (abs_bits >> 23);
+        const uint32_t mantissa = (abs_bits & 0x7FFFFFu) | 0x800000u;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1u))) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    // Normal: rebias the exponent and round the dropped 13 mantissa bits
+    uint32_t half = ((abs_bits - 0x38000000u) >> 13);
+    const uint32_t rest = abs_bits & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+size_t packedLogProbBytes(LogProbFormat format, size_t count) {
+    switch (format) {
+        case LogProbFormat::FLOAT32: return count * sizeof(float);
+        case LogProbFormat::FLOAT16: return count * sizeof(uint16_t);
+        case LogProbFormat::INT8: return count;
+        case LogProbFormat::NONE: break;
+    }
+    return 0;
+}
+
+float packLogProbs(const float* values, size_t count, LogProbFormat format, uint8_t* out) {
+    switch (format) {
+        case LogProbFormat::FLOAT32:
+            std::memcpy(out, values, count * sizeof(float));
+            return 1.0f;
+        case LogProbFormat::FLOAT16:
+            for (size_t i = 0; i < count; i++) {
+                const uint16_t half = floatToHalf(values[i]);
+                std::memcpy(out + i * sizeof(uint16_t), &half, sizeof(half));
+            }
+            return 1.0f;
+        case LogProbFormat::INT8: {
+            float max_abs = 0.0f;
+            for (size_t i = 0; i < count; i++) {
+                max_abs = std::max(max_abs, std::fabs(values[i]));
+            }
+            const float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+            for (size_t i = 0; i < count; i++) {
+                const float q = std::round(values[i] / scale);
+                out[i] = static_cast<uint8_t>(static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f)));
+            }
+            return scale;
+        }
+        case LogProbFormat::NONE:
+            break;
+    }
+    return 1.0f;
+}
+
+int32_t utf16Length(std::string_view utf8) {
+    int32_t length = 0;
+    for (unsigned char c : utf8) {
+        if ((c & 0xC0) != 0x80) {
+            length += (c >= 0xF0) ? 2 : 1;
+        }
+    }
+    return length;
+}
+
+void fillWordOffsets(const ResultArena& arena, const InferenceResult& result, int32_t* out) {
+    const AlignmentInfo* aligns = arena.alignments.data() + result.alignments.offset;
+    const size_t word_count = result.alignments.length;
+    // Each word's offset counts the separators between words
+    int32_t offset = 0;
+    size_t byte_pos = result.words.offset;
+    for (size_t i = 0; i < word_count; i++) {
+        offset += utf16Length(std::string_view(arena.chars.data() + byte_pos, aligns[i].word.offset - byte_pos));
+        out[i] = offset;
+        offset += utf16Length(arena.view(aligns[i].word));
+        byte_pos = aligns[i].word.offset + aligns[i].word.length;
+    }
+    out[word_count] = offset;
+}
+
+// Two readings of one word overlap by at least this share of the shorter one
+static constexpr float DUPLICATE_OVERLAP_RATIO = 0.5f;
+
+// Equal words starting this close together are one word even without overlap
+static constexpr float SAME_WORD_TOLERANCE_S = 0.15f;
+
+static bool sameWordText(const std::string& a, const std::string& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+template <typename Word>
+static bool isSameWord(const Word& a, const Word& b) {
+    float overlap = std::min(a.end_time, b.end_time) - std::max(a.start_time, b.start_time);
+    float shorter = std::min(a.end_time - a.start_time, b.end_time - b.start_time);
+    if (overlap > 0.0f && overlap >= DUPLICATE_OVERLAP_RATIO * shorter) {
+        return true;
+    }
+    return std::abs(a.start_time - b.start_time) < SAME_WORD_TOLERANCE_S && sameWordText(a.text, b.text);
+}
+
+void TranscriptStitcher::stitch(ResultArena& arena, InferenceResult& result, size_t speech_samples) {
+    const bool flushed = speech_samples < window_samples_;
+    const double window_start = nextWindowStart();
+    const double window_end = window_start + static_cast<double>(std::min(speech_samples, window_samples_)) / ASR_SAMPLE_RATE;
+    const double head_end = window_start + overlap_seconds_;
+    // Nothing follows a flushed window's audio, so none of its words wait
+    const double tail_start = flushed ? window_end : window_end - overlap_seconds_;
+    start_samples_ += flushed ? speech_samples : hop_samples_;
+    if (result.alignments.length == 0 && pending_.empty()) {
+        return;
+    }
+
+    // Rebase to session time; the decoder cannot place a word past its audio
+    current_.clear();
+    const AlignmentInfo* aligns = arena.alignments.data() + result.alignments.offset;
+    for (size_t i = 0; i < result.alignments.length; i++) {
+        const double start = window_start + aligns[i].start_time;
+        if (start >= window_end) {
+            continue;
+        }
+        const double end = std::min(window_start + aligns[i].end_time, window_end);
+        current_.push_back({std::string(arena.view(aligns[i].word)), static_cast<float>(start),
+                            static_cast<float>(end), aligns[i].confidence});
+    }
+
+    // Held-back words and this window's head cover the same audio: merge the
+    // two in time order, keeping the more confident reading of each duplicate
+    final_.clear();
+    next_pending_.clear();
+    size_t head = 0;
+    while (head < current_.size() && current_[head].start_time < head_end) {
+        head++;
+    }
+    size_t p = 0;
+    size_t c = 0;
+    while (p < pending_.size() || c < head) {
+        if (p < pending_.size() && c < head && isSameWord(pending_[p], current_[c])) {
+            final_.push_back(pending_[p].confidence >= current_[c].confidence ? pending_[p] : current_[c]);
+            p++;
+            c++;
+        } else if (c == head || (p < pending_.size() && pending_[p].start_time <= current_[c].start_time)) {
+            final_.push_back(pending_[p++]);
+        } else {
+            final_.push_back(current_[c++]);
+        }
+    }
+    for (; c < current_.size(); c++) {
+        (current_[c].start_time < tail_start ? final_ : next_pending_).push_back(current_[c]);
+    }
+    pending_.swap(next_pending_);
+
+    // The result is the arena's last, so its text and words are rewritten in place
+    arena.chars.resize(result.text.offset);
+    arena.alignments.resize(result.alignments.offset);
+    result.words.offset = arena.chars.size();
+    result.alignments.length = final_.size();
+    for (size_t i = 0; i < final_.size(); i++) {
+        if (i > 0) {
+            arena.chars.push_back(' ');
+        }
+        AlignmentInfo align;
+        align.word.offset = arena.chars.size();
+        align.word.length = final_[i].text.size();
+        align.start_time = final_[i].start_time;
+        align.end_time = final_[i].end_time;
+        align.confidence = final_[i].confidence;
+        arena.chars.append(final_[i].text);
+        arena.alignments.push_back(align);
+    }
+    result.words.length = arena.chars.size() - result.words.offset;
+    arena.chars.push_back('\0');
+    result.text = result.words;
+}
+
+void TranscriptStitcher::reset() {
+    start_samples_ = 0;
+    pending_.clear();
+}
+
+// Converts and analyses every chunk of a batch. Chunks are independent, so
+// they are spread over the shared compute pool at ASR priority.
+std::vector<AudioFeatures> analyzeBatch(const std::vector<const int16_t*>& chunks,
+                                        const std::vector<size_t>& lengths) {
+    std::vector<AudioFeatures> features(chunks.size());
+    ComputePool::shared().parallelFor(chunks.size(), [&](size_t i) {
+        // Pool threads keep their scratch across batches
+        thread_local std::vector<float> scratch;
+        StageTimer timer(MetricStage::FEATURE_EXTRACTION);
+        scratch.resize(std::max(scratch.size(), lengths[i]));
+        pcm16ToFloat(chunks[i], scratch.data(), lengths[i]);
+        features[i] = finalizeFeatures(accumulateFeatures(scratch.data(), lengths[i]));
+    }, TaskPriority::HIGH);
+    return features;
+}
+
+std::vector<AudioFeatures> analyzeBatch(const int16_t* pcm,
+                                        const std::vector<size_t>& offsets,
+                                        const std::vector<size_t>& lengths) {
+    std::vector<const int16_t*> chunks(offsets.size());
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        chunks[i] = pcm + offsets[i];
+    }
+    return analyzeBatch(chunks, lengths);
+}
+
+// Normalise int16 PCM straight into the session ring, no intermediate float buffer
+size_t pushPcm(StreamingSession& session, const int16_t* pcm, size_t count) {
+    StageTimer timer(MetricStage::JNI_MARSHAL);
+    if (!session.resampler) {
+        return session.ring.pushInPlace(count, [pcm](float* dst, size_t offset, size_t n) {
+            pcm16ToFloat(pcm + offset, dst, n);
+        });
+    }
+
+    // Filtered outputs are written into ring storage as they are computed;
+    // input is accepted only as far as its outputs fit
+    PcmResampler& resampler = *session.resampler;
+    const size_t accepted = std::min(count, resampler.inputsFor(session.ring.freeSpace()));
+    resampler.feed(pcm, accepted);
+    session.ring.pushInPlace(resampler.available(), [&resampler](float* dst, size_t, size_t n) {
+        resampler.produce(dst, n);
+    });
+    return accepted;
+}
+
+void endUtterance(StreamingSession& session) {
+    session.utterance_end.store(session.ring.pushedTotal(), std::memory_order_release);
+}
+
+// Each drain stops at the next pending end, so the ring position marked there
+// holds exactly the stored audio before it. Drains only run under the
+// session's lock, so the store's read position cannot move between them.
+size_t drainStoredAudio(StreamingSession& session, AudioChunkStore& store) {
+    std::lock_guard<std::mutex> lock(session.store_mutex);
+    size_t moved = 0;
+    while (true) {
+        const AudioStoreStats stats = store.stats();
+        const uint64_t read = stats.stored_samples - stats.unread_samples;
+        while (!session.stored_utterance_ends.empty() && session.stored_utterance_ends.front() <= read) {
+            session.stored_utterance_ends.pop_front();
+            endUtterance(session);
+        }
+        if (session.stored_utterance_ends.empty()) {
+            return moved + store.drain([&session](const int16_t* pcm, size_t count) {
+                return pushPcm(session, pcm, count);
+            });
+        }
+        uint64_t left = session.stored_utterance_ends.front() - read;
+        const size_t step = store.drain([&session, &left](const int16_t* pcm, size_t count) {
+            const size_t accepted = pushPcm(session, pcm, static_cast<size_t>(std::min<uint64_t>(count, left)));
+            left -= accepted;
+            return accepted;
+        });
+        moved += step;
+        if (left > 0) {
+            // The ring is full before the end; the next drain continues
+            return moved;
+        }
+    }
+}
+
+void endStoredUtterance(StreamingSession& session, AudioChunkStore& store) {
+    {
+        std::lock_guard<std::mutex> lock(session.store_mutex);
+        session.stored_utterance_ends.push_back(store.stats().stored_samples);
+    }
+    drainStoredAudio(session, store);
+}
+
+void resetStoredAudio(StreamingSession& session, AudioChunkStore& store) {
+    std::lock_guard<std::mutex> lock(session.store_mutex);
+    store.reset();
+    session.stored_utterance_ends.clear();
+}
+
+// Cut the next window from the ring. Only the samples that are new since the
+// previous window are analysed; the overlap tail's partial sums carry over.
+bool nextStreamWindow(StreamingSession& session, AudioFeatures& features) {
+    if (session.reset_requested.exchange(false)) {
+        session.ring.discard(session.ring.size());
+        session.tail_samples = 0;
+        session.tail_features = FeatureAccumulator();
+        session.stitcher.reset();
+        session.flushed_to = session.utterance_end.load(std::memory_order_acquire);
+    }
+
+    const size_t window = session.window_samples;
+    const size_t overlap = session.overlap_samples;
+    const size_t hop = window - session.tail_samples;
+    float* buffer = session.window_buffer.data();
+
+    // An utterance that ends before the next window fills is cut there,
+    // zero-padded, and the window after it starts afresh. An end inside a
+    // window already cut needs nothing; one further on waits its turn.
+    const size_t end = session.utterance_end.load(std::memory_order_acquire);
+    if (end != session.flushed_to) {
+        const size_t popped = session.ring.poppedTotal();
+        if (end < popped) {
+            session.flushed_to = end;
+        } else if (end - popped < hop) {
+            session.flushed_to = end;
+            const size_t fresh = end - popped;
+            const size_t speech = session.tail_samples + fresh;
+            if (speech > 0) {
+                StageTimer timer(MetricStage::FEATURE_EXTRACTION);
+                session.ring.pop(buffer + session.tail_samples, fresh);
+                std::fill(buffer + speech, buffer + window, 0.0f);
+                features = finalizeFeatures(mergeFeatures(session.tail_features,
+                                                          accumulateFeatures(buffer + session.tail_samples, fresh)));
+                session.tail_samples = 0;
+                session.tail_features = FeatureAccumulator();
+                session.window_speech_samples = speech;
+                return true;
+            }
+        }
+    }
+
+    if (session.ring.size() < hop) {
+        return false;
+    }
+
+    StageTimer timer(MetricStage::FEATURE_EXTRACTION);
+    session.ring.pop(buffer + session.tail_samples, hop);
+
+    FeatureAccumulator body = accumulateFeatures(buffer + session.tail_samples,
+                                                 window - overlap - session.tail_samples);
+    FeatureAccumulator next_tail = accumulateFeatures(buffer + window - overlap, overlap);
+    features = finalizeFeatures(mergeFeatures(mergeFeatures(session.tail_features, body), next_tail));
+
+    std::copy(buffer + window - overlap, buffer + window, buffer);
+    session.tail_samples = overlap;
+    session.tail_features = next_tail;
+    session.window_speech_samples = window;
+    return true;
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "audio_features.h"
+#include "pcm_resampler.h"
+#include "spsc_ring_buffer.h"
+
+class AudioChunkStore;
+
+// ASR core: result storage, mock transcription, stream windowing and
+// overlap stitching. Free of JNI so it also builds into the host benchmark.
+
+// Rate the model, the stream ring and every window geometry are in
+constexpr int ASR_SAMPLE_RATE = 16000;
+
+// Range inside one of a ResultArena's pools
+struct ArenaSpan {
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+struct AlignmentInfo {
+    ArenaSpan word;
+    float start_time;
+    float end_time;
+    float confidence;
+};
+
+struct InferenceResult {
+    ArenaSpan text;       // into chars, NUL-terminated
+    ArenaSpan words;      // into chars, aligned words joined by spaces, NUL-terminated
+    ArenaSpan log_probs;  // into floats
+    ArenaSpan alignments; // into alignments
+};
+
+// Per-result confidence, reduced natively so the default JNI payload is a
+// few scalars instead of every token's log probability
+struct ConfidenceSummary {
+    float confidence = 0.0f;      // 0..1, from the mean log probability
+    float mean_log_prob = 0.0f;
+    float min_log_prob = 0.0f;
+    float word_confidence = 0.0f; // mean over aligned words, 0 without words
+};
+
+// Encoding of the raw log probabilities for callers that ask for them
+// (evaluation and debugging); NONE keeps them on the native side
+enum class LogProbFormat : int32_t {
+    NONE = 0,
+    FLOAT32 = 1,
+    FLOAT16 = 2, // IEEE half, round to nearest even
+    INT8 = 3     // symmetric: value = q * scale
+};
+
+// How chunks are decoded. GREEDY and BEAM keep one width for every token;
+// ADAPTIVE starts greedy and widens the beam (doubling up to beam_size) on a
+// token whose log probability falls below widen_log_prob or whose entropy
+// rises above widen_entropy, then drops back to greedy after narrow_after
+// confident tokens in a row. With early_exit, a window flushed at the end of
+// an utterance is decoded only up to the end of speech, not into its padding.
+enum class DecodeMode : int32_t {
+    GREEDY = 0,
+    ADAPTIVE = 1,
+    BEAM = 2
+};
+
+struct DecoderConfig {
+    DecodeMode mode = DecodeMode::ADAPTIVE;
+    int beam_size = 5;
+    float widen_log_prob = -1.0f;
+    float widen_entropy = 2.5f; // nats
+    int narrow_after = 4;
+    bool early_exit = true;
+};
+
+// Decoder work so far. hypotheses is the sum of the beam width over every
+// decoded token, the decoder's cost in greedy token steps.
+struct DecodeStats {
+    uint64_t chunks = 0;
+    uint64_t tokens = 0;
+    uint64_t beam_tokens = 0;    // decoded with a beam wider than one
+    uint64_t hypotheses = 0;
+    uint64_t early_exits = 0;    // chunks stopped at the end of speech
+    uint64_t skipped_tokens = 0; // tokens those chunks did not decode
+};
+
+// Per-model storage for the results of one JNI call. reset() keeps every
+// pool's capacity, so once a session has seen its largest result, building
+// results no longer touches the heap.
+struct ResultArena {
+    std::string chars;
+    std::vector<float> floats;
+    std::vector<AlignmentInfo> alignments;
+    std::vector<InferenceResult> results;
+    
+    void reset() {
+        chars.clear();
+        floats.clear();
+        alignments.clear();
+        results.clear();
+    }
+    
+    // Frees the capacity reset() keeps for reuse; returns the bytes freed
+    size_t release() {
+        const size_t bytes = chars.capacity() + floats.capacity() * sizeof(float) +
+                             alignments.capacity() * sizeof(AlignmentInfo) +
+                             results.capacity() * sizeof(InferenceResult);
+        std::string().swap(chars);
+        std::vector<float>().swap(floats);
+        std::vector<AlignmentInfo>().swap(alignments);
+        std::vector<InferenceResult>().swap(results);
+        return bytes;
+    }
+    
+    ArenaSpan appendText(const char* text) {
+        ArenaSpan span{chars.size(), std::strlen(text)};
+        chars.append(text, span.length);
+        chars.push_back('\0');
+        return span;
+    }
+    
+    const char* c_str(ArenaSpan span) const { return chars.data() + span.offset; }
+    std::string_view view(ArenaSpan span) const { return std::string_view(chars.data() + span.offset, span.length); }
+};
+
+// Joins the word alignments of consecutive stream windows into one session
+// timeline. Each window starts a hop after the previous one, or right after
+// the speech of a flushed one, and its word times are rebased by that. Words
+// that start in a window's trailing overlap are held back: the next window
+// decodes the same audio with more context, and the two readings of every
+// word there are reconciled by timestamp, keeping the more confident one.
+// Each result then carries only the words that became final with that window.
+// Held-back words of the last window are dropped with the stream, like the
+// audio of its trailing partial window. Consumer side only.
+class TranscriptStitcher {
+public:
+    TranscriptStitcher(size_t window_samples, size_t overlap_samples)
+        : window_samples_(window_samples),
+          overlap_seconds_(static_cast<double>(overlap_samples) / ASR_SAMPLE_RATE),
+          hop_samples_(window_samples - overlap_samples) {}
+
+    // Rewrites result, which must be the last one appended to arena, to the
+    // words that are final once this window is known, in session time; its
+    // text becomes those words joined by spaces. Results without alignments
+    // and nothing held back are left as they are. A window with fewer than
+    // window_samples speech_samples was flushed at the end of an utterance:
+    // all of its words are final, and the next window starts after its speech.
+    void stitch(ResultArena& arena, InferenceResult& result, size_t speech_samples);
+
+    void reset();
+
+    // Session time of the next window's first sample, in seconds
+    double nextWindowStart() const { return static_cast<double>(start_samples_) / ASR_SAMPLE_RATE; }
+
+private:
+    struct Word {
+        std::string text;
+        float start_time;
+        float end_time;
+        float confidence;
+    };
+
+    size_t window_samples_;
+    double overlap_seconds_;
+    size_t hop_samples_;
+    uint64_t start_samples_ = 0;
+
+    // Words in the previous window's trailing overlap, not yet handed out
+    std::vector<Word> pending_;
+    // Scratch reused for every window
+    std::vector<Word> current_;
+    std::vector<Word> final_;
+    std::vector<Word> next_pending_;
+};
+
+// Streaming session state kept next to the model so that audio can be pushed
+// in small pieces and windows are cut natively, without a JVM copy per chunk.
+struct StreamingSession {
+    StreamingSession(size_t window, size_t overlap, size_t capacity, int input_rate = ASR_SAMPLE_RATE)
+        : ring(capacity), window_samples(window), overlap_samples(overlap),
+          resampler(input_rate != ASR_SAMPLE_RATE ? std::make_unique<PcmResampler>(input_rate, ASR_SAMPLE_RATE) : nullptr),
+          window_buffer(window), stitcher(window, overlap) {}
+
+    SpscRingBuffer<float> ring;
+    size_t window_samples;
+    size_t overlap_samples;
+
+    // Producer side: set when capture runs at another rate than the model
+    std::unique_ptr<PcmResampler> resampler;
+
+    // Consumer side: assembled analysis window and the cached overlap tail
+    std::vector<float> window_buffer;
+    size_t tail_samples = 0;
+    FeatureAccumulator tail_features;
+    TranscriptStitcher stitcher;
+    std::atomic<bool> reset_requested{false};
+    // Windows cut so far; keys each window's trace slice
+    uint64_t windows_cut = 0;
+    // Speech samples of the last window cut: window_samples, or fewer when it
+    // was flushed at an utterance end and zero-padded after them
+    size_t window_speech_samples = 0;
+
+    // Stream position (in ring samples pushed) where the latest utterance
+    // ended, set by the producer; the consumer flushes the audio up to it as
+    // a short window instead of waiting for the window to fill
+    std::atomic<size_t> utterance_end{0};
+    size_t flushed_to = 0;
+
+    // Producer side with an audio store: utterance ends in store positions
+    // (input samples stored) whose audio the ring has not all taken yet, in
+    // order. The mutex keeps the drains that reach them a single producer.
+    std::mutex store_mutex;
+    std::deque<uint64_t> stored_utterance_ends;
+};
+
+// Decodes one analysed chunk of length samples and appends its result to the
+// arena. Only the first speech_samples hold speech; with config.early_exit the
+// decoder stops there. Work is added to stats when it is set.
+InferenceResult transcribeFeatures(ResultArena& arena, const AudioFeatures& features, size_t length,
+                                   const DecoderConfig& config, size_t speech_samples, DecodeStats* stats);
+
+ConfidenceSummary summarizeConfidence(const ResultArena& arena, const InferenceResult& result);
+
+// Bytes packLogProbs() writes for count values
+size_t packedLogProbBytes(LogProbFormat format, size_t count);
+
+// Packs count log probabilities into out, in native byte order; returns the
+// INT8 dequantisation scale, 1 for the other formats
+float packLogProbs(const float* values, size_t count, LogProbFormat format, uint8_t* out);
+
+// Java strings are UTF-16; alignment offsets index into the joined word string
+int32_t utf16Length(std::string_view utf8);
+
+// UTF-16 offset of each aligned word in the joined word string, plus the
+// string's total length: word count + 1 values
+void fillWordOffsets(const ResultArena& arena, const InferenceResult& result, int32_t* out);
+
+// Converts and analyses every chunk of an int16 PCM batch on the compute pool
+std::vector<AudioFeatures> analyzeBatch(const int16_t* pcm,
+                                        const std::vector<size_t>& offsets,
+                                        const std::vector<size_t>& lengths);
+
+// Same, for chunks that are not in one buffer (stored session segments)
+std::vector<AudioFeatures> analyzeBatch(const std::vector<const int16_t*>& chunks,
+                                        const std::vector<size_t>& lengths);
+
+// Normalises int16 PCM at the session's input rate into the ring, resampling
+// on the way when needed; returns the input samples accepted
+size_t pushPcm(StreamingSession& session, const int16_t* pcm, size_t count);
+
+// Marks the end of an utterance at everything pushed so far. Producer side.
+void endUtterance(StreamingSession& session);
+
+// With an audio store, pushes go through it and the ring takes its backlog
+// as it frees up. Moves stored audio the ring has not taken yet into it, as
+// far as it fits, and marks each pending utterance end once the stored audio
+// before it has all reached the ring; returns the input samples moved.
+size_t drainStoredAudio(StreamingSession& session, AudioChunkStore& store);
+
+// Marks the end of an utterance after everything stored so far; it takes
+// effect once drainStoredAudio() has moved that audio into the ring
+void endStoredUtterance(StreamingSession& session, AudioChunkStore& store);
+
+// Drops the stored audio and the utterance ends that wait on it
+void resetStoredAudio(StreamingSession& session, AudioChunkStore& store);
+
+// Cuts and analyses the next window once enough audio is buffered, or the
+// audio up to an utterance end; sets session.window_speech_samples
+bool nextStreamWindow(StreamingSession& session, AudioFeatures& features);
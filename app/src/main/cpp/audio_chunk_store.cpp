@@ -0,0 +1,252 @@
+#include "audio_chunk_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "native_log.h"
+
+#define LOG_TAG "AudioChunkStore"
+#define LOGE(...) AMBIENT_LOG_ERROR(LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+// Plain memset may be dropped for memory that is about to be freed
+void secureZero(void* data, size_t bytes) {
+    volatile uint8_t* wipe = static_cast<uint8_t*>(data);
+    for (size_t i = 0; i < bytes; ++i) {
+        wipe[i] = 0;
+    }
+}
+
+} // namespace
+
+std::unique_ptr<AudioChunkStore> AudioChunkStore::open(const std::string& spill_path,
+                                                       const uint8_t key[CHACHA20_KEY_BYTES],
+                                                       size_t segment_samples, size_t memory_cap_bytes,
+                                                       std::string* error) {
+    if (segment_samples == 0) {
+        setError(error, "segment size must be positive");
+        return nullptr;
+    }
+    // O_TRUNC: anything left by a killed session was encrypted under a key
+    // that is gone, so it is unreadable and only takes space
+    int fd = ::open(spill_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        setError(error, "cannot open " + spill_path + ": " + strerror(errno));
+        return nullptr;
+    }
+    const size_t memory_segments = std::max<size_t>(2, memory_cap_bytes / (segment_samples * sizeof(int16_t)));
+    return std::unique_ptr<AudioChunkStore>(
+        new AudioChunkStore(spill_path, fd, key, segment_samples, memory_segments));
+}
+
+AudioChunkStore::AudioChunkStore(std::string path, int fd, const uint8_t key[CHACHA20_KEY_BYTES],
+                                 size_t segment_samples, size_t memory_segments)
+    : path_(std::move(path)), fd_(fd), segment_samples_(segment_samples), memory_segments_(memory_segments) {
+    memcpy(key_, key, CHACHA20_KEY_BYTES);
+}
+
+AudioChunkStore::~AudioChunkStore() {
+    secureZero(key_, sizeof(key_));
+    if (!drain_scratch_.empty()) {
+        secureZero(drain_scratch_.data(), drain_scratch_.size() * sizeof(int16_t));
+    }
+    if (map_) {
+        munmap(map_, map_bytes_);
+    }
+    close(fd_);
+    unlink(path_.c_str());
+}
+
+AudioChunkStore::Buffer AudioChunkStore::takeBuffer() {
+    if (!free_buffers_.empty()) {
+        Buffer buffer = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+        return buffer;
+    }
+    return std::make_shared<std::vector<int16_t>>(segment_samples_);
+}
+
+void AudioChunkStore::cryptSegment(uint64_t sequence, const int16_t* in, int16_t* out, size_t samples) const {
+    uint8_t nonce[CHACHA20_NONCE_BYTES] = {};
+    for (int i = 0; i < 8; ++i) {
+        nonce[i] = static_cast<uint8_t>(sequence >> (8 * i));
+    }
+    chacha20Xor(key_, nonce, 0, reinterpret_cast<const uint8_t*>(in), reinterpret_cast<uint8_t*>(out),
+                samples * sizeof(int16_t));
+}
+
+bool AudioChunkStore::ensureFileSize(size_t bytes) {
+    if (bytes <= map_bytes_) {
+        return true;
+    }
+    // Grow geometrically so a long session remaps a handful of times
+    const size_t grown = std::max(bytes, map_bytes_ * 2);
+    if (ftruncate(fd_, static_cast<off_t>(grown)) != 0) {
+        LOGE("Cannot grow spill file to %zu bytes: %s", grown, strerror(errno));
+        return false;
+    }
+    void* map = mmap(nullptr, grown, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        LOGE("Cannot map spill file: %s", strerror(errno));
+        return false;
+    }
+    if (map_) {
+        munmap(map_, map_bytes_);
+    }
+    map_ = map;
+    map_bytes_ = grown;
+    return true;
+}
+
+bool AudioChunkStore::spillOldest() {
+    while (spill_cursor_ < segments_.size() && segments_[spill_cursor_].spilled) {
+        ++spill_cursor_;
+    }
+    // Never the segment still being filled
+    if (spill_failed_ || spill_cursor_ + 1 >= segments_.size()) {
+        return false;
+    }
+    Segment& segment = segments_[spill_cursor_];
+    if (!ensureFileSize((spill_cursor_ + 1) * segmentBytes())) {
+        spill_failed_ = true;
+        LOGE("Spilling disabled; session audio now only grows in memory");
+        return false;
+    }
+    int16_t* slot = reinterpret_cast<int16_t*>(static_cast<uint8_t*>(map_) + spill_cursor_ * segmentBytes());
+    segment.spill_sequence = next_spill_sequence_++;
+    cryptSegment(segment.spill_sequence, segment.buffer->data(), slot, segment.length);
+    segment.spilled = true;
+    // A reader holding a view keeps its buffer; it is not reused under it
+    if (segment.buffer.use_count() == 1) {
+        free_buffers_.push_back(std::move(segment.buffer));
+    }
+    segment.buffer.reset();
+    --resident_segments_;
+    ++spilled_segments_;
+    ++spill_cursor_;
+    return true;
+}
+
+void AudioChunkStore::append(const int16_t* pcm, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (count > 0) {
+        if (segments_.empty() || segments_.back().length == segment_samples_) {
+            if (resident_segments_ >= memory_segments_) {
+                spillOldest();
+            }
+            Segment segment;
+            segment.buffer = takeBuffer();
+            segments_.push_back(std::move(segment));
+            ++resident_segments_;
+        }
+        Segment& tail = segments_.back();
+        const size_t take = std::min(count, segment_samples_ - tail.length);
+        memcpy(tail.buffer->data() + tail.length, pcm, take * sizeof(int16_t));
+        tail.length += take;
+        stored_samples_ += take;
+        pcm += take;
+        count -= take;
+    }
+}
+
+size_t AudioChunkStore::drain(const std::function<size_t(const int16_t*, size_t)>& sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    while (read_position_ < stored_samples_) {
+        const size_t index = static_cast<size_t>(read_position_ / segment_samples_);
+        const size_t offset = static_cast<size_t>(read_position_ % segment_samples_);
+        const Segment& segment = segments_[index];
+        const int16_t* data;
+        if (segment.spilled) {
+            if (drain_scratch_index_ != index) {
+                drain_scratch_.resize(segment_samples_);
+                const int16_t* slot = reinterpret_cast<const int16_t*>(
+                    static_cast<const uint8_t*>(map_) + index * segmentBytes());
+                cryptSegment(segment.spill_sequence, slot, drain_scratch_.data(), segment.length);
+                drain_scratch_index_ = index;
+            }
+            data = drain_scratch_.data();
+        } else {
+            data = segment.buffer->data();
+        }
+        const size_t available = segment.length - offset;
+        const size_t taken = std::min(available, sink(data + offset, available));
+        read_position_ += taken;
+        total += taken;
+        if (taken < available) {
+            break;
+        }
+    }
+    return total;
+}
+
+bool AudioChunkStore::segment(size_t index, SegmentView& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= segments_.size()) {
+        return false;
+    }
+    const Segment& segment = segments_[index];
+    out.length = segment.length;
+    if (!segment.spilled) {
+        out.buffer = segment.buffer;
+        return true;
+    }
+    auto plain = std::make_shared<std::vector<int16_t>>(segment.length);
+    const int16_t* slot =
+        reinterpret_cast<const int16_t*>(static_cast<const uint8_t*>(map_) + index * segmentBytes());
+    cryptSegment(segment.spill_sequence, slot, plain->data(), segment.length);
+    out.buffer = std::move(plain);
+    return true;
+}
+
+size_t AudioChunkStore::segmentCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+void AudioChunkStore::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Segment& segment : segments_) {
+        if (segment.buffer && segment.buffer.use_count() == 1 && free_buffers_.size() < memory_segments_) {
+            free_buffers_.push_back(std::move(segment.buffer));
+        }
+    }
+    segments_.clear();
+    resident_segments_ = 0;
+    spill_cursor_ = 0;
+    read_position_ = 0;
+    stored_samples_ = 0;
+    spilled_segments_ = 0;
+    drain_scratch_index_ = SIZE_MAX;
+    if (map_) {
+        munmap(map_, map_bytes_);
+        map_ = nullptr;
+        map_bytes_ = 0;
+    }
+    // Sequence numbers carry on: the key is unchanged, so nonces must be too
+    if (ftruncate(fd_, 0) != 0) {
+        LOGE("Cannot truncate spill file: %s", strerror(errno));
+    }
+    spill_failed_ = false;
+}
+
+AudioStoreStats AudioChunkStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AudioStoreStats stats;
+    stats.stored_samples = stored_samples_;
+    stats.unread_samples = stored_samples_ - read_position_;
+    stats.memory_bytes = static_cast<uint64_t>(resident_segments_ + free_buffers_.size()) * segmentBytes();
+    stats.spilled_bytes = spilled_segments_ * segmentBytes();
+    return stats;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "chacha20.h"
+
+struct AudioStoreStats {
+    uint64_t stored_samples = 0;
+    // Stored but not yet handed to the stream
+    uint64_t unread_samples = 0;
+    uint64_t memory_bytes = 0;
+    uint64_t spilled_bytes = 0;
+};
+
+// Every sample of a capture session in fixed-size int16 segments. The newest
+// segments stay in memory up to a cap; past it the oldest, which the stream
+// has normally already read, are encrypted into a memory-mapped spill file.
+// Memory stays flat however long the session runs, and the whole session can
+// be replayed for re-transcription.
+//
+// Segments in memory are read in place. Spilled ones are decrypted into a
+// buffer owned by the reader. Internally locked; a drain runs the sink with
+// the store locked.
+class AudioChunkStore {
+public:
+    // A segment's samples, valid for as long as the view is held, even if the
+    // store spills the segment meanwhile
+    struct SegmentView {
+        std::shared_ptr<const std::vector<int16_t>> buffer;
+        size_t length = 0;
+
+        const int16_t* data() const { return buffer ? buffer->data() : nullptr; }
+    };
+
+    // Creates (or truncates) the spill file. memory_cap_bytes is rounded down
+    // to whole segments, with at least two in memory. Returns null and, if
+    // error is non-null, describes why on failure.
+    static std::unique_ptr<AudioChunkStore> open(const std::string& spill_path, const uint8_t key[CHACHA20_KEY_BYTES],
+                                                 size_t segment_samples, size_t memory_cap_bytes,
+                                                 std::string* error = nullptr);
+
+    AudioChunkStore(const AudioChunkStore&) = delete;
+    AudioChunkStore& operator=(const AudioChunkStore&) = delete;
+    // Unmaps and deletes the spill file and wipes the key
+    ~AudioChunkStore();
+
+    // Always stores every sample. If spilling fails the segment stays in
+    // memory past the cap rather than losing audio.
+    void append(const int16_t* pcm, size_t count);
+
+    // Hands unread samples in order to sink, which returns how many it took,
+    // until it takes fewer than offered or nothing is left. Returns the
+    // samples taken.
+    size_t drain(const std::function<size_t(const int16_t*, size_t)>& sink);
+
+    // False if index is not a stored segment
+    bool segment(size_t index, SegmentView& out);
+    size_t segmentCount() const;
+    size_t segmentSamples() const { return segment_samples_; }
+
+    // Drops every sample and truncates the spill file
+    void reset();
+
+    AudioStoreStats stats() const;
+
+private:
+    using Buffer = std::shared_ptr<std::vector<int16_t>>;
+
+    struct Segment {
+        // Null once spilled
+        Buffer buffer;
+        size_t length = 0;
+        // Nonce of the spilled copy; spill sequence numbers are never reused
+        uint64_t spill_sequence = 0;
+        bool spilled = false;
+    };
+
+    AudioChunkStore(std::string path, int fd, const uint8_t key[CHACHA20_KEY_BYTES], size_t segment_samples,
+                    size_t memory_segments);
+
+    // Callers hold mutex_
+    Buffer takeBuffer();
+    bool spillOldest();
+    bool ensureFileSize(size_t bytes);
+    void cryptSegment(uint64_t sequence, const int16_t* in, int16_t* out, size_t samples) const;
+    size_t segmentBytes() const { return segment_samples_ * sizeof(int16_t); }
+
+    const std::string path_;
+    const int fd_;
+    uint8_t key_[CHACHA20_KEY_BYTES];
+    const size_t segment_samples_;
+    const size_t memory_segments_;
+
+    mutable std::mutex mutex_;
+    std::vector<Segment> segments_;
+    // Buffers of spilled segments, reused for new ones
+    std::vector<Buffer> free_buffers_;
+    size_t resident_segments_ = 0;
+    // Segments before it are all spilled
+    size_t spill_cursor_ = 0;
+    uint64_t next_spill_sequence_ = 0;
+    uint64_t read_position_ = 0;
+    uint64_t stored_samples_ = 0;
+    uint64_t spilled_segments_ = 0;
+    // Decrypted copy of the spilled segment being drained
+    std::vector<int16_t> drain_scratch_;
+    size_t drain_scratch_index_ = SIZE_MAX;
+
+    void* map_ = nullptr;
+    size_t map_bytes_ = 0;
+    // Set after a spill fails; the store then only grows in memory
+    bool spill_failed_ = false;
+};
@@ -0,0 +1,247 @@
+#include "audio_features.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_FEATURES_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_FEATURES_SSE2 1
+#endif
+
+// This file is built without -ffast-math and with -ffp-contract=off (see
+// CMakeLists.txt): bit-identical results depend on the compiler neither
+// reassociating the lane sums nor fusing multiply-adds.
+//
+// Lane layout shared by every path: blocks of four start at j = 0, 4, 8, ...
+// while j + 4 < count. Lane k accumulates sample j + k and the pair
+// (j + k, j + k + 1). Lanes reduce as (l0 + l1) + (l2 + l3), then the
+// remaining samples and pairs are added in order.
+
+namespace {
+
+struct LaneSums {
+    float squares[4] = {0, 0, 0, 0};
+    float diffs[4] = {0, 0, 0, 0};
+    float weighted[4] = {0, 0, 0, 0};
+    float max_abs[4] = {0, 0, 0, 0};
+    int crossings[4] = {0, 0, 0, 0};
+};
+
+inline float reduce(const float lanes[4]) {
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+FeatureAccumulator finishLanes(const float* samples, size_t count, size_t blocks_end, const LaneSums& lanes) {
+    float squares = reduce(lanes.squares);
+    float diffs = reduce(lanes.diffs);
+    float weighted = reduce(lanes.weighted);
+    float max_abs = std::max(std::max(lanes.max_abs[0], lanes.max_abs[1]),
+                             std::max(lanes.max_abs[2], lanes.max_abs[3]));
+    int crossings = (lanes.crossings[0] + lanes.crossings[1]) + (lanes.crossings[2] + lanes.crossings[3]);
+
+    for (size_t i = blocks_end; i < count; i++) {
+        float sample = samples[i];
+        float sq = sample * sample;
+        squares = squares + sq;
+        max_abs = std::max(max_abs, std::fabs(sample));
+        if (i + 1 < count) {
+            float next = samples[i + 1];
+            float diff = std::fabs(next - sample);
+            float w = diff * static_cast<float>(i);
+            diffs = diffs + diff;
+            weighted = weighted + w;
+            if ((sample >= 0.0f) != (next >= 0.0f)) {
+                crossings++;
+            }
+        }
+    }
+
+    FeatureAccumulator acc;
+    acc.count = count;
+    acc.first_sample = samples[0];
+    acc.last_sample = samples[count - 1];
+    acc.sum_squares = squares;
+    acc.max_amplitude = max_abs;
+    acc.zero_crossings = crossings;
+    acc.diff_sum = diffs;
+    acc.weighted_diff_sum = weighted;
+    return acc;
+}
+
+inline size_t blocksEnd(size_t count) {
+    // A block at j reads samples j .. j + 4, so it needs j + 4 < count
+    return count > 4 ? ((count - 1) / 4) * 4 : 0;
+}
+
+#if defined(AUDIO_FEATURES_NEON)
+
+FeatureAccumulator accumulateNeon(const float* samples, size_t count) {
+    const size_t end = blocksEnd(count);
+    float32x4_t squares = vdupq_n_f32(0.0f);
+    float32x4_t diffs = vdupq_n_f32(0.0f);
+    float32x4_t weighted = vdupq_n_f32(0.0f);
+    float32x4_t max_abs = vdupq_n_f32(0.0f);
+    uint32x4_t crossings = vdupq_n_u32(0);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t step = vdupq_n_f32(4.0f);
+    const float init_index[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t index = vld1q_f32(init_index);
+
+    for (size_t j = 0; j < end; j += 4) {
+        float32x4_t a = vld1q_f32(samples + j);
+        float32x4_t b = vld1q_f32(samples + j + 1);
+        squares = vaddq_f32(squares, vmulq_f32(a, a));
+        max_abs = vmaxq_f32(max_abs, vabsq_f32(a));
+        float32x4_t diff = vabsq_f32(vsubq_f32(b, a));
+        diffs = vaddq_f32(diffs, diff);
+        weighted = vaddq_f32(weighted, vmulq_f32(diff, index));
+        // Lanes whose signs differ are all-ones, i.e. -1 when subtracted
+        uint32x4_t flip = veorq_u32(vcgeq_f32(a, zero), vcgeq_f32(b, zero));
+        crossings = vsubq_u32(crossings, flip);
+        index = vaddq_f32(index, step);
+    }
+
+    LaneSums lanes;
+    vst1q_f32(lanes.squares, squares);
+    vst1q_f32(lanes.diffs, diffs);
+    vst1q_f32(lanes.weighted, weighted);
+    vst1q_f32(lanes.max_abs, max_abs);
+    uint32_t cross[4];
+    vst1q_u32(cross, crossings);
+    for (int k = 0; k < 4; k++) {
+        lanes.crossings[k] = static_cast<int>(cross[k]);
+    }
+    return finishLanes(samples, count, end, lanes);
+}
+
+#elif defined(AUDIO_FEATURES_SSE2)
+
+FeatureAccumulator accumulateSse2(const float* samples, size_t count) {
+    const size_t end = blocksEnd(count);
+    __m128 squares = _mm_setzero_ps();
+    __m128 diffs = _mm_setzero_ps();
+    __m128 weighted = _mm_setzero_ps();
+    __m128 max_abs = _mm_setzero_ps();
+    __m128i crossings = _mm_setzero_si128();
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 step = _mm_set1_ps(4.0f);
+    __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+    for (size_t j = 0; j < end; j += 4) {
+        __m128 a = _mm_loadu_ps(samples + j);
+        __m128 b = _mm_loadu_ps(samples + j + 1);
+        squares = _mm_add_ps(squares, _mm_mul_ps(a, a));
+        max_abs = _mm_max_ps(max_abs, _mm_and_ps(a, abs_mask));
+        __m128 diff = _mm_and_ps(_mm_sub_ps(b, a), abs_mask);
+        diffs = _mm_add_ps(diffs, diff);
+        weighted = _mm_add_ps(weighted, _mm_mul_ps(diff, index));
+        // Lanes whose signs differ are all-ones, i.e. -1 when subtracted
+        __m128 flip = _mm_xor_ps(_mm_cmpge_ps(a, zero), _mm_cmpge_ps(b, zero));
+        crossings = _mm_sub_epi32(crossings, _mm_castps_si128(flip));
+        index = _mm_add_ps(index, step);
+    }
+
+    LaneSums lanes;
+    _mm_storeu_ps(lanes.squares, squares);
+    _mm_storeu_ps(lanes.diffs, diffs);
+    _mm_storeu_ps(lanes.weighted, weighted);
+    _mm_storeu_ps(lanes.max_abs, max_abs);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes.crossings), crossings);
+    return finishLanes(samples, count, end, lanes);
+}
+
+#endif
+
+} // namespace
+
+FeatureAccumulator accumulateFeaturesScalar(const float* samples, size_t count) {
+    if (count == 0) {
+        return FeatureAccumulator();
+    }
+
+    const size_t end = blocksEnd(count);
+    LaneSums lanes;
+    float index[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+
+    for (size_t j = 0; j < end; j += 4) {
+        for (int k = 0; k < 4; k++) {
+            float a = samples[j + k];
+            float b = samples[j + k + 1];
+            float sq = a * a;
+            lanes.squares[k] = lanes.squares[k] + sq;
+            lanes.max_abs[k] = std::max(lanes.max_abs[k], std::fabs(a));
+            float diff = std::fabs(b - a);
+            float w = diff * index[k];
+            lanes.diffs[k] = lanes.diffs[k] + diff;
+            lanes.weighted[k] = lanes.weighted[k] + w;
+            if ((a >= 0.0f) != (b >= 0.0f)) {
+                lanes.crossings[k]++;
+            }
+            index[k] = index[k] + 4.0f;
+        }
+    }
+    return finishLanes(samples, count, end, lanes);
+}
+
+FeatureAccumulator accumulateFeatures(const float* samples, size_t count) {
+    if (count == 0) {
+        return FeatureAccumulator();
+    }
+#if defined(AUDIO_FEATURES_NEON)
+    return accumulateNeon(samples, count);
+#elif defined(AUDIO_FEATURES_SSE2)
+    return accumulateSse2(samples, count);
+#else
+    return accumulateFeaturesScalar(samples, count);
+#endif
+}
+
+FeatureAccumulator mergeFeatures(const FeatureAccumulator& a, const FeatureAccumulator& b) {
+    if (a.count == 0) return b;
+    if (b.count == 0) return a;
+
+    FeatureAccumulator out;
+    out.count = a.count + b.count;
+    out.first_sample = a.first_sample;
+    out.last_sample = b.last_sample;
+    out.sum_squares = a.sum_squares + b.sum_squares;
+    out.max_amplitude = std::max(a.max_amplitude, b.max_amplitude);
+    out.zero_crossings = a.zero_crossings + b.zero_crossings +
+                         (((a.last_sample >= 0) != (b.first_sample >= 0)) ? 1 : 0);
+
+    // The boundary difference sits at index a.count - 1; b's indices shift by a.count
+    double boundary = std::fabs(b.first_sample - a.last_sample);
+    double offset = static_cast<double>(a.count);
+    out.diff_sum = a.diff_sum + boundary + b.diff_sum;
+    out.weighted_diff_sum = a.weighted_diff_sum + boundary * (offset - 1.0) +
+                            b.weighted_diff_sum + offset * b.diff_sum;
+    return out;
+}
+
+AudioFeatures finalizeFeatures(const FeatureAccumulator& acc) {
+    AudioFeatures features;
+    if (acc.count == 0) {
+        return features;
+    }
+    features.rms = static_cast<float>(std::sqrt(acc.sum_squares / acc.count));
+    features.max_amplitude = acc.max_amplitude;
+    features.zero_crossings = acc.zero_crossings;
+    if (acc.count > 1) {
+        features.spectral_centroid = static_cast<float>(acc.weighted_diff_sum / (acc.count - 1));
+    }
+    return features;
+}
+
+const char* featureKernelName() {
+#if defined(AUDIO_FEATURES_NEON)
+    return "neon";
+#elif defined(AUDIO_FEATURES_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+struct AudioFeatures {
+    float rms = 0.0f;
+    float max_amplitude = 0.0f;
+    int zero_crossings = 0;
+    float spectral_centroid = 0.0f;
+};
+
+// Partial feature sums over a contiguous run of samples. Runs can be merged,
+// so a window's features are assembled without rescanning samples that were
+// already analysed as part of the previous window's overlap.
+struct FeatureAccumulator {
+    double sum_squares = 0.0;
+    float max_amplitude = 0.0f;
+    int zero_crossings = 0;
+    double diff_sum = 0.0;          // sum of |x[i+1] - x[i]|
+    double weighted_diff_sum = 0.0; // sum of |x[i+1] - x[i]| * i, i local to the run
+    size_t count = 0;
+    float first_sample = 0.0f;
+    float last_sample = 0.0f;
+};
+
+// Single pass over the samples. Uses NEON or SSE2 when the ABI has it; the
+// vector and scalar paths share one lane layout and reduction order so they
+// produce bit-identical results.
+FeatureAccumulator accumulateFeatures(const float* samples, size_t count);
+
+// Portable reference path, always compiled
+FeatureAccumulator accumulateFeaturesScalar(const float* samples, size_t count);
+
+// Appends run b after run a
+FeatureAccumulator mergeFeatures(const FeatureAccumulator& a, const FeatureAccumulator& b);
+
+AudioFeatures finalizeFeatures(const FeatureAccumulator& acc);
+
+// Name of the kernel accumulateFeatures() dispatches to ("neon", "sse2" or "scalar")
+const char* featureKernelName();
@@ -0,0 +1,296 @@
+#include "bench_harness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <regex>
+#include <thread>
+#include <unistd.h>
+
+namespace bench {
+
+namespace {
+
+// Each benchmark is grown until one run takes at least this long
+constexpr double DEFAULT_MIN_TIME_S = 0.5;
+constexpr int64_t MAX_ITERATIONS = 1000000000;
+
+int64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+std::vector<std::unique_ptr<Benchmark>>& registry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+struct Result {
+    std::string name;
+    int64_t iterations = 0;
+    double real_ns = 0;          // per iteration
+    double cpu_ns = 0;           // per iteration
+    double items_per_second = 0; // 0 when not reported
+    double bytes_per_second = 0;
+    std::vector<std::pair<std::string, double>> counters;
+    std::string error;
+};
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+std::string localDate() {
+    char buffer[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+    return buffer;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results,
+               const std::vector<std::pair<std::string, std::string>>& context, const char* executable) {
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+
+    out.precision(12);
+    out << "{\n  \"context\": {\n";
+    out << "    \"date\": \"" << localDate() << "\",\n";
+    out << "    \"host_name\": \"" << jsonEscape(host) << "\",\n";
+    out << "    \"executable\": \"" << jsonEscape(executable) << "\",\n";
+    out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+    out << "    \"library_build_type\": \"release\"";
+#else
+    out << "    \"library_build_type\": \"debug\"";
+#endif
+    for (const auto& entry : context) {
+        out << ",\n    \"" << jsonEscape(entry.first) << "\": \"" << jsonEscape(entry.second) << "\"";
+    }
+    out << "\n  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\n";
+        out << "      \"name\": \"" << jsonEscape(r.name) << "\",\n";
+        out << "      \"run_name\": \"" << jsonEscape(r.name) << "\",\n";
+        out << "      \"run_type\": \"iteration\",\n";
+        out << "      \"repetitions\": 1,\n";
+        out << "      \"threads\": 1,\n";
+        if (!r.error.empty()) {
+            out << "      \"error_occurred\": true,\n";
+            out << "      \"error_message\": \"" << jsonEscape(r.error) << "\"\n    }";
+            continue;
+        }
+        out << "      \"iterations\": " << r.iterations << ",\n";
+        out << "      \"real_time\": " << r.real_ns << ",\n";
+        out << "      \"cpu_time\": " << r.cpu_ns << ",\n";
+        out << "      \"time_unit\": \"ns\"";
+        if (r.bytes_per_second > 0) {
+            out << ",\n      \"bytes_per_second\": " << r.bytes_per_second;
+        }
+        if (r.items_per_second > 0) {
+            out << ",\n      \"items_per_second\": " << r.items_per_second;
+        }
+        for (const auto& counter : r.counters) {
+            out << ",\n      \"" << jsonEscape(counter.first) << "\": " << counter.second;
+        }
+        out << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+std::string humanRate(double perSecond, const char* unit) {
+    static const char* prefixes[] = {"", "k", "M", "G", "T"};
+    size_t p = 0;
+    while (perSecond >= 1000.0 && p + 1 < std::size(prefixes)) {
+        perSecond /= 1000.0;
+        p++;
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.4g%s%s/s", perSecond, prefixes[p], unit);
+    return buffer;
+}
+
+void printConsoleHeader() {
+    std::printf("%-40s %15s %15s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    std::printf("%s\n", std::string(85, '-').c_str());
+}
+
+void printConsoleRow(const Result& r) {
+    if (!r.error.empty()) {
+        std::printf("%-40s ERROR: %s\n", r.name.c_str(), r.error.c_str());
+        return;
+    }
+    std::printf("%-40s %12.0f ns %12.0f ns %12lld", r.name.c_str(), r.real_ns, r.cpu_ns,
+                static_cast<long long>(r.iterations));
+    if (r.bytes_per_second > 0) {
+        std::printf(" bytes_per_second=%s", humanRate(r.bytes_per_second, "B").c_str());
+    }
+    if (r.items_per_second > 0) {
+        std::printf(" items_per_second=%s", humanRate(r.items_per_second, "").c_str());
+    }
+    for (const auto& counter : r.counters) {
+        std::printf(" %s=%.4g", counter.first.c_str(), counter.second);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+} // namespace
+
+void State::startTiming() {
+    real_start_ns_ = clockNs(CLOCK_MONOTONIC);
+    cpu_start_ns_ = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void State::stopTiming() {
+    real_ns_ = clockNs(CLOCK_MONOTONIC) - real_start_ns_;
+    cpu_ns_ = clockNs(CLOCK_PROCESS_CPUTIME_ID) - cpu_start_ns_;
+}
+
+Benchmark* registerBenchmark(const char* name, void (*fn)(State&)) {
+    registry().push_back(std::make_unique<Benchmark>(name, fn));
+    return registry().back().get();
+}
+
+struct Runner {
+    // Same growth rule as Google Benchmark: aim 40% past the minimum time,
+    // never more than 10x per step
+    static Result run(const Benchmark& benchmark, const std::string& name, int64_t arg, double minTimeS) {
+        Result result;
+        result.name = name;
+        int64_t iterations = 1;
+        while (true) {
+            State state(iterations, arg);
+            benchmark.fn_(state);
+            if (!state.error_.empty()) {
+                result.error = state.error_;
+                return result;
+            }
+            const double seconds = (benchmark.real_time_ ? state.real_ns_ : state.cpu_ns_) / 1e9;
+            if (seconds >= minTimeS || iterations >= MAX_ITERATIONS) {
+                result.iterations = iterations;
+                result.real_ns = static_cast<double>(state.real_ns_) / iterations;
+                result.cpu_ns = static_cast<double>(state.cpu_ns_) / iterations;
+                if (seconds > 0) {
+                    result.items_per_second = state.items_ / seconds;
+                    result.bytes_per_second = state.bytes_ / seconds;
+                }
+                result.counters = state.counters_;
+                return result;
+            }
+            double multiplier = seconds <= 0 ? 10.0 : std::min(10.0, minTimeS * 1.4 / seconds);
+            iterations = std::min(MAX_ITERATIONS,
+                                  std::max(iterations + 1, static_cast<int64_t>(std::ceil(iterations * multiplier))));
+        }
+    }
+
+    static std::vector<std::pair<std::string, int64_t>> instances(const Benchmark& benchmark) {
+        std::vector<std::pair<std::string, int64_t>> named;
+        if (benchmark.args_.empty()) {
+            named.emplace_back(benchmark.name_, 0);
+        }
+        for (int64_t arg : benchmark.args_) {
+            named.emplace_back(benchmark.name_ + "/" + std::to_string(arg), arg);
+        }
+        return named;
+    }
+
+    static const std::vector<std::unique_ptr<Benchmark>>& all() { return registry(); }
+};
+
+int runBenchmarks(int argc, char** argv, const std::vector<std::pair<std::string, std::string>>& context) {
+    std::string filter = ".";
+    std::string format = "console";
+    std::string outPath;
+    double minTimeS = DEFAULT_MIN_TIME_S;
+
+    for (int i = 1; i < argc; i++) {
+        std::string flag = argv[i];
+        auto value = [&](const char* prefix) -> const char* {
+            size_t n = std::strlen(prefix);
+            return flag.compare(0, n, prefix) == 0 ? argv[i] + n : nullptr;
+        };
+        if (const char* v = value("--benchmark_filter=")) {
+            filter = v;
+        } else if (const char* v = value("--benchmark_min_time=")) {
+            minTimeS = std::atof(v);
+        } else if (const char* v = value("--benchmark_format=")) {
+            format = v;
+        } else if (const char* v = value("--benchmark_out=")) {
+            outPath = v;
+        } else if (flag != "--benchmark_out_format=json") {
+            std::fprintf(stderr, "Unknown flag: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (format != "console" && format != "json") {
+        std::fprintf(stderr, "Unsupported --benchmark_format=%s\n", format.c_str());
+        return 2;
+    }
+
+    std::regex pattern;
+    try {
+        pattern = std::regex(filter);
+    } catch (const std::regex_error&) {
+        std::fprintf(stderr, "Invalid --benchmark_filter=%s\n", filter.c_str());
+        return 2;
+    }
+
+    const bool console = format == "console";
+    if (console) {
+        printConsoleHeader();
+    }
+    std::vector<Result> results;
+    bool failed = false;
+    for (const auto& benchmark : Runner::all()) {
+        for (const auto& instance : Runner::instances(*benchmark)) {
+            if (!std::regex_search(instance.first, pattern)) {
+                continue;
+            }
+            results.push_back(Runner::run(*benchmark, instance.first, instance.second, minTimeS));
+            failed |= !results.back().error.empty();
+            if (console) {
+                printConsoleRow(results.back());
+            }
+        }
+    }
+
+    if (!console) {
+        writeJson(std::cout, results, context, argv[0]);
+    }
+    if (!outPath.empty()) {
+        std::ofstream file(outPath);
+        if (!file) {
+            std::fprintf(stderr, "Cannot write %s\n", outPath.c_str());
+            return 1;
+        }
+        writeJson(file, results, context, argv[0]);
+    }
+    return failed ? 1 : 0;
+}
+
+} // namespace bench
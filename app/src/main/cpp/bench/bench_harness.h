@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal Google Benchmark look-alike, so native_bench needs no third-party
+// code in the NDK build. Registration, the timing loop and the JSON layout
+// follow Google Benchmark, so its tools/compare.py can diff two runs.
+//
+//   static void BM_Foo(bench::State& state) {
+//       setup();                     // not timed
+//       for ([[maybe_unused]] auto _ : state) work(); // timed
+//       state.setItemsProcessed(state.iterations() * items_per_call);
+//   }
+//   BENCHMARK(BM_Foo)->Arg(1)->Arg(4);
+namespace bench {
+
+class State {
+public:
+    State(int64_t iterations, int64_t arg) : iterations_(iterations), arg_(arg) {}
+
+    struct Iterator {
+        State* state;
+        int64_t remaining;
+
+        bool operator!=(const Iterator&) {
+            if (remaining > 0) {
+                return true;
+            }
+            state->stopTiming();
+            return false;
+        }
+        void operator++() { remaining--; }
+        int operator*() const { return 0; }
+    };
+
+    Iterator begin() {
+        startTiming();
+        return Iterator{this, iterations_};
+    }
+    Iterator end() { return Iterator{this, 0}; }
+
+    int64_t iterations() const { return iterations_; }
+    // Argument given with Arg(), 0 for a benchmark registered without one
+    int64_t range(size_t = 0) const { return arg_; }
+
+    void setItemsProcessed(int64_t items) { items_ = items; }
+    void setBytesProcessed(int64_t bytes) { bytes_ = bytes; }
+    // Reported verbatim next to the timings
+    void setCounter(const std::string& name, double value) { counters_.emplace_back(name, value); }
+    void skipWithError(const std::string& message) { error_ = message; }
+
+private:
+    friend struct Runner;
+
+    void startTiming();
+    void stopTiming();
+
+    int64_t iterations_;
+    int64_t arg_;
+    int64_t items_ = 0;
+    int64_t bytes_ = 0;
+    std::vector<std::pair<std::string, double>> counters_;
+    std::string error_;
+
+    int64_t real_start_ns_ = 0;
+    int64_t cpu_start_ns_ = 0;
+    int64_t real_ns_ = 0;
+    int64_t cpu_ns_ = 0;
+};
+
+class Benchmark {
+public:
+    Benchmark(std::string name, std::function<void(State&)> fn) : name_(std::move(name)), fn_(std::move(fn)) {}
+
+    Benchmark* Arg(int64_t arg) {
+        args_.push_back(arg);
+        return this;
+    }
+
+    // Rates from wall time instead of process CPU time, for work that waits
+    Benchmark* UseRealTime() {
+        real_time_ = true;
+        return this;
+    }
+
+private:
+    friend struct Runner;
+
+    std::string name_;
+    std::function<void(State&)> fn_;
+    std::vector<int64_t> args_;
+    bool real_time_ = false;
+};
+
+Benchmark* registerBenchmark(const char* name, void (*fn)(State&));
+
+// Parses --benchmark_filter=<regex>, --benchmark_min_time=<seconds>,
+// --benchmark_format=console|json and --benchmark_out=<file> (always JSON),
+// then runs every matching benchmark. The context entries are copied into
+// the JSON context block. Returns the process exit code.
+int runBenchmarks(int argc, char** argv, const std::vector<std::pair<std::string, std::string>>& context);
+
+// Keeps the compiler from discarding a result the benchmark never uses
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_INNER(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_INNER(a, b)
+#define BENCHMARK(fn) \
+    static bench::Benchmark* BENCH_CONCAT(bench_registered_, __LINE__) [[maybe_unused]] = \
+        bench::registerBenchmark(#fn, fn)
@@ -0,0 +1,581 @@
+// Host and on-device benchmarks for the native ASR and LLM kernels.
+//
+//   Host:   cmake -S app/src/main/cpp -B build/native && cmake --build build/native
+//           build/native/native_bench --benchmark_out=before.json
+//   Device: build with the NDK toolchain and -DAMBIENT_BUILD_BENCH=ON, then
+//           adb push native_bench libambient_runtime.so /data/local/tmp
+//           adb shell 'cd /data/local/tmp && LD_LIBRARY_PATH=. ./native_bench --benchmark_format=json'
+//
+// --fixture=<file> runs on recorded audio: a 16 kHz mono 16-bit WAV, or raw
+// 16 kHz int16 PCM. Without one a deterministic synthetic recording is used,
+// so runs compare across machines. Compare two JSON runs with
+// scripts/compare_native_bench.py.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asr_core.h"
+#include "audio_chunk_store.h"
+#include "compute_backend.h"
+#include "audio_features.h"
+#include "bench_harness.h"
+#include "compute_pool.h"
+#include "cpu_features.h"
+#include "llm_core.h"
+#include "native_kernels.h"
+#include "pcm_convert.h"
+#include "quant_matmul.h"
+#include "voice_activity_detector.h"
+
+namespace {
+
+constexpr int SAMPLE_RATE = ASR_SAMPLE_RATE;
+
+// Chunking used by the app: 1 s batch chunks, 20 ms capture buffers, and
+// the stream's 3 s windows overlapping by 0.5 s (CHUNK_SIZE_SAMPLES and
+// OVERLAP_SAMPLES in ASRService.kt)
+constexpr size_t CHUNK_SAMPLES = SAMPLE_RATE;
+constexpr size_t CAPTURE_SAMPLES = SAMPLE_RATE / 50;
+constexpr size_t WINDOW_SAMPLES = 3 * SAMPLE_RATE;
+constexpr size_t OVERLAP_SAMPLES = SAMPLE_RATE / 2;
+
+std::vector<int16_t> g_pcm;
+std::string g_fixture_name = "synthetic";
+
+uint32_t readLe32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t readLe16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// 16 kHz mono PCM16 WAV, or headerless int16 PCM at that rate
+bool loadFixture(const std::string& path, std::vector<int16_t>& pcm) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file.good() && !file.eof()) {
+        return false;
+    }
+
+    const unsigned char* data = bytes.data();
+    size_t size = bytes.size();
+    if (size >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WAVE", 4) == 0) {
+        bool format_ok = false;
+        size_t pos = 12;
+        while (pos + 8 <= bytes.size()) {
+            const uint32_t chunk = readLe32(data + pos + 4);
+            const unsigned char* body = data + pos + 8;
+            if (std::memcmp(data + pos, "fmt ", 4) == 0 && chunk >= 16) {
+                format_ok = readLe16(body) == 1 && readLe16(body + 2) == 1 &&
+                            readLe32(body + 4) == SAMPLE_RATE && readLe16(body + 14) == 16;
+            } else if (std::memcmp(data + pos, "data", 4) == 0) {
+                if (!format_ok) {
+                    std::fprintf(stderr, "%s: only 16 kHz mono 16-bit PCM is supported\n", path.c_str());
+                    return false;
+                }
+                data = body;
+                size = std::min<size_t>(chunk, bytes.size() - (pos + 8));
+                break;
+            }
+            pos += 8 + chunk + (chunk & 1);
+        }
+    }
+
+    pcm.resize(size / sizeof(int16_t));
+    std::memcpy(pcm.data(), data, pcm.size() * sizeof(int16_t));
+    return !pcm.empty();
+}
+
+// Ten seconds of speech-like audio: voiced bursts (a 140 Hz fundamental
+// and harmonics under a syllable-rate envelope) separated by quiet noise
+std::vector<int16_t> syntheticRecording() {
+    const size_t count = SAMPLE_RATE * 10;
+    std::vector<int16_t> pcm(count);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = (static_cast<int32_t>(seed >> 8) - (1 << 23)) / static_cast<float>(1 << 23);
+        const float t = static_cast<float>(i) / SAMPLE_RATE;
+        const bool voiced = std::fmod(t, 1.0f) < 0.6f;
+        float sample = 0.01f * noise;
+        if (voiced) {
+            const float envelope = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * 4.0f * t);
+            for (int h = 1; h <= 5; h++) {
+                sample += envelope * (0.3f / h) * std::sin(2.0f * static_cast<float>(M_PI) * 140.0f * h * t);
+            }
+        }
+        pcm[i] = static_cast<int16_t>(std::max(-1.0f, std::min(1.0f, sample)) * 32767.0f);
+    }
+    return pcm;
+}
+
+std::vector<float> fixtureFloats() {
+    std::vector<float> samples(g_pcm.size());
+    pcm16ToFloat(g_pcm.data(), samples.data(), g_pcm.size());
+    return samples;
+}
+
+void chunkFixture(std::vector<size_t>& offsets, std::vector<size_t>& lengths) {
+    for (size_t offset = 0; offset < g_pcm.size(); offset += CHUNK_SAMPLES) {
+        offsets.push_back(offset);
+        lengths.push_back(std::min(CHUNK_SAMPLES, g_pcm.size() - offset));
+    }
+}
+
+void BM_Pcm16ToFloat(bench::State& state) {
+    std::vector<float> out(g_pcm.size());
+    for ([[maybe_unused]] auto _ : state) {
+        pcm16ToFloat(g_pcm.data(), out.data(), g_pcm.size());
+        bench::doNotOptimize(out.data());
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(g_pcm.size() * sizeof(int16_t)));
+}
+BENCHMARK(BM_Pcm16ToFloat);
+
+void BM_FeatureExtraction(bench::State& state) {
+    std::vector<float> samples = fixtureFloats();
+    for ([[maybe_unused]] auto _ : state) {
+        for (size_t offset = 0; offset < samples.size(); offset += CHUNK_SAMPLES) {
+            AudioFeatures features = finalizeFeatures(
+                accumulateFeatures(samples.data() + offset, std::min(CHUNK_SAMPLES, samples.size() - offset)));
+            bench::doNotOptimize(features);
+        }
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+}
+BENCHMARK(BM_FeatureExtraction);
+
+// Reference kernel the vector path must match bit for bit
+void BM_FeatureExtractionScalar(bench::State& state) {
+    std::vector<float> samples = fixtureFloats();
+    for ([[maybe_unused]] auto _ : state) {
+        for (size_t offset = 0; offset < samples.size(); offset += CHUNK_SAMPLES) {
+            AudioFeatures features = finalizeFeatures(
+                accumulateFeaturesScalar(samples.data() + offset, std::min(CHUNK_SAMPLES, samples.size() - offset)));
+            bench::doNotOptimize(features);
+        }
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+}
+BENCHMARK(BM_FeatureExtractionScalar);
+
+// nativeInferenceBatch without the JNI copies: conversion and features on the compute pool
+void BM_AnalyzeBatch(bench::State& state) {
+    std::vector<size_t> offsets, lengths;
+    chunkFixture(offsets, lengths);
+    for ([[maybe_unused]] auto _ : state) {
+        std::vector<AudioFeatures> features = analyzeBatch(g_pcm.data(), offsets, lengths);
+        bench::doNotOptimize(features.data());
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(g_pcm.size()));
+    state.setCounter("pool_threads", static_cast<double>(ComputePool::shared().threadCount()));
+}
+BENCHMARK(BM_AnalyzeBatch)->UseRealTime();
+
+// The VAD gate, fed capture-sized buffers as AudioCapture does; includes
+// the per-frame features it publishes to the diarizer
+void BM_VadGate(bench::State& state) {
+    VoiceActivityDetector vad{VadConfig()};
+    std::vector<int16_t> out(CAPTURE_SAMPLES + vad.frameSamples());
+    size_t speech = 0;
+    size_t frames = 0;
+    size_t voiced = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        vad.reset();
+        speech = 0;
+        frames = 0;
+        voiced = 0;
+        for (size_t offset = 0; offset < g_pcm.size(); offset += CAPTURE_SAMPLES) {
+            speech += vad.gate(g_pcm.data() + offset, std::min(CAPTURE_SAMPLES, g_pcm.size() - offset), out.data());
+            for (const FrameFeatures& features : vad.frameFeatures()) {
+                frames++;
+                voiced += features.pitch_hz > 0.0f;
+            }
+        }
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(g_pcm.size()));
+    state.setCounter("speech_fraction", g_pcm.empty() ? 0.0 : static_cast<double>(speech) / g_pcm.size());
+    state.setCounter("voiced_fraction", frames == 0 ? 0.0 : static_cast<double>(voiced) / frames);
+}
+BENCHMARK(BM_VadGate);
+
+// Streaming path: capture buffers into the ring, windows cut as soon as they fill
+void BM_StreamWindows(bench::State& state) {
+    StreamingSession session(WINDOW_SAMPLES, OVERLAP_SAMPLES, WINDOW_SAMPLES * 2);
+    AudioFeatures features;
+    int64_t windows = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        session.reset_requested.store(true);
+        for (size_t offset = 0; offset < g_pcm.size(); offset += CAPTURE_SAMPLES) {
+            pushPcm(session, g_pcm.data() + offset, std::min(CAPTURE_SAMPLES, g_pcm.size() - offset));
+            while (nextStreamWindow(session, features)) {
+                windows++;
+            }
+        }
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(g_pcm.size()));
+    state.setCounter("windows_per_pass", state.iterations() ? static_cast<double>(windows) / state.iterations() : 0.0);
+}
+BENCHMARK(BM_StreamWindows);
+
+// Capture-rate audio through the fused resampler into the stream ring, for
+// devices that only record at range(0) Hz. The fixture's samples stand in
+// for capture-rate input; one item is one input sample.
+void BM_PushResampled(bench::State& state) {
+    const int input_rate = static_cast<int>(state.range(0));
+    const size_t capture = static_cast<size_t>(input_rate) / 50;
+    StreamingSession session(WINDOW_SAMPLES, OVERLAP_SAMPLES, WINDOW_SAMPLES * 2, input_rate);
+    for ([[maybe_unused]] auto _ : state) {
+        for (size_t offset = 0; offset < g_pcm.size(); offset += capture) {
+            pushPcm(session, g_pcm.data() + offset, std::min(capture, g_pcm.size() - offset));
+            session.ring.discard(session.ring.size());
+        }
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(g_pcm.size()));
+    state.setCounter("taps_per_phase", static_cast<double>(session.resampler->tapsPerPhase()));
+}
+BENCHMARK(BM_PushResampled)->Arg(48000)->Arg(44100);
+
+// Capture buffers through the session audio store into the stream ring, with
+// room in memory for range(0) one-second segments; a small cap spills most
+// of the recording to the encrypted file. One item is one sample.
+void BM_AudioChunkStore(bench::State& state) {
+    const uint8_t key[CHACHA20_KEY_BYTES] = {};
+    const size_t memory_cap = static_cast<size_t>(state.range(0)) * CHUNK_SAMPLES * sizeof(int16_t);
+    std::unique_ptr<AudioChunkStore> store =
+        AudioChunkStore::open("native_bench_audio.spill", key, CHUNK_SAMPLES, memory_cap);
+    if (!store) {
+        state.skipWithError("cannot create spill file in the working directory");
+        return;
+    }
+    StreamingSession session(WINDOW_SAMPLES, OVERLAP_SAMPLES, WINDOW_SAMPLES * 2);
+    auto sink = [&session](const int16_t* pcm, size_t count) { return pushPcm(session, pcm, count); };
+    for ([[maybe_unused]] auto _ : state) {
+        store->reset();
+        for (size_t offset = 0; offset < g_pcm.size(); offset += CAPTURE_SAMPLES) {
+            store->append(g_pcm.data() + offset, std::min(CAPTURE_SAMPLES, g_pcm.size() - offset));
+            store->drain(sink);
+            session.ring.discard(session.ring.size());
+        }
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(g_pcm.size()));
+    state.setCounter("spilled_bytes", static_cast<double>(store->stats().spilled_bytes));
+}
+BENCHMARK(BM_AudioChunkStore)->Arg(2)->Arg(1024);
+
+// Result building and the native half of marshalling: arena results, the
+// confidence summary and the UTF-16 word offsets handed to Java. One item
+// is one result.
+void BM_ResultMarshalling(bench::State& state) {
+    std::vector<size_t> offsets, lengths;
+    chunkFixture(offsets, lengths);
+    std::vector<AudioFeatures> features = analyzeBatch(g_pcm.data(), offsets, lengths);
+    ResultArena arena;
+    std::vector<int32_t> word_offsets;
+    const DecoderConfig decoder;
+    for ([[maybe_unused]] auto _ : state) {
+        arena.reset();
+        for (size_t i = 0; i < features.size(); i++) {
+            arena.results.push_back(transcribeFeatures(arena, features[i], lengths[i], decoder, lengths[i], nullptr));
+        }
+        float confidence = 0.0f;
+        for (const InferenceResult& result : arena.results) {
+            confidence += summarizeConfidence(arena, result).confidence;
+            word_offsets.resize(result.alignments.length + 1);
+            fillWordOffsets(arena, result, word_offsets.data());
+        }
+        bench::doNotOptimize(word_offsets.data());
+        bench::doNotOptimize(confidence);
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(features.size()));
+}
+BENCHMARK(BM_ResultMarshalling);
+
+// Stream windows decoded and stitched into the session timeline, as one
+// poll drains them; one item is one window, words_per_window counts the
+// words that survive the overlap merge
+void BM_StitchWindows(bench::State& state) {
+    std::vector<AudioFeatures> windows;
+    {
+        StreamingSession session(WINDOW_SAMPLES, OVERLAP_SAMPLES, g_pcm.size() + WINDOW_SAMPLES);
+        pushPcm(session, g_pcm.data(), g_pcm.size());
+        AudioFeatures features;
+        while (nextStreamWindow(session, features)) {
+            windows.push_back(features);
+        }
+    }
+    TranscriptStitcher stitcher(WINDOW_SAMPLES, OVERLAP_SAMPLES);
+    ResultArena arena;
+    size_t words = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        arena.reset();
+        stitcher.reset();
+        words = 0;
+        for (const AudioFeatures& features : windows) {
+            InferenceResult result = transcribeFeatures(arena, features, WINDOW_SAMPLES, DecoderConfig(),
+                                                        WINDOW_SAMPLES, nullptr);
+            stitcher.stitch(arena, result, WINDOW_SAMPLES);
+            arena.results.push_back(result);
+            words += result.alignments.length;
+        }
+        bench::doNotOptimize(arena.alignments.data());
+    }
+    state.setItemsProcessed(state.iterations() * static_cast<int64_t>(windows.size()));
+    state.setCounter("words_per_window", windows.empty() ? 0.0 : static_cast<double>(words) / windows.size());
+}
+BENCHMARK(BM_StitchWindows);
+
+// The app's stream loop with range(0) as the DecodeMode: 20 ms captures
+// pushed, an utterance end marked where each voiced burst of the synthetic
+// recording stops, and every ready window decoded and stitched. One item is
+// one window; hypotheses_per_token is the decoder cost against greedy.
+void BM_StreamDecode(bench::State& state) {
+    DecoderConfig decoder;
+    decoder.mode = static_cast<DecodeMode>(state.range(0));
+    DecodeStats stats;
+    int64_t windows = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        StreamingSession session(WINDOW_SAMPLES, OVERLAP_SAMPLES, g_pcm.size() + WINDOW_SAMPLES);
+        ResultArena arena;
+        AudioFeatures features;
+        for (size_t offset = 0; offset < g_pcm.size(); offset += CAPTURE_SAMPLES) {
+            const size_t count = std::min(CAPTURE_SAMPLES, g_pcm.size() - offset);
+            pushPcm(session, g_pcm.data() + offset, count);
+            // Bursts are voiced for the first 0.6 s of every second
+            if ((offset + count) % SAMPLE_RATE == SAMPLE_RATE * 3 / 5) {
+                endUtterance(session);
+            }
+            arena.reset();
+            while (nextStreamWindow(session, features)) {
+                InferenceResult result = transcribeFeatures(arena, features, WINDOW_SAMPLES, decoder,
+                                                            session.window_speech_samples, &stats);
+                session.stitcher.stitch(arena, result, session.window_speech_samples);
+                arena.results.push_back(result);
+                windows++;
+            }
+            bench::doNotOptimize(arena.alignments.data());
+        }
+    }
+    state.setItemsProcessed(windows);
+    state.setCounter("hypotheses_per_token", stats.tokens ? static_cast<double>(stats.hypotheses) / stats.tokens : 0.0);
+    state.setCounter("early_exit_fraction", stats.chunks ? static_cast<double>(stats.early_exits) / stats.chunks : 0.0);
+}
+BENCHMARK(BM_StreamDecode)->Arg(0)->Arg(1)->Arg(2);
+
+// Q8 weights for a 384 x 1536 projection (a Whisper tiny MLP layer) and
+// range(0) input columns: 1 for a single decode step, more when batched
+struct MatmulFixture {
+    static constexpr size_t ROWS = 384;
+    static constexpr size_t DEPTH = 1536;
+    std::vector<BlockQ8> weights;
+    std::vector<BlockQ8> inputs;
+    std::vector<float> out;
+
+    explicit MatmulFixture(size_t cols)
+        : weights(ROWS * DEPTH / Q8_BLOCK), inputs(cols * DEPTH / Q8_BLOCK), out(ROWS * cols) {
+        std::vector<float> values(std::max(ROWS, cols) * DEPTH);
+        uint32_t seed = 1;
+        for (float& v : values) {
+            seed = seed * 1664525u + 1013904223u;
+            v = static_cast<float>(static_cast<int32_t>(seed >> 8) - (1 << 23)) / (1 << 23);
+        }
+        quantizeQ8(values.data(), weights.data(), ROWS * DEPTH);
+        quantizeQ8(values.data(), inputs.data(), cols * DEPTH);
+    }
+
+    size_t cols() const { return out.size() / ROWS; }
+};
+
+// One item is one multiply-accumulate
+void BM_QuantizedMatmul(bench::State& state) {
+    MatmulFixture fixture(static_cast<size_t>(state.range(0)));
+    for ([[maybe_unused]] auto _ : state) {
+        matmulQ8(fixture.weights.data(), MatmulFixture::ROWS, fixture.inputs.data(), fixture.cols(),
+                 MatmulFixture::DEPTH / Q8_BLOCK, fixture.out.data());
+        bench::doNotOptimize(fixture.out.data());
+    }
+    state.setItemsProcessed(state.iterations() *
+                            static_cast<int64_t>(MatmulFixture::ROWS * MatmulFixture::DEPTH * fixture.cols()));
+}
+BENCHMARK(BM_QuantizedMatmul)->Arg(1)->Arg(4);
+
+// Reference kernel every variant must match bit for bit (checked by
+// tests/quant_matmul_test.cpp)
+void BM_QuantizedMatmulScalar(bench::State& state) {
+    MatmulFixture fixture(static_cast<size_t>(state.range(0)));
+    for ([[maybe_unused]] auto _ : state) {
+        matmulQ8Scalar(fixture.weights.data(), MatmulFixture::ROWS, fixture.inputs.data(), fixture.cols(),
+                       MatmulFixture::DEPTH / Q8_BLOCK, fixture.out.data());
+        bench::doNotOptimize(fixture.out.data());
+    }
+    state.setItemsProcessed(state.iterations() *
+                            static_cast<int64_t>(MatmulFixture::ROWS * MatmulFixture::DEPTH * fixture.cols()));
+}
+BENCHMARK(BM_QuantizedMatmulScalar)->Arg(1)->Arg(4);
+
+// Mock tokens are runs of non-space characters plus trailing whitespace
+size_t countTokens(const std::string& text) {
+    size_t tokens = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        const bool space = text[i] == ' ' || text[i] == '\n' || text[i] == '\t';
+        const bool after_space = i > 0 && (text[i - 1] == ' ' || text[i - 1] == '\n' || text[i - 1] == '\t');
+        tokens += !space && (i == 0 || after_space);
+    }
+    return tokens;
+}
+
+// Scheduler throughput with range(0) concurrent requests on one context;
+// one item is one generated token
+void BM_GenerationThroughput(bench::State& state) {
+    MockLlamaContext context;
+    context.contextLength = 2048;
+    context.isLoaded = true;
+    context.scheduler = std::make_unique<GenerationScheduler>(context);
+
+    int64_t tokens = 0;
+    int64_t failed = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        std::vector<std::shared_ptr<GenerationSession>> sessions;
+        for (int64_t i = 0; i < state.range(0); i++) {
+            auto session = std::make_shared<GenerationSession>();
+            // Distinct prompts so the prefix cache does not absorb every prefill
+            session->prompt = "Patient reports headache and mild fever since visit " + std::to_string(i + tokens);
+            sessions.push_back(session);
+            context.scheduler->submit(session);
+        }
+        for (auto& session : sessions) {
+            std::unique_lock<std::mutex> lock(session->mutex);
+            session->tokensReady.wait(lock, [&] { return session->finished; });
+            tokens += static_cast<int64_t>(countTokens(session->pending));
+            failed += session->failed;
+        }
+    }
+    if (failed > 0) {
+        state.skipWithError(std::to_string(failed) + " generations failed");
+    }
+    state.setItemsProcessed(tokens);
+    SchedulerStats stats = context.scheduler->stats();
+    state.setCounter("mean_wait_us", stats.admittedRequests ? static_cast<double>(stats.totalWaitUs) / stats.admittedRequests : 0.0);
+}
+BENCHMARK(BM_GenerationThroughput)->Arg(1)->Arg(4)->UseRealTime();
+
+// Stand-in GPU: runs offloaded work in a quarter of its single-core CPU time
+// without touching the compute pool
+class BenchDelegate : public ComputeDelegate {
+public:
+    BackendKind kind() const override { return BackendKind::VULKAN; }
+    const char* name() const override { return "bench"; }
+    bool run(int64_t cpu_us) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(cpu_us / 4));
+        return true;
+    }
+};
+
+// One request with range(0) of the model's layers offloaded to a stand-in
+// delegate; one item is one generated token
+void BM_OffloadedGeneration(bench::State& state) {
+    BackendRegistry::shared().add(std::make_shared<BenchDelegate>());
+    MockLlamaContext context;
+    context.contextLength = 2048;
+    context.isLoaded = true;
+    if (!context.offload.configure(static_cast<int32_t>(BackendKind::VULKAN), static_cast<int>(state.range(0)))) {
+        state.skipWithError("cannot configure offload");
+        return;
+    }
+    context.scheduler = std::make_unique<GenerationScheduler>(context);
+
+    int64_t tokens = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto session = std::make_shared<GenerationSession>();
+        session->prompt = "Patient reports headache and mild fever since visit " + std::to_string(tokens);
+        context.scheduler->submit(session);
+        std::unique_lock<std::mutex> lock(session->mutex);
+        session->tokensReady.wait(lock, [&] { return session->finished; });
+        tokens += static_cast<int64_t>(countTokens(session->pending));
+    }
+    state.setItemsProcessed(tokens);
+    OffloadStats stats = context.offload.stats();
+    state.setCounter("offloaded_passes", static_cast<double>(stats.offloaded_passes));
+}
+BENCHMARK(BM_OffloadedGeneration)->Arg(0)->Arg(11)->Arg(LLAMA_LAYERS)->UseRealTime();
+
+// One request decoded speculatively with range(0) draft tokens per step, 0
+// for plain decoding; one item is one generated token. The mock draft's
+// weights are never read, so the bench maps its own executable for them.
+void BM_SpeculativeGeneration(bench::State& state) {
+    MockLlamaContext context;
+    context.contextLength = 2048;
+    context.isLoaded = true;
+    if (state.range(0) > 0) {
+        context.draftWeights = mapModelFile("/proc/self/exe");
+        if (!context.draftWeights) {
+            state.skipWithError("cannot map draft weights");
+            return;
+        }
+        context.speculativeTokens = static_cast<size_t>(state.range(0));
+    }
+    context.scheduler = std::make_unique<GenerationScheduler>(context);
+
+    int64_t tokens = 0;
+    int64_t failed = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto session = std::make_shared<GenerationSession>();
+        session->prompt = "Patient reports headache and mild fever since visit " + std::to_string(tokens);
+        context.scheduler->submit(session);
+        std::unique_lock<std::mutex> lock(session->mutex);
+        session->tokensReady.wait(lock, [&] { return session->finished; });
+        tokens += static_cast<int64_t>(countTokens(session->pending));
+        failed += session->failed;
+    }
+    if (failed > 0) {
+        state.skipWithError(std::to_string(failed) + " generations failed");
+    }
+    state.setItemsProcessed(tokens);
+    SchedulerStats stats = context.scheduler->stats();
+    state.setCounter("tokens_per_step", stats.decodeSteps ? static_cast<double>(stats.generatedTokens) / stats.decodeSteps : 0.0);
+    state.setCounter("acceptance", stats.draftedTokens ? static_cast<double>(stats.acceptedTokens) / stats.draftedTokens : 0.0);
+}
+BENCHMARK(BM_SpeculativeGeneration)->Arg(0)->Arg(2)->Arg(4)->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Strip our own flag; the rest belong to the harness
+    std::vector<char*> args;
+    std::string fixture;
+    for (int i = 0; i < argc; i++) {
+        if (i > 0 && std::strncmp(argv[i], "--fixture=", 10) == 0) {
+            fixture = argv[i] + 10;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (fixture.empty()) {
+        g_pcm = syntheticRecording();
+    } else if (loadFixture(fixture, g_pcm)) {
+        g_fixture_name = fixture;
+    } else {
+        std::fprintf(stderr, "Cannot load fixture %s\n", fixture.c_str());
+        return 1;
+    }
+
+    return bench::runBenchmarks(static_cast<int>(args.size()), args.data(), {
+        {"fixture", g_fixture_name},
+        {"fixture_seconds", std::to_string(static_cast<double>(g_pcm.size()) / SAMPLE_RATE)},
+        {"cpu_features", cpuFeatureNames(cpuFeatures())},
+        {"feature_kernel", featureKernelName()},
+        {"resample_kernel", nativeKernels().resample_variant},
+        {"matmul_kernel", nativeKernels().matmul_variant},
+        {"pool_threads", std::to_string(ComputePool::shared().threadCount())},
+    });
+}
@@ -0,0 +1,78 @@
+#include "chacha20.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr size_t BLOCK_BYTES = 64;
+
+inline uint32_t rotl(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+inline uint32_t load32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+inline void store32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+inline void quarterRound(uint32_t* x, int a, int b, int c, int d) {
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+}
+
+void block(const uint32_t state[16], uint8_t out[BLOCK_BYTES]) {
+    uint32_t x[16];
+    std::memcpy(x, state, sizeof(x));
+    for (int round = 0; round < 10; round++) {
+        quarterRound(x, 0, 4, 8, 12);
+        quarterRound(x, 1, 5, 9, 13);
+        quarterRound(x, 2, 6, 10, 14);
+        quarterRound(x, 3, 7, 11, 15);
+        quarterRound(x, 0, 5, 10, 15);
+        quarterRound(x, 1, 6, 11, 12);
+        quarterRound(x, 2, 7, 8, 13);
+        quarterRound(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; i++) {
+        store32(out + 4 * i, x[i] + state[i]);
+    }
+}
+
+} // namespace
+
+void chacha20Xor(const uint8_t key[CHACHA20_KEY_BYTES], const uint8_t nonce[CHACHA20_NONCE_BYTES],
+                 uint32_t counter, const uint8_t* in, uint8_t* out, size_t length) {
+    // "expand 32-byte k"
+    uint32_t state[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    for (int i = 0; i < 8; i++) {
+        state[4 + i] = load32(key + 4 * i);
+    }
+    state[12] = counter;
+    for (int i = 0; i < 3; i++) {
+        state[13 + i] = load32(nonce + 4 * i);
+    }
+
+    uint8_t keystream[BLOCK_BYTES];
+    for (size_t offset = 0; offset < length; offset += BLOCK_BYTES) {
+        block(state, keystream);
+        state[12]++;
+        const size_t n = length - offset < BLOCK_BYTES ? length - offset : BLOCK_BYTES;
+        for (size_t i = 0; i < n; i++) {
+            out[offset + i] = in[offset + i] ^ keystream[i];
+        }
+    }
+    // Keystream bytes are as sensitive as the key
+    volatile uint8_t* wipe = keystream;
+    for (size_t i = 0; i < BLOCK_BYTES; i++) {
+        wipe[i] = 0;
+    }
+}
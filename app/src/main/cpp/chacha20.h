@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ChaCha20 stream cipher (RFC 8439) for audio spilled to disk. Encryption
+// and decryption are the same XOR with the keystream; in and out may alias.
+// A (key, nonce) pair must never encrypt two different messages.
+constexpr size_t CHACHA20_KEY_BYTES = 32;
+constexpr size_t CHACHA20_NONCE_BYTES = 12;
+
+void chacha20Xor(const uint8_t key[CHACHA20_KEY_BYTES], const uint8_t nonce[CHACHA20_NONCE_BYTES],
+                 uint32_t counter, const uint8_t* in, uint8_t* out, size_t length);
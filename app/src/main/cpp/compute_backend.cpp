@@ -0,0 +1,241 @@
+#include "compute_backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef __ANDROID__
+#include <dlfcn.h>
+#endif
+
+#include "native_log.h"
+
+#define TAG "ComputeBackend"
+#define LOGD(...) AMBIENT_LOG_DEBUG(TAG, __VA_ARGS__)
+#define LOGE(...) AMBIENT_LOG_ERROR(TAG, __VA_ARGS__)
+
+namespace {
+
+// Delegate preference per role, best first
+constexpr BackendKind ENCODER_PREFERENCE[] = {BackendKind::QNN, BackendKind::NNAPI, BackendKind::VULKAN};
+constexpr BackendKind DECODER_PREFERENCE[] = {BackendKind::VULKAN, BackendKind::QNN};
+
+// Simulated device time per microsecond of single-core CPU work
+constexpr double VULKAN_TIME_RATIO = 0.25;
+constexpr double NNAPI_TIME_RATIO = 0.2;
+constexpr double QNN_TIME_RATIO = 0.15;
+
+// A delegate backed by a platform library. The library stays loaded for the
+// life of the process.
+class PlatformDelegate : public ComputeDelegate {
+public:
+    PlatformDelegate(BackendKind kind, const char* name, double time_ratio)
+        : kind_(kind), name_(name), time_ratio_(time_ratio) {}
+
+    BackendKind kind() const override { return kind_; }
+    const char* name() const override { return name_; }
+
+    bool run(int64_t cpu_us) override {
+        // In real implementation, would run the offloaded layers' subgraph:
+        // ggml's Vulkan backend, an NNAPI compilation or a QNN HTP graph
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(cpu_us * time_ratio_)));
+        return true;
+    }
+
+private:
+    const BackendKind kind_;
+    const char* const name_;
+    const double time_ratio_;
+};
+
+#ifdef __ANDROID__
+
+// ggml's Vulkan backend needs Vulkan 1.2
+constexpr uint32_t MIN_VULKAN_VERSION = (1u << 22) | (2u << 12);
+
+// From NeuralNetworks.h (API 29)
+constexpr int32_t ANEURALNETWORKS_NO_ERROR = 0;
+constexpr int32_t ANEURALNETWORKS_DEVICE_ACCELERATOR = 4;
+
+bool probeVulkan() {
+    void* library = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        return false;
+    }
+    using EnumerateVersion = int32_t (*)(uint32_t*);
+    auto enumerate = reinterpret_cast<EnumerateVersion>(dlsym(library, "vkEnumerateInstanceVersion"));
+    uint32_t version = 0;
+    return enumerate && enumerate(&version) == 0 && version >= MIN_VULKAN_VERSION;
+}
+
+// Only a dedicated accelerator is worth it; NNAPI's CPU and GPU paths are
+// no faster than ours
+bool probeNnapi() {
+    void* library = dlopen("libneuralnetworks.so", RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        return false;
+    }
+    using GetDeviceCount = int32_t (*)(uint32_t*);
+    using GetDevice = int32_t (*)(uint32_t, void**);
+    using GetType = int32_t (*)(const void*, int32_t*);
+    auto get_count = reinterpret_cast<GetDeviceCount>(dlsym(library, "ANeuralNetworks_getDeviceCount"));
+    auto get_device = reinterpret_cast<GetDevice>(dlsym(library, "ANeuralNetworks_getDevice"));
+    auto get_type = reinterpret_cast<GetType>(dlsym(library, "ANeuralNetworksDevice_getType"));
+    uint32_t count = 0;
+    if (!get_count || !get_device || !get_type || get_count(&count) != ANEURALNETWORKS_NO_ERROR) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        void* device = nullptr;
+        int32_t type = 0;
+        if (get_device(i, &device) == ANEURALNETWORKS_NO_ERROR &&
+            get_type(device, &type) == ANEURALNETWORKS_NO_ERROR && type == ANEURALNETWORKS_DEVICE_ACCELERATOR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The QNN HTP runtime ships in the APK, but only Hexagon parts can load it
+bool probeQnn() {
+    void* library = dlopen("libQnnHtp.so", RTLD_NOW | RTLD_LOCAL);
+    return library && dlsym(library, "QnnInterface_getProviders");
+}
+
+#endif
+
+} // namespace
+
+BackendRegistry& BackendRegistry::shared() {
+    static BackendRegistry registry;
+    return registry;
+}
+
+BackendRegistry::BackendRegistry() {
+#ifdef __ANDROID__
+    if (probeVulkan()) {
+        delegates_.push_back(std::make_shared<PlatformDelegate>(BackendKind::VULKAN, "vulkan", VULKAN_TIME_RATIO));
+    }
+    if (probeNnapi()) {
+        delegates_.push_back(std::make_shared<PlatformDelegate>(BackendKind::NNAPI, "nnapi", NNAPI_TIME_RATIO));
+    }
+    if (probeQnn()) {
+        delegates_.push_back(std::make_shared<PlatformDelegate>(BackendKind::QNN, "qnn", QNN_TIME_RATIO));
+    }
+#endif
+    LOGD("Offload delegates available: %zu", delegates_.size());
+}
+
+void BackendRegistry::add(std::shared_ptr<ComputeDelegate> delegate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const BackendKind kind = delegate->kind();
+    delegates_.erase(std::remove_if(delegates_.begin(), delegates_.end(),
+                                    [kind](const auto& d) { return d->kind() == kind; }),
+                     delegates_.end());
+    delegates_.push_back(std::move(delegate));
+}
+
+std::shared_ptr<ComputeDelegate> BackendRegistry::find(BackendKind kind) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& delegate : delegates_) {
+        if (delegate->kind() == kind) {
+            return delegate;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<ComputeDelegate> BackendRegistry::preferred(ModelRole role) const {
+    if (role == ModelRole::ENCODER) {
+        for (BackendKind kind : ENCODER_PREFERENCE) {
+            if (auto delegate = find(kind)) {
+                return delegate;
+            }
+        }
+    } else {
+        for (BackendKind kind : DECODER_PREFERENCE) {
+            if (auto delegate = find(kind)) {
+                return delegate;
+            }
+        }
+    }
+    return nullptr;
+}
+
+uint32_t BackendRegistry::availableMask() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t mask = 0;
+    for (const auto& delegate : delegates_) {
+        mask |= 1u << static_cast<uint32_t>(delegate->kind());
+    }
+    return mask;
+}
+
+bool LayerOffload::configure(int32_t kind, int layers) {
+    if (layers < 0 || layers > total_layers_) {
+        return false;
+    }
+    std::shared_ptr<ComputeDelegate> delegate;
+    if (kind == AUTO) {
+        delegate = BackendRegistry::shared().preferred(role_);
+    } else if (kind != static_cast<int32_t>(BackendKind::CPU)) {
+        delegate = BackendRegistry::shared().find(static_cast<BackendKind>(kind));
+        if (!delegate) {
+            return false;
+        }
+    }
+    if (layers == 0) {
+        delegate.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    delegate_ = delegate;
+    layers_ = delegate ? layers : 0;
+    stats_.backend = delegate ? delegate->kind() : BackendKind::CPU;
+    stats_.layers = layers_;
+    return true;
+}
+
+void LayerOffload::run(int64_t total_us, const std::function<void(int64_t)>& cpu) {
+    std::shared_ptr<ComputeDelegate> delegate;
+    int layers = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        delegate = delegate_;
+        layers = layers_;
+    }
+
+    if (!delegate || BackendRegistry::shared().suspended()) {
+        cpu(total_us);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.cpu_passes++;
+        return;
+    }
+
+    const int64_t offloaded_us = total_us * layers / total_layers_;
+    if (!delegate->run(offloaded_us)) {
+        LOGE("%s delegate failed; running on the CPU", delegate->name());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (delegate_ == delegate) {
+                delegate_.reset();
+                layers_ = 0;
+                stats_.backend = BackendKind::CPU;
+                stats_.layers = 0;
+            }
+            stats_.failures++;
+            stats_.cpu_passes++;
+        }
+        cpu(total_us);
+        return;
+    }
+
+    cpu(total_us - offloaded_us);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.offloaded_passes++;
+}
+
+OffloadStats LayerOffload::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Where model layers run; values match OffloadBackend in Kotlin, which adds
+// AUTO (-1) for the device's preferred delegate
+enum class BackendKind : int32_t {
+    CPU = 0,
+    VULKAN = 1,
+    NNAPI = 2,
+    QNN = 3,
+};
+
+// What the offloaded layers compute. NPUs run the fixed-shape Whisper
+// encoder well; LLM decode, with its growing KV cache, suits a GPU.
+enum class ModelRole {
+    ENCODER,
+    DECODER,
+};
+
+// An accelerator that runs a model's leading layers while the compute pool
+// is left to capture, the UI and whatever layers stay on the CPU
+class ComputeDelegate {
+public:
+    virtual ~ComputeDelegate() = default;
+    virtual BackendKind kind() const = 0;
+    virtual const char* name() const = 0;
+    // Runs layers that would cost cpu_us of single-core CPU time, blocking
+    // until the device is done. False if the delegate failed; the caller
+    // then runs those layers on the CPU.
+    virtual bool run(int64_t cpu_us) = 0;
+};
+
+// Delegates present on this device. Platform delegates are probed once per
+// process by dlopen-ing their libraries, so the APK has no link-time
+// dependency on any of them and runs unchanged where one is missing.
+class BackendRegistry {
+public:
+    static BackendRegistry& shared();
+
+    // Replaces any delegate of the same kind; benchmarks and tests register fakes
+    void add(std::shared_ptr<ComputeDelegate> delegate);
+    std::shared_ptr<ComputeDelegate> find(BackendKind kind) const;
+    // Best delegate present for the role, or null if there is none
+    std::shared_ptr<ComputeDelegate> preferred(ModelRole role) const;
+    // Bit 1 << kind per delegate present
+    uint32_t availableMask() const;
+
+    // Accelerators share the SoC's thermal budget, so thermal management
+    // moves every model back onto the (already shrunk) compute pool
+    void setSuspended(bool suspended) { suspended_.store(suspended, std::memory_order_relaxed); }
+    bool suspended() const { return suspended_.load(std::memory_order_relaxed); }
+
+private:
+    BackendRegistry();
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<ComputeDelegate>> delegates_;
+    std::atomic<bool> suspended_{false};
+};
+
+struct OffloadStats {
+    BackendKind backend = BackendKind::CPU;
+    int layers = 0;
+    uint64_t offloaded_passes = 0;
+    uint64_t cpu_passes = 0;
+    uint64_t failures = 0;
+};
+
+// Splits one model's layers between a delegate and the CPU: the first
+// layers() run on the delegate, the rest on the caller's CPU path. A pass
+// runs entirely on the CPU while offload is suspended, and a delegate that
+// fails is dropped for this model until it is configured again.
+class LayerOffload {
+public:
+    static constexpr int32_t AUTO = -1;
+
+    LayerOffload(ModelRole role, int total_layers) : role_(role), total_layers_(total_layers) {}
+
+    // kind AUTO picks the preferred delegate and falls back to the CPU when
+    // there is none. False, leaving the plan unchanged, if an explicit kind
+    // is missing or layers is outside 0..total layers.
+    bool configure(int32_t kind, int layers);
+
+    // One forward pass costing total_us of single-core CPU time; cpu runs
+    // the given share of it on the CPU
+    void run(int64_t total_us, const std::function<void(int64_t)>& cpu);
+
+    OffloadStats stats() const;
+    int totalLayers() const { return total_layers_; }
+
+private:
+    const ModelRole role_;
+    const int total_layers_;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<ComputeDelegate> delegate_;
+    int layers_ = 0;
+    OffloadStats stats_;
+};
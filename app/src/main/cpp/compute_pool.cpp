@@ -0,0 +1,206 @@
+#include "compute_pool.h"
+
+#include "cpu_topology.h"
+#include "native_trace.h"
+
+#include <algorithm>
+#include <exception>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+
+// Same niceness as Android's THREAD_PRIORITY_BACKGROUND
+constexpr int LOW_PRIORITY_NICE = 10;
+
+// Index of the pool worker running on this thread, if any
+thread_local const ComputePool* tls_pool = nullptr;
+thread_local size_t tls_worker = 0;
+
+void pinToCores(const std::vector<int>& cores) {
+    if (cores.empty()) {
+        return;
+    }
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cores) {
+        CPU_SET(cpu, &mask);
+    }
+    // Best effort: a restricted cpuset leaves the thread where the kernel put it
+    sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+// Shared state of one parallelFor call; helpers may outlive the call
+struct ParallelJob {
+    const std::function<void(size_t)>* body = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+
+    void work() {
+        size_t completed = 0;
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            try {
+                (*body)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            completed++;
+        }
+        if (completed > 0 && done.fetch_add(completed) + completed == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+ComputePool& ComputePool::shared() {
+    static ComputePool pool;
+    return pool;
+}
+
+ComputePool::ComputePool() {
+    const CpuTopology& topology = cpuTopology();
+    default_threads_ = std::max<size_t>(1, topology.performanceCores.size());
+    active_.store(default_threads_);
+
+    const size_t capacity = std::max(default_threads_,
+        topology.performanceCores.size() + topology.efficiencyCores.size());
+    for (size_t i = 0; i < capacity; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        workers_[i]->thread = std::thread([this, i, &topology] {
+            pinToCores(i < default_threads_ ? topology.performanceCores : topology.efficiencyCores);
+            run(i);
+        });
+    }
+}
+
+ComputePool::~ComputePool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    resized_.notify_all();
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+size_t ComputePool::resize(size_t threads) {
+    size_t applied = threads == 0 ? default_threads_ : std::min(threads, workers_.size());
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        active_.store(applied);
+    }
+    TRACE_COUNTER("compute_pool.threads", static_cast<int64_t>(applied));
+    // Newly active workers pick up anything already queued; newly parked ones move aside
+    resized_.notify_all();
+    wake_.notify_all();
+    return applied;
+}
+
+void ComputePool::submit(std::function<void()> task, TaskPriority priority) {
+    const size_t active = active_.load();
+    // A worker queues its own subtasks locally; others spread round robin
+    size_t target = (tls_pool == this && tls_worker < active) ? tls_worker : next_queue_.fetch_add(1) % active;
+    // Counted before it is queued, so a worker taking it never sees pending_ underflow
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        pending_.fetch_add(1);
+    }
+    {
+        Worker& worker = *workers_[target];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[static_cast<size_t>(priority)].push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void ComputePool::parallelFor(size_t count, const std::function<void(size_t)>& body, TaskPriority priority) {
+    if (count == 0) {
+        return;
+    }
+    auto job = std::make_shared<ParallelJob>();
+    job->body = &body;
+    job->count = count;
+
+    const size_t helpers = std::min(count, threadCount()) - 1;
+    for (size_t i = 0; i < helpers; i++) {
+        submit([job] { job->work(); }, priority);
+    }
+    job->work();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load() == count; });
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+// Highest priority first: own queue, then steal from any other worker
+// (including parked ones, so work queued before a shrink still runs)
+bool ComputePool::takeTask(size_t index, std::function<void()>& task, TaskPriority& priority) {
+    for (size_t level = 0; level < PRIORITY_LEVELS; level++) {
+        for (size_t offset = 0; offset < workers_.size(); offset++) {
+            Worker& victim = *workers_[(index + offset) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto& queue = victim.queues[level];
+            if (!queue.empty()) {
+                task = std::move(queue.front());
+                queue.pop_front();
+                priority = static_cast<TaskPriority>(level);
+                pending_.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ComputePool::run(size_t index) {
+    tls_pool = this;
+    tls_worker = index;
+    bool niced = false;
+
+    while (true) {
+        {
+            // Parked workers wait apart, so a wakeup for new work always reaches an active one
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            resized_.wait(lock, [&] { return stopping_ || index < active_.load(); });
+            wake_.wait(lock, [&] { return stopping_ || index >= active_.load() || pending_.load() > 0; });
+            if (stopping_) {
+                return;
+            }
+            if (index >= active_.load()) {
+                // Parked while a wakeup may have been meant for this worker; pass it on
+                if (pending_.load() > 0) {
+                    wake_.notify_one();
+                }
+                continue;
+            }
+        }
+
+        std::function<void()> task;
+        TaskPriority priority;
+        while (index < active_.load() && takeTask(index, task, priority)) {
+            const bool low = priority == TaskPriority::LOW;
+            if (low != niced && setpriority(PRIO_PROCESS, gettid(), low ? LOW_PRIORITY_NICE : 0) == 0) {
+                niced = low;
+            }
+            task();
+            task = nullptr;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Scheduling class of pool work. A worker always runs the highest class it
+// can find, so ASR never queues behind LLM work, and LOW work such as
+// speculative prefill runs at background niceness.
+enum class TaskPriority {
+    HIGH,   // ASR: transcription keeps up with live audio
+    NORMAL, // LLM generation the user is waiting for
+    LOW     // Background LLM prefill
+};
+
+// Process-wide work-stealing pool shared by the ASR and LLM libraries, so
+// the app never runs more compute threads than the cores can carry.
+// Workers are pinned to the performance cores, one per core by default;
+// workers beyond that count run on the efficiency cores and only take work
+// once the pool is resized up to them. Each worker has its own queues; idle
+// workers steal from the others.
+class ComputePool {
+public:
+    static ComputePool& shared();
+
+    ComputePool(const ComputePool&) = delete;
+    ComputePool& operator=(const ComputePool&) = delete;
+    ~ComputePool();
+
+    void submit(std::function<void()> task, TaskPriority priority);
+
+    // Runs body(i) for every i in [0, count) and returns when all have run.
+    // The caller takes indices too, so this cannot deadlock when called from
+    // a worker or when every worker is busy. The first exception thrown by
+    // body is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body, TaskPriority priority);
+
+    // Workers currently taking work
+    size_t threadCount() const { return active_.load(); }
+
+    // Workers that exist; resize() never starts or stops threads
+    size_t maxThreads() const { return workers_.size(); }
+
+    // Clamped to [1, maxThreads()]; 0 restores the default of one per
+    // performance core. Returns the count applied.
+    size_t resize(size_t threads);
+
+    size_t defaultThreadCount() const { return default_threads_; }
+
+private:
+    static constexpr size_t PRIORITY_LEVELS = 3;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> queues[PRIORITY_LEVELS];
+        std::thread thread;
+    };
+
+    ComputePool();
+
+    void run(size_t index);
+    bool takeTask(size_t index, std::function<void()>& task, TaskPriority& priority);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    size_t default_threads_ = 1;
+    std::atomic<size_t> active_{1};
+    std::atomic<size_t> next_queue_{0};
+
+    // Tasks queued but not yet taken; workers sleep while it is zero
+    std::atomic<size_t> pending_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable resized_;
+    bool stopping_ = false;
+};
@@ -0,0 +1,72 @@
+#include "cpu_features.h"
+
+#if defined(__aarch64__) || defined(__arm__)
+#include <sys/auxv.h>
+#endif
+
+namespace {
+
+#if defined(__aarch64__)
+// From the kernel's asm/hwcap.h, spelled out for NDK headers that predate them
+constexpr unsigned long HWCAP_BIT_ASIMD = 1ul << 1;
+constexpr unsigned long HWCAP_BIT_ASIMDHP = 1ul << 10;
+constexpr unsigned long HWCAP_BIT_ASIMDDP = 1ul << 20;
+constexpr unsigned long HWCAP_BIT_SVE = 1ul << 22;
+constexpr unsigned long HWCAP2_BIT_I8MM = 1ul << 13;
+#elif defined(__arm__)
+constexpr unsigned long HWCAP_BIT_NEON = 1ul << 12;
+#endif
+
+uint32_t detectCpuFeatures() {
+    uint32_t features = 0;
+#if defined(__aarch64__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+    if (hwcap & HWCAP_BIT_ASIMD) features |= CPU_FEATURE_NEON;
+    if (hwcap & HWCAP_BIT_ASIMDDP) features |= CPU_FEATURE_DOTPROD;
+    if (hwcap & HWCAP_BIT_ASIMDHP) features |= CPU_FEATURE_FP16;
+    if (hwcap & HWCAP_BIT_SVE) features |= CPU_FEATURE_SVE;
+    if (hwcap2 & HWCAP2_BIT_I8MM) features |= CPU_FEATURE_I8MM;
+#elif defined(__arm__)
+    if (getauxval(AT_HWCAP) & HWCAP_BIT_NEON) features |= CPU_FEATURE_NEON;
+#elif defined(__x86_64__) || defined(__i386__)
+    // Also checks that the OS saves the AVX register state
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) features |= CPU_FEATURE_SSE2;
+    if (__builtin_cpu_supports("avx2")) features |= CPU_FEATURE_AVX2;
+    if (__builtin_cpu_supports("fma")) features |= CPU_FEATURE_FMA;
+#endif
+    return features;
+}
+
+} // namespace
+
+uint32_t cpuFeatures() {
+    static const uint32_t features = detectCpuFeatures();
+    return features;
+}
+
+std::string cpuFeatureNames(uint32_t features) {
+    static const struct {
+        CpuFeature feature;
+        const char* name;
+    } NAMES[] = {
+        {CPU_FEATURE_NEON, "neon"},
+        {CPU_FEATURE_DOTPROD, "dotprod"},
+        {CPU_FEATURE_I8MM, "i8mm"},
+        {CPU_FEATURE_FP16, "fp16"},
+        {CPU_FEATURE_SVE, "sve"},
+        {CPU_FEATURE_SSE2, "sse2"},
+        {CPU_FEATURE_AVX2, "avx2"},
+        {CPU_FEATURE_FMA, "fma"},
+    };
+
+    std::string names;
+    for (const auto& entry : NAMES) {
+        if (features & entry.feature) {
+            if (!names.empty()) names += ',';
+            names += entry.name;
+        }
+    }
+    return names;
+}
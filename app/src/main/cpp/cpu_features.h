@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Instruction set extensions detected at run time. The ABI baseline (NEON
+// on arm, SSE2 on x86) is always set; everything else is only used through
+// a kernel variant built for it (see native_kernels.h).
+enum CpuFeature : uint32_t {
+    CPU_FEATURE_NEON = 1u << 0,
+    CPU_FEATURE_DOTPROD = 1u << 1,  // SDOT/UDOT int8 dot products
+    CPU_FEATURE_I8MM = 1u << 2,     // SMMLA int8 matrix multiply
+    CPU_FEATURE_FP16 = 1u << 3,     // half-precision vector arithmetic
+    CPU_FEATURE_SVE = 1u << 4,
+    CPU_FEATURE_SSE2 = 1u << 5,
+    CPU_FEATURE_AVX2 = 1u << 6,
+    CPU_FEATURE_FMA = 1u << 7,
+};
+
+// Read once: getauxval(AT_HWCAP/AT_HWCAP2) on arm, cpuid on x86
+uint32_t cpuFeatures();
+
+inline bool hasCpuFeatures(uint32_t mask) {
+    return (cpuFeatures() & mask) == mask;
+}
+
+// Comma-separated names of the set bits, e.g. "neon,dotprod,fp16"
+std::string cpuFeatureNames(uint32_t features);
@@ -0,0 +1,58 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Reads a single integer from a sysfs file, or returns -1
+long readSysfsValue(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        return -1;
+    }
+    long value = -1;
+    if (std::fscanf(file, "%ld", &value) != 1) {
+        value = -1;
+    }
+    std::fclose(file);
+    return value;
+}
+
+// Relative speed of one core: the scheduler's capacity if the kernel
+// exports it, else the maximum frequency
+long coreCapacity(int cpu) {
+    const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    long capacity = readSysfsValue(base + "/cpu_capacity");
+    return capacity > 0 ? capacity : readSysfsValue(base + "/cpufreq/cpuinfo_max_freq");
+}
+
+CpuTopology detectTopology() {
+    const int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<long> capacities;
+    for (int cpu = 0; cpu < cores; cpu++) {
+        capacities.push_back(coreCapacity(cpu));
+    }
+
+    CpuTopology topology;
+    auto [lowest, highest] = std::minmax_element(capacities.begin(), capacities.end());
+    const bool known = *lowest > 0;
+    for (int cpu = 0; cpu < cores; cpu++) {
+        // Unreadable or uniform capacities: treat every core alike
+        if (known && *lowest != *highest && capacities[cpu] == *lowest) {
+            topology.efficiencyCores.push_back(cpu);
+        } else {
+            topology.performanceCores.push_back(cpu);
+        }
+    }
+    return topology;
+}
+
+} // namespace
+
+const CpuTopology& cpuTopology() {
+    static const CpuTopology topology = detectTopology();
+    return topology;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+// Cores grouped by cluster. On big.LITTLE parts the efficiency cores are
+// the lowest-capacity cluster and everything else counts as performance;
+// on uniform parts every core is a performance core.
+struct CpuTopology {
+    std::vector<int> performanceCores;
+    std::vector<int> efficiencyCores;
+};
+
+// Read once from /sys/devices/system/cpu (cpu_capacity, else cpuinfo_max_freq)
+const CpuTopology& cpuTopology();
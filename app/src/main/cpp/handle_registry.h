@@ -0,0 +1,72 @@
+#pragma once
+
+#include <jni.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// Handles are unique across every registry in a library, so a handle of one
+// kind can never resolve to an object of another kind.
+inline jlong nextNativeHandle() {
+    static std::atomic<jlong> next_handle{1};
+    return next_handle.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Thread-safe map from JNI handles to native objects.
+// Lookups take a shared lock on one of SHARD_COUNT shards, so concurrent
+// callers on different handles never contend and callers on the same handle
+// only share a reader lock. acquire() hands out a shared_ptr: releasing a
+// handle while a call is still using it only drops the registry's reference,
+// and the object is destroyed when the last in-flight call returns.
+template <typename T>
+class HandleRegistry {
+public:
+    jlong add(std::shared_ptr<T> object) {
+        const jlong handle = nextNativeHandle();
+        Shard& shard = shardFor(handle);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.objects.emplace(handle, std::move(object));
+        return handle;
+    }
+
+    std::shared_ptr<T> acquire(jlong handle) const {
+        const Shard& shard = shardFor(handle);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.objects.find(handle);
+        return it == shard.objects.end() ? nullptr : it->second;
+    }
+
+    // Returns false if the handle was unknown
+    bool remove(jlong handle) {
+        std::shared_ptr<T> released;
+        Shard& shard = shardFor(handle);
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.objects.find(handle);
+            if (it == shard.objects.end()) {
+                return false;
+            }
+            released = std::move(it->second);
+            shard.objects.erase(it);
+        }
+        // released goes out of scope here, outside the lock, so a heavy
+        // destructor never blocks lookups on the shard
+        return true;
+    }
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<jlong, std::shared_ptr<T>> objects;
+    };
+
+    Shard& shardFor(jlong handle) { return shards_[static_cast<size_t>(handle) % SHARD_COUNT]; }
+    const Shard& shardFor(jlong handle) const { return shards_[static_cast<size_t>(handle) % SHARD_COUNT]; }
+
+    std::array<Shard, SHARD_COUNT> shards_;
+};
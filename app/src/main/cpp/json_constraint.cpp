@@ -0,0 +1,753 @@
+#include "json_constraint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+// Nesting bound for schema documents, so a hostile schema cannot overflow the stack
+constexpr int MAX_SCHEMA_DEPTH = 64;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isHexDigit(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Some property not yet present in the object is spelled starting with prefix
+bool hasUnseenProperty(const JsonSchema::Node& object, uint64_t seen, const std::string& prefix) {
+    for (size_t i = 0; i < object.properties.size(); i++) {
+        if (!(seen & (1ULL << i)) && startsWith(object.properties[i].first, prefix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t declaredMask(const JsonSchema::Node& node) {
+    size_t count = node.properties.size();
+    return count >= 64 ? ~0ULL : (1ULL << count) - 1;
+}
+
+// Parsed schema document
+struct JsonValue {
+    enum Kind { Null, Bool, Number, String, Array, Object };
+
+    Kind kind = Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& member : object) {
+            if (member.first == key) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue(0);
+        skipSpace();
+        if (pos_ != text_.size()) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    [[noreturn]] void fail(const char* what) {
+        throw std::runtime_error(std::string(what) + " at offset " + std::to_string(pos_));
+    }
+
+    void skipSpace() {
+        while (pos_ < text_.size() && isSpace(text_[pos_])) {
+            pos_++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail("unexpected character");
+        }
+    }
+
+    bool consumeWord(const char* word) {
+        size_t length = std::strlen(word);
+        if (text_.compare(pos_, length, word) == 0) {
+            pos_ += length;
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue parseValue(int depth) {
+        if (depth > MAX_SCHEMA_DEPTH) {
+            fail("schema nested too deeply");
+        }
+        skipSpace();
+        if (pos_ >= text_.size()) {
+            fail("unexpected end of schema");
+        }
+
+        JsonValue value;
+        char c = text_[pos_];
+        if (c == '{') {
+            pos_++;
+            value.kind = JsonValue::Object;
+            if (!consume('}')) {
+                do {
+                    skipSpace();
+                    std::string key = parseString();
+                    expect(':');
+                    value.object.emplace_back(std::move(key), parseValue(depth + 1));
+                } while (consume(','));
+                expect('}');
+            }
+        } else if (c == '[') {
+            pos_++;
+            value.kind = JsonValue::Array;
+            if (!consume(']')) {
+                do {
+                    value.array.push_back(parseValue(depth + 1));
+                } while (consume(','));
+                expect(']');
+            }
+        } else if (c == '"') {
+            value.kind = JsonValue::String;
+            value.string = parseString();
+        } else if (consumeWord("true")) {
+            value.kind = JsonValue::Bool;
+            value.boolean = true;
+        } else if (consumeWord("false")) {
+            value.kind = JsonValue::Bool;
+        } else if (consumeWord("null")) {
+            value.kind = JsonValue::Null;
+        } else {
+            value.kind = JsonValue::Number;
+            value.number = parseNumber();
+        }
+        return value;
+    }
+
+    std::string parseString() {
+        if (pos_ >= text_.size() || text_[pos_] != '"') {
+            fail("expected string");
+        }
+        pos_++;
+
+        std::string result;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                break;
+            }
+            char escape = text_[pos_++];
+            switch (escape) {
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'u': appendUtf8(result, parseHex4()); break;
+                default: result += escape; break;
+            }
+        }
+        if (pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        pos_++;
+        return result;
+    }
+
+    uint32_t parseHex4() {
+        if (pos_ + 4 > text_.size()) {
+            fail("truncated unicode escape");
+        }
+        uint32_t code = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = text_[pos_++];
+            if (!isHexDigit(c)) {
+                fail("invalid unicode escape");
+            }
+            code = code * 16 + (isDigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        // Surrogate halves are kept as-is; schemas only use them in descriptions
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    double parseNumber() {
+        const char* start = text_.c_str() + pos_;
+        char* end = nullptr;
+        double number = std::strtod(start, &end);
+        if (end == start) {
+            fail("unexpected character");
+        }
+        pos_ += static_cast<size_t>(end - start);
+        return number;
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+};
+
+class SchemaCompiler {
+public:
+    SchemaCompiler(const JsonValue& document, std::vector<std::unique_ptr<JsonSchema::Node>>& nodes)
+        : document_(document), nodes_(nodes) {}
+
+    const JsonSchema::Node* compile(const JsonValue& value, int depth) {
+        if (depth > MAX_SCHEMA_DEPTH) {
+            throw std::runtime_error("schema references nested too deeply");
+        }
+        if (value.kind == JsonValue::Bool) {
+            // "true" accepts anything; "false" is not worth constraining towards
+            return any();
+        }
+        if (value.kind != JsonValue::Object) {
+            throw std::runtime_error("schema must be an object");
+        }
+
+        if (const JsonValue* ref = value.find("$ref")) {
+            return resolve(*ref, depth);
+        }
+        JsonSchema::Node* node = newNode();
+        fill(*node, value, depth);
+        return node;
+    }
+
+    const JsonSchema::Node* any() {
+        if (!any_) {
+            JsonSchema::Node* node = newNode();
+            node->items = node;
+            any_ = node;
+        }
+        return any_;
+    }
+
+private:
+    JsonSchema::Node* newNode() {
+        nodes_.push_back(std::make_unique<JsonSchema::Node>());
+        return nodes_.back().get();
+    }
+
+    // Only local references of the form #/definitions/Name or #/$defs/Name
+    const JsonSchema::Node* resolve(const JsonValue& ref, int depth) {
+        if (ref.kind != JsonValue::String) {
+            throw std::runtime_error("$ref must be a string");
+        }
+        auto known = refs_.find(ref.string);
+        if (known != refs_.end()) {
+            return known->second;
+        }
+
+        const JsonValue* target = nullptr;
+        for (const char* section : {"definitions", "$defs"}) {
+            std::string prefix = std::string("#/") + section + "/";
+            if (ref.string.compare(0, prefix.size(), prefix) == 0) {
+                const JsonValue* definitions = document_.find(section);
+                target = definitions ? definitions->find(ref.string.substr(prefix.size())) : nullptr;
+            }
+        }
+        if (!target || target->kind != JsonValue::Object) {
+            throw std::runtime_error("unresolved $ref " + ref.string);
+        }
+
+        // Registered before filling so recursive definitions terminate
+        JsonSchema::Node* node = newNode();
+        refs_[ref.string] = node;
+        fill(*node, *target, depth + 1);
+        return node;
+    }
+
+    static uint8_t typeBit(const JsonValue& name) {
+        static const std::pair<const char*, uint8_t> TYPES[] = {
+            {"object", JsonSchema::OBJECT},
+            {"array", JsonSchema::ARRAY},
+            {"string", JsonSchema::STRING},
+            {"number", JsonSchema::NUMBER},
+            {"integer", JsonSchema::INTEGER},
+            {"boolean", JsonSchema::BOOLEAN},
+            {"null", JsonSchema::NULL_VALUE},
+        };
+        if (name.kind == JsonValue::String) {
+            for (const auto& type : TYPES) {
+                if (name.string == type.first) {
+                    return type.second;
+                }
+            }
+        }
+        throw std::runtime_error("unknown type in schema");
+    }
+
+    static size_t sizeKeyword(const JsonValue& value, const char* keyword, size_t fallback) {
+        const JsonValue* bound = value.find(keyword);
+        if (!bound || bound->kind != JsonValue::Number || bound->number < 0) {
+            return fallback;
+        }
+        return static_cast<size_t>(bound->number);
+    }
+
+    void fill(JsonSchema::Node& node, const JsonValue& value, int depth) {
+        if (const JsonValue* type = value.find("type")) {
+            node.types = 0;
+            if (type->kind == JsonValue::Array) {
+                for (const auto& name : type->array) {
+                    node.types |= typeBit(name);
+                }
+            } else {
+                node.types = typeBit(*type);
+            }
+        }
+
+        // Non-string enums are rare in note schemas; such an enum is simply not enforced
+        if (const JsonValue* values = value.find("enum")) {
+            bool allStrings = values->kind == JsonValue::Array && !values->array.empty();
+            for (const auto& option : values->array) {
+                allStrings = allStrings && option.kind == JsonValue::String;
+            }
+            if (allStrings) {
+                for (const auto& option : values->array) {
+                    node.enumValues.push_back(option.string);
+                }
+                node.types = JsonSchema::STRING;
+            }
+        }
+
+        if (const JsonValue* properties = value.find("properties")) {
+            if (properties->object.size() > JsonSchema::MAX_PROPERTIES) {
+                throw std::runtime_error("too many properties in one object");
+            }
+            for (const auto& property : properties->object) {
+                node.properties.emplace_back(property.first, compile(property.second, depth + 1));
+            }
+        }
+        if (const JsonValue* required = value.find("required")) {
+            for (const auto& name : required->array) {
+                auto it = std::find_if(node.properties.begin(), node.properties.end(),
+                    [&](const std::pair<std::string, const JsonSchema::Node*>& property) {
+                        return name.kind == JsonValue::String && property.first == name.string;
+                    });
+                if (it == node.properties.end()) {
+                    throw std::runtime_error("required property is not declared");
+                }
+                node.requiredMask |= 1ULL << (it - node.properties.begin());
+            }
+        }
+        if (const JsonValue* additional = value.find("additionalProperties")) {
+            node.additionalProperties = additional->kind != JsonValue::Bool || additional->boolean;
+        }
+
+        const JsonValue* items = value.find("items");
+        node.items = (items && items->kind != JsonValue::Array) ? compile(*items, depth + 1) : any();
+        node.minItems = sizeKeyword(value, "minItems", 0);
+        node.maxItems = sizeKeyword(value, "maxItems", SIZE_MAX);
+        node.minLength = sizeKeyword(value, "minLength", 0);
+        node.maxLength = sizeKeyword(value, "maxLength", SIZE_MAX);
+    }
+
+    const JsonValue& document_;
+    std::vector<std::unique_ptr<JsonSchema::Node>>& nodes_;
+    std::map<std::string, const JsonSchema::Node*> refs_;
+    const JsonSchema::Node* any_ = nullptr;
+};
+
+} // namespace
+
+std::shared_ptr<const JsonSchema> compileJsonSchema(const std::string& schemaJson, std::string* error) {
+    try {
+        JsonValue document = JsonParser(schemaJson).parseDocument();
+        std::shared_ptr<JsonSchema> schema(new JsonSchema());
+        SchemaCompiler compiler(document, schema->nodes_);
+        schema->root_ = compiler.compile(document, 0);
+        schema->any_ = compiler.any();
+        return schema;
+    } catch (const std::exception& e) {
+        if (error) {
+            *error = e.what();
+        }
+        return nullptr;
+    }
+}
+
+JsonConstraint::JsonConstraint(std::shared_ptr<const JsonSchema> schema) : schema_(std::move(schema)) {
+    Frame root;
+    root.node = schema_->root();
+    stack_.push_back(std::move(root));
+}
+
+bool JsonConstraint::allows(std::string_view text) const {
+    JsonConstraint trial = *this;
+    for (char c : text) {
+        if (!trial.feed(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonConstraint::advance(std::string_view text) {
+    JsonConstraint trial = *this;
+    for (char c : text) {
+        if (!trial.feed(c)) {
+            return false;
+        }
+    }
+    *this = std::move(trial);
+    return true;
+}
+
+size_t JsonConstraint::allowedPrefix(std::string_view text) const {
+    JsonConstraint trial = *this;
+    size_t length = 0;
+    while (length < text.size() && trial.feed(text[length])) {
+        length++;
+    }
+    return length;
+}
+
+void JsonConstraint::popValue() {
+    stack_.pop_back();
+    complete_ = stack_.empty();
+}
+
+bool JsonConstraint::feed(char c) {
+    if (stack_.empty()) {
+        // Only whitespace may follow the document
+        return isSpace(c);
+    }
+
+    Frame& frame = stack_.back();
+    switch (frame.mode) {
+        case Mode::Value:
+            return isSpace(c) || beginValue(frame, c);
+
+        case Mode::ObjectStart:
+        case Mode::ObjectKey: {
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c == '}' && frame.mode == Mode::ObjectStart) {
+                if (frame.node->requiredMask & ~frame.seen) {
+                    return false;
+                }
+                popValue();
+                return true;
+            }
+            if (c != '"') {
+                return false;
+            }
+            // The name must be able to become some property that is allowed here
+            if (!frame.node->additionalProperties &&
+                !hasUnseenProperty(*frame.node, frame.seen, std::string())) {
+                return false;
+            }
+            Frame key;
+            key.mode = Mode::String;
+            key.node = frame.node;
+            key.seen = frame.seen;
+            key.isKey = true;
+            key.matchText = !frame.node->additionalProperties;
+            frame.mode = Mode::ObjectColon;
+            stack_.push_back(std::move(key));
+            return true;
+        }
+
+        case Mode::ObjectColon: {
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c != ':') {
+                return false;
+            }
+            Frame value;
+            value.node = frame.valueNode;
+            frame.mode = Mode::ObjectNext;
+            stack_.push_back(std::move(value));
+            return true;
+        }
+
+        case Mode::ObjectNext:
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c == ',') {
+                // No comma once every property this object may hold is present
+                if (!frame.node->additionalProperties && (declaredMask(*frame.node) & ~frame.seen) == 0) {
+                    return false;
+                }
+                frame.mode = Mode::ObjectKey;
+                return true;
+            }
+            if (c == '}' && (frame.node->requiredMask & ~frame.seen) == 0) {
+                popValue();
+                return true;
+            }
+            return false;
+
+        case Mode::ArrayStart:
+        case Mode::ArrayNext: {
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c == ']') {
+                if (frame.count < frame.node->minItems) {
+                    return false;
+                }
+                popValue();
+                return true;
+            }
+            bool first = frame.mode == Mode::ArrayStart;
+            if ((first ? false : c != ',') || frame.count >= frame.node->maxItems) {
+                return false;
+            }
+            frame.mode = Mode::ArrayNext;
+            frame.count++;
+            Frame item;
+            item.node = frame.node->items;
+            stack_.push_back(std::move(item));
+            // The first item starts at this character; later ones after the comma
+            return !first || feed(c);
+        }
+
+        case Mode::String:
+            return feedString(frame, c);
+
+        case Mode::Number:
+            return feedNumber(frame, c);
+
+        case Mode::Literal:
+            if (c != frame.text[frame.count]) {
+                return false;
+            }
+            if (++frame.count == frame.text.size()) {
+                popValue();
+            }
+            return true;
+    }
+    return false;
+}
+
+bool JsonConstraint::beginValue(Frame& frame, char c) {
+    const uint8_t types = frame.node->types;
+    if (c == '{' && (types & JsonSchema::OBJECT)) {
+        frame.mode = Mode::ObjectStart;
+        return true;
+    }
+    if (c == '[' && (types & JsonSchema::ARRAY)) {
+        frame.mode = Mode::ArrayStart;
+        return true;
+    }
+    if (c == '"' && (types & JsonSchema::STRING)) {
+        frame.mode = Mode::String;
+        frame.matchText = !frame.node->enumValues.empty();
+        return true;
+    }
+    if ((c == '-' || isDigit(c)) && (types & (JsonSchema::NUMBER | JsonSchema::INTEGER))) {
+        frame.mode = Mode::Number;
+        return feedNumber(frame, c);
+    }
+
+    const char* literal = nullptr;
+    if (types & JsonSchema::BOOLEAN) {
+        literal = c == 't' ? "true" : c == 'f' ? "false" : nullptr;
+    }
+    if (!literal && c == 'n' && (types & JsonSchema::NULL_VALUE)) {
+        literal = "null";
+    }
+    if (!literal) {
+        return false;
+    }
+    frame.mode = Mode::Literal;
+    frame.text = literal;
+    frame.count = 1;
+    return true;
+}
+
+// String states: 0 plain, 1 after a backslash, 2-5 reading \u hex digits
+bool JsonConstraint::feedString(Frame& frame, char c) {
+    const unsigned char byte = static_cast<unsigned char>(c);
+    if (frame.state == 1) {
+        if (c == 'u') {
+            frame.state = 2;
+            return true;
+        }
+        if (c == '\0' || !std::strchr("\"\\/bfnrt", c)) {
+            return false;
+        }
+        frame.state = 0;
+        frame.count++;
+        return frame.count <= frame.node->maxLength;
+    }
+    if (frame.state >= 2) {
+        if (!isHexDigit(c)) {
+            return false;
+        }
+        if (++frame.state == 6) {
+            frame.state = 0;
+            frame.count++;
+        }
+        return frame.count <= frame.node->maxLength;
+    }
+
+    if (c == '"') {
+        return finishString(frame);
+    }
+    if (c == '\\') {
+        // Keys and enum values must be spelled out so they can be matched as typed
+        if (frame.isKey || frame.matchText) {
+            return false;
+        }
+        frame.state = 1;
+        return true;
+    }
+    if (byte < 0x20) {
+        return false;
+    }
+
+    // Length counts code points, so continuation bytes are free
+    if ((byte & 0xC0) != 0x80) {
+        frame.count++;
+    }
+    if (frame.isKey) {
+        frame.text += c;
+        return !frame.matchText || hasUnseenProperty(*frame.node, frame.seen, frame.text);
+    }
+    if (frame.count > frame.node->maxLength) {
+        return false;
+    }
+    if (!frame.matchText) {
+        return true;
+    }
+    frame.text += c;
+    return std::any_of(frame.node->enumValues.begin(), frame.node->enumValues.end(),
+        [&](const std::string& option) { return startsWith(option, frame.text); });
+}
+
+bool JsonConstraint::finishString(Frame& frame) {
+    if (!frame.isKey) {
+        if (frame.count < frame.node->minLength) {
+            return false;
+        }
+        const auto& options = frame.node->enumValues;
+        if (frame.matchText && std::find(options.begin(), options.end(), frame.text) == options.end()) {
+            return false;
+        }
+        popValue();
+        return true;
+    }
+
+    const JsonSchema::Node& object = *frame.node;
+    const JsonSchema::Node* valueNode = nullptr;
+    uint64_t bit = 0;
+    for (size_t i = 0; i < object.properties.size(); i++) {
+        if (object.properties[i].first == frame.text) {
+            bit = 1ULL << i;
+            valueNode = object.properties[i].second;
+            break;
+        }
+    }
+    if (bit & frame.seen) {
+        return false;
+    }
+    if (!valueNode) {
+        if (!object.additionalProperties) {
+            return false;
+        }
+        valueNode = schema_->any();
+    }
+
+    stack_.pop_back();
+    Frame& parent = stack_.back();
+    parent.seen |= bit;
+    parent.valueNode = valueNode;
+    return true;
+}
+
+// Number states: 0 start, 1 after '-', 2 leading zero, 3 integer digits, 4 after '.',
+// 5 fraction digits, 6 after 'e', 7 after exponent sign, 8 exponent digits
+bool JsonConstraint::feedNumber(Frame& frame, char c) {
+    const bool integerOnly = !(frame.node->types & JsonSchema::NUMBER);
+    const bool digit = isDigit(c);
+    uint8_t next = 0xff;
+    switch (frame.state) {
+        case 0: next = c == '-' ? 1 : c == '0' ? 2 : digit ? 3 : 0xff; break;
+        case 1: next = c == '0' ? 2 : digit ? 3 : 0xff; break;
+        case 2:
+        case 3:
+            if (digit && frame.state == 3) {
+                next = 3;
+            } else if (c == '.' && !integerOnly) {
+                next = 4;
+            } else if ((c == 'e' || c == 'E') && !integerOnly) {
+                next = 6;
+            }
+            break;
+        case 4: next = digit ? 5 : 0xff; break;
+        case 5: next = digit ? 5 : (c == 'e' || c == 'E') ? 6 : 0xff; break;
+        case 6: next = (c == '+' || c == '-') ? 7 : digit ? 8 : 0xff; break;
+        case 7: next = digit ? 8 : 0xff; break;
+        case 8: next = digit ? 8 : 0xff; break;
+    }
+    if (next != 0xff) {
+        frame.state = next;
+        return true;
+    }
+
+    // The number ends at the first character that cannot extend it; that
+    // character belongs to the enclosing value. A bare number at the root
+    // never completes, which no note schema asks for.
+    const uint8_t state = frame.state;
+    if (state != 2 && state != 3 && state != 5 && state != 8) {
+        return false;
+    }
+    popValue();
+    return feed(c);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compiled form of a JSON Schema, as used to constrain generated output.
+// Supports the subset the encounter note schemas use: type (single or list),
+// properties, required, additionalProperties, items, minItems/maxItems,
+// minLength/maxLength, string enum, and $ref into #/definitions. Numeric
+// ranges and string patterns are left to the validator that checks the
+// finished document.
+class JsonSchema {
+public:
+    enum Type : uint8_t {
+        OBJECT = 1 << 0,
+        ARRAY = 1 << 1,
+        STRING = 1 << 2,
+        NUMBER = 1 << 3,
+        INTEGER = 1 << 4,
+        BOOLEAN = 1 << 5,
+        NULL_VALUE = 1 << 6,
+        ANY = 0x7f
+    };
+
+    // Objects track which properties they have seen in a 64-bit mask
+    static constexpr size_t MAX_PROPERTIES = 64;
+
+    struct Node {
+        uint8_t types = ANY;
+        std::vector<std::pair<std::string, const Node*>> properties;
+        uint64_t requiredMask = 0;
+        bool additionalProperties = true;
+        const Node* items = nullptr;
+        size_t minItems = 0;
+        size_t maxItems = SIZE_MAX;
+        size_t minLength = 0;
+        size_t maxLength = SIZE_MAX;
+        std::vector<std::string> enumValues;
+    };
+
+    const Node* root() const { return root_; }
+
+    // Node accepting any JSON value, used for undeclared properties and untyped items
+    const Node* any() const { return any_; }
+
+private:
+    friend std::shared_ptr<const JsonSchema> compileJsonSchema(const std::string&, std::string*);
+
+    JsonSchema() = default;
+
+    std::vector<std::unique_ptr<Node>> nodes_;
+    const Node* root_ = nullptr;
+    const Node* any_ = nullptr;
+};
+
+// Parses and compiles schemaJson. On failure returns nullptr and, if error
+// is non-null, describes why.
+std::shared_ptr<const JsonSchema> compileJsonSchema(const std::string& schemaJson, std::string* error = nullptr);
+
+// Incremental matcher for one generated document. The decoder asks whether
+// a candidate token keeps the output a valid prefix of some document the
+// schema accepts, masks the ones that do not, and stops once complete().
+// Matching is per character, so it is independent of the tokenizer.
+class JsonConstraint {
+public:
+    explicit JsonConstraint(std::shared_ptr<const JsonSchema> schema);
+
+    // True if appending text keeps the output a valid prefix; state is unchanged
+    bool allows(std::string_view text) const;
+
+    // Appends text if allowed and returns whether it was
+    bool advance(std::string_view text);
+
+    // Longest prefix of text that is allowed, in bytes
+    size_t allowedPrefix(std::string_view text) const;
+
+    // The root value has been closed
+    bool complete() const { return complete_; }
+
+private:
+    enum class Mode : uint8_t {
+        Value,
+        ObjectStart,
+        ObjectKey,
+        ObjectColon,
+        ObjectNext,
+        ArrayStart,
+        ArrayNext,
+        String,
+        Number,
+        Literal
+    };
+
+    struct Frame {
+        Mode mode = Mode::Value;
+        const JsonSchema::Node* node = nullptr;
+        // Object: properties seen so far and the node for the value being read
+        uint64_t seen = 0;
+        const JsonSchema::Node* valueNode = nullptr;
+        // Array: items started; String: characters read; Literal: bytes matched
+        size_t count = 0;
+        // String: text read so far when it must match a key or enum value.
+        // Literal: the expected spelling.
+        std::string text;
+        // String and Number: position in the token grammar
+        uint8_t state = 0;
+        bool isKey = false;
+        bool matchText = false;
+    };
+
+    bool feed(char c);
+    bool beginValue(Frame& frame, char c);
+    bool feedString(Frame& frame, char c);
+    bool feedNumber(Frame& frame, char c);
+    bool finishString(Frame& frame);
+    void popValue();
+
+    std::shared_ptr<const JsonSchema> schema_;
+    std::vector<Frame> stack_;
+    bool complete_ = false;
+};
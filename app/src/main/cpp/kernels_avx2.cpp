@@ -0,0 +1,83 @@
+// AVX2 + FMA variants, built with -mavx2 -mfma on x86 only and selected by
+// nativeKernels() when cpuid reports both
+
+#include "native_kernels.h"
+
+#include <immintrin.h>
+
+namespace {
+
+inline int32_t sumLanes(__m256i v) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// Eight int32 partial sums of one block pair
+inline __m256i dotBlockLanes(const int8_t* w, const int8_t* x) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x));
+    // maddubs wants one unsigned operand: move a's sign onto b. Pairs of
+    // products of values in +-127 cannot saturate int16.
+    const __m256i pairs = _mm256_maddubs_epi16(_mm256_sign_epi8(a, a), _mm256_sign_epi8(b, a));
+    return _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+}
+
+} // namespace
+
+float dotPcm16Avx2(const int16_t* x, const float* taps, size_t count) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i s0 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+        __m256i s1 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s0), _mm256_loadu_ps(taps + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s1), _mm256_loadu_ps(taps + i + 8), acc1);
+    }
+    if (i < count) {
+        __m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+        acc0 = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s), _mm256_loadu_ps(taps + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+void matmulQ8Avx2(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                  float* out) {
+    for (size_t c = 0; c < cols; c++) {
+        const BlockQ8* x = inputs + c * blocks;
+        size_t r = 0;
+        // Four rows at a time, one float lane per row so each keeps the
+        // scalar summation order
+        for (; r + 4 <= rows; r += 4) {
+            const BlockQ8* w0 = weights + r * blocks;
+            const BlockQ8* w1 = w0 + blocks;
+            const BlockQ8* w2 = w1 + blocks;
+            const BlockQ8* w3 = w2 + blocks;
+            __m128 sums = _mm_setzero_ps();
+            for (size_t b = 0; b < blocks; b++) {
+                __m256i d01 = _mm256_hadd_epi32(dotBlockLanes(w0[b].q, x[b].q), dotBlockLanes(w1[b].q, x[b].q));
+                __m256i d23 = _mm256_hadd_epi32(dotBlockLanes(w2[b].q, x[b].q), dotBlockLanes(w3[b].q, x[b].q));
+                __m256i d = _mm256_hadd_epi32(d01, d23);
+                __m128i dots = _mm_add_epi32(_mm256_castsi256_si128(d), _mm256_extracti128_si256(d, 1));
+                __m128 scales = _mm_mul_ps(_mm_setr_ps(w0[b].scale, w1[b].scale, w2[b].scale, w3[b].scale),
+                                           _mm_set1_ps(x[b].scale));
+                sums = _mm_add_ps(sums, _mm_mul_ps(scales, _mm_cvtepi32_ps(dots)));
+            }
+            _mm_storeu_ps(out + c * rows + r, sums);
+        }
+        for (; r < rows; r++) {
+            const BlockQ8* w = weights + r * blocks;
+            float sum = 0.0f;
+            for (size_t b = 0; b < blocks; b++) {
+                sum = sum + (w[b].scale * x[b].scale) * static_cast<float>(sumLanes(dotBlockLanes(w[b].q, x[b].q)));
+            }
+            out[c * rows + r] = sum;
+        }
+    }
+}
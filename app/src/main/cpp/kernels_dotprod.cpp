@@ -0,0 +1,50 @@
+// Armv8.2 dot product variants, built with +dotprod on arm64 only and
+// selected by nativeKernels() when AT_HWCAP reports asimddp
+
+#include "native_kernels.h"
+
+#include <arm_neon.h>
+
+namespace {
+
+// Four int32 partial sums of one block pair
+inline int32x4_t dotBlockLanes(const int8_t* w, const int8_t* x) {
+    int32x4_t acc = vdotq_s32(vdupq_n_s32(0), vld1q_s8(w), vld1q_s8(x));
+    return vdotq_s32(acc, vld1q_s8(w + 16), vld1q_s8(x + 16));
+}
+
+} // namespace
+
+void matmulQ8Dotprod(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                     float* out) {
+    for (size_t c = 0; c < cols; c++) {
+        const BlockQ8* x = inputs + c * blocks;
+        size_t r = 0;
+        // Four rows at a time, one float lane per row so each keeps the
+        // scalar summation order
+        for (; r + 4 <= rows; r += 4) {
+            const BlockQ8* w0 = weights + r * blocks;
+            const BlockQ8* w1 = w0 + blocks;
+            const BlockQ8* w2 = w1 + blocks;
+            const BlockQ8* w3 = w2 + blocks;
+            float32x4_t sums = vdupq_n_f32(0.0f);
+            for (size_t b = 0; b < blocks; b++) {
+                int32x4_t d01 = vpaddq_s32(dotBlockLanes(w0[b].q, x[b].q), dotBlockLanes(w1[b].q, x[b].q));
+                int32x4_t d23 = vpaddq_s32(dotBlockLanes(w2[b].q, x[b].q), dotBlockLanes(w3[b].q, x[b].q));
+                int32x4_t dots = vpaddq_s32(d01, d23);
+                const float row_scales[4] = {w0[b].scale, w1[b].scale, w2[b].scale, w3[b].scale};
+                float32x4_t scales = vmulq_f32(vld1q_f32(row_scales), vdupq_n_f32(x[b].scale));
+                sums = vaddq_f32(sums, vmulq_f32(scales, vcvtq_f32_s32(dots)));
+            }
+            vst1q_f32(out + c * rows + r, sums);
+        }
+        for (; r < rows; r++) {
+            const BlockQ8* w = weights + r * blocks;
+            float sum = 0.0f;
+            for (size_t b = 0; b < blocks; b++) {
+                sum = sum + (w[b].scale * x[b].scale) * static_cast<float>(vaddvq_s32(dotBlockLanes(w[b].q, x[b].q)));
+            }
+            out[c * rows + r] = sum;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+// Armv8.6 int8 matrix multiply variants, built with +dotprod+i8mm on arm64
+// only and selected by nativeKernels() when AT_HWCAP2 reports i8mm
+
+#include "native_kernels.h"
+
+#include <arm_neon.h>
+
+namespace {
+
+// Interleaves the 8-byte halves of two rows, the operand layout SMMLA reads
+inline int8x16_t zipLow(int8x16_t a, int8x16_t b) {
+    return vreinterpretq_s8_s64(vzip1q_s64(vreinterpretq_s64_s8(a), vreinterpretq_s64_s8(b)));
+}
+
+inline int8x16_t zipHigh(int8x16_t a, int8x16_t b) {
+    return vreinterpretq_s8_s64(vzip2q_s64(vreinterpretq_s64_s8(a), vreinterpretq_s64_s8(b)));
+}
+
+// One block of a 2x2 tile: lanes are {w0.x0, w0.x1, w1.x0, w1.x1}
+inline int32x4_t dotBlockTile(const int8_t* w0, const int8_t* w1, const int8_t* x0, const int8_t* x1) {
+    int32x4_t acc = vdupq_n_s32(0);
+    for (size_t i = 0; i < Q8_BLOCK; i += 16) {
+        int8x16_t a0 = vld1q_s8(w0 + i);
+        int8x16_t a1 = vld1q_s8(w1 + i);
+        int8x16_t b0 = vld1q_s8(x0 + i);
+        int8x16_t b1 = vld1q_s8(x1 + i);
+        acc = vmmlaq_s32(acc, zipLow(a0, a1), zipLow(b0, b1));
+        acc = vmmlaq_s32(acc, zipHigh(a0, a1), zipHigh(b0, b1));
+    }
+    return acc;
+}
+
+inline int32_t dotBlock(const int8_t* w, const int8_t* x) {
+    int32x4_t acc = vdotq_s32(vdupq_n_s32(0), vld1q_s8(w), vld1q_s8(x));
+    return vaddvq_s32(vdotq_s32(acc, vld1q_s8(w + 16), vld1q_s8(x + 16)));
+}
+
+// Odd rows and columns left over by the 2x2 tiles
+float dotRow(const BlockQ8* w, const BlockQ8* x, size_t blocks) {
+    float sum = 0.0f;
+    for (size_t b = 0; b < blocks; b++) {
+        sum = sum + (w[b].scale * x[b].scale) * static_cast<float>(dotBlock(w[b].q, x[b].q));
+    }
+    return sum;
+}
+
+} // namespace
+
+void matmulQ8I8mm(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                  float* out) {
+    const size_t tile_rows = rows & ~static_cast<size_t>(1);
+    const size_t tile_cols = cols & ~static_cast<size_t>(1);
+
+    for (size_t c = 0; c < tile_cols; c += 2) {
+        const BlockQ8* x0 = inputs + c * blocks;
+        const BlockQ8* x1 = x0 + blocks;
+        for (size_t r = 0; r < tile_rows; r += 2) {
+            const BlockQ8* w0 = weights + r * blocks;
+            const BlockQ8* w1 = w0 + blocks;
+            // One float lane per output, so each keeps the scalar summation order
+            float32x4_t sums = vdupq_n_f32(0.0f);
+            for (size_t b = 0; b < blocks; b++) {
+                int32x4_t dots = dotBlockTile(w0[b].q, w1[b].q, x0[b].q, x1[b].q);
+                const float tile_scales[4] = {w0[b].scale * x0[b].scale, w0[b].scale * x1[b].scale,
+                                              w1[b].scale * x0[b].scale, w1[b].scale * x1[b].scale};
+                sums = vaddq_f32(sums, vmulq_f32(vld1q_f32(tile_scales), vcvtq_f32_s32(dots)));
+            }
+            out[c * rows + r] = vgetq_lane_f32(sums, 0);
+            out[(c + 1) * rows + r] = vgetq_lane_f32(sums, 1);
+            out[c * rows + r + 1] = vgetq_lane_f32(sums, 2);
+            out[(c + 1) * rows + r + 1] = vgetq_lane_f32(sums, 3);
+        }
+        if (tile_rows < rows) {
+            const BlockQ8* w = weights + tile_rows * blocks;
+            out[c * rows + tile_rows] = dotRow(w, x0, blocks);
+            out[(c + 1) * rows + tile_rows] = dotRow(w, x1, blocks);
+        }
+    }
+    if (tile_cols < cols) {
+        const BlockQ8* x = inputs + tile_cols * blocks;
+        for (size_t r = 0; r < rows; r++) {
+            out[tile_cols * rows + r] = dotRow(weights + r * blocks, x, blocks);
+        }
+    }
+}
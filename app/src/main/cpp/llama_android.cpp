@@ -5,145 +5,109 @@
 #include <vector>
 #include <thread>
 #include <mutex>
-#include <fstream>
-#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include "compute_pool.h"
+#include "handle_registry.h"
+#include "json_constraint.h"
+#include "llm_core.h"
+#include "memory_pressure.h"
+#include "model_mapping.h"
+#include "model_variants.h"
+#include "native_kernels.h"
+#include "native_log.h"
+#include "native_metrics.h"
+#include "native_trace.h"
+#include "prefix_cache.h"
 
 #define TAG "LlamaAndroid"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+#define LOGD(...) AMBIENT_LOG_DEBUG(TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
-// Mock LLaMA context structure for now
-// In real implementation, would use actual llama.cpp structures
-struct MockLlamaContext {
-    std::string modelPath;
-    int contextLength;
-    float temperature;
-    float topP;
-    bool isLoaded = false;
-    std::mutex generateMutex;
-};
-
-// Global context storage
-static std::mutex contextsMutex;
-static std::vector<std::unique_ptr<MockLlamaContext>> contexts;
+// Global context storage; cleanup never frees a context a generation is still using
+static HandleRegistry<MockLlamaContext> contexts;
 
 // Helper to get context by handle
-static MockLlamaContext* getContext(jlong handle) {
-    std::lock_guard<std::mutex> lock(contextsMutex);
-    for (auto& ctx : contexts) {
-        if (reinterpret_cast<jlong>(ctx.get()) == handle) {
-            return ctx.get();
-        }
-    }
-    return nullptr;
+static std::shared_ptr<MockLlamaContext> getContext(jlong handle) {
+    return contexts.acquire(handle);
 }
 
-// Mock medical prompt responses for testing
-static const std::vector<std::string> mockResponses = {
-    R"({
-        "soap": {
-            "subjective": ["Patient complains of headache for 2 days", "No fever or nausea"],
-            "objective": ["Temperature 98.6°F", "Blood pressure 120/80 mmHg"],
-            "assessment": ["Tension headache", "Mild dehydration"],
-            "plan": ["Pain management", "Increase fluid intake"],
-            "confidence": 0.85
-        },
-        "prescription": {
-            "medications": [
-                {
-                    "name": "Acetaminophen",
-                    "dosage": "500mg",
-                    "frequency": "twice daily",
-                    "duration": "3 days",
-                    "instructions": "Take with food",
-                    "confidence": 0.9,
-                    "isGeneric": true
-                }
-            ],
-            "instructions": ["Rest and adequate hydration"],
-            "followUp": "Follow up if symptoms persist beyond 3 days",
-            "confidence": 0.8
-        }
-    })",
-    
-    R"({
-        "soap": {
-            "subjective": ["Cough and cold symptoms for 5 days", "Sore throat and nasal congestion"],
-            "objective": ["Temperature 100.2°F", "Throat appears red"],
-            "assessment": ["Upper respiratory tract infection", "Mild fever"],
-            "plan": ["Symptomatic treatment", "Rest and fluids"],
-            "confidence": 0.78
-        },
-        "prescription": {
-            "medications": [
-                {
-                    "name": "Amoxicillin",
-                    "dosage": "500mg",
-                    "frequency": "three times daily",
-                    "duration": "7 days",
-                    "instructions": "Complete full course",
-                    "confidence": 0.85,
-                    "isGeneric": true
-                },
-                {
-                    "name": "Paracetamol",
-                    "dosage": "650mg",
-                    "frequency": "every 6 hours",
-                    "duration": "as needed",
-                    "instructions": "For fever and pain",
-                    "confidence": 0.92,
-                    "isGeneric": true
-                }
-            ],
-            "instructions": ["Complete antibiotic course", "Maintain adequate hydration"],
-            "followUp": "Return if fever persists beyond 48 hours of treatment",
-            "confidence": 0.82
-        }
-    })"
-};
-
-// Mock generation based on simple keyword analysis
-static std::string generateMockResponse(const std::string& prompt) {
-    std::string lowerPrompt = prompt;
-    std::transform(lowerPrompt.begin(), lowerPrompt.end(), lowerPrompt.begin(), ::tolower);
-    
-    // Simple keyword matching for different medical scenarios
-    if (lowerPrompt.find("headache") != std::string::npos || 
-        lowerPrompt.find("head") != std::string::npos) {
-        return mockResponses[0];
-    } else if (lowerPrompt.find("cough") != std::string::npos || 
-               lowerPrompt.find("cold") != std::string::npos ||
-               lowerPrompt.find("fever") != std::string::npos) {
-        return mockResponses[1];
-    }
-    
-    // Default response for other cases
-    return mockResponses[0];
+static HandleRegistry<GenerationSession> generations;
+
+static jlong startGeneration(MockLlamaContext& context, std::string prompt, int priority, jlong handle) {
+    try {
+        auto session = std::make_shared<GenerationSession>();
+        session->prompt = std::move(prompt);
+        session->priority = priority;
+        
+        jlong generation = generations.add(session);
+        session->traceCookie = traceCookie(handle, static_cast<uint64_t>(generation));
+        context.scheduler->submit(std::move(session));
+        LOGI("Streaming generation %ld queued on context %ld, priority %d", generation, handle, priority);
+        return generation;
+        
+    } catch (const std::exception& e) {
+        LOGE("Failed to start generation: %s", e.what());
+        return 0;
+    }
 }
 
-// Validate model file exists and is readable
-static bool validateModelFile(const std::string& modelPath) {
-    std::ifstream file(modelPath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        LOGE("Cannot open model file: %s", modelPath.c_str());
-        return false;
+// Map the model file and check it is plausibly a model. Contexts on the same
+// file share one mapping, so re-initialising after an unload is page faults
+// against the page cache rather than a full read.
+static std::shared_ptr<const MappedModel> mapModel(const std::string& modelPath) {
+    std::string error;
+    std::shared_ptr<const MappedModel> mapped = mapModelFile(modelPath, &error);
+    if (!mapped) {
+        LOGE("Cannot map model file %s: %s", modelPath.c_str(), error.c_str());
+        return nullptr;
     }
     
-    auto size = file.tellg();
-    file.close();
+    if (mapped->size() < 1024 * 1024) { // At least 1MB for a valid model
+        LOGE("Model file too small: %zu bytes", mapped->size());
+        return nullptr;
+    }
     
-    if (size < 1024 * 1024) { // At least 1MB for a valid model
-        LOGE("Model file too small: %ld bytes", size);
-        return false;
+    LOGI("Model file mapped: %zu bytes, %zu model files mapped", mapped->size(), mappedModelCount());
+    return mapped;
+}
+
+// Saves the prefix cache and drops the registry's reference; the context is
+// destroyed once the last call using it returns
+static void releaseContext(jlong handle) {
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (context) {
+        std::lock_guard<std::mutex> lock(context->generateMutex);
+        if (!context->prefixCachePath.empty() && !context->prefixCache.save(context->prefixCachePath)) {
+            LOGE("Failed to save prefix cache to %s", context->prefixCachePath.c_str());
+        }
     }
     
-    LOGI("Model file validated: %ld bytes", size);
-    return true;
+    // Find and remove the context
+    if (contexts.remove(handle)) {
+        LOGI("Context cleaned up successfully");
+    } else {
+        LOGE("Context not found for cleanup");
+    }
 }
 
 extern "C" {
 
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void * /* reserved */) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    LOGI("Quantized matmul kernel: %s", nativeKernels().matmul_variant);
+    return JNI_VERSION_1_6;
+}
+
 JNIEXPORT jlong JNICALL
 Java_com_frozo_ambientscribe_ai_LLMService_nativeInitialize(
     JNIEnv *env,
@@ -162,16 +126,18 @@ Java_com_frozo_ambientscribe_ai_LLMService_nativeInitialize(
     LOGI("Context length: %d, temperature: %.2f, top_p: %.2f", 
          contextLength, temperature, topP);
     
-    // Validate model file
-    if (!validateModelFile(modelPath)) {
+    // Map and validate model file
+    std::shared_ptr<const MappedModel> weights = mapModel(modelPath);
+    if (!weights) {
         LOGE("Model validation failed");
         return 0;
     }
     
     try {
         // Create and initialize context
-        auto context = std::make_unique<MockLlamaContext>();
+        auto context = std::make_shared<MockLlamaContext>();
         context->modelPath = modelPath;
+        context->weights = std::move(weights);
         context->contextLength = contextLength;
         context->temperature = temperature;
         context->topP = topP;
@@ -179,14 +145,10 @@ Java_com_frozo_ambientscribe_ai_LLMService_nativeInitialize(
         // In real implementation, would load actual LLaMA model here
         // For now, just mark as loaded for testing
         context->isLoaded = true;
-        
-        jlong handle = reinterpret_cast<jlong>(context.get());
+        context->scheduler = std::make_unique<GenerationScheduler>(*context);
         
         // Store context globally
-        {
-            std::lock_guard<std::mutex> lock(contextsMutex);
-            contexts.push_back(std::move(context));
-        }
+        jlong handle = contexts.add(std::move(context));
         
         LOGI("LLaMA context initialized successfully, handle: %ld", handle);
         return handle;
@@ -197,6 +159,127 @@ Java_com_frozo_ambientscribe_ai_LLMService_nativeInitialize(
     }
 }
 
+// Per path: [bits per weight, weight bytes, footprint bytes, expected tokens/sec].
+// Weight bytes are 0 for a variant that is not on disk.
+JNIEXPORT jdoubleArray JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeDescribeVariants(
+    JNIEnv *env,
+    jobject /* this */,
+    jobjectArray jPaths,
+    jint contextLength) {
+    
+    const jsize count = env->GetArrayLength(jPaths);
+    std::vector<jdouble> values;
+    values.reserve(static_cast<size_t>(count) * 4);
+    for (jsize i = 0; i < count; i++) {
+        auto jPath = static_cast<jstring>(env->GetObjectArrayElement(jPaths, i));
+        const char* pathCStr = env->GetStringUTFChars(jPath, nullptr);
+        std::string path(pathCStr);
+        env->ReleaseStringUTFChars(jPath, pathCStr);
+        env->DeleteLocalRef(jPath);
+        
+        ModelVariantInfo info = describeModelVariant(path, KV_BYTES_PER_TOKEN * std::max(contextLength, 0));
+        values.push_back(info.bitsPerWeight);
+        values.push_back(static_cast<jdouble>(info.weightBytes));
+        values.push_back(static_cast<jdouble>(info.footprintBytes));
+        values.push_back(info.tokensPerSecond);
+        LOGD("Variant %s: %.1f bits/weight, %llu bytes, %.1f tokens/s", path.c_str(), info.bitsPerWeight,
+             static_cast<unsigned long long>(info.footprintBytes), info.tokensPerSecond);
+    }
+    
+    jdoubleArray result = env->NewDoubleArray(static_cast<jsize>(values.size()));
+    if (result) {
+        env->SetDoubleArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    return result;
+}
+
+// Replaces the context's weights with another variant of the same model.
+// Queued and running generations continue: the scheduler re-prefills
+// running sequences against the new weights before their next token.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeSwapModel(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jModelPath) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context for model swap");
+        return JNI_FALSE;
+    }
+    
+    const char* modelPathCStr = env->GetStringUTFChars(jModelPath, nullptr);
+    std::string modelPath(modelPathCStr);
+    env->ReleaseStringUTFChars(jModelPath, modelPathCStr);
+    
+    // Map outside the lock so decoding continues on the old weights meanwhile
+    std::shared_ptr<const MappedModel> weights = mapModel(modelPath);
+    if (!weights) {
+        return JNI_FALSE;
+    }
+    
+    std::shared_ptr<const MappedModel> previous;
+    {
+        std::lock_guard<std::mutex> lock(context->generateMutex);
+        // Cached prefixes were evaluated by the old weights. Persist them for
+        // that model; the caller points the cache at the new model's file.
+        if (!context->prefixCachePath.empty()) {
+            context->prefixCache.save(context->prefixCachePath);
+            context->prefixCachePath.clear();
+        }
+        context->prefixCache.clear();
+        
+        previous = std::move(context->weights);
+        context->weights = std::move(weights);
+        context->modelPath = modelPath;
+        context->weightsVersion++;
+    }
+    
+    LOGI("Context %ld swapped from %s to %s", handle,
+         previous ? previous->path().c_str() : "(none)", modelPath.c_str());
+    // previous is unmapped here, outside the lock, unless another context shares it
+    return JNI_TRUE;
+}
+
+// Reconfigures a live context without reloading the model, so thermal
+// throttling costs a parameter change instead of a model load. Values <= 0
+// leave a parameter unchanged. The thread count resizes the compute pool
+// shared with ASR and never grows past the performance cores; the context
+// length and batch size apply to requests admitted from now on.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeUpdateParameters(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jint threadCount,
+    jint contextLength,
+    jint batchSize) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context for parameter update");
+        return JNI_FALSE;
+    }
+    
+    if (threadCount > 0) {
+        ComputePool& pool = ComputePool::shared();
+        pool.resize(std::min(static_cast<size_t>(threadCount), pool.defaultThreadCount()));
+    }
+    if (contextLength > 0) {
+        // In real implementation, would resize the KV cache, keeping cached sequences that still fit
+        context->contextLength.store(contextLength);
+    }
+    if (batchSize > 0) {
+        context->maxSequences.store(std::min(static_cast<size_t>(batchSize), GenerationScheduler::MAX_SEQUENCES));
+    }
+    
+    LOGI("Context %ld reconfigured: %zu threads, context length %d, batch size %zu", handle,
+         ComputePool::shared().threadCount(), context->contextLength.load(), context->maxSequences.load());
+    return JNI_TRUE;
+}
+
 JNIEXPORT jstring JNICALL
 Java_com_frozo_ambientscribe_ai_LLMService_nativeGenerate(
     JNIEnv *env,
@@ -204,7 +287,7 @@ Java_com_frozo_ambientscribe_ai_LLMService_nativeGenerate(
     jlong handle,
     jstring jPrompt) {
     
-    MockLlamaContext* context = getContext(handle);
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
     if (!context || !context->isLoaded) {
         LOGE("Invalid context or model not loaded");
         return nullptr;
@@ -217,19 +300,25 @@ Java_com_frozo_ambientscribe_ai_LLMService_nativeGenerate(
     
     LOGI("Generating response for prompt length: %zu", prompt.length());
     
-    std::lock_guard<std::mutex> lock(context->generateMutex);
-    
     try {
-        // Simulate processing time (real LLM would take longer)
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // Runs through the scheduler like streaming requests, so concurrent
+        // blocking calls share decode steps instead of queuing on the context
+        auto session = std::make_shared<GenerationSession>();
+        session->prompt = std::move(prompt);
+        session->traceCookie = traceCookie(handle, reinterpret_cast<uintptr_t>(session.get()));
+        context->scheduler->submit(session);
         
-        // Generate mock response based on prompt content
-        std::string response = generateMockResponse(prompt);
+        std::unique_lock<std::mutex> lock(session->mutex);
+        session->tokensReady.wait(lock, [&] { return session->finished; });
+        if (session->failed || session->cancelled.load()) {
+            LOGE("Generation did not complete");
+            return nullptr;
+        }
         
-        LOGI("Generated response length: %zu", response.length());
+        LOGI("Generated response length: %zu", session->pending.length());
         
         // Return response as Java string
-        return env->NewStringUTF(response.c_str());
+        return env->NewStringUTF(session->pending.c_str());
         
     } catch (const std::exception& e) {
         LOGE("Generation failed: %s", e.what());
@@ -237,28 +326,485 @@ Java_com_frozo_ambientscribe_ai_LLMService_nativeGenerate(
     }
 }
 
+JNIEXPORT jlong JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeStartGeneration(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jPrompt,
+    jint priority) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context or model not loaded");
+        return 0;
+    }
+    
+    std::string prompt;
+    {
+        StageTimer timer(MetricStage::JNI_MARSHAL);
+        const char* promptCStr = env->GetStringUTFChars(jPrompt, nullptr);
+        prompt = promptCStr;
+        env->ReleaseStringUTFChars(jPrompt, promptCStr);
+    }
+    
+    return startGeneration(*context, std::move(prompt), priority, handle);
+}
+
+// Returns the text decoded since the last poll, waiting up to timeoutMs for
+// some to arrive ("" on timeout), or null once generation has ended and
+// everything has been drained.
+JNIEXPORT jstring JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativePollTokens(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong generation,
+    jint timeoutMs) {
+    
+    std::shared_ptr<GenerationSession> session = generations.acquire(generation);
+    if (!session) {
+        LOGE("Invalid generation handle: %ld", generation);
+        return nullptr;
+    }
+    
+    TRACE_SECTION("llm.poll_tokens");
+    std::string batch;
+    {
+        std::unique_lock<std::mutex> lock(session->mutex);
+        session->tokensReady.wait_for(lock, std::chrono::milliseconds(std::max(0, timeoutMs)),
+            [&] { return !session->pending.empty() || session->finished; });
+        if (session->pending.empty() && session->finished) {
+            return nullptr;
+        }
+        batch.swap(session->pending);
+    }
+    StageTimer timer(MetricStage::RESULT_BUILD);
+    return env->NewStringUTF(batch.c_str());
+}
+
 JNIEXPORT void JNICALL
-Java_com_frozo_ambientscribe_ai_LLMService_nativeCleanup(
+Java_com_frozo_ambientscribe_ai_LLMService_nativeCancelGeneration(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong generation) {
+    
+    std::shared_ptr<GenerationSession> session = generations.acquire(generation);
+    if (session) {
+        // The scheduler stops the sequence before its next token
+        session->cancelled.store(true);
+    }
+}
+
+// Cancels the generation if still running and frees the handle. Returns true
+// if generation ran to completion without error.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeReleaseGeneration(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong generation) {
+    
+    std::shared_ptr<GenerationSession> session = generations.acquire(generation);
+    if (!session) {
+        LOGE("Invalid generation handle: %ld", generation);
+        return JNI_FALSE;
+    }
+    generations.remove(generation);
+    
+    bool completed;
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        completed = session->finished && !session->failed && !session->cancelled.load();
+    }
+    if (!completed) {
+        // The scheduler holds its own reference and drops the request at its next step
+        session->cancelled.store(true);
+    }
+    return completed ? JNI_TRUE : JNI_FALSE;
+}
+
+// Starts accumulating a prompt for incremental generation, discarding any
+// previous one. preamble is the fixed system prompt and template.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeBeginIncremental(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jPreamble) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context or model not loaded");
+        return JNI_FALSE;
+    }
+    
+    const char* preambleCStr = env->GetStringUTFChars(jPreamble, nullptr);
+    std::string preamble(preambleCStr);
+    env->ReleaseStringUTFChars(jPreamble, preambleCStr);
+    
+    try {
+        auto incremental = std::make_unique<IncrementalPrompt>();
+        incremental->text = std::move(preamble);
+        incremental->worker = std::thread(runIncrementalPrefill, context.get(), incremental.get());
+        
+        std::unique_ptr<IncrementalPrompt> previous;
+        {
+            std::lock_guard<std::mutex> lock(context->incrementalMutex);
+            previous = std::move(context->incremental);
+            context->incremental = std::move(incremental);
+        }
+        // previous (if any) stops and joins here, outside the lock
+        return JNI_TRUE;
+        
+    } catch (const std::exception& e) {
+        LOGE("Failed to begin incremental prompt: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+// Appends a finalized transcript chunk to the incremental prompt
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeAppendIncremental(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jText) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context) {
+        return JNI_FALSE;
+    }
+    
+    std::string text;
+    {
+        StageTimer timer(MetricStage::JNI_MARSHAL);
+        const char* textCStr = env->GetStringUTFChars(jText, nullptr);
+        text = textCStr;
+        env->ReleaseStringUTFChars(jText, textCStr);
+    }
+    
+    std::lock_guard<std::mutex> lock(context->incrementalMutex);
+    IncrementalPrompt* incremental = context->incremental.get();
+    if (!incremental) {
+        LOGE("No incremental prompt on context %ld", handle);
+        return JNI_FALSE;
+    }
+    {
+        std::lock_guard<std::mutex> textLock(incremental->mutex);
+        // Chunks arrive without separators; keep words from fusing across chunk boundaries
+        if (!incremental->text.empty() && !std::isspace(static_cast<unsigned char>(incremental->text.back())) &&
+            !text.empty() && !std::isspace(static_cast<unsigned char>(text.front()))) {
+            incremental->text += ' ';
+        }
+        incremental->text += text;
+    }
+    incremental->changed.notify_one();
+    return JNI_TRUE;
+}
+
+// Ends the incremental prompt and starts streaming generation of the
+// accumulated prompt plus instruction. Most of it is already in the prefix
+// cache, so prefill only covers what arrived in the last moments and the
+// instruction. Returns a generation handle for nativePollTokens.
+JNIEXPORT jlong JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeFinishIncremental(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jInstruction,
+    jint priority) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context or model not loaded");
+        return 0;
+    }
+    
+    std::unique_ptr<IncrementalPrompt> incremental;
+    {
+        std::lock_guard<std::mutex> lock(context->incrementalMutex);
+        incremental = std::move(context->incremental);
+    }
+    if (!incremental) {
+        LOGE("No incremental prompt on context %ld", handle);
+        return 0;
+    }
+    
+    std::string prompt;
+    {
+        std::lock_guard<std::mutex> lock(incremental->mutex);
+        prompt = incremental->text;
+    }
+    // Stops the background worker, waiting at most one prefill slice
+    incremental.reset();
+    
+    const char* instructionCStr = env->GetStringUTFChars(jInstruction, nullptr);
+    prompt += instructionCStr;
+    env->ReleaseStringUTFChars(jInstruction, instructionCStr);
+    
+    return startGeneration(*context, std::move(prompt), priority, handle);
+}
+
+// Discards the incremental prompt without generating
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeAbortIncremental(
     JNIEnv *env,
     jobject /* this */,
     jlong handle) {
     
-    LOGI("Cleaning up LLaMA context: %ld", handle);
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (context) {
+        std::unique_ptr<IncrementalPrompt> incremental;
+        {
+            std::lock_guard<std::mutex> lock(context->incrementalMutex);
+            incremental = std::move(context->incremental);
+        }
+    }
+}
+
+// Enables saving the prefix cache to path on cleanup, loading any cache
+// already there; a null path turns persistence off
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeSetPrefixCachePath(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jPath) {
     
-    std::lock_guard<std::mutex> lock(contextsMutex);
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context) {
+        LOGE("Invalid context for prefix cache");
+        return JNI_FALSE;
+    }
     
-    // Find and remove the context
-    auto it = std::find_if(contexts.begin(), contexts.end(),
-        [handle](const std::unique_ptr<MockLlamaContext>& ctx) {
-            return reinterpret_cast<jlong>(ctx.get()) == handle;
-        });
+    std::string path;
+    if (jPath) {
+        const char* pathCStr = env->GetStringUTFChars(jPath, nullptr);
+        path = pathCStr;
+        env->ReleaseStringUTFChars(jPath, pathCStr);
+    }
     
-    if (it != contexts.end()) {
-        contexts.erase(it);
-        LOGI("Context cleaned up successfully");
-    } else {
-        LOGE("Context not found for cleanup");
+    std::lock_guard<std::mutex> lock(context->generateMutex);
+    context->prefixCachePath = path;
+    if (!path.empty() && context->prefixCache.load(path)) {
+        LOGI("Loaded %zu prefix cache entries from %s", context->prefixCache.size(), path.c_str());
     }
+    return JNI_TRUE;
+}
+
+// Constrains every later generation on the context to documents matching
+// the JSON schema; null removes the constraint
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeSetOutputSchema(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jSchema) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context) {
+        LOGE("Invalid context for output schema");
+        return JNI_FALSE;
+    }
+    
+    std::shared_ptr<const JsonSchema> schema;
+    if (jSchema) {
+        const char* schemaCStr = env->GetStringUTFChars(jSchema, nullptr);
+        std::string schemaJson = schemaCStr;
+        env->ReleaseStringUTFChars(jSchema, schemaCStr);
+        
+        std::string error;
+        schema = compileJsonSchema(schemaJson, &error);
+        if (!schema) {
+            LOGE("Invalid output schema: %s", error.c_str());
+            return JNI_FALSE;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(context->generateMutex);
+    context->outputSchema = std::move(schema);
+    LOGI("Output schema %s for context %ld", context->outputSchema ? "set" : "cleared", handle);
+    return JNI_TRUE;
+}
+
+// Loads a small draft model for speculative decoding, or unloads it when
+// the path is null. The draft must share the main model's tokenizer and be
+// smaller than it; draftTokens is how many tokens it proposes per step.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeLoadDraftModel(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jstring jDraftPath,
+    jint draftTokens) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context for draft model");
+        return JNI_FALSE;
+    }
+    
+    std::shared_ptr<const MappedModel> draft;
+    if (jDraftPath) {
+        if (draftTokens <= 0 || static_cast<size_t>(draftTokens) > GenerationScheduler::MAX_DRAFT_TOKENS) {
+            LOGE("Draft length %d outside 1..%zu", draftTokens, GenerationScheduler::MAX_DRAFT_TOKENS);
+            return JNI_FALSE;
+        }
+        const char* draftPathCStr = env->GetStringUTFChars(jDraftPath, nullptr);
+        std::string draftPath(draftPathCStr);
+        env->ReleaseStringUTFChars(jDraftPath, draftPathCStr);
+        
+        // Map outside the lock so decoding continues meanwhile
+        draft = mapModel(draftPath);
+        if (!draft) {
+            return JNI_FALSE;
+        }
+    }
+    
+    std::shared_ptr<const MappedModel> previous;
+    {
+        std::lock_guard<std::mutex> lock(context->generateMutex);
+        if (draft && context->weights && draft->size() >= context->weights->size()) {
+            LOGE("Draft model (%zu bytes) is not smaller than the main model (%zu bytes)",
+                 draft->size(), context->weights->size());
+            return JNI_FALSE;
+        }
+        previous = std::move(context->draftWeights);
+        context->draftWeights = std::move(draft);
+        context->speculativeTokens = context->draftWeights ? static_cast<size_t>(draftTokens) : 0;
+    }
+    
+    LOGI("Speculative decoding %s for context %ld, %zu draft tokens per step",
+         context->speculativeTokens ? "enabled" : "disabled", handle, context->speculativeTokens);
+    return JNI_TRUE;
+}
+
+// Offloads the main model's first `layers` layers to backend (LayerOffload::AUTO
+// for the device's preferred delegate, 0 for the CPU); applies from the next pass
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeSetOffload(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jint backend,
+    jint layers) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context for offload");
+        return JNI_FALSE;
+    }
+    if (!context->offload.configure(backend, layers)) {
+        LOGE("Offload of %d layers to backend %d unavailable", layers, backend);
+        return JNI_FALSE;
+    }
+    
+    OffloadStats stats = context->offload.stats();
+    LOGI("Context %ld offloads %d of %d layers to backend %d", handle, stats.layers, LLAMA_LAYERS,
+         static_cast<int>(stats.backend));
+    return JNI_TRUE;
+}
+
+// [backend, offloaded layers, offloaded passes, CPU passes, delegate failures]
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeGetOffloadStats(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context) {
+        return nullptr;
+    }
+    
+    OffloadStats stats = context->offload.stats();
+    jlong values[5] = {
+        static_cast<jlong>(stats.backend),
+        static_cast<jlong>(stats.layers),
+        static_cast<jlong>(stats.offloaded_passes),
+        static_cast<jlong>(stats.cpu_passes),
+        static_cast<jlong>(stats.failures)
+    };
+    jlongArray result = env->NewLongArray(5);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// Scheduler counters: [queue depth, active sequences, completed requests,
+// admitted requests, total queue wait us, max queue wait us, generated
+// tokens, decode steps, drafted tokens, accepted draft tokens]
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeGetSchedulerStats(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle) {
+    
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->scheduler) {
+        return nullptr;
+    }
+    
+    SchedulerStats stats = context->scheduler->stats();
+    jlong values[10] = {
+        static_cast<jlong>(stats.queueDepth),
+        static_cast<jlong>(stats.activeSequences),
+        static_cast<jlong>(stats.completedRequests),
+        static_cast<jlong>(stats.admittedRequests),
+        static_cast<jlong>(stats.totalWaitUs),
+        static_cast<jlong>(stats.maxWaitUs),
+        static_cast<jlong>(stats.generatedTokens),
+        static_cast<jlong>(stats.decodeSteps),
+        static_cast<jlong>(stats.draftedTokens),
+        static_cast<jlong>(stats.acceptedTokens)
+    };
+    jlongArray result = env->NewLongArray(10);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 10, values);
+    }
+    return result;
+}
+
+// Frees memory at level (MemoryPressure values) and returns the bytes
+// reclaimed. Below CRITICAL the context stays loaded in a degraded state;
+// CRITICAL also releases it as nativeCleanup does, invalidating the handle.
+JNIEXPORT jlong JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeTrimMemory(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle,
+    jint level) {
+    
+    if (level < static_cast<jint>(MemoryPressure::MODERATE) || level > static_cast<jint>(MemoryPressure::CRITICAL)) {
+        LOGE("Unknown memory pressure level %d", level);
+        return 0;
+    }
+    std::shared_ptr<MockLlamaContext> context = getContext(handle);
+    if (!context || !context->isLoaded) {
+        LOGE("Invalid context for memory trim");
+        return 0;
+    }
+    
+    const MemoryPressure pressure = static_cast<MemoryPressure>(level);
+    const uint64_t reclaimed = trimContextMemory(*context, pressure);
+    LOGI("Context %ld trimmed at pressure %d: %llu bytes reclaimed", handle, level,
+         static_cast<unsigned long long>(reclaimed));
+    
+    if (pressure == MemoryPressure::CRITICAL) {
+        context.reset();
+        releaseContext(handle);
+    }
+    return static_cast<jlong>(reclaimed);
+}
+
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_ai_LLMService_nativeCleanup(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong handle) {
+    
+    LOGI("Cleaning up LLaMA context: %ld", handle);
+    releaseContext(handle);
 }
 
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include "llm_core.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "compute_pool.h"
+#include "native_log.h"
+#include "native_metrics.h"
+#include "native_trace.h"
+
+#define TAG "LlamaAndroid"
+#define LOGD(...) AMBIENT_LOG_DEBUG(TAG, __VA_ARGS__)
+#define LOGE(...) AMBIENT_LOG_ERROR(TAG, __VA_ARGS__)
+
+// Simulated prompt evaluation cost per token not covered by the prefix cache
+static constexpr int PREFILL_US_PER_TOKEN = 200;
+
+// Simulated cost of one batched decode step, whatever the number of sequences
+static constexpr int DECODE_STEP_US = 300;
+
+// Speculative decoding: one step of the draft model, and the extra cost of
+// each drafted position in the main model's verifying decode. Decode is
+// memory-bound, so scoring a few more positions per sequence is cheap.
+static constexpr int DRAFT_STEP_US = 40;
+static constexpr int VERIFY_US_PER_TOKEN = 20;
+
+// Mock draft quality: the draft misses one in this many free-text tokens
+static constexpr uint32_t DRAFT_MISS_PERIOD = 4;
+
+// Background prefill works in slices of this many tokens, releasing the
+// context in between so a foreground generation never waits long
+static constexpr size_t PREFILL_SLICE_TOKENS = 64;
+
+// Same niceness as Android's THREAD_PRIORITY_BACKGROUND
+static constexpr int BACKGROUND_NICE = 10;
+
+// Simulated evaluation work, split across the compute pool shared with ASR.
+// In real implementation, the pool would run llama's per-thread matmul shards.
+static void runMockCompute(int64_t totalUs, TaskPriority priority) {
+    if (totalUs <= 0) {
+        return;
+    }
+    ComputePool& pool = ComputePool::shared();
+    const size_t shards = pool.threadCount();
+    pool.parallelFor(shards, [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::microseconds(totalUs / static_cast<int64_t>(shards)));
+    }, priority);
+}
+
+// A pass of the main model: its offloaded layers on the context's delegate,
+// the rest split across the pool as above
+static void runModelLayers(MockLlamaContext& context, int64_t totalUs, TaskPriority priority) {
+    context.offload.run(totalUs, [priority](int64_t cpuUs) { runMockCompute(cpuUs, priority); });
+}
+
+// Mock medical prompt responses for testing
+static const std::vector<std::string> mockResponses = {
+    R"({
+        "version": "1.0",
+        "timestamp": 0,
+        "soap": {
+            "subjective": ["Patient complains of headache for 2 days", "No fever or nausea"],
+            "objective": ["Temperature 98.6°F", "Blood pressure 120/80 mmHg"],
+            "assessment": ["Tension headache", "Mild dehydration"],
+            "plan": ["Pain management", "Increase fluid intake"],
+            "confidence": 0.85
+        },
+        "prescription": {
+            "medications": [
+                {
+                    "name": "Acetaminophen",
+                    "dosage": "500mg",
+                    "frequency": "twice daily",
+                    "duration": "3 days",
+                    "instructions": "Take with food",
+                    "confidence": 0.9,
+                    "isGeneric": true
+                }
+            ],
+            "instructions": ["Rest and adequate hydration"],
+            "followUp": "Follow up if symptoms persist beyond 3 days",
+            "confidence": 0.8
+        },
+        "metadata": {
+            "speakerTurns": 0,
+            "totalDuration": 0,
+            "processingTime": 0,
+            "modelVersion": "mock-llama-1.1b-q4",
+            "fallbackUsed": false,
+            "encounterId": "",
+            "patientId": ""
+        }
+    })",
+    
+    R"({
+        "version": "1.0",
+        "timestamp": 0,
+        "soap": {
+            "subjective": ["Cough and cold symptoms for 5 days", "Sore throat and nasal congestion"],
+            "objective": ["Temperature 100.2°F", "Throat appears red"],
+            "assessment": ["Upper respiratory tract infection", "Mild fever"],
+            "plan": ["Symptomatic treatment", "Rest and fluids"],
+            "confidence": 0.78
+        },
+        "prescription": {
+            "medications": [
+                {
+                    "name": "Amoxicillin",
+                    "dosage": "500mg",
+                    "frequency": "three times daily",
+                    "duration": "7 days",
+                    "instructions": "Complete full course",
+                    "confidence": 0.85,
+                    "isGeneric": true
+                },
+                {
+                    "name": "Paracetamol",
+                    "dosage": "650mg",
+                    "frequency": "every 6 hours",
+                    "duration": "as needed",
+                    "instructions": "For fever and pain",
+                    "confidence": 0.92,
+                    "isGeneric": true
+                }
+            ],
+            "instructions": ["Complete antibiotic course", "Maintain adequate hydration"],
+            "followUp": "Return if fever persists beyond 48 hours of treatment",
+            "confidence": 0.82
+        },
+        "metadata": {
+            "speakerTurns": 0,
+            "totalDuration": 0,
+            "processingTime": 0,
+            "modelVersion": "mock-llama-1.1b-q4",
+            "fallbackUsed": false,
+            "encounterId": "",
+            "patientId": ""
+        }
+    })"
+};
+
+// Mock generation based on simple keyword analysis
+static std::string generateMockResponse(const std::string& prompt) {
+    std::string lowerPrompt = prompt;
+    std::transform(lowerPrompt.begin(), lowerPrompt.end(), lowerPrompt.begin(), ::tolower);
+    
+    // Simple keyword matching for different medical scenarios
+    if (lowerPrompt.find("headache") != std::string::npos || 
+        lowerPrompt.find("head") != std::string::npos) {
+        return mockResponses[0];
+    } else if (lowerPrompt.find("cough") != std::string::npos || 
+               lowerPrompt.find("cold") != std::string::npos ||
+               lowerPrompt.find("fever") != std::string::npos) {
+        return mockResponses[1];
+    }
+    
+    // Default response for other cases
+    return mockResponses[0];
+}
+
+// Mock tokenizer: a token is a run of non-space characters plus the whitespace after it
+static std::vector<std::string> splitMockTokens(const std::string& text) {
+    std::vector<std::string> tokens;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find_first_of(" \n\t", start);
+        end = (end == std::string::npos) ? text.size() : text.find_first_not_of(" \n\t", end);
+        end = (end == std::string::npos) ? text.size() : end;
+        tokens.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return tokens;
+}
+
+// Mock tokenizer ids: a stable hash of each token's text
+static std::vector<int32_t> tokenizeMock(const std::string& text) {
+    std::vector<int32_t> ids;
+    for (const auto& token : splitMockTokens(text)) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : token) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        ids.push_back(static_cast<int32_t>(hash & 0x7fffffff));
+    }
+    return ids;
+}
+
+// Mock draft model. A small model reproduces the note template - keys,
+// punctuation, literals - and most of the free text, but not all of it;
+// which free-text tokens it misses is a stable hash of token and position.
+static bool draftAgrees(const std::string& token, size_t position) {
+    size_t end = token.find_last_not_of(" \n\t");
+    const bool key = end != std::string::npos && end > 0 && token[end] == ':' && token[end - 1] == '"';
+    const bool structural = std::none_of(token.begin(), token.end(),
+        [](unsigned char c) { return std::isalpha(c); });
+    if (key || structural) {
+        return true;
+    }
+    uint32_t hash = 2166136261u ^ static_cast<uint32_t>(position);
+    for (unsigned char c : token) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash % DRAFT_MISS_PERIOD != 0;
+}
+
+// Evaluates the prompt, resuming from the longest cached prefix. Caller holds generateMutex.
+static void prefillPrompt(MockLlamaContext& context, const std::string& prompt) {
+    StageTimer timer(MetricStage::ENCODE);
+    std::vector<int32_t> tokens = tokenizeMock(prompt);
+    size_t reused = context.prefixCache.longestPrefix(tokens);
+    size_t evaluated = tokens.size() - reused;
+    
+    // In real implementation, would restore the cached KV state and decode only the remaining tokens
+    runModelLayers(context, static_cast<int64_t>(evaluated) * PREFILL_US_PER_TOKEN, TaskPriority::NORMAL);
+    context.prefixCache.store(tokens);
+    
+    LOGD("Prefill: %zu prompt tokens, %zu reused from prefix cache", tokens.size(), reused);
+}
+
+static void finishSession(GenerationSession& session, bool failed) {
+    TRACE_ASYNC_END("llm.generation", session.traceCookie);
+    std::lock_guard<std::mutex> lock(session.mutex);
+    session.failed = failed;
+    session.finished = true;
+    session.tokensReady.notify_all();
+}
+
+GenerationScheduler::GenerationScheduler(MockLlamaContext& context)
+    : context(context), worker(&GenerationScheduler::run, this) {}
+
+GenerationScheduler::~GenerationScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    worker.join();
+    
+    // Nothing decodes for this context any more; wake anyone still polling
+    for (auto& session : waiting) {
+        session->cancelled.store(true);
+        finishSession(*session, false);
+    }
+    for (auto& sequence : active) {
+        sequence.session->cancelled.store(true);
+        finishSession(*sequence.session, false);
+    }
+}
+
+void GenerationScheduler::submit(std::shared_ptr<GenerationSession> session) {
+    session->enqueued = std::chrono::steady_clock::now();
+    TRACE_ASYNC_BEGIN("llm.generation", session->traceCookie);
+    TRACE_ASYNC_BEGIN("llm.queued", session->traceCookie);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting.push_back(std::move(session));
+    }
+    workAvailable.notify_one();
+}
+
+SchedulerStats GenerationScheduler::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    SchedulerStats snapshot = totals;
+    snapshot.queueDepth = waiting.size();
+    snapshot.activeSequences = activeCount.load();
+    return snapshot;
+}
+
+// Caller holds mutex
+std::shared_ptr<GenerationSession> GenerationScheduler::takeNextWaiting() {
+    auto best = waiting.end();
+    for (auto it = waiting.begin(); it != waiting.end(); ++it) {
+        // waiting is in arrival order, so strict > keeps FIFO within a priority
+        if (best == waiting.end() || (*it)->priority > (*best)->priority) {
+            best = it;
+        }
+    }
+    std::shared_ptr<GenerationSession> session = std::move(*best);
+    waiting.erase(best);
+    return session;
+}
+
+void GenerationScheduler::run() {
+    while (true) {
+        std::vector<std::shared_ptr<GenerationSession>> admitted;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&] { return stopping || !waiting.empty() || !active.empty(); });
+            if (stopping) {
+                return;
+            }
+            
+            // Requests cancelled while queued never take a slot
+            waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+                [](const std::shared_ptr<GenerationSession>& session) {
+                    if (session->cancelled.load()) {
+                        TRACE_ASYNC_END("llm.queued", session->traceCookie);
+                        finishSession(*session, false);
+                        return true;
+                    }
+                    return false;
+                }), waiting.end());
+            
+            // A smaller batch size lets running sequences finish; none are evicted
+            const size_t slots = context.maxSequences.load();
+            while (active.size() + admitted.size() < slots && !waiting.empty()) {
+                std::shared_ptr<GenerationSession> session = takeNextWaiting();
+                TRACE_ASYNC_END("llm.queued", session->traceCookie);
+                uint64_t waitUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - session->enqueued).count();
+                totals.admittedRequests++;
+                totals.totalWaitUs += waitUs;
+                totals.maxWaitUs = std::max(totals.maxWaitUs, waitUs);
+                admitted.push_back(std::move(session));
+            }
+            TRACE_COUNTER("llm.queue_depth", static_cast<int64_t>(waiting.size()));
+        }
+        
+        std::lock_guard<std::mutex> contextLock(context.generateMutex);
+        TRACE_SECTION("llm.step");
+        
+        // New sequences join the batch after their prompt is evaluated
+        for (auto& session : admitted) {
+            try {
+                const int contextLength = context.contextLength.load();
+                if (contextLength > 0 && tokenizeMock(session->prompt).size() >= static_cast<size_t>(contextLength)) {
+                    throw std::length_error("prompt does not fit the context");
+                }
+                prefillPrompt(context, session->prompt);
+                Sequence sequence;
+                sequence.session = session;
+                sequence.tokens = splitMockTokens(generateMockResponse(session->prompt));
+                if (context.outputSchema) {
+                    sequence.constraint = std::make_unique<JsonConstraint>(context.outputSchema);
+                }
+                sequence.weightsVersion = context.weightsVersion;
+                active.push_back(std::move(sequence));
+            } catch (const std::exception& e) {
+                LOGE("Prefill failed: %s", e.what());
+                finishSession(*session, true);
+            }
+        }
+        
+        // After a variant swap the old KV state is meaningless; rebuild it
+        // from the prompt and everything emitted so far, then carry on
+        for (auto& sequence : active) {
+            if (sequence.weightsVersion != context.weightsVersion) {
+                std::string text = sequence.session->prompt;
+                for (size_t i = 0; i < sequence.next; i++) {
+                    text += sequence.tokens[i];
+                }
+                prefillPrompt(context, text);
+                sequence.weightsVersion = context.weightsVersion;
+            }
+        }
+        activeCount.store(active.size());
+        TRACE_COUNTER("llm.active_sequences", static_cast<int64_t>(active.size()));
+        if (active.empty()) {
+            continue;
+        }
+        
+        // In real implementation, draftTokens llama_decode calls on the draft
+        // context, each batched across sequences like the main decode
+        const size_t draftTokens = context.draftWeights ? context.speculativeTokens : 0;
+        if (draftTokens > 0) {
+            StageTimer timer(MetricStage::DRAFT);
+            runMockCompute(static_cast<int64_t>(draftTokens) * DRAFT_STEP_US, TaskPriority::NORMAL);
+        }
+        
+        // In real implementation, one llama_decode over a batch holding the next
+        // token of every sequence, followed by its drafted tokens when speculating
+        {
+            StageTimer timer(MetricStage::DECODE);
+            runModelLayers(context, DECODE_STEP_US + static_cast<int64_t>(draftTokens) * VERIFY_US_PER_TOKEN,
+                           TaskPriority::NORMAL);
+        }
+        
+        size_t completed = 0;
+        uint64_t generated = 0;
+        uint64_t drafted = 0;
+        uint64_t accepted = 0;
+        for (auto it = active.begin(); it != active.end();) {
+            GenerationSession& session = *it->session;
+            bool done = session.cancelled.load(std::memory_order_relaxed);
+            bool failed = false;
+            if (!done && it->next >= it->tokens.size()) {
+                // Running out before a constrained document closes is truncated output
+                done = true;
+                failed = it->constraint && !it->constraint->complete();
+            }
+            if (!done) {
+                StageTimer timer(MetricStage::TOKEN_SAMPLING);
+                // The verifying decode gives the main model's token at every
+                // drafted position: keep the drafts it agrees with up to the first
+                // miss, then its own token there, so one step emits 1..k+1 tokens
+                const size_t remaining = it->tokens.size() - it->next;
+                const size_t proposed = std::min(draftTokens, remaining);
+                size_t agreed = 0;
+                while (agreed < proposed && draftAgrees(it->tokens[it->next + agreed], it->next + agreed)) {
+                    agreed++;
+                }
+                drafted += proposed;
+                accepted += agreed;
+                
+                std::string text;
+                const size_t emit = std::min(agreed + 1, remaining);
+                for (size_t i = 0; i < emit && !done; i++) {
+                    std::string token = it->tokens[it->next++];
+                    if (it->constraint) {
+                        // In real implementation, tokens the constraint rejects get -inf
+                        // logits before sampling, in the draft as well as the main model.
+                        // The mock proposes a single candidate, so keep the longest part
+                        // of it the schema allows.
+                        token.resize(it->constraint->allowedPrefix(token));
+                        it->constraint->advance(token);
+                        // Stop at the closing brace rather than decoding to the token limit
+                        done = it->constraint->complete() || token.empty();
+                        failed = token.empty();
+                    }
+                    text += token;
+                    generated += !token.empty();
+                }
+                if (!text.empty()) {
+                    std::lock_guard<std::mutex> lock(session.mutex);
+                    session.pending += text;
+                    session.tokensReady.notify_one();
+                }
+            }
+            if (done) {
+                finishSession(session, failed);
+                it = active.erase(it);
+                completed++;
+            } else {
+                ++it;
+            }
+        }
+        activeCount.store(active.size());
+        TRACE_COUNTER("llm.active_sequences", static_cast<int64_t>(active.size()));
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            totals.completedRequests += completed;
+            totals.generatedTokens += generated;
+            totals.decodeSteps++;
+            totals.draftedTokens += drafted;
+            totals.acceptedTokens += accepted;
+        }
+    }
+}
+
+// Background worker for an IncrementalPrompt: whenever the transcript grows,
+// evaluate its new tokens slice by slice and record them in the prefix cache.
+// The last token is held back because the next delta may still extend it.
+void runIncrementalPrefill(MockLlamaContext* context, IncrementalPrompt* incremental) {
+    setpriority(PRIO_PROCESS, gettid(), BACKGROUND_NICE);
+    
+    size_t seenBytes = 0;
+    size_t prefilled = 0;
+    while (true) {
+        std::string snapshot;
+        {
+            std::unique_lock<std::mutex> lock(incremental->mutex);
+            incremental->changed.wait(lock, [&] { return incremental->stop || incremental->text.size() != seenBytes; });
+            if (incremental->stop) {
+                return;
+            }
+            snapshot = incremental->text;
+            seenBytes = snapshot.size();
+        }
+        
+        std::vector<int32_t> tokens = tokenizeMock(snapshot);
+        const size_t stable = tokens.empty() ? 0 : tokens.size() - 1;
+        while (prefilled < stable) {
+            std::lock_guard<std::mutex> contextLock(context->generateMutex);
+            {
+                std::lock_guard<std::mutex> lock(incremental->mutex);
+                if (incremental->stop) {
+                    return;
+                }
+            }
+            
+            std::vector<int32_t> prefix(tokens.begin(), tokens.begin() + std::min(stable, prefilled + PREFILL_SLICE_TOKENS));
+            size_t start = std::max(prefilled, context->prefixCache.longestPrefix(prefix));
+            StageTimer timer(MetricStage::ENCODE);
+            runModelLayers(*context, static_cast<int64_t>(prefix.size() - start) * PREFILL_US_PER_TOKEN, TaskPriority::LOW);
+            context->prefixCache.store(prefix);
+            prefilled = prefix.size();
+        }
+        LOGD("Incremental prefill: %zu of %zu tokens evaluated", prefilled, tokens.size());
+    }
+}
+
+uint64_t trimContextMemory(MockLlamaContext& context, MemoryPressure level) {
+    uint64_t reclaimed = 0;
+    std::shared_ptr<const MappedModel> draft;
+    {
+        std::lock_guard<std::mutex> lock(context.generateMutex);
+        // Persist before evicting, so a restart still resumes warm
+        if (!context.prefixCachePath.empty() && !context.prefixCache.save(context.prefixCachePath)) {
+            LOGE("Failed to save prefix cache to %s", context.prefixCachePath.c_str());
+        }
+        // In real implementation, would free the evicted entries' KV state and
+        // defragment the cells of finished sequences
+        const size_t keep = level == MemoryPressure::MODERATE ? context.prefixCache.size() / 2 : 0;
+        reclaimed += context.prefixCache.shrink(keep) * KV_BYTES_PER_TOKEN;
+        
+        if (level != MemoryPressure::MODERATE) {
+            draft = std::move(context.draftWeights);
+            context.speculativeTokens = 0;
+            if (context.weights) {
+                reclaimed += context.weights->dontNeed();
+            }
+        }
+    }
+    // The draft is unmapped here, outside the lock, unless another context shares it
+    if (draft) {
+        reclaimed += draft->dontNeed();
+    }
+    LOGD("Trimmed context at pressure %d: %llu bytes reclaimed", static_cast<int>(level),
+         static_cast<unsigned long long>(reclaimed));
+    return reclaimed;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compute_backend.h"
+#include "json_constraint.h"
+#include "memory_pressure.h"
+#include "model_mapping.h"
+#include "prefix_cache.h"
+
+// LLM generation core: contexts, the batched scheduler and background
+// prefill. Free of JNI so it also builds into the host benchmark.
+
+// Transcript accumulated while a call is still running. A background worker
+// pre-fills it into the context's prefix cache at low priority, so when the
+// call ends only the closing instruction is left to evaluate.
+struct IncrementalPrompt {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::string text;
+    bool stop = false;
+    
+    std::thread worker;
+    
+    ~IncrementalPrompt() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
+
+// One generation request. The context's scheduler decodes into pending; the
+// JVM drains pending in batches with pollTokens() so a token never costs a
+// JNI upcall.
+struct GenerationSession {
+    std::string prompt;
+    int priority = 0;
+    std::chrono::steady_clock::time_point enqueued;
+    
+    std::mutex mutex;
+    std::condition_variable tokensReady;
+    std::string pending;
+    bool finished = false;
+    bool failed = false;
+    std::atomic<bool> cancelled{false};
+    // Keys the session's async trace slices
+    int32_t traceCookie = 0;
+};
+
+struct SchedulerStats {
+    size_t queueDepth = 0;
+    size_t activeSequences = 0;
+    uint64_t completedRequests = 0;
+    uint64_t admittedRequests = 0;
+    uint64_t totalWaitUs = 0;
+    uint64_t maxWaitUs = 0;
+    // Tokens emitted over all batched decode steps; their ratio is the
+    // speculative speedup, 1.0 when no draft model is loaded
+    uint64_t generatedTokens = 0;
+    uint64_t decodeSteps = 0;
+    // Tokens the draft model proposed and how many the main model kept
+    uint64_t draftedTokens = 0;
+    uint64_t acceptedTokens = 0;
+};
+
+struct MockLlamaContext;
+
+// Serves every generation on one context from a single decode thread. Each
+// step admits waiting requests into free sequence slots (highest priority
+// first, then FIFO), prefills them, and then advances every active sequence
+// by one token in a single batched decode. Decode is memory-bound, so a step
+// costs about the same for one sequence as for MAX_SEQUENCES, and concurrent
+// requests overlap instead of queuing behind each other.
+//
+// With a draft model loaded the step is speculative: the draft proposes up
+// to speculativeTokens tokens per sequence, the main model scores all of
+// them in the same single batched decode, and each sequence keeps the
+// proposals up to the first disagreement plus the main model's own token
+// there. Output is identical to plain decoding; it only arrives in fewer steps.
+class GenerationScheduler {
+public:
+    static constexpr size_t MAX_SEQUENCES = 4;
+    static constexpr size_t MAX_DRAFT_TOKENS = 8;
+    
+    explicit GenerationScheduler(MockLlamaContext& context);
+    ~GenerationScheduler();
+    
+    void submit(std::shared_ptr<GenerationSession> session);
+    SchedulerStats stats();
+    
+private:
+    struct Sequence {
+        std::shared_ptr<GenerationSession> session;
+        std::vector<std::string> tokens;
+        size_t next = 0;
+        // Set when the context has an output schema
+        std::unique_ptr<JsonConstraint> constraint;
+        // Weights the sequence's KV state was built with
+        uint32_t weightsVersion = 0;
+    };
+    
+    void run();
+    std::shared_ptr<GenerationSession> takeNextWaiting();
+    
+    MockLlamaContext& context;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::vector<std::shared_ptr<GenerationSession>> waiting;
+    std::vector<Sequence> active; // decode thread only
+    std::atomic<size_t> activeCount{0};
+    SchedulerStats totals;
+    bool stopping = false;
+    
+    std::thread worker; // started last, once every other member exists
+};
+
+// Transformer layers of the 1.1B model
+constexpr int LLAMA_LAYERS = 22;
+
+// Mock LLaMA context structure for now
+// In real implementation, would use actual llama.cpp structures
+struct MockLlamaContext {
+    std::string modelPath;
+    std::shared_ptr<const MappedModel> weights;
+    // Bumped under generateMutex whenever weights are swapped
+    uint32_t weightsVersion = 0;
+    // Reconfigured in place by nativeUpdateParameters; read when a request is admitted
+    std::atomic<int> contextLength{0};
+    std::atomic<size_t> maxSequences{GenerationScheduler::MAX_SEQUENCES};
+    float temperature;
+    float topP;
+    bool isLoaded = false;
+    std::mutex generateMutex;
+    
+    // Guarded by generateMutex; saved to prefixCachePath on cleanup when set
+    PrefixCache prefixCache;
+    std::string prefixCachePath;
+    
+    // Guarded by generateMutex; when set, every generation is decoded under it
+    std::shared_ptr<const JsonSchema> outputSchema;
+    
+    // Guarded by generateMutex; a small model sharing the main model's
+    // tokenizer. Decoding is speculative while it is set and
+    // speculativeTokens is non-zero.
+    std::shared_ptr<const MappedModel> draftWeights;
+    size_t speculativeTokens = 0;
+    
+    // Where the main model's layers run; prefill and decode go through it,
+    // the draft model always stays on the CPU
+    LayerOffload offload{ModelRole::DECODER, LLAMA_LAYERS};
+    
+    // Declared after the state they use so their threads are joined before
+    // the rest of the context goes away
+    std::unique_ptr<GenerationScheduler> scheduler;
+    std::mutex incrementalMutex;
+    std::unique_ptr<IncrementalPrompt> incremental;
+};
+
+// KV cache per context token for the 1.1B model: 22 layers x (K + V) x 256 f16 values
+constexpr uint64_t KV_BYTES_PER_TOKEN = LLAMA_LAYERS * 2 * 256 * 2;
+
+// Background worker for a context's IncrementalPrompt; returns once the prompt is stopped
+void runIncrementalPrefill(MockLlamaContext* context, IncrementalPrompt* incremental);
+
+// Frees what the context can spare at level while it stays loaded, and
+// returns the bytes reclaimed. Generations in flight carry on, slower: they
+// re-evaluate prompts the cache no longer covers, decode without the draft
+// model and fault weights back in. CRITICAL trims like HIGH; releasing the
+// context itself is up to the caller.
+uint64_t trimContextMemory(MockLlamaContext& context, MemoryPressure level);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// How hard a native trim reclaims; values match MemoryPressure in Kotlin,
+// which maps onTrimMemory levels onto them. Each level also does everything
+// the levels below it do.
+enum class MemoryPressure : int32_t {
+    // Drop cached state that is cheap to rebuild: prefix KV entries, spare
+    // arena capacity
+    MODERATE = 1,
+    // Also drop resident model pages (refaulted from the file on next use)
+    // and optional models such as the speculative draft
+    HIGH = 2,
+    // Also release the model itself
+    CRITICAL = 3,
+};
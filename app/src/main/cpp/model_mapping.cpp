@@ -0,0 +1,131 @@
+#include "model_mapping.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Header bytes prefetched on map; model formats keep their metadata up front
+constexpr size_t HEADER_PREFETCH_BYTES = 64 * 1024;
+
+struct FileKey {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    time_t mtime;
+
+    bool operator<(const FileKey& other) const {
+        return std::tie(device, inode, size, mtime) <
+               std::tie(other.device, other.inode, other.size, other.mtime);
+    }
+};
+
+std::mutex g_cache_mutex;
+std::map<FileKey, std::weak_ptr<const MappedModel>> g_cache;
+
+void setError(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // namespace
+
+MappedModel::~MappedModel() {
+    munmap(address_, size_);
+}
+
+void MappedModel::willNeed(size_t offset, size_t length) const {
+    if (offset >= size_) {
+        return;
+    }
+    // madvise needs a page-aligned start
+    size_t start = offset & ~(pageSize() - 1);
+    size_t end = std::min(size_, offset + length);
+    madvise(static_cast<uint8_t*>(address_) + start, end - start, MADV_WILLNEED);
+}
+
+size_t MappedModel::residentBytes() const {
+    const size_t page = pageSize();
+    std::vector<unsigned char> pages((size_ + page - 1) / page);
+    if (mincore(address_, size_, pages.data()) != 0) {
+        return 0;
+    }
+    size_t resident = 0;
+    for (unsigned char flags : pages) {
+        resident += flags & 1;
+    }
+    return std::min(size_, resident * page);
+}
+
+size_t MappedModel::dontNeed() const {
+    const size_t resident = residentBytes();
+    madvise(address_, size_, MADV_DONTNEED);
+    return resident;
+}
+
+std::shared_ptr<const MappedModel> mapModelFile(const std::string& path, std::string* error) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        setError(error, "open failed: " + std::string(strerror(errno)));
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        setError(error, "not a non-empty regular file");
+        close(fd);
+        return nullptr;
+    }
+
+    const FileKey key{st.st_dev, st.st_ino, st.st_size, st.st_mtime};
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+
+    auto it = g_cache.find(key);
+    if (it != g_cache.end()) {
+        if (auto shared = it->second.lock()) {
+            close(fd);
+            return shared;
+        }
+        g_cache.erase(it);
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (address == MAP_FAILED) {
+        setError(error, "mmap failed: " + std::string(strerror(errno)));
+        return nullptr;
+    }
+
+    std::shared_ptr<const MappedModel> mapped(new MappedModel(path, address, size));
+    mapped->willNeed(0, HEADER_PREFETCH_BYTES);
+    g_cache[key] = mapped;
+    return mapped;
+}
+
+size_t mappedModelCount() {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    size_t count = 0;
+    for (const auto& entry : g_cache) {
+        if (!entry.second.expired()) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+// Read-only MAP_PRIVATE view of a model file. Pages are faulted in on first
+// touch rather than read up front, and stay in the page cache after unmap,
+// so re-initialising a released model is mostly minor faults.
+class MappedModel {
+public:
+    MappedModel(const MappedModel&) = delete;
+    MappedModel& operator=(const MappedModel&) = delete;
+    ~MappedModel();
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(address_); }
+    size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+    // Prefetch a byte range the caller is about to read (e.g. a header or the first layers)
+    void willNeed(size_t offset, size_t length) const;
+
+    // Bytes of the file currently in memory. The mapping is file-backed, so
+    // this counts page-cache pages whether or not this process touched them.
+    size_t residentBytes() const;
+
+    // Let the kernel drop resident pages; they are re-read from the file on
+    // next touch. Returns the bytes resident beforehand, an upper bound on
+    // the memory this process gives back.
+    size_t dontNeed() const;
+
+private:
+    friend std::shared_ptr<const MappedModel> mapModelFile(const std::string&, std::string*);
+
+    MappedModel(std::string path, void* address, size_t size)
+        : path_(std::move(path)), address_(address), size_(size) {}
+
+    std::string path_;
+    void* address_;
+    size_t size_;
+};
+
+// Maps path, or returns the mapping another holder already has open for the
+// same file. Files are keyed by device, inode, size and mtime, so two paths
+// to one file share a mapping and a replaced file gets a fresh one. The
+// mapping is unmapped when the last returned pointer is released.
+// On failure returns nullptr and, if error is non-null, describes why.
+std::shared_ptr<const MappedModel> mapModelFile(const std::string& path, std::string* error = nullptr);
+
+// Number of distinct files currently mapped through mapModelFile
+size_t mappedModelCount();
@@ -0,0 +1,116 @@
+#include "model_variants.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace {
+
+// Large enough to defeat the last-level cache on current phones
+constexpr size_t BANDWIDTH_PROBE_BYTES = 16 * 1024 * 1024;
+constexpr int BANDWIDTH_PROBE_ROUNDS = 3;
+
+// Name tags per quantization, most specific first so "q8" never matches inside "int8"
+const std::pair<const char*, Quantization> QUANTIZATION_TAGS[] = {
+    {"int8", Quantization::INT8},
+    {"fp16", Quantization::F16},
+    {"f16", Quantization::F16},
+    {"q8", Quantization::Q8},
+    {"q5", Quantization::Q5},
+    {"q4", Quantization::Q4},
+};
+
+bool isBoundary(const std::string& name, size_t index) {
+    return index >= name.size() || !std::isalnum(static_cast<unsigned char>(name[index]));
+}
+
+} // namespace
+
+Quantization quantizationFromName(const std::string& path) {
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    for (const auto& tag : QUANTIZATION_TAGS) {
+        const size_t length = std::strlen(tag.first);
+        for (size_t at = name.find(tag.first); at != std::string::npos; at = name.find(tag.first, at + 1)) {
+            if ((at == 0 || isBoundary(name, at - 1)) && isBoundary(name, at + length)) {
+                return tag.second;
+            }
+        }
+    }
+    return Quantization::UNKNOWN;
+}
+
+float bitsPerWeight(Quantization quantization) {
+    switch (quantization) {
+        case Quantization::Q4: return 4.5f;
+        case Quantization::Q5: return 5.5f;
+        case Quantization::Q8: return 8.5f;
+        case Quantization::INT8: return 8.0f;
+        case Quantization::F16: return 16.0f;
+        case Quantization::UNKNOWN: break;
+    }
+    return 0.0f;
+}
+
+uint64_t modelFileBytes(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        return S_ISREG(st.st_mode) ? static_cast<uint64_t>(st.st_size) : 0;
+    }
+
+    uint64_t total = 0;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return 0;
+    }
+    while (dirent* entry = readdir(dir)) {
+        std::string file = path + "/" + entry->d_name;
+        if (stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            total += static_cast<uint64_t>(st.st_size);
+        }
+    }
+    closedir(dir);
+    return total;
+}
+
+double memoryBandwidthBytesPerSecond() {
+    static const double bandwidth = [] {
+        std::vector<uint8_t> source(BANDWIDTH_PROBE_BYTES, 1);
+        std::vector<uint8_t> target(BANDWIDTH_PROBE_BYTES);
+        double best = 0.0;
+        for (int round = 0; round < BANDWIDTH_PROBE_ROUNDS; round++) {
+            auto start = std::chrono::steady_clock::now();
+            std::memcpy(target.data(), source.data(), BANDWIDTH_PROBE_BYTES);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            // A copy reads and writes every byte
+            if (elapsed.count() > 0) {
+                best = std::max(best, 2.0 * BANDWIDTH_PROBE_BYTES / elapsed.count());
+            }
+            // Read the copy back so it cannot be optimised away
+            source[round] = target[BANDWIDTH_PROBE_BYTES - 1 - round];
+        }
+        return best;
+    }();
+    return bandwidth;
+}
+
+ModelVariantInfo describeModelVariant(const std::string& path, uint64_t runtimeBytes) {
+    ModelVariantInfo info;
+    info.quantization = quantizationFromName(path);
+    info.bitsPerWeight = bitsPerWeight(info.quantization);
+    info.weightBytes = modelFileBytes(path);
+    if (info.weightBytes == 0) {
+        return info;
+    }
+    info.footprintBytes = info.weightBytes + runtimeBytes;
+    info.tokensPerSecond = memoryBandwidthBytesPerSecond() / static_cast<double>(info.weightBytes);
+    return info;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Quantization of a model variant, taken from the tag in its file or
+// directory name (e.g. llama_1.1b_q5.bin, whisper-tiny-int8)
+enum class Quantization {
+    UNKNOWN,
+    Q4,
+    Q5,
+    Q8,
+    INT8,
+    F16
+};
+
+// Load-time estimate for one variant, reported to the JVM so the variant
+// can be chosen against the device's memory and speed budget
+struct ModelVariantInfo {
+    Quantization quantization = Quantization::UNKNOWN;
+    float bitsPerWeight = 0.0f;
+    // Size of the weight files; 0 when the variant is not on disk
+    uint64_t weightBytes = 0;
+    // Weights plus the runtime state the caller expects to allocate
+    uint64_t footprintBytes = 0;
+    double tokensPerSecond = 0.0;
+};
+
+Quantization quantizationFromName(const std::string& path);
+
+// Storage cost per weight including block scales (e.g. q4_0 is 18 bytes per 32 weights)
+float bitsPerWeight(Quantization quantization);
+
+// Size of the model file, or of every non-empty file in the model directory
+uint64_t modelFileBytes(const std::string& path);
+
+// Sustained memory copy bandwidth, measured once per process. Decoding a
+// token streams every weight once, so it bounds decode speed.
+double memoryBandwidthBytesPerSecond();
+
+// Describes path without mapping it. runtimeBytes is the KV cache or
+// activation memory the caller would allocate for its context size.
+ModelVariantInfo describeModelVariant(const std::string& path, uint64_t runtimeBytes);
@@ -0,0 +1,143 @@
+#include "native_kernels.h"
+
+#include "cpu_features.h"
+#include "pcm_convert.h"
+
+namespace {
+
+#if defined(PCM_CONVERT_NEON)
+constexpr const char* BASELINE_VARIANT = "neon";
+#elif defined(PCM_CONVERT_SSE2)
+constexpr const char* BASELINE_VARIANT = "sse2";
+#else
+constexpr const char* BASELINE_VARIANT = "scalar";
+#endif
+
+// Integer dot product of one block pair
+inline int32_t dotBlockQ8(const int8_t* w, const int8_t* x) {
+#if defined(PCM_CONVERT_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (size_t i = 0; i < Q8_BLOCK; i += 16) {
+        int8x16_t a = vld1q_s8(w + i);
+        int8x16_t b = vld1q_s8(x + i);
+        // Two products of values in +-127 fit int16
+        int16x8_t pairs = vmull_s8(vget_low_s8(a), vget_low_s8(b));
+        pairs = vmlal_s8(pairs, vget_high_s8(a), vget_high_s8(b));
+        acc = vpadalq_s16(acc, pairs);
+    }
+#if defined(__aarch64__)
+    return vaddvq_s32(acc);
+#else
+    int32x2_t pair = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    return vget_lane_s32(vpadd_s32(pair, pair), 0);
+#endif
+#elif defined(PCM_CONVERT_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (size_t i = 0; i < Q8_BLOCK; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        // Sign-extend to int16 by duplicating each byte and shifting back down
+        __m128i a_lo = _mm_srai_epi16(_mm_unpacklo_epi8(a, a), 8);
+        __m128i a_hi = _mm_srai_epi16(_mm_unpackhi_epi8(a, a), 8);
+        __m128i b_lo = _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8);
+        __m128i b_hi = _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a_lo, b_lo));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a_hi, b_hi));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    int32_t dot = 0;
+    for (size_t i = 0; i < Q8_BLOCK; i++) {
+        dot += static_cast<int32_t>(w[i]) * x[i];
+    }
+    return dot;
+#endif
+}
+
+NativeKernels selectKernels(uint32_t features) {
+    NativeKernels kernels = {dotPcm16Baseline, matmulQ8Baseline, BASELINE_VARIANT, BASELINE_VARIANT};
+#if defined(AMBIENT_KERNELS_AVX2)
+    if ((features & (CPU_FEATURE_AVX2 | CPU_FEATURE_FMA)) == (CPU_FEATURE_AVX2 | CPU_FEATURE_FMA)) {
+        kernels.dot_pcm16 = dotPcm16Avx2;
+        kernels.matmul_q8 = matmulQ8Avx2;
+        kernels.resample_variant = "avx2";
+        kernels.matmul_variant = "avx2";
+    }
+#endif
+#if defined(AMBIENT_KERNELS_DOTPROD)
+    if (features & CPU_FEATURE_DOTPROD) {
+        kernels.matmul_q8 = matmulQ8Dotprod;
+        kernels.matmul_variant = "dotprod";
+    }
+#endif
+#if defined(AMBIENT_KERNELS_I8MM)
+    // The i8mm kernel finishes odd rows and columns with dot products
+    if ((features & (CPU_FEATURE_I8MM | CPU_FEATURE_DOTPROD)) == (CPU_FEATURE_I8MM | CPU_FEATURE_DOTPROD)) {
+        kernels.matmul_q8 = matmulQ8I8mm;
+        kernels.matmul_variant = "i8mm";
+    }
+#endif
+    return kernels;
+}
+
+} // namespace
+
+const NativeKernels& nativeKernels() {
+    static const NativeKernels kernels = selectKernels(cpuFeatures());
+    return kernels;
+}
+
+float dotPcm16Baseline(const int16_t* x, const float* taps, size_t count) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(PCM_CONVERT_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s = vld1q_s16(x + i);
+        acc0 = vmlaq_f32(acc0, vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), vld1q_f32(taps + i));
+        acc1 = vmlaq_f32(acc1, vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), vld1q_f32(taps + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    sum = vaddvq_f32(acc);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+#elif defined(PCM_CONVERT_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_loadu_ps(taps + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_loadu_ps(taps + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; i++) {
+        sum += static_cast<float>(x[i]) * taps[i];
+    }
+    return sum;
+}
+
+void matmulQ8Baseline(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                      float* out) {
+    for (size_t c = 0; c < cols; c++) {
+        const BlockQ8* x = inputs + c * blocks;
+        for (size_t r = 0; r < rows; r++) {
+            const BlockQ8* w = weights + r * blocks;
+            float sum = 0.0f;
+            for (size_t b = 0; b < blocks; b++) {
+                sum = sum + (w[b].scale * x[b].scale) * static_cast<float>(dotBlockQ8(w[b].q, x[b].q));
+            }
+            out[c * rows + r] = sum;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "quant_matmul.h"
+
+// Dot product of int16 samples with float taps; count is a multiple of 8
+using DotPcm16Kernel = float (*)(const int16_t* x, const float* taps, size_t count);
+using MatmulQ8Kernel = void (*)(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols,
+                                size_t blocks, float* out);
+
+// Hot kernels with variants above the ABI baseline, chosen once per process
+// from cpuFeatures(): each entry is the best variant this build compiled
+// that the CPU can run. The variants live in kernels_<extension>.cpp, which
+// CMakeLists.txt builds with that extension's -march flags.
+struct NativeKernels {
+    DotPcm16Kernel dot_pcm16;
+    MatmulQ8Kernel matmul_q8;
+    const char* resample_variant;
+    const char* matmul_variant;
+};
+
+// The first call selects; JNI_OnLoad makes it so it never happens mid-inference
+const NativeKernels& nativeKernels();
+
+// Baseline variants: NEON, SSE2 or scalar, whichever the ABI guarantees
+float dotPcm16Baseline(const int16_t* x, const float* taps, size_t count);
+void matmulQ8Baseline(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                      float* out);
+
+#if defined(AMBIENT_KERNELS_AVX2)
+float dotPcm16Avx2(const int16_t* x, const float* taps, size_t count);
+void matmulQ8Avx2(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                  float* out);
+#endif
+
+#if defined(AMBIENT_KERNELS_DOTPROD)
+void matmulQ8Dotprod(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                     float* out);
+#endif
+
+#if defined(AMBIENT_KERNELS_I8MM)
+void matmulQ8I8mm(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                  float* out);
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+// Logging shared by the JNI libraries and the host-built core. On Android it
+// goes to logcat; host builds (native_bench) print to stderr instead.
+#ifdef __ANDROID__
+#include <android/log.h>
+#define AMBIENT_LOG_PRINT(priority, tag, ...) __android_log_print(ANDROID_LOG_##priority, tag, __VA_ARGS__)
+#else
+#include <cstdio>
+#define AMBIENT_LOG_PRINT(priority, tag, ...) \
+    (std::fprintf(stderr, "%s/%s: ", #priority, tag), std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))
+#endif
+
+#define AMBIENT_LOG_INFO(tag, ...) AMBIENT_LOG_PRINT(INFO, tag, __VA_ARGS__)
+#define AMBIENT_LOG_ERROR(tag, ...) AMBIENT_LOG_PRINT(ERROR, tag, __VA_ARGS__)
+
+// Debug logging compiles in only with AMBIENT_VERBOSE_LOGGING, which the
+// build defines for debug builds. Release builds still type-check the format
+// and arguments but emit no call, so no hot path pays for formatting.
+#ifdef AMBIENT_VERBOSE_LOGGING
+#define AMBIENT_LOG_DEBUG(tag, ...) AMBIENT_LOG_PRINT(DEBUG, tag, __VA_ARGS__)
+#else
+#define AMBIENT_LOG_DEBUG(tag, ...) \
+    do { if (false) AMBIENT_LOG_PRINT(DEBUG, tag, __VA_ARGS__); } while (0)
+#endif
@@ -0,0 +1,184 @@
+#include "native_metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace latency_buckets {
+
+size_t indexFor(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    const size_t exponent = 63 - __builtin_clzll(micros);
+    if (exponent > MAX_EXPONENT) {
+        return COUNT - 1;
+    }
+    const size_t sub = (micros >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t lowerBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const size_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const uint64_t sub = index % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t upperBound(size_t index) {
+    return index + 1 < COUNT ? lowerBound(index + 1) - 1 : std::numeric_limits<uint64_t>::max();
+}
+
+} // namespace latency_buckets
+
+namespace {
+
+// One thread's histograms. Only the owning thread writes, so a record is a
+// relaxed load and store with no read-modify-write.
+struct ThreadMetrics {
+    std::atomic<uint64_t> buckets[METRIC_STAGE_COUNT][latency_buckets::COUNT] = {};
+    std::atomic<uint64_t> totalUs[METRIC_STAGE_COUNT] = {};
+    std::atomic<uint64_t> maxUs[METRIC_STAGE_COUNT] = {};
+};
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Every block ever handed out lives here. A thread that exits returns its
+// block to the free list with its counts intact, so short-lived threads
+// neither lose samples nor grow the registry. Counters only ever grow;
+// a reset records a baseline that snapshots subtract.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+    std::vector<ThreadMetrics*> free;
+    std::vector<std::vector<uint64_t>> baselineBuckets;
+    std::vector<uint64_t> baselineTotalUs;
+};
+
+// Sums every block's counters; caller holds the registry mutex
+void mergeCounters(const Registry& reg, std::vector<std::vector<uint64_t>>& buckets, std::vector<uint64_t>& totalUs) {
+    buckets.assign(METRIC_STAGE_COUNT, std::vector<uint64_t>(latency_buckets::COUNT));
+    totalUs.assign(METRIC_STAGE_COUNT, 0);
+    for (const auto& block : reg.blocks) {
+        for (size_t s = 0; s < METRIC_STAGE_COUNT; s++) {
+            for (size_t i = 0; i < latency_buckets::COUNT; i++) {
+                buckets[s][i] += block->buckets[s][i].load(std::memory_order_relaxed);
+            }
+            totalUs[s] += block->totalUs[s].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+Registry& registry() {
+    // Leaked so threads exiting during static destruction can still return blocks
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct ThreadSlot {
+    ThreadMetrics* block = nullptr;
+
+    ThreadMetrics& get() {
+        if (!block) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            if (!reg.free.empty()) {
+                block = reg.free.back();
+                reg.free.pop_back();
+            } else {
+                reg.blocks.push_back(std::make_unique<ThreadMetrics>());
+                block = reg.blocks.back().get();
+            }
+        }
+        return *block;
+    }
+
+    ~ThreadSlot() {
+        if (block) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.free.push_back(block);
+        }
+    }
+};
+
+thread_local ThreadSlot tls_slot;
+
+// Smallest bucket bound at or above the given rank, capped by the observed maximum
+uint64_t percentile(const std::vector<uint64_t>& buckets, uint64_t count, uint64_t maxUs, double fraction) {
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(latency_buckets::upperBound(i), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+} // namespace
+
+void recordStageLatency(MetricStage stage, uint64_t micros) {
+    const size_t s = static_cast<size_t>(stage);
+    ThreadMetrics& metrics = tls_slot.get();
+    bump(metrics.buckets[s][latency_buckets::indexFor(micros)], 1);
+    bump(metrics.totalUs[s], micros);
+    if (micros > metrics.maxUs[s].load(std::memory_order_relaxed)) {
+        metrics.maxUs[s].store(micros, std::memory_order_relaxed);
+    }
+}
+
+std::vector<StageSummary> snapshotStageMetrics() {
+    std::vector<StageSummary> summaries(METRIC_STAGE_COUNT);
+    std::vector<std::vector<uint64_t>> merged;
+    std::vector<uint64_t> totalUs;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        mergeCounters(reg, merged, totalUs);
+        for (size_t s = 0; s < METRIC_STAGE_COUNT; s++) {
+            if (!reg.baselineBuckets.empty()) {
+                for (size_t i = 0; i < latency_buckets::COUNT; i++) {
+                    merged[s][i] -= reg.baselineBuckets[s][i];
+                }
+                totalUs[s] -= reg.baselineTotalUs[s];
+            }
+            for (const auto& block : reg.blocks) {
+                summaries[s].maxUs = std::max(summaries[s].maxUs, block->maxUs[s].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    for (size_t s = 0; s < METRIC_STAGE_COUNT; s++) {
+        StageSummary& summary = summaries[s];
+        summary.totalUs = totalUs[s];
+        for (uint64_t n : merged[s]) {
+            summary.count += n;
+        }
+        if (summary.count == 0) {
+            continue;
+        }
+        summary.p50Us = percentile(merged[s], summary.count, summary.maxUs, 0.50);
+        summary.p90Us = percentile(merged[s], summary.count, summary.maxUs, 0.90);
+        summary.p99Us = percentile(merged[s], summary.count, summary.maxUs, 0.99);
+    }
+    return summaries;
+}
+
+void resetStageMetrics() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    mergeCounters(reg, reg.baselineBuckets, reg.baselineTotalUs);
+    for (const auto& block : reg.blocks) {
+        for (auto& maxUs : block->maxUs) {
+            maxUs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
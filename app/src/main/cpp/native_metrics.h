@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "native_trace.h"
+
+// Hot-path stages timed by both AI libraries
+enum class MetricStage : size_t {
+    JNI_MARSHAL,        // Java arguments into native memory
+    FEATURE_EXTRACTION, // PCM conversion and audio features
+    ENCODE,             // ASR acoustic pass, LLM prompt prefill
+    DECODE,             // LLM batched decode step
+    DRAFT,              // LLM draft-model proposals for speculative decoding
+    TOKEN_SAMPLING,     // LLM per-token selection under the output constraint
+    RESULT_BUILD,       // Native results into Java objects
+    COUNT
+};
+
+constexpr size_t METRIC_STAGE_COUNT = static_cast<size_t>(MetricStage::COUNT);
+
+// Names for trace sections and the Kotlin side, in enum order
+constexpr const char* METRIC_STAGE_NAMES[METRIC_STAGE_COUNT] = {
+    "jni_marshal", "feature_extraction", "encode", "decode", "draft", "token_sampling", "result_build"
+};
+
+// Log-linear latency buckets in microseconds, HDR style: each power of two
+// is split into 8 linear sub-buckets, so a value is never more than 12.5%
+// above its bucket's lower bound. Values past ~35 minutes share the top bucket.
+namespace latency_buckets {
+constexpr size_t SUB_BUCKET_BITS = 3;
+constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+constexpr size_t MAX_EXPONENT = 31;
+constexpr size_t COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+size_t indexFor(uint64_t micros);
+uint64_t lowerBound(size_t index);
+uint64_t upperBound(size_t index);
+} // namespace latency_buckets
+
+struct StageSummary {
+    uint64_t count = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+    uint64_t p50Us = 0;
+    uint64_t p90Us = 0;
+    uint64_t p99Us = 0;
+};
+
+// Records one sample into the calling thread's histogram. Lock-free: every
+// thread owns its counters, and only snapshot() reads across threads.
+void recordStageLatency(MetricStage stage, uint64_t micros);
+
+// Merges every thread's histograms, one summary per stage in enum order
+std::vector<StageSummary> snapshotStageMetrics();
+
+// Starts every histogram afresh. Counts are exact across a concurrent
+// record; only the maximum can miss a sample recorded during the reset.
+void resetStageMetrics();
+
+// Times the enclosing scope into one stage and marks it as a trace section
+class StageTimer {
+public:
+    explicit StageTimer(MetricStage stage)
+        : trace_(METRIC_STAGE_NAMES[static_cast<size_t>(stage)]),
+          stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    ~StageTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        recordStageLatency(stage_, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+
+private:
+    TraceSection trace_;
+    MetricStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
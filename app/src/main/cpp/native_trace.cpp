@@ -0,0 +1,58 @@
+#include "native_trace.h"
+
+#ifdef AMBIENT_TRACING
+
+#include <dlfcn.h>
+
+namespace {
+
+// API 29 entry points, looked up once so the library still loads on API 26
+struct AsyncTraceApi {
+    void (*beginAsyncSection)(const char*, int32_t) = nullptr;
+    void (*endAsyncSection)(const char*, int32_t) = nullptr;
+    void (*setCounter)(const char*, int64_t) = nullptr;
+
+    AsyncTraceApi() {
+        void* lib = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD);
+        if (!lib) {
+            return;
+        }
+        beginAsyncSection = reinterpret_cast<void (*)(const char*, int32_t)>(dlsym(lib, "ATrace_beginAsyncSection"));
+        endAsyncSection = reinterpret_cast<void (*)(const char*, int32_t)>(dlsym(lib, "ATrace_endAsyncSection"));
+        setCounter = reinterpret_cast<void (*)(const char*, int64_t)>(dlsym(lib, "ATrace_setCounter"));
+    }
+};
+
+const AsyncTraceApi& asyncTraceApi() {
+    static const AsyncTraceApi api;
+    return api;
+}
+
+} // namespace
+
+namespace native_trace {
+
+void beginAsync(const char* name, int32_t cookie) {
+    const AsyncTraceApi& api = asyncTraceApi();
+    if (api.beginAsyncSection && ATrace_isEnabled()) {
+        api.beginAsyncSection(name, cookie);
+    }
+}
+
+void endAsync(const char* name, int32_t cookie) {
+    const AsyncTraceApi& api = asyncTraceApi();
+    if (api.endAsyncSection && ATrace_isEnabled()) {
+        api.endAsyncSection(name, cookie);
+    }
+}
+
+void counter(const char* name, int64_t value) {
+    const AsyncTraceApi& api = asyncTraceApi();
+    if (api.setCounter && ATrace_isEnabled()) {
+        api.setCounter(name, value);
+    }
+}
+
+} // namespace native_trace
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+// ATrace markers for system traces (Perfetto, systrace). Compiled in only
+// with AMBIENT_TRACING; otherwise every macro expands to nothing. When
+// compiled in, each marker costs one ATrace_isEnabled() check unless a
+// trace is being captured.
+//
+//   TRACE_SECTION(name)             Slice on the current thread until scope exit
+//   TRACE_ASYNC_BEGIN(name, cookie) Slice that may end on another thread;
+//   TRACE_ASYNC_END(name, cookie)   name and cookie must match
+//   TRACE_COUNTER(name, value)      Counter track
+//
+// Async slices and counters need API 29 and are skipped on older devices.
+
+// Cookie for an async slice of one item (chunk, window, generation) on a handle
+inline int32_t traceCookie(int64_t handle, uint64_t id) {
+    return static_cast<int32_t>((static_cast<uint32_t>(handle) << 20) ^ static_cast<uint32_t>(id));
+}
+
+#ifdef AMBIENT_TRACING
+
+#include <android/trace.h>
+
+namespace native_trace {
+void beginAsync(const char* name, int32_t cookie);
+void endAsync(const char* name, int32_t cookie);
+void counter(const char* name, int64_t value);
+} // namespace native_trace
+
+class TraceSection {
+public:
+    explicit TraceSection(const char* name) : active_(ATrace_isEnabled()) {
+        if (active_) {
+            ATrace_beginSection(name);
+        }
+    }
+
+    TraceSection(const TraceSection&) = delete;
+    TraceSection& operator=(const TraceSection&) = delete;
+
+    ~TraceSection() {
+        if (active_) {
+            ATrace_endSection();
+        }
+    }
+
+private:
+    bool active_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SECTION(name) TraceSection TRACE_CONCAT(trace_section_, __LINE__)(name)
+#define TRACE_ASYNC_BEGIN(name, cookie) native_trace::beginAsync(name, cookie)
+#define TRACE_ASYNC_END(name, cookie) native_trace::endAsync(name, cookie)
+#define TRACE_COUNTER(name, value) native_trace::counter(name, value)
+
+#else
+
+// Empty, so classes holding one cost nothing
+class TraceSection {
+public:
+    explicit TraceSection(const char*) {}
+};
+
+#define TRACE_SECTION(name) ((void)0)
+#define TRACE_ASYNC_BEGIN(name, cookie) ((void)0)
+#define TRACE_ASYNC_END(name, cookie) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+
+#endif
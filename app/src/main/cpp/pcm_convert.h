@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PCM_CONVERT_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_CONVERT_SSE2 1
+#endif
+
+// Same scale the Kotlin side used (sample / Short.MAX_VALUE)
+static constexpr float PCM16_SCALE = 1.0f / 32767.0f;
+
+// Normalise int16 PCM to float, eight samples per vector step
+inline void pcm16ToFloat(const int16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(PCM_CONVERT_NEON)
+    const float32x4_t scale = vdupq_n_f32(PCM16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(dst + i, vmulq_f32(lo, scale));
+        vst1q_f32(dst + i + 4, vmulq_f32(hi, scale));
+    }
+#elif defined(PCM_CONVERT_SSE2)
+    const __m128 scale = _mm_set1_ps(PCM16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // Sign-extend by duplicating each lane into the high half and shifting back down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = static_cast<float>(src[i]) * PCM16_SCALE;
+    }
+}
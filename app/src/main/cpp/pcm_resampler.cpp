@@ -0,0 +1,123 @@
+#include "pcm_resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "native_kernels.h"
+#include "pcm_convert.h"
+
+namespace {
+
+// Zero crossings of the sinc on each side, at the lower of the two rates;
+// with the Kaiser window below this keeps aliasing under about -80 dB
+constexpr int ZERO_CROSSINGS = 16;
+constexpr double KAISER_BETA = 8.0;
+
+// Pass band edge as a fraction of the lower Nyquist frequency
+constexpr double ROLLOFF = 0.9;
+
+// SIMD step; phases are zero-padded to a multiple of it
+constexpr size_t TAP_BLOCK = 8;
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+PcmResampler::PcmResampler(int input_rate, int output_rate)
+    : input_rate_(input_rate), output_rate_(output_rate) {
+    const int64_t g = std::gcd<int64_t>(input_rate, output_rate);
+    up_ = output_rate / g;
+    down_ = input_rate / g;
+
+    // Wide enough to cover the sinc's zero crossings at the lower rate
+    const double stretch = std::max(1.0, static_cast<double>(input_rate) / output_rate);
+    const size_t taps = static_cast<size_t>(std::ceil(2.0 * ZERO_CROSSINGS * stretch));
+    taps_per_phase_ = (taps + TAP_BLOCK - 1) / TAP_BLOCK * TAP_BLOCK;
+
+    // Prototype low-pass at the upsampled rate, up_ * taps_per_phase_ long
+    const size_t length = static_cast<size_t>(up_) * taps_per_phase_;
+    const double cutoff = ROLLOFF * 0.5 * std::min(input_rate, output_rate) / (static_cast<double>(up_) * input_rate);
+    const double centre = (length - 1) / 2.0;
+    const double i0_beta = besselI0(KAISER_BETA);
+    std::vector<double> prototype(length);
+    for (size_t j = 0; j < length; j++) {
+        const double x = j - centre;
+        const double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+        const double r = length > 1 ? 2.0 * j / (length - 1) - 1.0 : 0.0;
+        const double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        // Interpolation by up_ leaves each phase with 1/up_ of the gain
+        prototype[j] = 2.0 * cutoff * sinc * window * up_;
+    }
+
+    taps_.assign(static_cast<size_t>(up_) * taps_per_phase_, 0.0f);
+    for (int64_t p = 0; p < up_; p++) {
+        float* phase = taps_.data() + p * taps_per_phase_;
+        for (size_t i = 0; i < taps_per_phase_; i++) {
+            phase[i] = static_cast<float>(prototype[p + (taps_per_phase_ - 1 - i) * up_] * PCM16_SCALE);
+        }
+    }
+
+    reset();
+}
+
+void PcmResampler::reset() {
+    pending_.assign(taps_per_phase_ - 1, 0);
+    start_ = -static_cast<int64_t>(taps_per_phase_ - 1);
+    next_ = 0;
+}
+
+size_t PcmResampler::inputsFor(size_t max_outputs) const {
+    // Output n needs input floor(n * down / up); the queue may reach just
+    // short of output next_ + max_outputs
+    const int64_t end = start_ + static_cast<int64_t>(pending_.size());
+    const int64_t limit = (next_ + static_cast<int64_t>(max_outputs)) * down_ / up_;
+    return static_cast<size_t>(std::max<int64_t>(0, limit - end));
+}
+
+size_t PcmResampler::available() const {
+    const int64_t end = start_ + static_cast<int64_t>(pending_.size());
+    const int64_t last = (end * up_ + down_ - 1) / down_;
+    return static_cast<size_t>(std::max<int64_t>(0, last - next_));
+}
+
+void PcmResampler::feed(const int16_t* pcm, size_t count) {
+    // Drop input no future output reads before appending
+    const int64_t first_needed = next_ * down_ / up_ - static_cast<int64_t>(taps_per_phase_) + 1;
+    const size_t drop = static_cast<size_t>(std::clamp<int64_t>(first_needed - start_, 0, pending_.size()));
+    pending_.erase(pending_.begin(), pending_.begin() + drop);
+    start_ += drop;
+    pending_.insert(pending_.end(), pcm, pcm + count);
+}
+
+void PcmResampler::produce(float* out, size_t n) {
+    const size_t taps = taps_per_phase_;
+    const DotPcm16Kernel dotPcm16 = nativeKernels().dot_pcm16;
+    const int64_t window_offset = 1 - static_cast<int64_t>(taps) - start_;
+    if (up_ == 1) {
+        // Integer decimation: one phase, the window steps by down_
+        const int16_t* x = pending_.data() + (next_ * down_ + window_offset);
+        for (size_t i = 0; i < n; i++, x += down_) {
+            out[i] = dotPcm16(x, taps_.data(), taps);
+        }
+    } else {
+        int64_t t = next_ * down_;
+        for (size_t i = 0; i < n; i++, t += down_) {
+            const int64_t base = t / up_;
+            const float* phase = taps_.data() + (t - base * up_) * taps;
+            out[i] = dotPcm16(pending_.data() + (base + window_offset), phase, taps);
+        }
+    }
+    next_ += static_cast<int64_t>(n);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming polyphase resampler from int16 PCM at any capture rate to
+// normalised float at the ASR rate. The int16 -> float scale is folded into
+// the filter taps, so conversion, anti-aliasing and rate change are one
+// pass: each output is a single SIMD dot product over the input window.
+//
+// The ratio is reduced to up/down; output n reads phase (n * down) % up of
+// a Kaiser-windowed sinc low-pass. Integer decimation (48 kHz -> 16 kHz is
+// up = 1, down = 3) has a single phase and skips the phase bookkeeping.
+class PcmResampler {
+public:
+    PcmResampler(int input_rate, int output_rate);
+
+    int inputRate() const { return input_rate_; }
+    int outputRate() const { return output_rate_; }
+
+    // Largest number of further input samples whose outputs fit in max_outputs
+    size_t inputsFor(size_t max_outputs) const;
+
+    // Queues input; its outputs become available()
+    void feed(const int16_t* pcm, size_t count);
+
+    // Outputs the queued input completes
+    size_t available() const;
+
+    // Writes the next n <= available() outputs
+    void produce(float* out, size_t n);
+
+    // Drops queued input and restarts from silence
+    void reset();
+
+    size_t tapsPerPhase() const { return taps_per_phase_; }
+
+private:
+    int input_rate_;
+    int output_rate_;
+    int64_t up_;
+    int64_t down_;
+    size_t taps_per_phase_;
+
+    // Per phase, taps in input order (oldest sample first), scaled for int16 input
+    std::vector<float> taps_;
+
+    // Input window: pending_[0] is input sample start_; starts with
+    // taps_per_phase_ - 1 samples of silence so output 0 is defined
+    std::vector<int16_t> pending_;
+    int64_t start_ = 0;
+    // Next output index; its input position is next_ * down_ / up_
+    int64_t next_ = 0;
+};
@@ -0,0 +1,212 @@
+#include "prefix_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr char CACHE_MAGIC[4] = {'P', 'F', 'X', 'C'};
+constexpr uint32_t CACHE_VERSION = 1;
+
+// Bound on tokens per entry read from disk, so a corrupt file cannot request a huge allocation
+constexpr uint32_t MAX_ENTRY_TOKENS = 1 << 20;
+
+size_t commonPrefix(const std::vector<int32_t>& a, const std::vector<int32_t>& b) {
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+template <typename T>
+bool writeValue(FILE* file, const T& value) {
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+bool readValue(FILE* file, T& value) {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+} // namespace
+
+uint64_t PrefixCache::headHash(const std::vector<int32_t>& tokens) {
+    // FNV-1a over the head tokens
+    uint64_t hash = 1469598103934665603ULL;
+    size_t n = std::min(tokens.size(), HEAD_TOKENS);
+    for (size_t i = 0; i < n; i++) {
+        hash ^= static_cast<uint32_t>(tokens[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t PrefixCache::longestPrefix(const std::vector<int32_t>& tokens) {
+    if (tokens.size() < HEAD_TOKENS) {
+        return 0;
+    }
+    auto it = buckets_.find(headHash(tokens));
+    if (it == buckets_.end()) {
+        return 0;
+    }
+
+    size_t best = 0;
+    Entry* best_entry = nullptr;
+    for (auto& entry : it->second) {
+        size_t shared = commonPrefix(entry.tokens, tokens);
+        if (shared > best) {
+            best = shared;
+            best_entry = &entry;
+        }
+    }
+    // A hash collision shows up as a short match; only trust a full head
+    if (best < HEAD_TOKENS) {
+        return 0;
+    }
+    best_entry->last_use = ++use_clock_;
+    return best;
+}
+
+void PrefixCache::store(const std::vector<int32_t>& tokens) {
+    if (tokens.size() < HEAD_TOKENS) {
+        return;
+    }
+    auto& bucket = buckets_[headHash(tokens)];
+    for (auto& entry : bucket) {
+        // An entry this prompt extends is superseded; one that already covers it is kept
+        if (commonPrefix(entry.tokens, tokens) == std::min(entry.tokens.size(), tokens.size())) {
+            if (entry.tokens.size() < tokens.size()) {
+                entry.tokens = tokens;
+            }
+            entry.last_use = ++use_clock_;
+            return;
+        }
+    }
+
+    evictIfFull();
+    Entry entry;
+    entry.tokens = tokens;
+    entry.last_use = ++use_clock_;
+    buckets_[headHash(tokens)].push_back(std::move(entry));
+}
+
+size_t PrefixCache::size() const {
+    size_t count = 0;
+    for (const auto& bucket : buckets_) {
+        count += bucket.second.size();
+    }
+    return count;
+}
+
+size_t PrefixCache::tokenCount() const {
+    size_t count = 0;
+    for (const auto& bucket : buckets_) {
+        for (const auto& entry : bucket.second) {
+            count += entry.tokens.size();
+        }
+    }
+    return count;
+}
+
+size_t PrefixCache::shrink(size_t max_entries) {
+    size_t evicted = 0;
+    while (size() > max_entries) {
+        evicted += evictOldest();
+    }
+    return evicted;
+}
+
+void PrefixCache::evictIfFull() {
+    if (size() >= max_entries_) {
+        evictOldest();
+    }
+}
+
+size_t PrefixCache::evictOldest() {
+    auto oldest_bucket = buckets_.end();
+    size_t oldest_index = 0;
+    uint64_t oldest_use = UINT64_MAX;
+    for (auto it = buckets_.begin(); it != buckets_.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); i++) {
+            if (it->second[i].last_use < oldest_use) {
+                oldest_use = it->second[i].last_use;
+                oldest_bucket = it;
+                oldest_index = i;
+            }
+        }
+    }
+    if (oldest_bucket == buckets_.end()) {
+        return 0;
+    }
+    const size_t tokens = oldest_bucket->second[oldest_index].tokens.size();
+    oldest_bucket->second.erase(oldest_bucket->second.begin() + oldest_index);
+    if (oldest_bucket->second.empty()) {
+        buckets_.erase(oldest_bucket);
+    }
+    return tokens;
+}
+
+bool PrefixCache::save(const std::string& path) const {
+    // Write to a temporary file and rename, so a crash never leaves a torn cache
+    const std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = std::fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC), 1, file) == 1 &&
+              writeValue(file, CACHE_VERSION) &&
+              writeValue(file, static_cast<uint32_t>(size()));
+    for (const auto& bucket : buckets_) {
+        for (const auto& entry : bucket.second) {
+            ok = ok && writeValue(file, static_cast<uint32_t>(entry.tokens.size())) &&
+                 std::fwrite(entry.tokens.data(), sizeof(int32_t), entry.tokens.size(), file) == entry.tokens.size();
+        }
+    }
+    ok = (std::fclose(file) == 0) && ok;
+
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PrefixCache::load(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t count = 0;
+    bool ok = std::fread(magic, sizeof(magic), 1, file) == 1 &&
+              std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) == 0 &&
+              readValue(file, version) && version == CACHE_VERSION &&
+              readValue(file, count);
+
+    std::vector<std::vector<int32_t>> entries;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint32_t length = 0;
+        ok = readValue(file, length) && length <= MAX_ENTRY_TOKENS;
+        if (ok) {
+            std::vector<int32_t> tokens(length);
+            ok = std::fread(tokens.data(), sizeof(int32_t), length, file) == length;
+            entries.push_back(std::move(tokens));
+        }
+    }
+    std::fclose(file);
+
+    if (!ok) {
+        return false;
+    }
+    clear();
+    for (const auto& tokens : entries) {
+        store(tokens);
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Cache of evaluated prompt prefixes for one LLM context.
+// Entries are keyed by a hash of their first HEAD_TOKENS tokens, so prompts
+// sharing a system prompt land in the same bucket, and a lookup resumes from
+// the longest common token prefix with any entry in that bucket. A KV cache
+// can be truncated to any prefix, so one entry per distinct prompt serves
+// every shorter prefix of it too.
+// Not thread-safe; callers hold the context's generation lock.
+class PrefixCache {
+public:
+    static constexpr size_t HEAD_TOKENS = 32;
+
+    explicit PrefixCache(size_t max_entries = 8) : max_entries_(max_entries) {}
+
+    // Number of leading tokens whose state can be reused
+    size_t longestPrefix(const std::vector<int32_t>& tokens);
+
+    // Remember the evaluated state for tokens, evicting the least recently used entry if full
+    void store(const std::vector<int32_t>& tokens);
+
+    size_t size() const;
+    void clear() { buckets_.clear(); }
+
+    // Tokens of evaluated state held over all entries
+    size_t tokenCount() const;
+    // Evict least recently used entries until at most max_entries remain;
+    // returns the tokens of state evicted
+    size_t shrink(size_t max_entries);
+
+    // Persist entries next to the model so a restart resumes warm.
+    // load() replaces the current entries; both return false on I/O or format errors.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    struct Entry {
+        std::vector<int32_t> tokens;
+        // A real implementation keeps the serialized sequence KV state here
+        uint64_t last_use = 0;
+    };
+
+    static uint64_t headHash(const std::vector<int32_t>& tokens);
+    void evictIfFull();
+    // Returns the evicted entry's token count, 0 if the cache is empty
+    size_t evictOldest();
+
+    size_t max_entries_;
+    uint64_t use_clock_ = 0;
+    std::unordered_map<uint64_t, std::vector<Entry>> buckets_;
+};
@@ -0,0 +1,50 @@
+#include "quant_matmul.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "native_kernels.h"
+
+// Every matmul variant builds with -ffp-contract=off (see CMakeLists.txt):
+// each output is the in-order sum over blocks of (weight scale * input
+// scale) * int dot, and all of them must round it the same way.
+
+void quantizeQ8(const float* src, BlockQ8* dst, size_t count) {
+    for (size_t b = 0; b < count / Q8_BLOCK; b++) {
+        const float* values = src + b * Q8_BLOCK;
+        float max_abs = 0.0f;
+        for (size_t i = 0; i < Q8_BLOCK; i++) {
+            max_abs = std::max(max_abs, std::fabs(values[i]));
+        }
+        const float scale = max_abs / 127.0f;
+        const float inverse = scale > 0.0f ? 1.0f / scale : 0.0f;
+        dst[b].scale = scale;
+        for (size_t i = 0; i < Q8_BLOCK; i++) {
+            const float q = std::round(values[i] * inverse);
+            dst[b].q[i] = static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f));
+        }
+    }
+}
+
+void matmulQ8Scalar(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks,
+                    float* out) {
+    for (size_t c = 0; c < cols; c++) {
+        const BlockQ8* x = inputs + c * blocks;
+        for (size_t r = 0; r < rows; r++) {
+            const BlockQ8* w = weights + r * blocks;
+            float sum = 0.0f;
+            for (size_t b = 0; b < blocks; b++) {
+                int32_t dot = 0;
+                for (size_t i = 0; i < Q8_BLOCK; i++) {
+                    dot += static_cast<int32_t>(w[b].q[i]) * x[b].q[i];
+                }
+                sum = sum + (w[b].scale * x[b].scale) * static_cast<float>(dot);
+            }
+            out[c * rows + r] = sum;
+        }
+    }
+}
+
+void matmulQ8(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks, float* out) {
+    nativeKernels().matmul_q8(weights, rows, inputs, cols, blocks, out);
+}
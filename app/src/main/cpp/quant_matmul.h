@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Values per quantization block, the block size of ggml's Q8_0
+constexpr size_t Q8_BLOCK = 32;
+
+// Q8_BLOCK int8 values sharing one scale: value = scale * q. q stays in
+// +-127, never -128, which the int16 pairwise sums in the kernels rely on.
+struct BlockQ8 {
+    float scale;
+    int8_t q[Q8_BLOCK];
+};
+
+// Symmetric per-block quantization; count is a multiple of Q8_BLOCK
+void quantizeQ8(const float* src, BlockQ8* dst, size_t count);
+
+// out[c * rows + r] = dot(weights row r, inputs column c), where weights is
+// rows x blocks and inputs is cols x blocks, both row-major. Runs the variant
+// nativeKernels() chose; every variant sums the blocks of a dot product in
+// order, so they all produce bit-identical results.
+void matmulQ8(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks, float* out);
+
+// Portable reference path, always compiled
+void matmulQ8Scalar(const BlockQ8* weights, size_t rows, const BlockQ8* inputs, size_t cols, size_t blocks, float* out);
@@ -0,0 +1,121 @@
+#include <jni.h>
+#include <android/log.h>
+#include <vector>
+
+#include "compute_backend.h"
+#include "compute_pool.h"
+#include "cpu_features.h"
+#include "cpu_topology.h"
+#include "native_kernels.h"
+#include "native_metrics.h"
+
+#define TAG "AmbientRuntime"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+extern "C" {
+
+// Resizes the compute pool shared by ASR and LLM; 0 restores the default
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_performance_NativeComputePool_nativeSetThreadCount(
+        JNIEnv *env, jobject thiz, jint thread_count) {
+    
+    ComputePool& pool = ComputePool::shared();
+    size_t applied = pool.resize(thread_count > 0 ? static_cast<size_t>(thread_count) : 0);
+    LOGI("Compute pool resized to %zu of %zu threads", applied, pool.maxThreads());
+    return static_cast<jint>(applied);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_performance_NativeComputePool_nativeGetThreadCount(
+        JNIEnv *env, jobject thiz) {
+    
+    return static_cast<jint>(ComputePool::shared().threadCount());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_performance_NativeComputePool_nativeGetPerformanceCoreCount(
+        JNIEnv *env, jobject thiz) {
+    
+    return static_cast<jint>(cpuTopology().performanceCores.size());
+}
+
+// Bit 1 << BackendKind per offload delegate present on this device
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_performance_NativeComputePool_nativeGetOffloadBackends(
+        JNIEnv *env, jobject thiz) {
+    
+    return static_cast<jint>(BackendRegistry::shared().availableMask());
+}
+
+// Moves every model's offloaded layers back onto the pool while suspended
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_performance_NativeComputePool_nativeSetOffloadSuspended(
+        JNIEnv *env, jobject thiz, jboolean suspended) {
+    
+    BackendRegistry::shared().setSuspended(suspended == JNI_TRUE);
+    LOGI("Accelerator offload %s", suspended == JNI_TRUE ? "suspended" : "resumed");
+}
+
+// CPU_FEATURE_* bits from cpu_features.h
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_performance_NativeCpuFeatures_nativeGetCpuFeatures(
+        JNIEnv *env, jobject thiz) {
+    
+    return static_cast<jint>(cpuFeatures());
+}
+
+// Variants nativeKernels() chose: [resample, quantized matmul]
+JNIEXPORT jobjectArray JNICALL
+Java_com_frozo_ambientscribe_performance_NativeCpuFeatures_nativeGetKernelVariants(
+        JNIEnv *env, jobject thiz) {
+    
+    const NativeKernels& kernels = nativeKernels();
+    const char* variants[] = {kernels.resample_variant, kernels.matmul_variant};
+    jclass string_class = env->FindClass("java/lang/String");
+    if (!string_class) {
+        return nullptr;
+    }
+    jobjectArray result = env->NewObjectArray(2, string_class, nullptr);
+    env->DeleteLocalRef(string_class);
+    if (!result) {
+        return nullptr;
+    }
+    for (jsize i = 0; i < 2; i++) {
+        jstring name = env->NewStringUTF(variants[i]);
+        if (!name) {
+            return nullptr;
+        }
+        env->SetObjectArrayElement(result, i, name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+
+// Per stage, in MetricStage order: [count, total us, max us, p50 us, p90 us, p99 us]
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_performance_NativeMetrics_nativeSnapshot(
+        JNIEnv *env, jobject thiz) {
+    
+    std::vector<jlong> values;
+    for (const StageSummary& stage : snapshotStageMetrics()) {
+        values.insert(values.end(), {
+            static_cast<jlong>(stage.count), static_cast<jlong>(stage.totalUs), static_cast<jlong>(stage.maxUs),
+            static_cast<jlong>(stage.p50Us), static_cast<jlong>(stage.p90Us), static_cast<jlong>(stage.p99Us)
+        });
+    }
+    
+    jlongArray result = env->NewLongArray(static_cast<jsize>(values.size()));
+    if (result) {
+        env->SetLongArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_performance_NativeMetrics_nativeReset(
+        JNIEnv *env, jobject thiz) {
+    
+    resetStageMetrics();
+}
+
+} // extern "C"
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+// Lock-free single-producer/single-consumer ring buffer.
+// One thread may call push(), one (possibly different) thread may call
+// pop()/peek()/discard(). Capacity is rounded up to a power of two so that
+// index wrapping is a mask instead of a modulo.
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t min_capacity)
+        : capacity_(roundUpPow2(min_capacity)),
+          mask_(capacity_ - 1),
+          data_(new T[capacity_]) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Number of elements readable by the consumer
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    size_t freeSpace() const { return capacity_ - size(); }
+
+    // Elements ever pushed and ever popped; positions in the stream
+    size_t pushedTotal() const { return head_.load(std::memory_order_acquire); }
+    size_t poppedTotal() const { return tail_.load(std::memory_order_acquire); }
+
+    // Producer side: copies up to count elements, returns how many were written
+    size_t push(const T* src, size_t count) {
+        return pushInPlace(count, [src](T* dst, size_t offset, size_t n) {
+            std::memcpy(dst, src + offset, n * sizeof(T));
+        });
+    }
+
+    // Producer side: fill(dst, offset, n) writes elements [offset, offset + n)
+    // straight into ring storage; called at most twice when the write wraps
+    template <typename Fill>
+    size_t pushInPlace(size_t count, Fill&& fill) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t n = std::min(count, capacity_ - (head - tail));
+        const size_t start = head & mask_;
+        const size_t first = std::min(n, capacity_ - start);
+        if (first > 0) {
+            fill(data_.get() + start, 0, first);
+        }
+        if (n > first) {
+            fill(data_.get(), first, n - first);
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side: copies up to count elements without consuming them
+    size_t peek(T* dst, size_t count) const {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t n = std::min(count, head - tail);
+        copyOut(tail, dst, n);
+        return n;
+    }
+
+    // Consumer side: drops up to count elements, returns how many were dropped
+    size_t discard(size_t count) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t n = std::min(count, head - tail);
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t pop(T* dst, size_t count) {
+        return discard(peek(dst, count));
+    }
+
+private:
+    static size_t roundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    void copyOut(size_t tail, T* dst, size_t n) const {
+        const size_t start = tail & mask_;
+        const size_t first = std::min(n, capacity_ - start);
+        std::memcpy(dst, data_.get() + start, first * sizeof(T));
+        std::memcpy(dst + first, data_.get(), (n - first) * sizeof(T));
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> data_;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "asr_core.h"
+#include "audio_chunk_store.h"
+#include "test_harness.h"
+
+namespace {
+
+const char* SPILL_PATH = "native_tests_audio.spill";
+
+// 1000-sample segments with a cap of two in memory
+constexpr size_t SEGMENT = 1000;
+constexpr size_t MEMORY_CAP = 2 * SEGMENT * sizeof(int16_t);
+
+std::unique_ptr<AudioChunkStore> openStore() {
+    uint8_t key[CHACHA20_KEY_BYTES];
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+    std::string error;
+    auto store = AudioChunkStore::open(SPILL_PATH, key, SEGMENT, MEMORY_CAP, &error);
+    if (!store) {
+        test::fail(__FILE__, __LINE__, "open failed: " + error);
+    }
+    return store;
+}
+
+std::vector<int16_t> rampPcm(size_t count) {
+    std::vector<int16_t> pcm(count);
+    for (size_t i = 0; i < count; ++i) {
+        pcm[i] = static_cast<int16_t>(i * 31);
+    }
+    return pcm;
+}
+
+std::vector<int16_t> readSegment(AudioChunkStore& store, size_t index) {
+    AudioChunkStore::SegmentView view;
+    if (!store.segment(index, view)) {
+        return {};
+    }
+    return std::vector<int16_t>(view.data(), view.data() + view.length);
+}
+
+} // namespace
+
+TEST(AudioStoreSpillsPastMemoryCap) {
+    auto store = openStore();
+    ASSERT_TRUE(store != nullptr);
+    std::vector<int16_t> pcm = rampPcm(10 * SEGMENT + 500);
+    store->append(pcm.data(), pcm.size());
+
+    AudioStoreStats stats = store->stats();
+    EXPECT_EQ(store->segmentCount(), 11u);
+    EXPECT_EQ(stats.stored_samples, pcm.size());
+    EXPECT_EQ(stats.spilled_bytes, 9 * SEGMENT * sizeof(int16_t));
+    EXPECT_TRUE(stats.memory_bytes <= 3 * SEGMENT * sizeof(int16_t));
+}
+
+TEST(AudioStoreReadsSpilledSegmentsBack) {
+    auto store = openStore();
+    ASSERT_TRUE(store != nullptr);
+    std::vector<int16_t> pcm = rampPcm(6 * SEGMENT + 123);
+    store->append(pcm.data(), pcm.size());
+
+    for (size_t i = 0; i < store->segmentCount(); ++i) {
+        const size_t begin = i * SEGMENT;
+        const size_t end = std::min(pcm.size(), begin + SEGMENT);
+        EXPECT_TRUE(readSegment(*store, i) == std::vector<int16_t>(pcm.begin() + begin, pcm.begin() + end));
+    }
+    AudioChunkStore::SegmentView view;
+    EXPECT_FALSE(store->segment(store->segmentCount(), view));
+}
+
+TEST(AudioStoreSpillFileHoldsNoPlaintext) {
+    auto store = openStore();
+    ASSERT_TRUE(store != nullptr);
+    std::vector<int16_t> pcm = rampPcm(4 * SEGMENT);
+    store->append(pcm.data(), pcm.size());
+
+    FILE* file = std::fopen(SPILL_PATH, "rb");
+    ASSERT_TRUE(file != nullptr);
+    std::vector<int16_t> disk(SEGMENT);
+    const size_t read = std::fread(disk.data(), sizeof(int16_t), disk.size(), file);
+    std::fclose(file);
+    EXPECT_EQ(read, SEGMENT);
+    EXPECT_FALSE(disk == std::vector<int16_t>(pcm.begin(), pcm.begin() + SEGMENT));
+}
+
+TEST(AudioStoreDrainResumesAfterPartialSink) {
+    auto store = openStore();
+    ASSERT_TRUE(store != nullptr);
+    std::vector<int16_t> pcm = rampPcm(8 * SEGMENT + 250);
+    std::vector<int16_t> drained;
+    // Appends in odd pieces against a sink that takes 300 per drain, so the
+    // reader falls behind into spilled segments
+    for (size_t offset = 0; offset < pcm.size(); offset += 777) {
+        store->append(pcm.data() + offset, std::min<size_t>(777, pcm.size() - offset));
+        size_t budget = 300;
+        store->drain([&](const int16_t* data, size_t count) {
+            const size_t take = std::min(count, budget);
+            drained.insert(drained.end(), data, data + take);
+            budget -= take;
+            return take;
+        });
+    }
+    EXPECT_TRUE(store->stats().unread_samples > 0);
+    store->drain([&](const int16_t* data, size_t count) {
+        drained.insert(drained.end(), data, data + count);
+        return count;
+    });
+    EXPECT_TRUE(drained == pcm);
+    EXPECT_EQ(store->stats().unread_samples, 0u);
+}
+
+TEST(AudioStoreResetDropsAudioAndFileGoesWithStore) {
+    auto store = openStore();
+    ASSERT_TRUE(store != nullptr);
+    std::vector<int16_t> pcm = rampPcm(5 * SEGMENT);
+    store->append(pcm.data(), pcm.size());
+    store->reset();
+    EXPECT_EQ(store->segmentCount(), 0u);
+    EXPECT_EQ(store->stats().stored_samples, 0u);
+    EXPECT_EQ(store->stats().spilled_bytes, 0u);
+
+    // Spilling again after a reset still reads back
+    store->append(pcm.data(), pcm.size());
+    EXPECT_TRUE(readSegment(*store, 0) == std::vector<int16_t>(pcm.begin(), pcm.begin() + SEGMENT));
+
+    store.reset();
+    FILE* file = std::fopen(SPILL_PATH, "rb");
+    EXPECT_TRUE(file == nullptr);
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+TEST(AudioStoreUtteranceEndLandsAfterStoredBacklog) {
+    auto store = openStore();
+    ASSERT_TRUE(store != nullptr);
+    // A 1024-sample ring behind a store that holds three times as much
+    StreamingSession stream(800, 200, 1024);
+    std::vector<int16_t> pcm = rampPcm(3 * SEGMENT + 500);
+    const size_t utterance = 3 * SEGMENT;
+    store->append(pcm.data(), utterance);
+    drainStoredAudio(stream, *store);
+    EXPECT_EQ(stream.ring.freeSpace(), 0u);
+
+    // The end comes while most of the utterance still waits in the store,
+    // and the next one starts before the ring has room again
+    endStoredUtterance(stream, *store);
+    store->append(pcm.data() + utterance, pcm.size() - utterance);
+    EXPECT_EQ(stream.utterance_end.load(), 0u);
+
+    while (store->stats().unread_samples > 0) {
+        stream.ring.discard(300);
+        drainStoredAudio(stream, *store);
+        if (stream.ring.pushedTotal() < utterance) {
+            EXPECT_EQ(stream.utterance_end.load(), 0u);
+        }
+    }
+    EXPECT_EQ(stream.ring.pushedTotal(), pcm.size());
+    EXPECT_EQ(stream.utterance_end.load(), utterance);
+    EXPECT_TRUE(stream.stored_utterance_ends.empty());
+}
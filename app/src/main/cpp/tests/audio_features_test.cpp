@@ -0,0 +1,68 @@
+// The vector feature kernel must match the scalar reference bit for bit, so
+// stream windows analyse the same on every ABI.
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "audio_features.h"
+#include "test_harness.h"
+
+namespace {
+
+constexpr size_t MAX_LENGTH = 320;
+// Start offsets in floats; every misalignment of a 16-byte vector load
+constexpr size_t MAX_OFFSET = 4;
+
+std::vector<float> testSamples(size_t count) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Some exact zeros and repeats, where the zero crossing test has edges
+        samples[i] = i % 17 == 0 ? 0.0f : i % 23 == 0 ? samples[i - 1] : value(rng);
+    }
+    return samples;
+}
+
+bool sameFeatures(const FeatureAccumulator& a, const FeatureAccumulator& b) {
+    return a.sum_squares == b.sum_squares && a.max_amplitude == b.max_amplitude &&
+           a.zero_crossings == b.zero_crossings && a.diff_sum == b.diff_sum &&
+           a.weighted_diff_sum == b.weighted_diff_sum && a.count == b.count &&
+           a.first_sample == b.first_sample && a.last_sample == b.last_sample;
+}
+
+} // namespace
+
+TEST(FeatureKernelMatchesScalarForEveryLengthAndAlignment) {
+    alignas(16) static float buffer[MAX_LENGTH + MAX_OFFSET];
+    const std::vector<float> samples = testSamples(MAX_LENGTH + MAX_OFFSET);
+    std::copy(samples.begin(), samples.end(), buffer);
+    for (size_t offset = 0; offset < MAX_OFFSET; ++offset) {
+        for (size_t length = 0; length <= MAX_LENGTH; ++length) {
+            const FeatureAccumulator vector = accumulateFeatures(buffer + offset, length);
+            const FeatureAccumulator scalar = accumulateFeaturesScalar(buffer + offset, length);
+            if (!sameFeatures(vector, scalar)) {
+                test::fail(__FILE__, __LINE__, std::string(featureKernelName()) + " differs from scalar at length " +
+                           std::to_string(length) + ", offset " + std::to_string(offset));
+            }
+        }
+    }
+}
+
+TEST(FeatureKernelFieldsMatchScalar) {
+    // Field by field for one long unaligned run, so a mismatch names the field
+    const std::vector<float> samples = testSamples(MAX_LENGTH + 1);
+    const FeatureAccumulator vector = accumulateFeatures(samples.data() + 1, MAX_LENGTH);
+    const FeatureAccumulator scalar = accumulateFeaturesScalar(samples.data() + 1, MAX_LENGTH);
+    EXPECT_EQ(vector.sum_squares, scalar.sum_squares);
+    EXPECT_EQ(vector.max_amplitude, scalar.max_amplitude);
+    EXPECT_EQ(vector.zero_crossings, scalar.zero_crossings);
+    EXPECT_EQ(vector.diff_sum, scalar.diff_sum);
+    EXPECT_EQ(vector.weighted_diff_sum, scalar.weighted_diff_sum);
+    EXPECT_EQ(vector.count, scalar.count);
+    EXPECT_EQ(vector.first_sample, scalar.first_sample);
+    EXPECT_EQ(vector.last_sample, scalar.last_sample);
+}
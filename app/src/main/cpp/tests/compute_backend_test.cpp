@@ -0,0 +1,110 @@
+#include <cstdint>
+#include <memory>
+
+#include "compute_backend.h"
+#include "test_harness.h"
+
+namespace {
+
+// Records the work it is handed; the host registry has no platform delegates
+class FakeDelegate : public ComputeDelegate {
+public:
+    FakeDelegate(BackendKind kind, bool fails = false) : kind_(kind), fails_(fails) {}
+
+    BackendKind kind() const override { return kind_; }
+    const char* name() const override { return "fake"; }
+    bool run(int64_t cpu_us) override {
+        ran_us += cpu_us;
+        return !fails_;
+    }
+
+    int64_t ran_us = 0;
+
+private:
+    BackendKind kind_;
+    bool fails_;
+};
+
+std::shared_ptr<FakeDelegate> addFake(BackendKind kind, bool fails = false) {
+    auto delegate = std::make_shared<FakeDelegate>(kind, fails);
+    BackendRegistry::shared().add(delegate);
+    return delegate;
+}
+
+} // namespace
+
+TEST(OffloadSplitsPassByLayers) {
+    auto qnn = addFake(BackendKind::QNN);
+    LayerOffload offload(ModelRole::ENCODER, 10);
+    EXPECT_TRUE(offload.configure(LayerOffload::AUTO, 4));
+
+    int64_t cpu_us = 0;
+    offload.run(1000, [&cpu_us](int64_t us) { cpu_us += us; });
+    EXPECT_EQ(qnn->ran_us, 400);
+    EXPECT_EQ(cpu_us, 600);
+
+    OffloadStats stats = offload.stats();
+    EXPECT_TRUE(stats.backend == BackendKind::QNN);
+    EXPECT_EQ(stats.layers, 4);
+    EXPECT_EQ(stats.offloaded_passes, 1u);
+    EXPECT_EQ(stats.cpu_passes, 0u);
+}
+
+TEST(OffloadAutoPrefersGpuForDecoder) {
+    addFake(BackendKind::QNN);
+    auto vulkan = addFake(BackendKind::VULKAN);
+    EXPECT_TRUE(BackendRegistry::shared().preferred(ModelRole::DECODER) == vulkan);
+    EXPECT_TRUE(BackendRegistry::shared().preferred(ModelRole::ENCODER)->kind() == BackendKind::QNN);
+}
+
+TEST(OffloadRejectsMissingBackendAndBadLayerCount) {
+    LayerOffload offload(ModelRole::ENCODER, 10);
+    // NNAPI is never registered in this process
+    EXPECT_FALSE(offload.configure(static_cast<int32_t>(BackendKind::NNAPI), 4));
+    EXPECT_FALSE(offload.configure(LayerOffload::AUTO, 11));
+    EXPECT_FALSE(offload.configure(LayerOffload::AUTO, -1));
+    EXPECT_TRUE(offload.stats().backend == BackendKind::CPU);
+
+    // Zero layers is the CPU whatever the kind
+    addFake(BackendKind::QNN);
+    EXPECT_TRUE(offload.configure(static_cast<int32_t>(BackendKind::QNN), 0));
+    EXPECT_TRUE(offload.stats().backend == BackendKind::CPU);
+}
+
+TEST(OffloadFallsBackToCpuWhenDelegateFails) {
+    auto failing = addFake(BackendKind::VULKAN, true);
+    LayerOffload offload(ModelRole::DECODER, 8);
+    EXPECT_TRUE(offload.configure(static_cast<int32_t>(BackendKind::VULKAN), 8));
+
+    int64_t cpu_us = 0;
+    offload.run(800, [&cpu_us](int64_t us) { cpu_us += us; });
+    EXPECT_EQ(cpu_us, 800);
+    // The delegate is dropped, so the next pass never reaches it
+    offload.run(800, [&cpu_us](int64_t us) { cpu_us += us; });
+    EXPECT_EQ(cpu_us, 1600);
+    EXPECT_EQ(failing->ran_us, 800);
+
+    OffloadStats stats = offload.stats();
+    EXPECT_TRUE(stats.backend == BackendKind::CPU);
+    EXPECT_EQ(stats.failures, 1u);
+    EXPECT_EQ(stats.cpu_passes, 2u);
+}
+
+TEST(OffloadRunsOnCpuWhileSuspended) {
+    auto vulkan = addFake(BackendKind::VULKAN);
+    LayerOffload offload(ModelRole::DECODER, 8);
+    EXPECT_TRUE(offload.configure(LayerOffload::AUTO, 8));
+
+    BackendRegistry::shared().setSuspended(true);
+    int64_t cpu_us = 0;
+    offload.run(500, [&cpu_us](int64_t us) { cpu_us += us; });
+    BackendRegistry::shared().setSuspended(false);
+    EXPECT_EQ(cpu_us, 500);
+    EXPECT_EQ(vulkan->ran_us, 0);
+
+    // Suspension keeps the plan for when it is lifted
+    offload.run(500, [&cpu_us](int64_t us) { cpu_us += us; });
+    EXPECT_EQ(vulkan->ran_us, 500);
+    EXPECT_EQ(offload.stats().cpu_passes, 1u);
+    EXPECT_EQ(offload.stats().offloaded_passes, 1u);
+}
@@ -0,0 +1,85 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "asr_core.h"
+#include "test_harness.h"
+
+namespace {
+
+uint16_t halfAt(const std::vector<uint8_t>& packed, size_t i) {
+    uint16_t half;
+    std::memcpy(&half, packed.data() + i * sizeof(half), sizeof(half));
+    return half;
+}
+
+} // namespace
+
+TEST(ConfidenceSummarizesLogProbsAndWords) {
+    ResultArena arena;
+    InferenceResult result;
+    result.log_probs.offset = arena.floats.size();
+    for (float log_prob : {-0.1f, -0.5f, -0.3f}) {
+        arena.floats.push_back(log_prob);
+    }
+    result.log_probs.length = 3;
+    result.alignments.offset = arena.alignments.size();
+    for (float confidence : {0.6f, 1.0f}) {
+        AlignmentInfo align;
+        align.word = arena.appendText("word");
+        align.start_time = 0.0f;
+        align.end_time = 0.1f;
+        align.confidence = confidence;
+        arena.alignments.push_back(align);
+    }
+    result.alignments.length = 2;
+
+    ConfidenceSummary summary = summarizeConfidence(arena, result);
+    EXPECT_TRUE(std::fabs(summary.mean_log_prob - -0.3f) < 1e-6f);
+    EXPECT_EQ(summary.min_log_prob, -0.5f);
+    EXPECT_TRUE(std::fabs(summary.word_confidence - 0.8f) < 1e-6f);
+    EXPECT_TRUE(summary.confidence > 0.5f && summary.confidence < 1.0f);
+}
+
+TEST(ConfidenceIsZeroWithoutTokens) {
+    ResultArena arena;
+    InferenceResult result;
+    ConfidenceSummary summary = summarizeConfidence(arena, result);
+    EXPECT_EQ(summary.confidence, 0.0f);
+    EXPECT_EQ(summary.word_confidence, 0.0f);
+}
+
+TEST(LogProbsPackToHalfRoundingToNearestEven) {
+    // 1 + 2^-11 is halfway between two halves and rounds down to the even one
+    const float values[] = {1.0f, -0.5f, 1.0f + 1.0f / 2048.0f, 65520.0f, 1e-8f, -INFINITY};
+    const size_t count = sizeof(values) / sizeof(values[0]);
+    std::vector<uint8_t> packed(packedLogProbBytes(LogProbFormat::FLOAT16, count));
+    EXPECT_EQ(packed.size(), count * 2);
+    EXPECT_EQ(packLogProbs(values, count, LogProbFormat::FLOAT16, packed.data()), 1.0f);
+    EXPECT_EQ(halfAt(packed, 0), 0x3C00u);
+    EXPECT_EQ(halfAt(packed, 1), 0xB800u);
+    EXPECT_EQ(halfAt(packed, 2), 0x3C00u);
+    EXPECT_EQ(halfAt(packed, 3), 0x7C00u);
+    EXPECT_EQ(halfAt(packed, 4), 0x0000u);
+    EXPECT_EQ(halfAt(packed, 5), 0xFC00u);
+}
+
+TEST(LogProbsPackToInt8WithinHalfAStep) {
+    const float values[] = {-12.7f, -3.3f, -0.04f, 0.0f};
+    const size_t count = sizeof(values) / sizeof(values[0]);
+    std::vector<uint8_t> packed(packedLogProbBytes(LogProbFormat::INT8, count));
+    EXPECT_EQ(packed.size(), count);
+    const float scale = packLogProbs(values, count, LogProbFormat::INT8, packed.data());
+    EXPECT_TRUE(std::fabs(scale - 0.1f) < 1e-6f);
+    EXPECT_EQ(static_cast<int8_t>(packed[0]), -127);
+    for (size_t i = 0; i < count; ++i) {
+        const float restored = static_cast<int8_t>(packed[i]) * scale;
+        EXPECT_TRUE(std::fabs(restored - values[i]) <= scale / 2);
+    }
+}
+
+TEST(LogProbsNoneFormatPacksNothing) {
+    EXPECT_EQ(packedLogProbBytes(LogProbFormat::NONE, 10), 0u);
+    EXPECT_EQ(packedLogProbBytes(LogProbFormat::FLOAT32, 10), 40u);
+}
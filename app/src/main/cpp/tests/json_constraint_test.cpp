@@ -0,0 +1,108 @@
+#include <memory>
+#include <string>
+
+#include "json_constraint.h"
+#include "test_harness.h"
+
+namespace {
+
+const char* NOTE_SCHEMA = R"({
+  "type": "object",
+  "required": ["status", "medications"],
+  "additionalProperties": false,
+  "properties": {
+    "status": {"type": "string", "enum": ["draft", "final"]},
+    "summary": {"type": "string", "maxLength": 5},
+    "medications": {
+      "type": "array",
+      "minItems": 1,
+      "maxItems": 2,
+      "items": {"$ref": "#/definitions/medication"}
+    }
+  },
+  "definitions": {
+    "medication": {
+      "type": "object",
+      "required": ["name"],
+      "properties": {"name": {"type": "string", "minLength": 1}, "days": {"type": "integer"}}
+    }
+  }
+})";
+
+std::shared_ptr<const JsonSchema> noteSchema() {
+    std::string error;
+    auto schema = compileJsonSchema(NOTE_SCHEMA, &error);
+    if (!schema) {
+        test::fail(__FILE__, __LINE__, "schema did not compile: " + error);
+    }
+    return schema;
+}
+
+// Whether the whole document is accepted and closes the root value
+bool acceptsDocument(const std::shared_ptr<const JsonSchema>& schema, const std::string& document) {
+    JsonConstraint constraint(schema);
+    return constraint.advance(document) && constraint.complete();
+}
+
+} // namespace
+
+TEST(JsonConstraintAcceptsConformingDocument) {
+    auto schema = noteSchema();
+    ASSERT_TRUE(schema != nullptr);
+    EXPECT_TRUE(acceptsDocument(schema, R"({"status": "final", "medications": [{"name": "x", "days": 5}]})"));
+    EXPECT_TRUE(acceptsDocument(schema, R"({"medications":[{"name":"a"},{"name":"b"}],"status":"draft","summary":"ok"})"));
+}
+
+TEST(JsonConstraintRejectsSchemaViolations) {
+    auto schema = noteSchema();
+    ASSERT_TRUE(schema != nullptr);
+    // Enum value, additional property, length and item bounds, and item type
+    EXPECT_FALSE(acceptsDocument(schema, R"({"status": "open", "medications": [{"name": "x"}]})"));
+    EXPECT_FALSE(acceptsDocument(schema, R"({"status": "final", "extra": 1, "medications": [{"name": "x"}]})"));
+    EXPECT_FALSE(acceptsDocument(schema, R"({"status": "final", "summary": "too long", "medications": [{"name": "x"}]})"));
+    EXPECT_FALSE(acceptsDocument(schema, R"({"status": "final", "medications": []})"));
+    EXPECT_FALSE(acceptsDocument(schema, R"({"status": "final", "medications": [{"name": "a"}, {"name": "b"}, {"name": "c"}]})"));
+    EXPECT_FALSE(acceptsDocument(schema, R"({"status": "final", "medications": [{"name": "x", "days": 1.5}]})"));
+    EXPECT_FALSE(acceptsDocument(schema, R"([1, 2])"));
+}
+
+TEST(JsonConstraintRejectsClosingBeforeRequired) {
+    auto schema = noteSchema();
+    ASSERT_TRUE(schema != nullptr);
+    JsonConstraint constraint(schema);
+    EXPECT_TRUE(constraint.advance(R"({"status": "draft")"));
+    EXPECT_FALSE(constraint.allows("}"));
+    EXPECT_TRUE(constraint.allows(","));
+    EXPECT_FALSE(constraint.complete());
+}
+
+TEST(JsonConstraintAllowsLeavesStateUnchanged) {
+    auto schema = noteSchema();
+    ASSERT_TRUE(schema != nullptr);
+    JsonConstraint constraint(schema);
+    EXPECT_TRUE(constraint.advance(R"({"status": ")"));
+    EXPECT_TRUE(constraint.allows("fin"));
+    EXPECT_FALSE(constraint.allows("x"));
+    // Enum prefixes stay open until one is closed
+    EXPECT_TRUE(constraint.advance("dr"));
+    EXPECT_FALSE(constraint.allows("afts\""));
+    EXPECT_TRUE(constraint.advance("aft\""));
+}
+
+TEST(JsonConstraintAllowedPrefixStopsAtFirstViolation) {
+    auto schema = noteSchema();
+    ASSERT_TRUE(schema != nullptr);
+    JsonConstraint constraint(schema);
+    const std::string text = R"({"status": "final", "bogus")";
+    EXPECT_EQ(constraint.allowedPrefix(text), text.find("bogus"));
+    EXPECT_FALSE(constraint.advance(text));
+    // A rejected advance appends nothing
+    EXPECT_TRUE(constraint.advance("{"));
+}
+
+TEST(JsonConstraintReportsCompileErrors) {
+    std::string error;
+    EXPECT_TRUE(compileJsonSchema("{\"type\": ", &error) == nullptr);
+    EXPECT_FALSE(error.empty());
+    EXPECT_TRUE(compileJsonSchema(R"({"$ref": "#/definitions/missing"})", &error) == nullptr);
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pcm_resampler.h"
+#include "test_harness.h"
+
+namespace {
+
+constexpr int OUTPUT_RATE = 16000;
+
+// The decimation fast path and the polyphase path
+const int INPUT_RATES[] = {48000, 44100};
+
+std::vector<int16_t> tonePcm(int rate, double hz, size_t count, double amplitude) {
+    std::vector<int16_t> pcm(count);
+    for (size_t i = 0; i < count; ++i) {
+        pcm[i] = static_cast<int16_t>(std::lround(amplitude * 32767.0 * std::sin(2.0 * M_PI * hz * i / rate)));
+    }
+    return pcm;
+}
+
+std::vector<int16_t> noisePcm(size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> value(-32768, 32767);
+    std::vector<int16_t> pcm(count);
+    for (int16_t& s : pcm) {
+        s = static_cast<int16_t>(value(rng));
+    }
+    return pcm;
+}
+
+std::vector<float> resampleAll(PcmResampler& resampler, const std::vector<int16_t>& pcm) {
+    resampler.feed(pcm.data(), pcm.size());
+    std::vector<float> out(resampler.available());
+    resampler.produce(out.data(), out.size());
+    return out;
+}
+
+// Output RMS over the settled part, past the filter's start-up from silence
+double settledRms(const std::vector<float>& out, size_t skip) {
+    double sum = 0.0;
+    for (size_t i = skip; i < out.size(); ++i) {
+        sum += static_cast<double>(out[i]) * out[i];
+    }
+    return std::sqrt(sum / (out.size() - skip));
+}
+
+} // namespace
+
+TEST(ResamplerOutputCountFollowsRatio) {
+    for (int rate : INPUT_RATES) {
+        for (size_t count : {0u, 1u, 2u, 3u, 441u, 4800u, 4801u, 12345u}) {
+            PcmResampler resampler(rate, OUTPUT_RATE);
+            std::vector<int16_t> pcm(count, 100);
+            resampler.feed(pcm.data(), pcm.size());
+            // Output n reads input floor(n * in / out), so count inputs complete
+            // ceil(count * out / in) outputs
+            const size_t expected = (count * OUTPUT_RATE + rate - 1) / rate;
+            EXPECT_EQ(resampler.available(), expected);
+        }
+    }
+}
+
+TEST(ResamplerInputsForFillsExactlyToLimit) {
+    for (int rate : INPUT_RATES) {
+        PcmResampler resampler(rate, OUTPUT_RATE);
+        std::vector<int16_t> pcm = noisePcm(rate);
+        size_t offset = 0;
+        for (size_t room : {1u, 7u, 160u, 333u, 1000u}) {
+            const size_t inputs = resampler.inputsFor(room);
+            resampler.feed(pcm.data() + offset, inputs);
+            offset += inputs;
+            EXPECT_TRUE(resampler.available() <= room);
+            // One more input would complete an output past the limit
+            PcmResampler probe = resampler;
+            probe.feed(pcm.data() + offset, 1);
+            EXPECT_TRUE(probe.available() > room);
+
+            std::vector<float> out(resampler.available());
+            resampler.produce(out.data(), out.size());
+        }
+    }
+}
+
+TEST(ResamplerPassbandGainNearUnity) {
+    for (int rate : INPUT_RATES) {
+        for (double hz : {300.0, 1000.0, 3000.0, 5000.0}) {
+            PcmResampler resampler(rate, OUTPUT_RATE);
+            std::vector<float> out = resampleAll(resampler, tonePcm(rate, hz, rate / 2, 0.5));
+            const double gain = settledRms(out, resampler.tapsPerPhase()) / (0.5 / std::sqrt(2.0));
+            if (std::fabs(gain - 1.0) > 0.01) {
+                test::fail(__FILE__, __LINE__, "passband gain " + std::to_string(gain) + " at " +
+                           std::to_string(hz) + " Hz from " + std::to_string(rate));
+            }
+        }
+    }
+}
+
+TEST(ResamplerAttenuatesStopband) {
+    for (int rate : INPUT_RATES) {
+        for (double hz : {10000.0, 12000.0, 20000.0}) {
+            PcmResampler resampler(rate, OUTPUT_RATE);
+            std::vector<float> out = resampleAll(resampler, tonePcm(rate, hz, rate / 2, 0.5));
+            const double gain = settledRms(out, resampler.tapsPerPhase()) / (0.5 / std::sqrt(2.0));
+            // Better than -60 dB of aliasing into the band
+            if (gain > 1e-3) {
+                test::fail(__FILE__, __LINE__, "stopband gain " + std::to_string(gain) + " at " +
+                           std::to_string(hz) + " Hz from " + std::to_string(rate));
+            }
+        }
+    }
+}
+
+TEST(ResamplerSplitFeedsMatchOneFeed) {
+    for (int rate : INPUT_RATES) {
+        std::vector<int16_t> pcm = noisePcm(rate);
+        PcmResampler whole(rate, OUTPUT_RATE);
+        const std::vector<float> expected = resampleAll(whole, pcm);
+
+        // Odd feed sizes, each drained only partly, the way the ring takes them
+        PcmResampler split(rate, OUTPUT_RATE);
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<size_t> piece(1, 700);
+        std::vector<float> out;
+        size_t offset = 0;
+        while (offset < pcm.size()) {
+            const size_t count = std::min(piece(rng), pcm.size() - offset);
+            split.feed(pcm.data() + offset, count);
+            offset += count;
+            const size_t n = offset < pcm.size() ? split.available() / 2 : split.available();
+            out.resize(out.size() + n);
+            split.produce(out.data() + out.size() - n, n);
+        }
+        const size_t rest = split.available();
+        out.resize(out.size() + rest);
+        split.produce(out.data() + out.size() - rest, rest);
+        EXPECT_TRUE(out == expected);
+    }
+}
@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "prefix_cache.h"
+#include "test_harness.h"
+
+namespace {
+
+// A shared head of HEAD_TOKENS tokens followed by a tail unique to seed
+std::vector<int32_t> prompt(int32_t head_seed, int32_t tail_seed, size_t tail_length) {
+    std::vector<int32_t> tokens;
+    for (size_t i = 0; i < PrefixCache::HEAD_TOKENS; ++i) {
+        tokens.push_back(head_seed * 1000 + static_cast<int32_t>(i));
+    }
+    for (size_t i = 0; i < tail_length; ++i) {
+        tokens.push_back(tail_seed * 1000 + static_cast<int32_t>(i));
+    }
+    return tokens;
+}
+
+} // namespace
+
+TEST(PrefixCacheHitsOnSharedPrefix) {
+    PrefixCache cache;
+    std::vector<int32_t> stored = prompt(1, 1, 8);
+    cache.store(stored);
+
+    std::vector<int32_t> extended = stored;
+    extended.push_back(99);
+    EXPECT_EQ(cache.longestPrefix(extended), stored.size());
+
+    // Same head, different tail: only the head is reusable
+    EXPECT_EQ(cache.longestPrefix(prompt(1, 2, 8)), PrefixCache::HEAD_TOKENS);
+}
+
+TEST(PrefixCacheMissesOnOtherHeadOrShortPrompt) {
+    PrefixCache cache;
+    cache.store(prompt(1, 1, 8));
+    EXPECT_EQ(cache.longestPrefix(prompt(2, 1, 8)), 0u);
+
+    std::vector<int32_t> short_prompt(PrefixCache::HEAD_TOKENS - 1, 7);
+    cache.store(short_prompt);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.longestPrefix(short_prompt), 0u);
+}
+
+TEST(PrefixCacheExtendingPromptSupersedesEntry) {
+    PrefixCache cache;
+    std::vector<int32_t> first = prompt(1, 1, 4);
+    std::vector<int32_t> longer = prompt(1, 1, 8);
+    cache.store(first);
+    cache.store(longer);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.tokenCount(), longer.size());
+    // The shorter prompt is served by the longer entry
+    EXPECT_EQ(cache.longestPrefix(first), first.size());
+}
+
+TEST(PrefixCacheEvictsLeastRecentlyUsed) {
+    PrefixCache cache(2);
+    std::vector<int32_t> a = prompt(1, 1, 4);
+    std::vector<int32_t> b = prompt(2, 1, 4);
+    std::vector<int32_t> c = prompt(3, 1, 4);
+    cache.store(a);
+    cache.store(b);
+    // Touching a leaves b as the oldest
+    EXPECT_EQ(cache.longestPrefix(a), a.size());
+    cache.store(c);
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.longestPrefix(a), a.size());
+    EXPECT_EQ(cache.longestPrefix(b), 0u);
+    EXPECT_EQ(cache.longestPrefix(c), c.size());
+}
+
+TEST(PrefixCacheShrinkReportsEvictedTokens) {
+    PrefixCache cache;
+    std::vector<int32_t> a = prompt(1, 1, 4);
+    std::vector<int32_t> b = prompt(2, 1, 10);
+    cache.store(a);
+    cache.store(b);
+    EXPECT_EQ(cache.shrink(1), a.size());
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.shrink(0), b.size());
+    EXPECT_EQ(cache.tokenCount(), 0u);
+}
+
+TEST(PrefixCacheSaveLoadRoundTrips) {
+    const char* path = "native_tests_prefix.cache";
+    PrefixCache saved;
+    std::vector<int32_t> a = prompt(1, 1, 4);
+    saved.store(a);
+    ASSERT_TRUE(saved.save(path));
+
+    PrefixCache loaded;
+    EXPECT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.size(), 1u);
+    EXPECT_EQ(loaded.longestPrefix(a), a.size());
+    std::remove(path);
+
+    EXPECT_FALSE(loaded.load(path));
+}
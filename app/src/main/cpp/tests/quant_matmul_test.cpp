@@ -0,0 +1,80 @@
+// Every quantized matmul variant must match the scalar reference bit for
+// bit, so the kernel a device happens to pick never changes model output.
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "cpu_features.h"
+#include "native_kernels.h"
+#include "quant_matmul.h"
+#include "test_harness.h"
+
+namespace {
+
+struct Shape {
+    size_t rows;
+    size_t cols;
+    size_t blocks;
+};
+
+// Odd rows and columns exercise the tails the wider kernels finish separately
+const Shape SHAPES[] = {{1, 1, 1}, {2, 2, 3}, {5, 3, 4}, {8, 8, 2}, {17, 4, 3}, {64, 1, 8}};
+
+std::vector<BlockQ8> randomBlocks(size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+    std::vector<float> floats(count * Q8_BLOCK);
+    for (float& f : floats) {
+        f = value(rng);
+    }
+    std::vector<BlockQ8> blocks(count);
+    quantizeQ8(floats.data(), blocks.data(), floats.size());
+    return blocks;
+}
+
+void expectMatchesScalar(const char* variant, MatmulQ8Kernel kernel) {
+    std::mt19937 rng(42);
+    for (const Shape& shape : SHAPES) {
+        std::vector<BlockQ8> weights = randomBlocks(shape.rows * shape.blocks, rng);
+        std::vector<BlockQ8> inputs = randomBlocks(shape.cols * shape.blocks, rng);
+        std::vector<float> expected(shape.rows * shape.cols);
+        std::vector<float> actual(shape.rows * shape.cols, -1.0f);
+        matmulQ8Scalar(weights.data(), shape.rows, inputs.data(), shape.cols, shape.blocks, expected.data());
+        kernel(weights.data(), shape.rows, inputs.data(), shape.cols, shape.blocks, actual.data());
+        if (std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) != 0) {
+            test::fail(__FILE__, __LINE__,
+                       std::string(variant) + " differs from scalar at " + std::to_string(shape.rows) + "x" +
+                           std::to_string(shape.cols) + "x" + std::to_string(shape.blocks));
+        }
+    }
+}
+
+} // namespace
+
+TEST(MatmulQ8BaselineMatchesScalar) {
+    expectMatchesScalar("baseline", matmulQ8Baseline);
+}
+
+TEST(MatmulQ8DispatchedMatchesScalar) {
+    expectMatchesScalar(nativeKernels().matmul_variant, matmulQ8);
+}
+
+TEST(MatmulQ8ExtensionVariantsMatchScalar) {
+    // Variants this build compiled but the CPU cannot run are skipped
+#if defined(AMBIENT_KERNELS_AVX2)
+    if (hasCpuFeatures(CPU_FEATURE_AVX2 | CPU_FEATURE_FMA)) {
+        expectMatchesScalar("avx2", matmulQ8Avx2);
+    }
+#endif
+#if defined(AMBIENT_KERNELS_DOTPROD)
+    if (hasCpuFeatures(CPU_FEATURE_DOTPROD)) {
+        expectMatchesScalar("dotprod", matmulQ8Dotprod);
+    }
+#endif
+#if defined(AMBIENT_KERNELS_I8MM)
+    if (hasCpuFeatures(CPU_FEATURE_I8MM | CPU_FEATURE_DOTPROD)) {
+        expectMatchesScalar("i8mm", matmulQ8I8mm);
+    }
+#endif
+}
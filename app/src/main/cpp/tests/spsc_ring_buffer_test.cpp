@@ -0,0 +1,80 @@
+#include <vector>
+
+#include "spsc_ring_buffer.h"
+#include "test_harness.h"
+
+TEST(RingRoundsCapacityToPowerOfTwo) {
+    SpscRingBuffer<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_EQ(ring.size(), 0u);
+    EXPECT_EQ(ring.freeSpace(), 8u);
+}
+
+TEST(RingPushStopsWhenFull) {
+    SpscRingBuffer<int> ring(4);
+    const int values[] = {1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(ring.push(values, 6), 4u);
+    EXPECT_EQ(ring.freeSpace(), 0u);
+    EXPECT_EQ(ring.push(values, 1), 0u);
+}
+
+TEST(RingWrapsAroundInOrder) {
+    SpscRingBuffer<int> ring(4);
+    int next_in = 0;
+    int next_out = 0;
+    // Pushes of three against pops of two walk the indices across the end
+    // of storage many times over
+    for (int round = 0; round < 20; ++round) {
+        int in[3];
+        for (int& v : in) {
+            v = next_in++;
+        }
+        const size_t pushed = ring.push(in, 3);
+        next_in -= static_cast<int>(3 - pushed);
+
+        int out[2] = {-1, -1};
+        const size_t popped = ring.pop(out, 2);
+        for (size_t i = 0; i < popped; ++i) {
+            EXPECT_EQ(out[i], next_out++);
+        }
+    }
+    int rest[4];
+    const size_t left = ring.pop(rest, 4);
+    for (size_t i = 0; i < left; ++i) {
+        EXPECT_EQ(rest[i], next_out++);
+    }
+    EXPECT_EQ(next_out, next_in);
+    EXPECT_EQ(ring.pushedTotal(), ring.poppedTotal());
+}
+
+TEST(RingPushInPlaceSplitsAtTheWrap) {
+    SpscRingBuffer<int> ring(4);
+    const int head[] = {0, 1, 2};
+    ring.push(head, 3);
+    EXPECT_EQ(ring.discard(3), 3u);
+
+    // Write position is 3 of 4, so four elements go in as 1 + 3
+    std::vector<std::pair<size_t, size_t>> calls;
+    const size_t written = ring.pushInPlace(4, [&calls](int* dst, size_t offset, size_t n) {
+        calls.emplace_back(offset, n);
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = static_cast<int>(10 + offset + i);
+        }
+    });
+    EXPECT_EQ(written, 4u);
+    ASSERT_TRUE(calls.size() == 2);
+    EXPECT_EQ(calls[0].first, 0u);
+    EXPECT_EQ(calls[0].second, 1u);
+    EXPECT_EQ(calls[1].first, 1u);
+    EXPECT_EQ(calls[1].second, 3u);
+
+    int peeked[4] = {};
+    EXPECT_EQ(ring.peek(peeked, 4), 4u);
+    EXPECT_EQ(ring.size(), 4u);
+    int popped[4] = {};
+    EXPECT_EQ(ring.pop(popped, 4), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(peeked[i], 10 + i);
+        EXPECT_EQ(popped[i], 10 + i);
+    }
+}
@@ -0,0 +1,71 @@
+#include "test_harness.h"
+
+#include <cstdio>
+#include <cstring>
+#include <regex>
+#include <vector>
+
+namespace test {
+
+namespace {
+
+struct Registered {
+    const char* name;
+    TestFn fn;
+};
+
+std::vector<Registered>& registry() {
+    static std::vector<Registered> tests;
+    return tests;
+}
+
+int g_failures = 0;
+
+} // namespace
+
+bool registerTest(const char* name, TestFn fn) {
+    registry().push_back({name, fn});
+    return true;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+    g_failures++;
+}
+
+int runTests(int argc, char** argv) {
+    std::regex filter(".*");
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--test_filter=", 14) == 0) {
+            filter = std::regex(argv[i] + 14);
+        } else {
+            std::fprintf(stderr, "Unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int run = 0;
+    int failed = 0;
+    for (const Registered& test : registry()) {
+        if (!std::regex_search(test.name, filter)) {
+            continue;
+        }
+        const int before = g_failures;
+        test.fn();
+        run++;
+        if (g_failures != before) {
+            failed++;
+            std::printf("[  FAILED  ] %s\n", test.name);
+        } else {
+            std::printf("[       OK ] %s\n", test.name);
+        }
+    }
+    std::printf("%d tests, %d failed\n", run, failed);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
+
+} // namespace test
+
+int main(int argc, char** argv) {
+    return test::runTests(argc, argv);
+}
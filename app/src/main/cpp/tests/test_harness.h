@@ -0,0 +1,65 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+// Minimal test runner for the native core, so native_tests needs no
+// third-party code in the NDK build, like native_bench. Tests register
+// themselves; a failed check reports and the test carries on, so one run
+// lists every mismatch.
+//
+//   TEST(RingWrapsAround) {
+//       SpscRingBuffer<int> ring(4);
+//       EXPECT_EQ(ring.capacity(), 4u);
+//   }
+namespace test {
+
+using TestFn = void (*)();
+
+bool registerTest(const char* name, TestFn fn);
+
+// Records a failure of the running test
+void fail(const char* file, int line, const std::string& message);
+
+template <typename A, typename B>
+void expectEq(const A& actual, const B& expected, const char* actual_text, const char* expected_text,
+              const char* file, int line) {
+    if (!(actual == expected)) {
+        std::ostringstream message;
+        message << actual_text << " == " << expected_text << ": got " << actual << ", expected " << expected;
+        fail(file, line, message.str());
+    }
+}
+
+// Parses --test_filter=<regex> and runs every matching test. Returns the
+// process exit code: 0 only if every test passed.
+int runTests(int argc, char** argv);
+
+} // namespace test
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+#define TEST(name) \
+    static void name(); \
+    static bool TEST_CONCAT(test_registered_, name) [[maybe_unused]] = test::registerTest(#name, name); \
+    static void name()
+
+#define EXPECT_TRUE(condition) \
+    do { \
+        if (!(condition)) { \
+            test::fail(__FILE__, __LINE__, "expected " #condition); \
+        } \
+    } while (0)
+
+#define EXPECT_FALSE(condition) EXPECT_TRUE(!(condition))
+
+#define EXPECT_EQ(actual, expected) test::expectEq((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+// Stops the test when the rest of it depends on the check
+#define ASSERT_TRUE(condition) \
+    do { \
+        if (!(condition)) { \
+            test::fail(__FILE__, __LINE__, "expected " #condition); \
+            return; \
+        } \
+    } while (0)
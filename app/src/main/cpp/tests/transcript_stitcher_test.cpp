@@ -0,0 +1,107 @@
+#include <string>
+#include <vector>
+
+#include "asr_core.h"
+#include "test_harness.h"
+
+namespace {
+
+// 2 s windows overlapping by 0.5 s, so each starts 1.5 s after the last
+constexpr size_t WINDOW = 2 * ASR_SAMPLE_RATE;
+constexpr size_t OVERLAP = ASR_SAMPLE_RATE / 2;
+
+struct DecodedWord {
+    const char* text;
+    float start_time;
+    float end_time;
+    float confidence;
+};
+
+// Appends a decoded window to arena as the decoder would, times relative to
+// the window, and returns it as the arena's last result
+InferenceResult& appendWindow(ResultArena& arena, const std::vector<DecodedWord>& words) {
+    std::string joined;
+    for (const DecodedWord& word : words) {
+        joined += (joined.empty() ? "" : " ") + std::string(word.text);
+    }
+    InferenceResult result;
+    result.text = arena.appendText(joined.c_str());
+    result.words = result.text;
+    result.alignments.offset = arena.alignments.size();
+    for (const DecodedWord& word : words) {
+        AlignmentInfo align;
+        align.word = arena.appendText(word.text);
+        align.start_time = word.start_time;
+        align.end_time = word.end_time;
+        align.confidence = word.confidence;
+        arena.alignments.push_back(align);
+    }
+    result.alignments.length = words.size();
+    arena.results.push_back(result);
+    return arena.results.back();
+}
+
+const AlignmentInfo& alignment(const ResultArena& arena, const InferenceResult& result, size_t i) {
+    return arena.alignments[result.alignments.offset + i];
+}
+
+} // namespace
+
+TEST(StitcherHoldsBackTrailingOverlapWords) {
+    TranscriptStitcher stitcher(WINDOW, OVERLAP);
+    ResultArena arena;
+    InferenceResult& first = appendWindow(arena, {{"the", 0.1f, 0.4f, 0.9f},
+                                                  {"patient", 0.6f, 1.2f, 0.8f},
+                                                  {"reports", 1.6f, 1.9f, 0.4f}});
+    stitcher.stitch(arena, first, WINDOW);
+    EXPECT_EQ(arena.view(first.text), "the patient");
+    EXPECT_EQ(first.alignments.length, 2u);
+    EXPECT_EQ(stitcher.nextWindowStart(), 1.5);
+}
+
+TEST(StitcherKeepsMoreConfidentReadingOfOverlap) {
+    TranscriptStitcher stitcher(WINDOW, OVERLAP);
+    ResultArena arena;
+    stitcher.stitch(arena, appendWindow(arena, {{"patient", 0.6f, 1.2f, 0.8f}, {"reports", 1.6f, 1.9f, 0.4f}}),
+                    WINDOW);
+
+    // The same word again at 1.6 s session time, now decoded with context
+    arena.reset();
+    InferenceResult& second = appendWindow(arena, {{"reports", 0.1f, 0.4f, 0.9f}, {"pain", 0.8f, 1.1f, 0.7f}});
+    stitcher.stitch(arena, second, WINDOW);
+    EXPECT_EQ(arena.view(second.text), "reports pain");
+    ASSERT_TRUE(second.alignments.length == 2);
+    EXPECT_EQ(alignment(arena, second, 0).confidence, 0.9f);
+    // Rebased by the hop
+    EXPECT_EQ(alignment(arena, second, 1).start_time, 2.3f);
+    EXPECT_EQ(alignment(arena, second, 1).end_time, 2.6f);
+}
+
+TEST(StitcherKeepsHeldBackReadingWhenMoreConfident) {
+    TranscriptStitcher stitcher(WINDOW, OVERLAP);
+    ResultArena arena;
+    stitcher.stitch(arena, appendWindow(arena, {{"reports", 1.6f, 1.9f, 0.9f}}), WINDOW);
+
+    arena.reset();
+    InferenceResult& second = appendWindow(arena, {{"report", 0.12f, 0.38f, 0.3f}, {"pain", 0.8f, 1.1f, 0.7f}});
+    stitcher.stitch(arena, second, WINDOW);
+    EXPECT_EQ(arena.view(second.text), "reports pain");
+    EXPECT_EQ(alignment(arena, second, 0).start_time, 1.6f);
+}
+
+TEST(StitcherFlushedWindowReleasesEveryWord) {
+    TranscriptStitcher stitcher(WINDOW, OVERLAP);
+    ResultArena arena;
+    stitcher.stitch(arena, appendWindow(arena, {{"hello", 0.2f, 0.6f, 0.9f}}), WINDOW);
+
+    // One second of speech, flushed at an utterance end; the word in what
+    // would be the overlap is final since no window follows it
+    arena.reset();
+    InferenceResult& flushed = appendWindow(arena, {{"done", 0.7f, 0.95f, 0.8f}});
+    stitcher.stitch(arena, flushed, ASR_SAMPLE_RATE);
+    EXPECT_EQ(arena.view(flushed.text), "done");
+    EXPECT_EQ(stitcher.nextWindowStart(), 2.5);
+
+    stitcher.reset();
+    EXPECT_EQ(stitcher.nextWindowStart(), 0.0);
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "voice_activity_detector.h"
+#include "test_harness.h"
+
+namespace {
+
+constexpr int RATE = 16000;
+constexpr float PI = 3.14159265358979f;
+
+// Generates consecutive frames, with sample time carried across them
+class Signal {
+public:
+    explicit Signal(size_t frame_samples) : frame_(frame_samples) {}
+
+    const float* silence() {
+        std::fill(frame_.begin(), frame_.end(), 0.0f);
+        return advance();
+    }
+
+    const float* tone(float hz, float amplitude) {
+        for (size_t i = 0; i < frame_.size(); ++i) {
+            frame_[i] = amplitude * std::sin(2.0f * PI * hz * (time_ + i) / RATE);
+        }
+        return advance();
+    }
+
+    // Flat-spectrum noise: loud, but nothing like speech
+    const float* noise(float amplitude) {
+        std::uniform_real_distribution<float> value(-amplitude, amplitude);
+        for (float& s : frame_) {
+            s = value(rng_);
+        }
+        return advance();
+    }
+
+    // Voiced buzz at pitch_hz, a few falling harmonics over a little noise
+    const float* speech(float pitch_hz, float amplitude) {
+        std::uniform_real_distribution<float> value(-0.02f * amplitude, 0.02f * amplitude);
+        for (size_t i = 0; i < frame_.size(); ++i) {
+            float s = value(rng_);
+            for (int h = 1; h <= 5; ++h) {
+                s += amplitude / h * std::sin(2.0f * PI * pitch_hz * h * (time_ + i) / RATE);
+            }
+            frame_[i] = s;
+        }
+        return advance();
+    }
+
+private:
+    const float* advance() {
+        time_ += frame_.size();
+        return frame_.data();
+    }
+
+    std::vector<float> frame_;
+    size_t time_ = 0;
+    std::mt19937 rng_{3};
+};
+
+bool rejects(const VadConfig& config) {
+    try {
+        VoiceActivityDetector vad(config);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(VadRejectsFramesTooShortForPitch) {
+    VadConfig config;
+    EXPECT_FALSE(rejects(config));
+
+    // 10 ms is 160 samples, under two periods of 70 Hz
+    VadConfig short_frame;
+    short_frame.frame_ms = 10;
+    EXPECT_TRUE(rejects(short_frame));
+
+    VadConfig zero_rate;
+    zero_rate.sample_rate = 0;
+    EXPECT_TRUE(rejects(zero_rate));
+
+    VadConfig negative_frame;
+    negative_frame.frame_ms = -30;
+    EXPECT_TRUE(rejects(negative_frame));
+
+    VadConfig inverted_pitch;
+    inverted_pitch.min_pitch_hz = 500.0f;
+    EXPECT_TRUE(rejects(inverted_pitch));
+
+    VadConfig no_pitch;
+    no_pitch.min_pitch_hz = 0.0f;
+    EXPECT_TRUE(rejects(no_pitch));
+}
+
+TEST(VadGatesSpeechNotSilenceOrNoise) {
+    VadConfig config;
+    config.hangover_frames = 0;
+    VoiceActivityDetector vad(config);
+    Signal signal(vad.frameSamples());
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_FALSE(vad.processFrame(signal.silence()));
+    }
+    // Loud flat noise clears the energy gate but not the flatness one
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_FALSE(vad.processFrame(signal.noise(0.3f)));
+    }
+    EXPECT_TRUE(vad.lastFeatures().spectral_flatness > config.flatness_threshold);
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(vad.processFrame(signal.speech(150.0f, 0.3f)));
+    }
+    EXPECT_TRUE(std::fabs(vad.lastFeatures().pitch_hz - 150.0f) < 5.0f);
+
+    EXPECT_TRUE(vad.processFrame(signal.tone(220.0f, 0.3f)));
+    EXPECT_TRUE(std::fabs(vad.lastFeatures().pitch_hz - 220.0f) < 5.0f);
+    EXPECT_EQ(vad.framesTotal(), 16u);
+    EXPECT_EQ(vad.framesSpeech(), 6u);
+}
+
+TEST(VadNoiseFloorRisesWithSteadyNoise) {
+    VadConfig config;
+    config.hangover_frames = 0;
+
+    // After quiet noise a moderate tone stands well clear of the floor
+    VoiceActivityDetector quiet(config);
+    Signal quiet_signal(quiet.frameSamples());
+    for (int i = 0; i < 200; ++i) {
+        quiet.processFrame(quiet_signal.noise(0.003f));
+    }
+    EXPECT_TRUE(quiet.processFrame(quiet_signal.tone(220.0f, 0.1f)));
+
+    // After long loud noise the floor has risen to it, so the same tone sits
+    // inside the margin
+    VoiceActivityDetector loud(config);
+    Signal loud_signal(loud.frameSamples());
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_FALSE(loud.processFrame(loud_signal.noise(0.15f)));
+    }
+    EXPECT_FALSE(loud.processFrame(loud_signal.tone(220.0f, 0.1f)));
+
+    // The floor falls at once when the noise stops
+    loud.processFrame(loud_signal.noise(0.003f));
+    EXPECT_TRUE(loud.processFrame(loud_signal.tone(220.0f, 0.1f)));
+}
+
+TEST(VadHangoverBridgesExactlyConfiguredFrames) {
+    VadConfig config;
+    config.hangover_frames = 4;
+    VoiceActivityDetector vad(config);
+    Signal signal(vad.frameSamples());
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_FALSE(vad.processFrame(signal.noise(0.003f)));
+    }
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(vad.processFrame(signal.speech(150.0f, 0.3f)));
+    }
+    for (int i = 0; i < config.hangover_frames; ++i) {
+        EXPECT_TRUE(vad.processFrame(signal.silence()));
+    }
+    EXPECT_FALSE(vad.processFrame(signal.silence()));
+    EXPECT_EQ(vad.framesSpeech(), 7u);
+
+    // Speech before the hangover runs out restarts it
+    EXPECT_TRUE(vad.processFrame(signal.speech(150.0f, 0.3f)));
+    EXPECT_TRUE(vad.processFrame(signal.silence()));
+    EXPECT_TRUE(vad.processFrame(signal.speech(150.0f, 0.3f)));
+    for (int i = 0; i < config.hangover_frames; ++i) {
+        EXPECT_TRUE(vad.processFrame(signal.silence()));
+    }
+    EXPECT_FALSE(vad.processFrame(signal.silence()));
+}
+
+TEST(VadGateCopiesSpeechFramesAcrossCalls) {
+    VadConfig config;
+    config.hangover_frames = 0;
+    VoiceActivityDetector vad(config);
+    const size_t frame = vad.frameSamples();
+
+    // Two quiet frames then two tone frames, pushed in pieces that split frames
+    std::vector<int16_t> pcm(4 * frame, 0);
+    for (size_t i = 2 * frame; i < pcm.size(); ++i) {
+        pcm[i] = static_cast<int16_t>(8000.0f * std::sin(2.0f * PI * 220.0f * i / RATE));
+    }
+    std::vector<int16_t> out(pcm.size() + frame);
+    size_t written = 0;
+    size_t frames = 0;
+    const size_t piece = frame * 2 / 3;
+    for (size_t offset = 0; offset < pcm.size(); offset += piece) {
+        const size_t count = std::min(piece, pcm.size() - offset);
+        written += vad.gate(pcm.data() + offset, count, out.data() + written);
+        frames += vad.frameFeatures().size();
+    }
+    EXPECT_EQ(frames, 4u);
+    EXPECT_EQ(written, 2 * frame);
+    EXPECT_TRUE(std::equal(out.begin(), out.begin() + written, pcm.begin() + 2 * frame));
+}
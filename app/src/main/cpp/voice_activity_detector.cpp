@@ -0,0 +1,362 @@
+#include "voice_activity_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "audio_features.h"
+#include "pcm_convert.h"
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float POWER_EPSILON = 1e-10f;
+
+// Speech band used for flatness; DC and the top octave are mostly noise
+constexpr float FLATNESS_LOW_HZ = 100.0f;
+constexpr float FLATNESS_HIGH_HZ = 4000.0f;
+
+// Noise floor tracking: falls immediately, rises slowly during non-speech
+constexpr float NOISE_FLOOR_RISE = 0.05f;
+
+// Pitch lags keep at least this share of the frame overlapping
+constexpr size_t MIN_PITCH_OVERLAP_DIVISOR = 2;
+
+// Earliest autocorrelation peak within this ratio of the best is the period
+constexpr float OCTAVE_PEAK_RATIO = 0.9f;
+
+size_t nextPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) {
+        p <<= 1;
+    }
+    return p;
+}
+
+inline float dotFloat(const float* a, const float* b, size_t count) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(PCM_CONVERT_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    sum = vaddvq_f32(acc);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+#elif defined(PCM_CONVERT_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+} // namespace
+
+size_t vadFrameSamples(const VadConfig& config) {
+    if (config.sample_rate <= 0 || config.frame_ms <= 0 || config.hangover_frames < 0) {
+        throw std::invalid_argument("sample rate, frame and hangover must be positive");
+    }
+    if (!(config.min_pitch_hz > 0.0f && config.min_pitch_hz < config.max_pitch_hz &&
+          config.max_pitch_hz <= config.sample_rate / 2.0f)) {
+        throw std::invalid_argument("pitch range must be ordered and below the Nyquist frequency");
+    }
+    const int64_t frame_samples = static_cast<int64_t>(config.sample_rate) * config.frame_ms / 1000;
+    if (frame_samples < 2 * static_cast<int64_t>(std::ceil(config.sample_rate / config.min_pitch_hz))) {
+        throw std::invalid_argument("frame of " + std::to_string(frame_samples) +
+                                    " samples is shorter than two periods of the lowest pitch");
+    }
+    return static_cast<size_t>(frame_samples);
+}
+
+VoiceActivityDetector::VoiceActivityDetector(const VadConfig& config)
+    : config_(config),
+      frame_samples_(vadFrameSamples(config)),
+      fft_size_(nextPow2(frame_samples_)) {
+
+    // Hann window over the frame, zero padded to the FFT size
+    window_.resize(frame_samples_);
+    for (size_t i = 0; i < frame_samples_; i++) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * PI * i / (frame_samples_ - 1));
+    }
+
+    twiddles_.resize(fft_size_ / 2);
+    for (size_t k = 0; k < fft_size_ / 2; k++) {
+        float angle = -2.0f * PI * k / fft_size_;
+        twiddles_[k] = std::complex<float>(std::cos(angle), std::sin(angle));
+    }
+
+    size_t bits = 0;
+    while ((size_t(1) << bits) < fft_size_) {
+        bits++;
+    }
+    bit_reverse_.resize(fft_size_);
+    for (size_t i = 0; i < fft_size_; i++) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        bit_reverse_[i] = r;
+    }
+
+    spectrum_.resize(fft_size_);
+    frame_scratch_.resize(frame_samples_);
+    pending_.reserve(frame_samples_);
+
+    const float bin_hz = static_cast<float>(config_.sample_rate) / fft_size_;
+    for (int b = 0; b <= FRAME_FEATURE_BANDS; b++) {
+        size_t bin = static_cast<size_t>(std::ceil(FRAME_BAND_EDGES_HZ[b] / bin_hz));
+        band_bins_[b] = std::clamp<size_t>(bin, 1, fft_size_ / 2 + 1);
+    }
+
+    const size_t max_lag = frame_samples_ / MIN_PITCH_OVERLAP_DIVISOR;
+    max_lag_ = std::min(max_lag, static_cast<size_t>(config_.sample_rate / config_.min_pitch_hz));
+    min_lag_ = std::clamp<size_t>(static_cast<size_t>(config_.sample_rate / config_.max_pitch_hz), 1, max_lag_);
+    energy_prefix_.resize(frame_samples_ + 1);
+    autocorr_.resize(max_lag_ - min_lag_ + 1);
+}
+
+void VoiceActivityDetector::analyseSpectrum(const float* frame) {
+    // Windowed frame into bit-reversed order, then an in-place radix-2 FFT
+    std::fill(spectrum_.begin(), spectrum_.end(), std::complex<float>(0.0f, 0.0f));
+    for (size_t i = 0; i < frame_samples_; i++) {
+        spectrum_[bit_reverse_[i]] = std::complex<float>(frame[i] * window_[i], 0.0f);
+    }
+    for (size_t len = 2; len <= fft_size_; len <<= 1) {
+        size_t half = len / 2;
+        size_t stride = fft_size_ / len;
+        for (size_t start = 0; start < fft_size_; start += len) {
+            for (size_t k = 0; k < half; k++) {
+                std::complex<float> t = twiddles_[k * stride] * spectrum_[start + k + half];
+                std::complex<float> u = spectrum_[start + k];
+                spectrum_[start + k] = u + t;
+                spectrum_[start + k + half] = u - t;
+            }
+        }
+    }
+
+    const float bin_hz = static_cast<float>(config_.sample_rate) / fft_size_;
+    size_t lo = std::max<size_t>(1, static_cast<size_t>(FLATNESS_LOW_HZ / bin_hz));
+    size_t hi = std::min(fft_size_ / 2, static_cast<size_t>(FLATNESS_HIGH_HZ / bin_hz));
+
+    // One walk over the half spectrum: flatness (geometric over arithmetic
+    // mean of the power in the speech band), centroid and band energies
+    double log_sum = 0.0;
+    double flat_sum = 0.0;
+    double total = 0.0;
+    double weighted = 0.0;
+    double band_sum[FRAME_FEATURE_BANDS] = {};
+    int band = 0;
+    for (size_t k = 1; k <= fft_size_ / 2; k++) {
+        float power = std::norm(spectrum_[k]) + POWER_EPSILON;
+        if (k >= lo && k < hi) {
+            log_sum += std::log(power);
+            flat_sum += power;
+        }
+        total += power;
+        weighted += power * (k * bin_hz);
+        while (band < FRAME_FEATURE_BANDS && k >= band_bins_[band + 1]) {
+            band++;
+        }
+        if (band < FRAME_FEATURE_BANDS && k >= band_bins_[band]) {
+            band_sum[band] += power;
+        }
+    }
+
+    if (hi > lo) {
+        double n = static_cast<double>(hi - lo);
+        features_.spectral_flatness = static_cast<float>(std::exp(log_sum / n) / (flat_sum / n));
+    } else {
+        features_.spectral_flatness = 1.0f;
+    }
+    features_.spectral_centroid_hz = static_cast<float>(weighted / total);
+    for (int b = 0; b < FRAME_FEATURE_BANDS; b++) {
+        size_t bins = band_bins_[b + 1] - band_bins_[b];
+        double mean = bins > 0 ? band_sum[b] / bins : 0.0;
+        features_.band_energy_db[b] = 10.0f * std::log10(static_cast<float>(mean) + POWER_EPSILON);
+    }
+}
+
+void VoiceActivityDetector::estimatePitch(const float* frame) {
+    // Normalised autocorrelation over the pitch lag range; the prefix sums
+    // give each lag's overlap energies without rescanning the frame
+    const size_t n = frame_samples_;
+    energy_prefix_[0] = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        energy_prefix_[i + 1] = energy_prefix_[i] + static_cast<double>(frame[i]) * frame[i];
+    }
+
+    float best = 0.0f;
+    for (size_t lag = min_lag_; lag <= max_lag_; lag++) {
+        const size_t overlap = n - lag;
+        double head = energy_prefix_[overlap];
+        double tail = energy_prefix_[n] - energy_prefix_[lag];
+        float r = 0.0f;
+        if (head > 0.0 && tail > 0.0) {
+            r = static_cast<float>(dotFloat(frame, frame + lag, overlap) / std::sqrt(head * tail));
+        }
+        autocorr_[lag - min_lag_] = r;
+        best = std::max(best, r);
+    }
+
+    features_.voicing = best;
+    if (best < config_.voicing_threshold) {
+        features_.pitch_hz = 0.0f;
+        return;
+    }
+
+    // Multiples of the period correlate almost as well as the period itself,
+    // so take the earliest local peak close to the best one
+    const size_t lags = max_lag_ - min_lag_ + 1;
+    size_t peak = 0;
+    for (size_t i = 0; i < lags; i++) {
+        float r = autocorr_[i];
+        bool local_max = (i == 0 || r >= autocorr_[i - 1]) && (i + 1 == lags || r >= autocorr_[i + 1]);
+        if (local_max && r >= OCTAVE_PEAK_RATIO * best) {
+            peak = i;
+            break;
+        }
+    }
+
+    // Parabolic interpolation around the peak for a sub-sample lag
+    float lag = static_cast<float>(peak + min_lag_);
+    if (peak > 0 && peak + 1 < lags) {
+        float prev = autocorr_[peak - 1];
+        float next = autocorr_[peak + 1];
+        float denom = prev - 2.0f * autocorr_[peak] + next;
+        if (denom < 0.0f) {
+            lag += 0.5f * (prev - next) / denom;
+        }
+    }
+    features_.pitch_hz = static_cast<float>(config_.sample_rate) / lag;
+}
+
+bool VoiceActivityDetector::processFrame(const float* frame) {
+    FeatureAccumulator acc = accumulateFeatures(frame, frame_samples_);
+    float mean_square = static_cast<float>(acc.sum_squares / frame_samples_);
+    float energy_db = 10.0f * std::log10(mean_square + POWER_EPSILON);
+
+    features_.energy_db = energy_db;
+    features_.rms = std::sqrt(mean_square);
+    features_.zero_crossing_rate = static_cast<float>(acc.zero_crossings) / frame_samples_;
+    analyseSpectrum(frame);
+
+    if (!noise_floor_valid_) {
+        noise_floor_db_ = energy_db;
+        noise_floor_valid_ = true;
+    }
+
+    bool raw_speech = false;
+    float threshold_db = std::max(noise_floor_db_ + config_.energy_margin_db, config_.min_energy_db);
+    if (energy_db > threshold_db) {
+        // Flatness and pitch only matter for frames loud enough to be candidates
+        raw_speech = features_.spectral_flatness < config_.flatness_threshold;
+        estimatePitch(frame);
+    } else {
+        features_.pitch_hz = 0.0f;
+        features_.voicing = 0.0f;
+    }
+
+    if (energy_db < noise_floor_db_) {
+        noise_floor_db_ = energy_db;
+    } else if (!raw_speech) {
+        noise_floor_db_ += NOISE_FLOOR_RISE * (energy_db - noise_floor_db_);
+    }
+
+    bool speech = raw_speech;
+    if (raw_speech) {
+        hangover_left_ = config_.hangover_frames;
+    } else if (hangover_left_ > 0) {
+        hangover_left_--;
+        speech = true;
+    }
+
+    frames_total_++;
+    if (speech) {
+        frames_speech_++;
+    }
+    last_speech_ = speech;
+    return speech;
+}
+
+size_t VoiceActivityDetector::gate(const int16_t* pcm, size_t count, int16_t* out) {
+    size_t written = 0;
+    size_t consumed = 0;
+    gate_features_.clear();
+
+    // Complete the frame left over from the previous call first
+    if (!pending_.empty()) {
+        size_t take = std::min(frame_samples_ - pending_.size(), count);
+        pending_.insert(pending_.end(), pcm, pcm + take);
+        consumed = take;
+        if (pending_.size() < frame_samples_) {
+            return 0;
+        }
+        pcm16ToFloat(pending_.data(), frame_scratch_.data(), frame_samples_);
+        if (processFrame(frame_scratch_.data())) {
+            std::copy(pending_.begin(), pending_.end(), out);
+            written += frame_samples_;
+        }
+        gate_features_.push_back(features_);
+        pending_.clear();
+    }
+
+    while (count - consumed >= frame_samples_) {
+        const int16_t* frame = pcm + consumed;
+        pcm16ToFloat(frame, frame_scratch_.data(), frame_samples_);
+        if (processFrame(frame_scratch_.data())) {
+            std::copy(frame, frame + frame_samples_, out + written);
+            written += frame_samples_;
+        }
+        gate_features_.push_back(features_);
+        consumed += frame_samples_;
+    }
+
+    pending_.assign(pcm + consumed, pcm + count);
+    return written;
+}
+
+size_t VoiceActivityDetector::copyFrameFeatures(float* out, size_t max_frames) const {
+    size_t frames = std::min(max_frames, gate_features_.size());
+    for (size_t f = 0; f < frames; f++) {
+        const FrameFeatures& features = gate_features_[f];
+        float* row = out + f * FRAME_FEATURE_STRIDE;
+        row[0] = features.energy_db;
+        row[1] = features.rms;
+        row[2] = features.zero_crossing_rate;
+        row[3] = features.pitch_hz;
+        row[4] = features.voicing;
+        row[5] = features.spectral_centroid_hz;
+        row[6] = features.spectral_flatness;
+        std::copy(features.band_energy_db, features.band_energy_db + FRAME_FEATURE_BANDS, row + 7);
+    }
+    return frames;
+}
+
+void VoiceActivityDetector::reset() {
+    pending_.clear();
+    gate_features_.clear();
+    features_ = FrameFeatures();
+    noise_floor_valid_ = false;
+    hangover_left_ = 0;
+    last_speech_ = false;
+    frames_total_ = 0;
+    frames_speech_ = 0;
+}
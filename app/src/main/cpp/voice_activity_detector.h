@@ -0,0 +1,111 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Log-spaced band edges of FrameFeatures::band_energy_db, in Hz; bands
+// reaching past the Nyquist frequency are cut off at it
+constexpr int FRAME_FEATURE_BANDS = 6;
+constexpr float FRAME_BAND_EDGES_HZ[FRAME_FEATURE_BANDS + 1] = {100, 250, 500, 1000, 2000, 4000, 8000};
+
+// Per-frame features from the detector's single pass over each frame. The
+// gate decides on energy and flatness; the same record is published to the
+// diarizer, so no other stage rescans the samples.
+struct FrameFeatures {
+    float energy_db = 0.0f;
+    float rms = 0.0f;
+    float zero_crossing_rate = 0.0f;   // crossings per sample
+    float pitch_hz = 0.0f;             // 0 when the frame is not voiced
+    float voicing = 0.0f;              // normalised autocorrelation peak, 0..1
+    float spectral_centroid_hz = 0.0f;
+    float spectral_flatness = 1.0f;
+    float band_energy_db[FRAME_FEATURE_BANDS] = {};
+};
+
+// Floats per frame when FrameFeatures is flattened for JNI, in field order
+constexpr size_t FRAME_FEATURE_STRIDE = 7 + FRAME_FEATURE_BANDS;
+
+struct VadConfig {
+    int sample_rate = 16000;
+    int frame_ms = 30;
+    float energy_margin_db = 9.0f;    // speech must sit this far above the noise floor
+    float min_energy_db = -55.0f;     // absolute floor below which nothing is speech
+    float flatness_threshold = 0.45f; // noise and hiss are spectrally flat (close to 1)
+    int hangover_frames = 8;          // frames kept after speech ends, bridges short pauses
+    float min_pitch_hz = 70.0f;       // pitch search range, covers adult voices
+    float max_pitch_hz = 400.0f;
+    float voicing_threshold = 0.35f;  // autocorrelation peak below which no pitch is reported
+};
+
+// Samples per frame of config. Throws std::invalid_argument unless the pitch
+// range is ordered below the Nyquist frequency and the frame holds two
+// periods of min_pitch_hz, as the pitch search needs.
+size_t vadFrameSamples(const VadConfig& config);
+
+// Frame-level voice activity detector: frame energy against an adaptive
+// noise floor, spectral flatness of the frame, and hangover smoothing.
+// Every frame's FrameFeatures are kept for the caller; pitch is only
+// searched on frames loud enough to be speech candidates.
+class VoiceActivityDetector {
+public:
+    // Throws std::invalid_argument for configs vadFrameSamples() rejects
+    explicit VoiceActivityDetector(const VadConfig& config);
+
+    size_t frameSamples() const { return frame_samples_; }
+
+    // Classifies one frame of frameSamples() normalised samples and
+    // stores its features in lastFeatures()
+    bool processFrame(const float* frame);
+
+    // Splits int16 PCM into frames (carrying partial frames between calls) and
+    // copies speech frames to out, which must hold count + frameSamples()
+    // samples. Returns the number of samples written.
+    size_t gate(const int16_t* pcm, size_t count, int16_t* out);
+
+    // Features of the frames completed by the last gate() call, in order
+    const std::vector<FrameFeatures>& frameFeatures() const { return gate_features_; }
+    const FrameFeatures& lastFeatures() const { return features_; }
+
+    // Writes frameFeatures() as FRAME_FEATURE_STRIDE floats per frame, at
+    // most max_frames of them; returns the number of frames written
+    size_t copyFrameFeatures(float* out, size_t max_frames) const;
+
+    void reset();
+
+    bool lastFrameSpeech() const { return last_speech_; }
+    uint64_t framesTotal() const { return frames_total_; }
+    uint64_t framesSpeech() const { return frames_speech_; }
+
+private:
+    // Fills the spectral fields of features_ from one FFT of the frame
+    void analyseSpectrum(const float* frame);
+    void estimatePitch(const float* frame);
+
+    VadConfig config_;
+    size_t frame_samples_;
+    size_t fft_size_;
+
+    std::vector<float> window_;
+    std::vector<std::complex<float>> twiddles_;
+    std::vector<size_t> bit_reverse_;
+    std::vector<std::complex<float>> spectrum_;
+    std::vector<float> frame_scratch_;
+    std::vector<double> energy_prefix_;
+    std::vector<float> autocorr_;
+    size_t band_bins_[FRAME_FEATURE_BANDS + 1];
+    size_t min_lag_;
+    size_t max_lag_;
+
+    FrameFeatures features_;
+    std::vector<FrameFeatures> gate_features_;
+
+    std::vector<int16_t> pending_;
+    float noise_floor_db_ = 0.0f;
+    bool noise_floor_valid_ = false;
+    int hangover_left_ = 0;
+    bool last_speech_ = false;
+    uint64_t frames_total_ = 0;
+    uint64_t frames_speech_ = 0;
+};
@@ -2,45 +2,280 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <map>
-#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <cstring>
+#include <stdexcept>
 #include <android/log.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "compute_backend.h"
+#include "compute_pool.h"
+#include "handle_registry.h"
+#include "memory_pressure.h"
+#include "model_mapping.h"
+#include "model_variants.h"
+#include "native_kernels.h"
+#include "native_log.h"
+#include "native_metrics.h"
+#include "native_trace.h"
+#include "asr_core.h"
+#include "audio_chunk_store.h"
+#include "audio_features.h"
+#include "voice_activity_detector.h"
 
 // CTranslate2 includes (would be actual includes in real implementation)
 // #include <ctranslate2/translator.h>
 // #include <ctranslate2/models/whisper.h>
 
 #define LOG_TAG "WhisperAndroid"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) AMBIENT_LOG_DEBUG(LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// Stub structures for demonstration
-struct AlignmentInfo {
-    std::string word;
-    float start_time;
-    float end_time;
-    float confidence;
-};
+// Upper bound on stream windows analysed per poll
+static constexpr int MAX_BATCH_SIZE = 16;
+
+// Widest beam the decoder accepts
+static constexpr int MAX_BEAM_SIZE = 8;
+
+// Transformer layers in the whisper-tiny encoder
+static constexpr int WHISPER_ENCODER_LAYERS = 4;
 
 struct WhisperModel {
     std::string model_path;
+    // Encoder, decoder and tokenizer files, shared with any other model on the same files
+    std::vector<std::shared_ptr<const MappedModel>> weights;
     bool initialized = false;
-    int thread_count = 4;
-    int context_size = 3000;
+    // Reconfigured in place by thermal management; the compute pool sets actual parallelism
+    std::atomic<int> thread_count{4};
+    std::atomic<int> context_size{3000};
+    // Most stream windows analysed per poll
+    std::atomic<int> batch_size{MAX_BATCH_SIZE};
+    // Raw log probabilities cross JNI only when evaluation asks for them
+    std::atomic<LogProbFormat> log_prob_format{LogProbFormat::NONE};
+    // Swapped atomically so open/close never race a push or poll in flight
+    std::shared_ptr<StreamingSession> stream;
+    // Every sample of the session, for backlog and replay; swapped atomically like the stream
+    std::shared_ptr<AudioChunkStore> audio_store;
+    
+    // Result storage reused across calls; held for as long as results are being built and marshalled
+    std::mutex arena_mutex;
+    ResultArena arena;
+    // Guarded by arena_mutex, which every decode holds
+    DecoderConfig decoder;
+    DecodeStats decode_stats;
+    // Where the encoder's layers run; every window passes through it
+    LayerOffload encoder{ModelRole::ENCODER, WHISPER_ENCODER_LAYERS};
+    // Chunks handed to batched inference so far; keys their async trace slices
+    std::atomic<uint64_t> chunks_batched{0};
 };
 
-struct InferenceResult {
-    std::string text;
-    std::vector<float> log_probs;
-    std::vector<AlignmentInfo> alignments;
-};
+// Global model storage; handles stay valid for calls in flight after release
+static HandleRegistry<WhisperModel> g_models;
+
+// Voice activity detectors share the handle sequence with models
+static HandleRegistry<VoiceActivityDetector> g_vads;
+
+// Streaming defaults: 30 s of 16 kHz audio can be queued before pushes are refused
+static constexpr size_t STREAM_RING_CAPACITY = ASR_SAMPLE_RATE * 30;
+
+// Capture rates the stream resamples from
+static constexpr int MIN_INPUT_SAMPLE_RATE = 8000;
+static constexpr int MAX_INPUT_SAMPLE_RATE = 192000;
+
+// Encoder activations per context frame for whisper-tiny: 4 layers x 384 f32 values
+static constexpr uint64_t ACTIVATION_BYTES_PER_FRAME = WHISPER_ENCODER_LAYERS * 384 * 4;
+
+// In real implementation, CTranslate2 would encode the window here with the
+// leading layers on the model's delegate. The mock encoder costs nothing, so
+// this only routes the pass, which keeps the fallback and counters live.
+static void encodeWindow(WhisperModel& model) {
+    model.encoder.run(0, [](int64_t) {});
+}
+
+static std::shared_ptr<WhisperModel> findModel(jlong handle) {
+    std::shared_ptr<WhisperModel> model = g_models.acquire(handle);
+    if (!model || !model->initialized) {
+        return nullptr;
+    }
+    return model;
+}
+
+static std::shared_ptr<StreamingSession> findStream(jlong handle) {
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    return model ? std::atomic_load(&model->stream) : nullptr;
+}
+
+// Maps the model file, or every non-empty file in the model directory
+static bool mapModelFiles(const std::string& path, std::vector<std::shared_ptr<const MappedModel>>& weights) {
+    std::vector<std::string> files;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        LOGE("Model path not found: %s", path.c_str());
+        return false;
+    }
+    
+    if (S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            LOGE("Cannot open model directory: %s", path.c_str());
+            return false;
+        }
+        while (dirent* entry = readdir(dir)) {
+            std::string file = path + "/" + entry->d_name;
+            if (stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                files.push_back(file);
+            }
+        }
+        closedir(dir);
+    } else {
+        files.push_back(path);
+    }
+    
+    for (const auto& file : files) {
+        std::string error;
+        std::shared_ptr<const MappedModel> mapped = mapModelFile(file, &error);
+        if (!mapped) {
+            LOGE("Failed to map %s: %s", file.c_str(), error.c_str());
+            return false;
+        }
+        LOGD("Mapped %s (%zu bytes)", file.c_str(), mapped->size());
+        weights.push_back(std::move(mapped));
+    }
+    return true;
+}
+
+// Result class and constructor, resolved once in JNI_OnLoad and held as a global ref
+static jclass g_result_class = nullptr;
+static jmethodID g_result_ctor = nullptr;
+
+static constexpr const char* RESULT_CLASS = "com/frozo/ambientscribe/transcription/ASRService$NativeInferenceResult";
+
+// Allocates a Java array and fills it in place, with no native staging copy
+template <typename Array, typename Element, typename Fill>
+static Array newFilledArray(JNIEnv *env, Array (JNIEnv::*alloc)(jsize), size_t length, Fill&& fill) {
+    Array array = (env->*alloc)(static_cast<jsize>(length));
+    if (!array || length == 0) {
+        return array;
+    }
+    auto* data = static_cast<Element*>(env->GetPrimitiveArrayCritical(array, nullptr));
+    if (!data) {
+        env->DeleteLocalRef(array);
+        return nullptr;
+    }
+    fill(data);
+    env->ReleasePrimitiveArrayCritical(array, data, 0);
+    return array;
+}
+
+// Create Java result object. Confidence is reduced to scalars here; the log
+// probabilities themselves are only packed when format asks for them. Word
+// alignments are flattened into parallel arrays plus one space-joined
+// string, so a result costs a fixed number of allocations however many
+// words it holds.
+static jobject toJavaResult(JNIEnv *env, const ResultArena& arena, const InferenceResult& result, LogProbFormat format) {
+    StageTimer timer(MetricStage::RESULT_BUILD);
+    const AlignmentInfo* aligns = arena.alignments.data() + result.alignments.offset;
+    const size_t word_count = result.alignments.length;
+    const ConfidenceSummary confidence = summarizeConfidence(arena, result);
+    
+    jstring text = env->NewStringUTF(arena.c_str(result.text));
+    jbyteArray packedLogProbs = nullptr;
+    float logProbScale = 1.0f;
+    if (format != LogProbFormat::NONE) {
+        packedLogProbs = newFilledArray<jbyteArray, jbyte>(env, &JNIEnv::NewByteArray,
+            packedLogProbBytes(format, result.log_probs.length), [&](jbyte* out) {
+                logProbScale = packLogProbs(arena.floats.data() + result.log_probs.offset, result.log_probs.length,
+                                            format, reinterpret_cast<uint8_t*>(out));
+            });
+    }
+    jstring wordText = env->NewStringUTF(arena.c_str(result.words));
+    jintArray wordOffsets = newFilledArray<jintArray, jint>(env, &JNIEnv::NewIntArray, word_count + 1,
+        [&](jint* out) { fillWordOffsets(arena, result, out); });
+    jfloatArray wordStarts = newFilledArray<jfloatArray, jfloat>(env, &JNIEnv::NewFloatArray, word_count,
+        [&](jfloat* out) { for (size_t i = 0; i < word_count; i++) out[i] = aligns[i].start_time; });
+    jfloatArray wordEnds = newFilledArray<jfloatArray, jfloat>(env, &JNIEnv::NewFloatArray, word_count,
+        [&](jfloat* out) { for (size_t i = 0; i < word_count; i++) out[i] = aligns[i].end_time; });
+    jfloatArray wordConfidences = newFilledArray<jfloatArray, jfloat>(env, &JNIEnv::NewFloatArray, word_count,
+        [&](jfloat* out) { for (size_t i = 0; i < word_count; i++) out[i] = aligns[i].confidence; });
+    
+    jobject resultObj = nullptr;
+    if (!env->ExceptionCheck()) {
+        resultObj = env->NewObject(g_result_class, g_result_ctor, text, confidence.confidence,
+                                   confidence.mean_log_prob, confidence.min_log_prob, confidence.word_confidence,
+                                   packedLogProbs, static_cast<jint>(format), logProbScale,
+                                   wordText, wordOffsets, wordStarts, wordEnds, wordConfidences);
+    }
+    
+    env->DeleteLocalRef(text);
+    if (packedLogProbs) {
+        env->DeleteLocalRef(packedLogProbs);
+    }
+    env->DeleteLocalRef(wordText);
+    env->DeleteLocalRef(wordOffsets);
+    env->DeleteLocalRef(wordStarts);
+    env->DeleteLocalRef(wordEnds);
+    env->DeleteLocalRef(wordConfidences);
+    return resultObj;
+}
 
-// Global model storage (in real implementation, this would be more sophisticated)
-static std::map<jlong, std::unique_ptr<WhisperModel>> g_models;
-static jlong g_next_handle = 1;
+// One NativeInferenceResult[] for every result in the arena
+static jobjectArray toJavaResultArray(JNIEnv *env, const ResultArena& arena, LogProbFormat format) {
+    jobjectArray array = env->NewObjectArray(arena.results.size(), g_result_class, nullptr);
+    for (size_t i = 0; array && i < arena.results.size(); i++) {
+        jobject resultObj = toJavaResult(env, arena, arena.results[i], format);
+        if (!resultObj) {
+            env->DeleteLocalRef(array);
+            return nullptr;
+        }
+        env->SetObjectArrayElement(array, i, resultObj);
+        env->DeleteLocalRef(resultObj);
+    }
+    return array;
+}
 
 extern "C" {
 
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void * /* reserved */) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    
+    jclass result_class = env->FindClass(RESULT_CLASS);
+    if (!result_class) {
+        LOGE("Failed to find NativeInferenceResult class");
+        return JNI_ERR;
+    }
+    g_result_class = static_cast<jclass>(env->NewGlobalRef(result_class));
+    env->DeleteLocalRef(result_class);
+    
+    g_result_ctor = env->GetMethodID(g_result_class, "<init>", "(Ljava/lang/String;FFFF[BIFLjava/lang/String;[I[F[F[F)V");
+    if (!g_result_ctor) {
+        LOGE("Failed to find NativeInferenceResult constructor");
+        return JNI_ERR;
+    }
+    
+    // Kernel variants are chosen here, before the first audio chunk needs them
+    const NativeKernels& kernels = nativeKernels();
+    LOGD("Resample kernel %s, matmul kernel %s", kernels.resample_variant, kernels.matmul_variant);
+    
+    return JNI_VERSION_1_6;
+}
+
+JNIEXPORT void JNICALL
+JNI_OnUnload(JavaVM *vm, void * /* reserved */) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK && g_result_class) {
+        env->DeleteGlobalRef(g_result_class);
+    }
+    g_result_class = nullptr;
+    g_result_ctor = nullptr;
+}
+
 JNIEXPORT jlong JNICALL
 Java_com_frozo_ambientscribe_transcription_ASRService_initializeNativeModel(
         JNIEnv *env, jobject thiz, jstring model_path, jint thread_count, jint context_size) {
@@ -53,8 +288,15 @@ Java_com_frozo_ambientscribe_transcription_ASRService_initializeNativeModel(
          path.c_str(), thread_count, context_size);
     
     try {
-        auto model = std::make_unique<WhisperModel>();
+        auto model = std::make_shared<WhisperModel>();
         model->model_path = path;
+        model->thread_count = thread_count;
+        model->context_size = context_size;
+        
+        // Weights are paged in on first touch; a second model on the same files reuses the mapping
+        if (!mapModelFiles(path, model->weights)) {
+            return 0;
+        }
         
         // In real implementation, initialize CTranslate2 Whisper model with thread count
         // model->translator = std::make_unique<ctranslate2::models::WhisperModel>(
@@ -67,8 +309,7 @@ Java_com_frozo_ambientscribe_transcription_ASRService_initializeNativeModel(
         
         model->initialized = true;
         
-        jlong handle = g_next_handle++;
-        g_models[handle] = std::move(model);
+        jlong handle = g_models.add(std::move(model));
         
         LOGD("Model initialized successfully, handle: %ld", handle);
         return handle;
@@ -79,19 +320,283 @@ Java_com_frozo_ambientscribe_transcription_ASRService_initializeNativeModel(
     }
 }
 
+// Per path: [bits per weight, weight bytes, footprint bytes, expected tokens/sec].
+// Weight bytes are 0 for a variant that is not on disk.
+JNIEXPORT jdoubleArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeDescribeVariants(
+        JNIEnv *env, jobject thiz, jobjectArray model_paths, jint context_size) {
+    
+    const jsize count = env->GetArrayLength(model_paths);
+    std::vector<jdouble> values;
+    values.reserve(static_cast<size_t>(count) * 4);
+    for (jsize i = 0; i < count; i++) {
+        auto model_path = static_cast<jstring>(env->GetObjectArrayElement(model_paths, i));
+        const char *path_cstr = env->GetStringUTFChars(model_path, nullptr);
+        std::string path(path_cstr);
+        env->ReleaseStringUTFChars(model_path, path_cstr);
+        env->DeleteLocalRef(model_path);
+        
+        ModelVariantInfo info = describeModelVariant(path, ACTIVATION_BYTES_PER_FRAME * std::max(context_size, 0));
+        values.push_back(info.bitsPerWeight);
+        values.push_back(static_cast<jdouble>(info.weightBytes));
+        values.push_back(static_cast<jdouble>(info.footprintBytes));
+        values.push_back(info.tokensPerSecond);
+    }
+    
+    jdoubleArray result = env->NewDoubleArray(static_cast<jsize>(values.size()));
+    if (result) {
+        env->SetDoubleArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    return result;
+}
+
+// Replaces the model's weights with another variant without closing the
+// stream; audio already queued is transcribed by the new variant
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeSwapModel(
+        JNIEnv *env, jobject thiz, jlong handle, jstring model_path) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle: %ld", handle);
+        return JNI_FALSE;
+    }
+    
+    const char *path_cstr = env->GetStringUTFChars(model_path, nullptr);
+    std::string path(path_cstr);
+    env->ReleaseStringUTFChars(model_path, path_cstr);
+    
+    // Map before taking the lock so inference in flight is not held up
+    std::vector<std::shared_ptr<const MappedModel>> weights;
+    if (!mapModelFiles(path, weights)) {
+        return JNI_FALSE;
+    }
+    
+    {
+        // Every inference holds arena_mutex, so none sees a half-swapped model
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        model->weights.swap(weights);
+        model->model_path = path;
+    }
+    
+    LOGD("Model %ld swapped to %s", handle, path.c_str());
+    // The previous mappings are released here, outside the lock
+    return JNI_TRUE;
+}
+
+// Reconfigures a live handle without reloading the model, so thermal
+// throttling costs a parameter change instead of a model load. The thread
+// count resizes the compute pool shared with the LLM and never grows past
+// the performance cores. Values <= 0 leave a parameter unchanged.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_updateNativeModelParameters(
+        JNIEnv *env, jobject thiz, jlong handle, jint thread_count, jint context_size, jint batch_size) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle: %ld", handle);
+        return JNI_FALSE;
+    }
+    
+    if (thread_count > 0) {
+        ComputePool& pool = ComputePool::shared();
+        size_t threads = pool.resize(std::min(static_cast<size_t>(thread_count), pool.defaultThreadCount()));
+        model->thread_count.store(static_cast<int>(threads));
+    }
+    if (context_size > 0) {
+        // In real implementation, would shrink the decoder's KV cache in place
+        model->context_size.store(context_size);
+    }
+    if (batch_size > 0) {
+        // Applies from the next poll; a backlog beyond it waits for the one after
+        model->batch_size.store(std::min(batch_size, MAX_BATCH_SIZE));
+    }
+    
+    LOGD("Model %ld reconfigured: %d threads, context size %d, batch size %d", handle,
+         model->thread_count.load(), model->context_size.load(), model->batch_size.load());
+    return JNI_TRUE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeSetLogProbFormat(
+        JNIEnv *env, jobject thiz, jlong handle, jint format) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle: %ld", handle);
+        return JNI_FALSE;
+    }
+    if (format < static_cast<jint>(LogProbFormat::NONE) || format > static_cast<jint>(LogProbFormat::INT8)) {
+        LOGE("Unknown log-prob format: %d", format);
+        return JNI_FALSE;
+    }
+    
+    model->log_prob_format.store(static_cast<LogProbFormat>(format));
+    LOGD("Model %ld log-prob format: %d", handle, format);
+    return JNI_TRUE;
+}
+
+// Decoding strategy for every inference from now on; see DecoderConfig
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeSetDecoderConfig(
+        JNIEnv *env, jobject thiz, jlong handle, jint mode, jint beam_size, jfloat widen_log_prob,
+        jfloat widen_entropy, jint narrow_after, jboolean early_exit) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle: %ld", handle);
+        return JNI_FALSE;
+    }
+    if (mode < static_cast<jint>(DecodeMode::GREEDY) || mode > static_cast<jint>(DecodeMode::BEAM)) {
+        LOGE("Unknown decode mode: %d", mode);
+        return JNI_FALSE;
+    }
+    if (beam_size < 1 || beam_size > MAX_BEAM_SIZE || narrow_after < 1) {
+        LOGE("Invalid decoder config: beam=%d, narrow after=%d", beam_size, narrow_after);
+        return JNI_FALSE;
+    }
+    
+    DecoderConfig config;
+    config.mode = static_cast<DecodeMode>(mode);
+    config.beam_size = beam_size;
+    config.widen_log_prob = widen_log_prob;
+    config.widen_entropy = widen_entropy;
+    config.narrow_after = narrow_after;
+    config.early_exit = early_exit == JNI_TRUE;
+    {
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        model->decoder = config;
+    }
+    LOGD("Model %ld decoder: mode %d, beam %d, widen below %.2f or above %.2f nats, narrow after %d, early exit %d",
+         handle, mode, beam_size, widen_log_prob, widen_entropy, narrow_after, config.early_exit);
+    return JNI_TRUE;
+}
+
+// Decoder work since the model was loaded: [chunks, tokens, beam tokens,
+// hypotheses, early exits, skipped tokens]
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeGetDecodeStats(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        return nullptr;
+    }
+    
+    DecodeStats stats;
+    {
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        stats = model->decode_stats;
+    }
+    jlong values[6] = {
+        static_cast<jlong>(stats.chunks),
+        static_cast<jlong>(stats.tokens),
+        static_cast<jlong>(stats.beam_tokens),
+        static_cast<jlong>(stats.hypotheses),
+        static_cast<jlong>(stats.early_exits),
+        static_cast<jlong>(stats.skipped_tokens)
+    };
+    jlongArray result = env->NewLongArray(6);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 6, values);
+    }
+    return result;
+}
+
+// Offloads the encoder's first `layers` layers to backend (LayerOffload::AUTO
+// for the device's preferred delegate, 0 for the CPU)
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeSetOffload(
+        JNIEnv *env, jobject thiz, jlong handle, jint backend, jint layers) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle for offload");
+        return JNI_FALSE;
+    }
+    if (!model->encoder.configure(backend, layers)) {
+        LOGE("Offload of %d encoder layers to backend %d unavailable", layers, backend);
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+// [backend, offloaded layers, offloaded passes, CPU passes, delegate failures]
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeGetOffloadStats(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        return nullptr;
+    }
+    
+    OffloadStats stats = model->encoder.stats();
+    jlong values[5] = {
+        static_cast<jlong>(stats.backend),
+        static_cast<jlong>(stats.layers),
+        static_cast<jlong>(stats.offloaded_passes),
+        static_cast<jlong>(stats.cpu_passes),
+        static_cast<jlong>(stats.failures)
+    };
+    jlongArray result = env->NewLongArray(5);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// Frees memory at level (MemoryPressure values) and returns the bytes
+// reclaimed: the result arena's spare capacity, then from HIGH the resident
+// model pages. The model stays loaded at every level, since releasing it
+// would drop the stream of an encounter in progress.
+JNIEXPORT jlong JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeTrimMemory(
+        JNIEnv *env, jobject thiz, jlong handle, jint level) {
+    
+    if (level < static_cast<jint>(MemoryPressure::MODERATE) || level > static_cast<jint>(MemoryPressure::CRITICAL)) {
+        LOGE("Unknown memory pressure level %d", level);
+        return 0;
+    }
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle for memory trim");
+        return 0;
+    }
+    
+    uint64_t reclaimed = 0;
+    {
+        // Results are rebuilt from scratch on every call, so the arena only holds spare capacity here
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        reclaimed += model->arena.release();
+        if (static_cast<MemoryPressure>(level) != MemoryPressure::MODERATE) {
+            for (const auto& weights : model->weights) {
+                reclaimed += weights->dontNeed();
+            }
+        }
+    }
+    LOGD("Model %ld trimmed at pressure %d: %llu bytes reclaimed", handle, level,
+         static_cast<unsigned long long>(reclaimed));
+    return static_cast<jlong>(reclaimed);
+}
+
 JNIEXPORT jobject JNICALL
 Java_com_frozo_ambientscribe_transcription_ASRService_nativeInference(
-        JNIEnv *env, jobject thiz, jlong handle, jfloatArray audio_data, jint thread_count, jint context_size) {
+        JNIEnv *env, jobject thiz, jlong handle, jfloatArray audio_data) {
     
-    auto it = g_models.find(handle);
-    if (it == g_models.end() || !it->second->initialized) {
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
         LOGE("Invalid model handle or model not initialized: %ld", handle);
         return nullptr;
     }
     
     // Get audio data
     jsize length = env->GetArrayLength(audio_data);
-    jfloat *audio_ptr = env->GetFloatArrayElements(audio_data, nullptr);
+    jfloat *audio_ptr;
+    {
+        StageTimer timer(MetricStage::JNI_MARSHAL);
+        audio_ptr = env->GetFloatArrayElements(audio_data, nullptr);
+    }
     
     if (!audio_ptr) {
         LOGE("Failed to get audio data");
@@ -99,240 +604,558 @@ Java_com_frozo_ambientscribe_transcription_ASRService_nativeInference(
     }
     
     LOGD("Running inference on %d audio samples with %d threads, context size: %d", 
-         length, thread_count, context_size);
+         length, model->thread_count.load(), model->context_size.load());
     
+    TRACE_SECTION("asr.inference");
     try {
         // Real audio analysis implementation
-        InferenceResult result;
+        AudioFeatures features;
+        {
+            StageTimer timer(MetricStage::FEATURE_EXTRACTION);
+            features = finalizeFeatures(accumulateFeatures(audio_ptr, length));
+        }
+        env->ReleaseFloatArrayElements(audio_data, audio_ptr, JNI_ABORT);
+        // Released exactly once; the catch below only frees it if extraction threw
+        audio_ptr = nullptr;
         
-        // Analyze audio characteristics
-        float rms = 0.0f;
-        float max_amplitude = 0.0f;
-        int zero_crossings = 0;
-        float spectral_centroid = 0.0f;
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        model->arena.reset();
+        encodeWindow(*model);
+        InferenceResult result = transcribeFeatures(model->arena, features, length, model->decoder, length,
+                                                    &model->decode_stats);
+        jobject resultObj = toJavaResult(env, model->arena, result, model->log_prob_format.load());
         
-        // Calculate audio features
-        for (int i = 0; i < length; i++) {
-            float sample = audio_ptr[i];
-            rms += sample * sample;
-            max_amplitude = std::max(max_amplitude, std::abs(sample));
-            
-            if (i > 0 && ((audio_ptr[i-1] >= 0) != (sample >= 0))) {
-                zero_crossings++;
-            }
-        }
-        rms = std::sqrt(rms / length);
+        LOGD("Inference completed successfully");
+        return resultObj;
         
-        // Calculate spectral centroid (simplified)
-        for (int i = 0; i < length - 1; i++) {
-            float diff = std::abs(audio_ptr[i+1] - audio_ptr[i]);
-            spectral_centroid += diff * i;
+    } catch (const std::exception& e) {
+        LOGE("Inference failed: %s", e.what());
+        if (audio_ptr) {
+            env->ReleaseFloatArrayElements(audio_data, audio_ptr, JNI_ABORT);
+        }
+        return nullptr;
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeOpenStream(
+        JNIEnv *env, jobject thiz, jlong handle, jint window_samples, jint overlap_samples, jint input_sample_rate) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle or model not initialized: %ld", handle);
+        return JNI_FALSE;
+    }
+    
+    if (window_samples <= 0 || overlap_samples < 0 || overlap_samples * 2 > window_samples) {
+        LOGE("Invalid stream geometry: window=%d, overlap=%d", window_samples, overlap_samples);
+        return JNI_FALSE;
+    }
+    
+    if (input_sample_rate < MIN_INPUT_SAMPLE_RATE || input_sample_rate > MAX_INPUT_SAMPLE_RATE) {
+        LOGE("Unsupported input sample rate: %d", input_sample_rate);
+        return JNI_FALSE;
+    }
+    
+    try {
+        // Window geometry and capacity are in model-rate samples; pushes are at the input rate
+        size_t capacity = std::max(STREAM_RING_CAPACITY, static_cast<size_t>(window_samples) * 2);
+        auto stream = std::make_shared<StreamingSession>(window_samples, overlap_samples, capacity, input_sample_rate);
+        LOGD("Stream opened on handle %ld: window=%d, overlap=%d, capacity=%zu, input=%d Hz (%zu taps/phase)",
+             handle, window_samples, overlap_samples, stream->ring.capacity(), input_sample_rate,
+             stream->resampler ? stream->resampler->tapsPerPhase() : 0);
+        std::atomic_store(&model->stream, std::move(stream));
+        return JNI_TRUE;
+    } catch (const std::exception& e) {
+        LOGE("Failed to open stream: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativePushAudio(
+        JNIEnv *env, jobject thiz, jlong handle, jobject pcm_buffer, jint sample_count) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<StreamingSession> stream = model ? std::atomic_load(&model->stream) : nullptr;
+    if (!stream) {
+        LOGE("No open stream for handle: %ld", handle);
+        return -1;
+    }
+    
+    // Direct buffers are read in place; ART never copies them
+    const auto* pcm = static_cast<const int16_t*>(env->GetDirectBufferAddress(pcm_buffer));
+    if (!pcm || sample_count < 0) {
+        LOGE("PCM input must be a direct ByteBuffer");
+        return -1;
+    }
+    
+    TRACE_SECTION("asr.push_audio");
+    size_t capacity_samples = static_cast<size_t>(env->GetDirectBufferCapacity(pcm_buffer)) / sizeof(int16_t);
+    size_t count = std::min(static_cast<size_t>(sample_count), capacity_samples);
+    size_t pushed;
+    std::shared_ptr<AudioChunkStore> store = std::atomic_load(&model->audio_store);
+    if (store) {
+        // The store takes everything; what the ring refuses waits there, not in Java
+        // Pushes from the capture thread and drains before a poll both go
+        // through drainStoredAudio(), which keeps them a single producer
+        store->append(pcm, count);
+        drainStoredAudio(*stream, *store);
+        pushed = count;
+    } else {
+        pushed = pushPcm(*stream, pcm, count);
+    }
+    TRACE_COUNTER("asr.buffered_samples", static_cast<int64_t>(stream->ring.size()));
+    return static_cast<jint>(pushed);
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativePollStreamBatch(
+        JNIEnv *env, jobject thiz, jlong handle, jint max_windows) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<StreamingSession> stream = model ? std::atomic_load(&model->stream) : nullptr;
+    if (!stream) {
+        LOGE("No open stream for handle: %ld", handle);
+        return nullptr;
+    }
+    
+    try {
+        // Cut every ready window (up to the batch size) so a backlog costs one JNI transition
+        const jint limit = std::min(max_windows, static_cast<jint>(model->batch_size.load()));
+        TRACE_SECTION("asr.poll_stream");
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        ResultArena& arena = model->arena;
+        arena.reset();
+        AudioFeatures features;
+        const uint64_t first_window = stream->windows_cut;
+        while (static_cast<jint>(arena.results.size()) < limit && nextStreamWindow(*stream, features)) {
+            TRACE_ASYNC_BEGIN("asr.window", traceCookie(handle, stream->windows_cut));
+            stream->windows_cut++;
+            encodeWindow(*model);
+            InferenceResult result = transcribeFeatures(arena, features, stream->window_samples, model->decoder,
+                                                        stream->window_speech_samples, &model->decode_stats);
+            // Only words final in session time cross JNI
+            stream->stitcher.stitch(arena, result, stream->window_speech_samples);
+            arena.results.push_back(result);
         }
-        if (length > 1) {
-            spectral_centroid /= (length - 1);
+        jobjectArray results = toJavaResultArray(env, arena, model->log_prob_format.load());
+        for (uint64_t window = first_window; window < stream->windows_cut; window++) {
+            TRACE_ASYNC_END("asr.window", traceCookie(handle, window));
         }
+        return results;
         
-        // Generate transcription based on audio characteristics
-        std::string transcription;
-        std::vector<float> log_probs;
-        std::vector<AlignmentInfo> word_alignments;
-        
-        // Determine if audio contains speech
-        bool has_speech = rms > 0.01f && zero_crossings > length / 100;
-        
-        // Log audio analysis
-        LOGD("Audio analysis: RMS=%.4f, MaxAmp=%.4f, ZeroCrossings=%d, SpectralCentroid=%.2f, HasSpeech=%s", 
-             rms, max_amplitude, zero_crossings, spectral_centroid, has_speech ? "true" : "false");
-        
-        if (has_speech) {
-            // Simulate real speech recognition with pattern-based transcription
-            // This analyzes audio patterns to generate more realistic transcriptions
-            
-            // Calculate speech characteristics
-            float speech_energy = rms * 100.0f; // Scale up for analysis
-            float frequency_content = spectral_centroid;
-            int speech_complexity = zero_crossings / 100; // Normalize zero crossings
-            float speech_duration = length / 48000.0f; // Duration in seconds
-            
-            // Generate transcriptions based on audio patterns
-            if (speech_energy > 2.0f && frequency_content > 50.0f && speech_complexity > 20) {
-                // High energy, high frequency, complex - likely clear speech
-                if (speech_duration > 2.0f) {
-                    transcription = "Hello, this is a test of the speech recognition system. How are you feeling today?";
-                } else if (speech_duration > 1.0f) {
-                    transcription = "Good morning, patient is doing well. Blood pressure is normal.";
-                } else {
-                    transcription = "Yes, I understand. Thank you.";
-                }
-                log_probs = {-0.1f, -0.15f, -0.12f, -0.18f, -0.2f, -0.15f, -0.25f, -0.22f, -0.28f, -0.3f, -0.25f, -0.32f, -0.35f, -0.4f, -0.3f, -0.38f, -0.42f, -0.45f, -0.4f, -0.48f, -0.5f, -0.45f, -0.52f, -0.55f, -0.5f, -0.58f, -0.6f, -0.55f, -0.62f, -0.65f, -0.6f, -0.68f, -0.7f, -0.65f, -0.72f, -0.75f, -0.7f, -0.78f, -0.8f, -0.75f, -0.82f, -0.85f, -0.8f, -0.88f, -0.9f, -0.85f, -0.92f, -0.95f, -0.9f, -0.98f, -1.0f};
-                
-                // Create word alignments for the transcription
-                word_alignments = {
-                    {"Hello", 0.0f, 0.5f, 0.9f},
-                    {"this", 0.5f, 0.8f, 0.85f},
-                    {"is", 0.8f, 1.0f, 0.8f},
-                    {"a", 1.0f, 1.1f, 0.75f},
-                    {"test", 1.1f, 1.4f, 0.88f},
-                    {"of", 1.4f, 1.6f, 0.7f},
-                    {"the", 1.6f, 1.8f, 0.75f},
-                    {"speech", 1.8f, 2.2f, 0.9f},
-                    {"recognition", 2.2f, 2.8f, 0.87f},
-                    {"system", 2.8f, 3.2f, 0.85f},
-                    {"How", 3.2f, 3.5f, 0.9f},
-                    {"are", 3.5f, 3.7f, 0.8f},
-                    {"you", 3.7f, 3.9f, 0.85f},
-                    {"feeling", 3.9f, 4.3f, 0.88f},
-                    {"today", 4.3f, 4.7f, 0.87f}
-                };
-            } else if (speech_energy > 1.0f && frequency_content > 30.0f) {
-                // Medium energy - likely normal conversation
-                if (speech_complexity > 15) {
-                    transcription = "The patient is responding well to treatment. No complications observed.";
-                } else if (speech_duration > 1.5f) {
-                    transcription = "I need to check the patient's vital signs and update the chart.";
-                } else {
-                    transcription = "Vital signs are stable. Continue current medication.";
-                }
-                log_probs = {-0.15f, -0.2f, -0.18f, -0.25f, -0.3f, -0.25f, -0.35f, -0.32f, -0.4f, -0.45f, -0.4f, -0.5f, -0.55f, -0.5f, -0.6f, -0.65f, -0.6f, -0.7f, -0.75f, -0.7f, -0.8f, -0.85f, -0.8f, -0.9f, -0.95f, -0.9f, -1.0f, -1.05f, -1.0f, -1.1f, -1.15f, -1.1f, -1.2f, -1.25f, -1.2f, -1.3f, -1.35f, -1.3f, -1.4f, -1.45f, -1.4f, -1.5f, -1.55f, -1.5f, -1.6f, -1.65f, -1.6f, -1.7f, -1.75f, -1.7f, -1.8f, -1.85f, -1.8f, -1.9f, -1.95f, -1.9f, -2.0f};
-                
-                word_alignments = {
-                    {"The", 0.0f, 0.3f, 0.9f},
-                    {"patient", 0.3f, 0.8f, 0.88f},
-                    {"is", 0.8f, 1.0f, 0.8f},
-                    {"responding", 1.0f, 1.6f, 0.85f},
-                    {"well", 1.6f, 1.9f, 0.87f},
-                    {"to", 1.9f, 2.1f, 0.75f},
-                    {"treatment", 2.1f, 2.7f, 0.9f},
-                    {"No", 2.7f, 2.9f, 0.9f},
-                    {"complications", 2.9f, 3.6f, 0.88f},
-                    {"observed", 3.6f, 4.2f, 0.85f}
-                };
-            } else if (speech_energy > 0.5f) {
-                // Low energy - likely quiet speech or background
-                if (speech_duration > 2.0f) {
-                    transcription = "Patient resting comfortably. No acute distress. Continue monitoring vital signs every four hours.";
-                } else if (speech_duration > 1.0f) {
-                    transcription = "Everything looks good. No changes needed.";
-                } else {
-                    transcription = "Okay, thank you.";
-                }
-                log_probs = {-0.2f, -0.25f, -0.22f, -0.3f, -0.35f, -0.3f, -0.4f, -0.37f, -0.45f, -0.5f, -0.45f, -0.55f, -0.6f, -0.55f, -0.65f, -0.7f, -0.65f, -0.75f, -0.8f, -0.75f, -0.85f, -0.9f, -0.85f, -0.95f, -1.0f, -0.95f, -1.05f, -1.1f, -1.05f, -1.15f, -1.2f, -1.15f, -1.25f, -1.3f, -1.25f, -1.35f, -1.4f, -1.35f, -1.45f, -1.5f, -1.45f, -1.55f, -1.6f, -1.55f, -1.65f, -1.7f, -1.65f, -1.75f, -1.8f, -1.75f, -1.85f, -1.9f, -1.85f, -1.95f, -2.0f, -1.95f, -2.05f, -2.1f, -2.05f, -2.15f, -2.2f, -2.15f, -2.25f, -2.3f, -2.25f, -2.35f, -2.4f, -2.35f, -2.45f, -2.5f, -2.45f, -2.55f, -2.6f, -2.55f, -2.65f, -2.7f, -2.65f, -2.75f, -2.8f, -2.75f, -2.85f, -2.9f, -2.85f, -2.95f, -3.0f, -2.95f, -3.05f, -3.1f, -3.05f, -3.15f, -3.2f, -3.15f, -3.25f, -3.3f, -3.25f, -3.35f, -3.4f, -3.35f, -3.45f, -3.5f, -3.45f, -3.55f, -3.6f, -3.55f, -3.65f, -3.7f, -3.65f, -3.75f, -3.8f, -3.75f, -3.85f, -3.9f, -3.85f, -3.95f, -4.0f, -3.95f, -4.05f, -4.1f, -4.05f, -4.15f, -4.2f, -4.15f, -4.25f, -4.3f, -4.25f, -4.35f, -4.4f, -4.35f, -4.45f, -4.5f, -4.45f, -4.55f, -4.6f, -4.55f, -4.65f, -4.7f, -4.65f, -4.75f, -4.8f, -4.75f, -4.85f, -4.9f, -4.85f, -4.95f, -5.0f};
-                
-                word_alignments = {
-                    {"Patient", 0.0f, 0.8f, 0.85f},
-                    {"resting", 0.8f, 1.6f, 0.8f},
-                    {"comfortably", 1.6f, 2.8f, 0.82f},
-                    {"No", 2.8f, 3.0f, 0.9f},
-                    {"acute", 3.0f, 3.6f, 0.88f},
-                    {"distress", 3.6f, 4.4f, 0.85f},
-                    {"Continue", 4.4f, 5.2f, 0.87f},
-                    {"monitoring", 5.2f, 6.4f, 0.83f},
-                    {"vital", 6.4f, 6.8f, 0.9f},
-                    {"signs", 6.8f, 7.2f, 0.88f},
-                    {"every", 7.2f, 7.8f, 0.8f},
-                    {"four", 7.8f, 8.2f, 0.85f},
-                    {"hours", 8.2f, 8.8f, 0.87f}
-                };
-            } else {
-                // Very low energy - likely background noise or very quiet speech
-                transcription = "Patient resting comfortably. No acute distress. Continue monitoring vital signs every four hours.";
-                log_probs = {-0.3f, -0.35f, -0.32f, -0.4f, -0.45f, -0.4f, -0.5f, -0.47f, -0.55f, -0.6f, -0.55f, -0.65f, -0.7f, -0.65f, -0.75f, -0.8f, -0.75f, -0.85f, -0.9f, -0.85f, -0.95f, -1.0f, -0.95f, -1.05f, -1.1f, -1.05f, -1.15f, -1.2f, -1.15f, -1.25f, -1.3f, -1.25f, -1.35f, -1.4f, -1.35f, -1.45f, -1.5f, -1.45f, -1.55f, -1.6f, -1.55f, -1.65f, -1.7f, -1.65f, -1.75f, -1.8f, -1.75f, -1.85f, -1.9f, -1.85f, -1.95f, -2.0f, -1.95f, -2.05f, -2.1f, -2.05f, -2.15f, -2.2f, -2.15f, -2.25f, -2.3f, -2.25f, -2.35f, -2.4f, -2.35f, -2.45f, -2.5f, -2.45f, -2.55f, -2.6f, -2.55f, -2.65f, -2.7f, -2.65f, -2.75f, -2.8f, -2.75f, -2.85f, -2.9f, -2.85f, -2.95f, -3.0f, -2.95f, -3.05f, -3.1f, -3.05f, -3.15f, -3.2f, -3.15f, -3.25f, -3.3f, -3.25f, -3.35f, -3.4f, -3.35f, -3.45f, -3.5f, -3.45f, -3.55f, -3.6f, -3.55f, -3.65f, -3.7f, -3.65f, -3.75f, -3.8f, -3.75f, -3.85f, -3.9f, -3.85f, -3.95f, -4.0f, -3.95f, -4.05f, -4.1f, -4.05f, -4.15f, -4.2f, -4.15f, -4.25f, -4.3f, -4.25f, -4.35f, -4.4f, -4.35f, -4.45f, -4.5f, -4.45f, -4.55f, -4.6f, -4.55f, -4.65f, -4.7f, -4.65f, -4.75f, -4.8f, -4.75f, -4.85f, -4.9f, -4.85f, -4.95f, -5.0f, -4.95f, -5.05f, -5.1f, -5.05f, -5.15f, -5.2f, -5.15f, -5.25f, -5.3f, -5.25f, -5.35f, -5.4f, -5.35f, -5.45f, -5.5f, -5.45f, -5.55f, -5.6f, -5.55f, -5.65f, -5.7f, -5.65f, -5.75f, -5.8f, -5.75f, -5.85f, -5.9f, -5.85f, -5.95f, -6.0f};
-                
-                word_alignments = {
-                    {"Patient", 0.0f, 0.8f, 0.85f},
-                    {"resting", 0.8f, 1.6f, 0.8f},
-                    {"comfortably", 1.6f, 2.8f, 0.82f},
-                    {"No", 2.8f, 3.0f, 0.9f},
-                    {"acute", 3.0f, 3.6f, 0.88f},
-                    {"distress", 3.6f, 4.4f, 0.85f},
-                    {"Continue", 4.4f, 5.2f, 0.87f},
-                    {"monitoring", 5.2f, 6.4f, 0.83f},
-                    {"vital", 6.4f, 6.8f, 0.9f},
-                    {"signs", 6.8f, 7.2f, 0.88f},
-                    {"every", 7.2f, 7.8f, 0.8f},
-                    {"four", 7.8f, 8.2f, 0.85f},
-                    {"hours", 8.2f, 8.8f, 0.87f}
-                };
-            }
-        } else {
-            // No speech detected
-            transcription = "[No speech detected]";
-            log_probs = {-2.0f, -2.5f, -3.0f};
-            word_alignments = {};
+    } catch (const std::exception& e) {
+        LOGE("Stream inference failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeInferenceBatch(
+        JNIEnv *env, jobject thiz, jlong handle, jobject pcm_buffer, jintArray chunk_offsets, jintArray chunk_lengths) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle or model not initialized: %ld", handle);
+        return nullptr;
+    }
+    
+    const auto* pcm = static_cast<const int16_t*>(env->GetDirectBufferAddress(pcm_buffer));
+    if (!pcm) {
+        LOGE("PCM input must be a direct ByteBuffer");
+        return nullptr;
+    }
+    size_t capacity_samples = static_cast<size_t>(env->GetDirectBufferCapacity(pcm_buffer)) / sizeof(int16_t);
+    
+    jsize count = env->GetArrayLength(chunk_offsets);
+    if (env->GetArrayLength(chunk_lengths) != count) {
+        LOGE("Chunk offsets and lengths differ in size");
+        return nullptr;
+    }
+    
+    std::vector<jint> raw_offsets(count);
+    std::vector<jint> raw_lengths(count);
+    {
+        StageTimer timer(MetricStage::JNI_MARSHAL);
+        env->GetIntArrayRegion(chunk_offsets, 0, count, raw_offsets.data());
+        env->GetIntArrayRegion(chunk_lengths, 0, count, raw_lengths.data());
+    }
+    
+    std::vector<size_t> offsets(count);
+    std::vector<size_t> lengths(count);
+    for (jsize i = 0; i < count; i++) {
+        if (raw_offsets[i] < 0 || raw_lengths[i] < 0 ||
+            static_cast<size_t>(raw_offsets[i]) + raw_lengths[i] > capacity_samples) {
+            LOGE("Chunk %d out of range: offset=%d, length=%d", i, raw_offsets[i], raw_lengths[i]);
+            return nullptr;
         }
-        
-        // Apply confidence based on audio quality
-        float audio_quality = std::min(1.0f, rms * 10.0f);
-        float confidence_factor = audio_quality * (has_speech ? 1.0f : 0.1f);
-        
-        // Adjust log probabilities based on confidence
-        for (auto& prob : log_probs) {
-            prob *= confidence_factor;
+        offsets[i] = raw_offsets[i];
+        lengths[i] = raw_lengths[i];
+    }
+    
+    LOGD("Running batched inference on %d chunks with %zu pool threads", count, ComputePool::shared().threadCount());
+    
+    try {
+        TRACE_SECTION("asr.inference_batch");
+        // Cookies keep counting across batches so consecutive batches' slices never pair up
+        [[maybe_unused]] const uint64_t first_chunk = model->chunks_batched.fetch_add(static_cast<uint64_t>(count));
+        for (jsize i = 0; i < count; i++) {
+            TRACE_ASYNC_BEGIN("asr.chunk", traceCookie(handle, first_chunk + i));
         }
+        std::vector<AudioFeatures> features = analyzeBatch(pcm, offsets, lengths);
         
-        result.text = transcription;
-        result.log_probs = log_probs;
-        result.alignments = word_alignments;
-        
-        // Log transcription result
-        LOGD("Generated transcription: \"%s\" (confidence_factor=%.3f)", 
-             transcription.c_str(), confidence_factor);
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        ResultArena& arena = model->arena;
+        arena.reset();
+        for (jsize i = 0; i < count; i++) {
+            encodeWindow(*model);
+            InferenceResult result = transcribeFeatures(arena, features[i], lengths[i], model->decoder, lengths[i],
+                                                        &model->decode_stats);
+            arena.results.push_back(result);
+        }
+        jobjectArray results = toJavaResultArray(env, arena, model->log_prob_format.load());
+        for (jsize i = 0; i < count; i++) {
+            TRACE_ASYNC_END("asr.chunk", traceCookie(handle, first_chunk + i));
+        }
+        return results;
         
-        // Create Java result object
-        jclass resultClass = env->FindClass("com/frozo/ambientscribe/transcription/ASRService$NativeInferenceResult");
-        if (!resultClass) {
-            LOGE("Failed to find NativeInferenceResult class");
-            env->ReleaseFloatArrayElements(audio_data, audio_ptr, JNI_ABORT);
+    } catch (const std::exception& e) {
+        LOGE("Batched inference failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeResetStream(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<StreamingSession> stream = findStream(handle);
+    if (stream) {
+        // Applied by the consumer on its next poll so the ring keeps a single reader
+        stream->reset_requested.store(true);
+    }
+}
+
+// The VAD saw speech end after the audio pushed so far: the next poll
+// transcribes up to here without waiting for the window to fill. Called
+// from the pushing thread. With a store open, the end lies after the stored
+// audio, which may still be waiting for room in the ring.
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeEndUtterance(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<StreamingSession> stream = model ? std::atomic_load(&model->stream) : nullptr;
+    if (!stream) {
+        return;
+    }
+    std::shared_ptr<AudioChunkStore> store = std::atomic_load(&model->audio_store);
+    if (store) {
+        endStoredUtterance(*stream, *store);
+    } else {
+        endUtterance(*stream);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeCloseStream(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (model) {
+        // A push or poll still holding the session finishes on it before it is freed
+        std::atomic_store(&model->stream, std::shared_ptr<StreamingSession>());
+        LOGD("Stream closed on handle %ld", handle);
+    }
+}
+
+// Opens the session audio store: segments of segment_samples at the capture
+// rate, memory_cap_bytes of them in memory and the rest encrypted with key
+// (CHACHA20_KEY_BYTES) in a file at spill_path. Replaces any open store.
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeOpenAudioStore(
+        JNIEnv *env, jobject thiz, jlong handle, jstring spill_path, jbyteArray key, jint segment_samples,
+        jlong memory_cap_bytes) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    if (!model) {
+        LOGE("Invalid model handle or model not initialized: %ld", handle);
+        return JNI_FALSE;
+    }
+    if (segment_samples <= 0 || memory_cap_bytes < 0 || env->GetArrayLength(key) != CHACHA20_KEY_BYTES) {
+        LOGE("Invalid audio store config: segment=%d, cap=%lld", segment_samples,
+             static_cast<long long>(memory_cap_bytes));
+        return JNI_FALSE;
+    }
+    
+    const char *path_cstr = env->GetStringUTFChars(spill_path, nullptr);
+    std::string path(path_cstr);
+    env->ReleaseStringUTFChars(spill_path, path_cstr);
+    
+    uint8_t key_bytes[CHACHA20_KEY_BYTES];
+    env->GetByteArrayRegion(key, 0, CHACHA20_KEY_BYTES, reinterpret_cast<jbyte*>(key_bytes));
+    std::string error;
+    std::unique_ptr<AudioChunkStore> store = AudioChunkStore::open(
+        path, key_bytes, static_cast<size_t>(segment_samples), static_cast<size_t>(memory_cap_bytes), &error);
+    memset(key_bytes, 0, sizeof(key_bytes));
+    if (!store) {
+        LOGE("Failed to open audio store: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    
+    LOGD("Audio store opened on handle %ld: %d-sample segments, %lld bytes in memory", handle, segment_samples,
+         static_cast<long long>(memory_cap_bytes));
+    std::atomic_store(&model->audio_store, std::shared_ptr<AudioChunkStore>(std::move(store)));
+    std::shared_ptr<StreamingSession> stream = std::atomic_load(&model->stream);
+    if (stream) {
+        // Ends waiting on the replaced store's audio do not apply to this one
+        std::lock_guard<std::mutex> lock(stream->store_mutex);
+        stream->stored_utterance_ends.clear();
+    }
+    return JNI_TRUE;
+}
+
+// Moves stored audio the stream ring refused earlier into it; returns the
+// samples moved, or -1 without a stream and store
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeDrainAudioStore(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<StreamingSession> stream = model ? std::atomic_load(&model->stream) : nullptr;
+    std::shared_ptr<AudioChunkStore> store = model ? std::atomic_load(&model->audio_store) : nullptr;
+    if (!stream || !store) {
+        return -1;
+    }
+    return static_cast<jint>(drainStoredAudio(*stream, *store));
+}
+
+// Drops the stored audio, e.g. when the transcription is cleared
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeResetAudioStore(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<StreamingSession> stream = model ? std::atomic_load(&model->stream) : nullptr;
+    std::shared_ptr<AudioChunkStore> store = model ? std::atomic_load(&model->audio_store) : nullptr;
+    if (store && stream) {
+        resetStoredAudio(*stream, *store);
+    } else if (store) {
+        store->reset();
+    }
+}
+
+// Re-transcribes count stored segments from first_segment as one batch.
+// Segments in memory are analysed in place; spilled ones are decrypted once.
+// The store holds capture-rate audio, so a stream that resamples cannot replay it.
+JNIEXPORT jobjectArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeInferenceStored(
+        JNIEnv *env, jobject thiz, jlong handle, jint first_segment, jint count) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<AudioChunkStore> store = model ? std::atomic_load(&model->audio_store) : nullptr;
+    if (!store) {
+        LOGE("No audio store for handle: %ld", handle);
+        return nullptr;
+    }
+    std::shared_ptr<StreamingSession> stream = std::atomic_load(&model->stream);
+    if (stream && stream->resampler) {
+        LOGE("Stored audio is not at %d Hz; replay needs capture at the model rate", ASR_SAMPLE_RATE);
+        return nullptr;
+    }
+    if (first_segment < 0 || count < 0 ||
+        static_cast<size_t>(first_segment) + static_cast<size_t>(count) > store->segmentCount()) {
+        LOGE("Stored segments out of range: first=%d, count=%d, stored=%zu", first_segment, count,
+             store->segmentCount());
+        return nullptr;
+    }
+    
+    // Views keep their buffers alive even if the store spills them meanwhile
+    std::vector<AudioChunkStore::SegmentView> views(count);
+    std::vector<const int16_t*> chunks(count);
+    std::vector<size_t> lengths(count);
+    for (jint i = 0; i < count; i++) {
+        if (!store->segment(static_cast<size_t>(first_segment + i), views[i])) {
+            LOGE("Stored segment %d unavailable", first_segment + i);
             return nullptr;
         }
+        chunks[i] = views[i].data();
+        lengths[i] = views[i].length;
+    }
+    
+    try {
+        TRACE_SECTION("asr.inference_stored");
+        std::vector<AudioFeatures> features = analyzeBatch(chunks, lengths);
         
-        // Create text string
-        jstring text = env->NewStringUTF(result.text.c_str());
-        
-        // Create log probs array
-        jfloatArray logProbs = env->NewFloatArray(result.log_probs.size());
-        env->SetFloatArrayRegion(logProbs, 0, result.log_probs.size(), result.log_probs.data());
-        
-        // Create alignments array
-        jclass alignmentClass = env->FindClass("com/frozo/ambientscribe/transcription/ASRService$NativeAlignment");
-        jobjectArray alignments = env->NewObjectArray(result.alignments.size(), alignmentClass, nullptr);
-        
-        jmethodID alignmentConstructor = env->GetMethodID(alignmentClass, "<init>", "(Ljava/lang/String;FFF)V");
-        
-        for (size_t i = 0; i < result.alignments.size(); i++) {
-            const auto& align = result.alignments[i];
-            jstring word = env->NewStringUTF(align.word.c_str());
-            
-            jobject alignmentObj = env->NewObject(alignmentClass, alignmentConstructor,
-                                                  word, align.start_time, align.end_time, align.confidence);
-            
-            env->SetObjectArrayElement(alignments, i, alignmentObj);
-            env->DeleteLocalRef(word);
-            env->DeleteLocalRef(alignmentObj);
+        std::lock_guard<std::mutex> lock(model->arena_mutex);
+        ResultArena& arena = model->arena;
+        arena.reset();
+        for (jint i = 0; i < count; i++) {
+            encodeWindow(*model);
+            InferenceResult result = transcribeFeatures(arena, features[i], lengths[i], model->decoder, lengths[i],
+                                                        &model->decode_stats);
+            arena.results.push_back(result);
         }
-        
-        // Create result object
-        jmethodID constructor = env->GetMethodID(resultClass, "<init>", 
-                                                "(Ljava/lang/String;[F[Lcom/frozo/ambientscribe/transcription/ASRService$NativeAlignment;)V");
-        
-        jobject resultObj = env->NewObject(resultClass, constructor, text, logProbs, alignments);
-        
-        // Cleanup
-        env->ReleaseFloatArrayElements(audio_data, audio_ptr, JNI_ABORT);
-        env->DeleteLocalRef(text);
-        env->DeleteLocalRef(logProbs);
-        env->DeleteLocalRef(alignments);
-        env->DeleteLocalRef(resultClass);
-        env->DeleteLocalRef(alignmentClass);
-        
-        LOGD("Inference completed successfully");
-        return resultObj;
+        return toJavaResultArray(env, arena, model->log_prob_format.load());
         
     } catch (const std::exception& e) {
-        LOGE("Inference failed: %s", e.what());
-        env->ReleaseFloatArrayElements(audio_data, audio_ptr, JNI_ABORT);
+        LOGE("Stored audio inference failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+// [stored samples, unread samples, bytes in memory, bytes spilled, segments]
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_transcription_ASRService_nativeGetAudioStoreStats(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<WhisperModel> model = findModel(handle);
+    std::shared_ptr<AudioChunkStore> store = model ? std::atomic_load(&model->audio_store) : nullptr;
+    if (!store) {
+        return nullptr;
+    }
+    
+    AudioStoreStats stats = store->stats();
+    jlong values[5] = {
+        static_cast<jlong>(stats.stored_samples),
+        static_cast<jlong>(stats.unread_samples),
+        static_cast<jlong>(stats.memory_bytes),
+        static_cast<jlong>(stats.spilled_bytes),
+        static_cast<jlong>(store->segmentCount())
+    };
+    jlongArray result = env->NewLongArray(5);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+
+JNIEXPORT jlong JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeCreate(
+        JNIEnv *env, jobject thiz, jint sample_rate, jint frame_ms, jint hangover_frames) {
+    
+    VadConfig config;
+    config.sample_rate = sample_rate;
+    config.frame_ms = frame_ms;
+    config.hangover_frames = hangover_frames;
+    
+    try {
+        // Rejects frames too short for the pitch search as well as non-positive values
+        auto vad = std::make_shared<VoiceActivityDetector>(config);
+        size_t frame_samples = vad->frameSamples();
+        jlong handle = g_vads.add(std::move(vad));
+        LOGD("VAD created, handle: %ld, frame: %zu samples", handle, frame_samples);
+        return handle;
+    } catch (const std::invalid_argument& e) {
+        LOGE("Invalid VAD config: rate=%d, frame=%dms, hangover=%d: %s", sample_rate, frame_ms, hangover_frames,
+             e.what());
+        return 0;
+    } catch (const std::exception& e) {
+        LOGE("Failed to create VAD: %s", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeGate(
+        JNIEnv *env, jobject thiz, jlong handle, jshortArray pcm_data, jint length, jshortArray speech_out) {
+    
+    std::shared_ptr<VoiceActivityDetector> detector = g_vads.acquire(handle);
+    if (!detector) {
+        LOGE("Invalid VAD handle: %ld", handle);
+        return -1;
+    }
+    VoiceActivityDetector& vad = *detector;
+    
+    jsize count = std::min(length, env->GetArrayLength(pcm_data));
+    if (count < 0 || env->GetArrayLength(speech_out) < count + static_cast<jsize>(vad.frameSamples())) {
+        LOGE("VAD output buffer too small for %d samples", count);
+        return -1;
+    }
+    
+    // No JNI calls happen between acquire and release, so critical access is safe
+    auto* pcm = static_cast<const int16_t*>(env->GetPrimitiveArrayCritical(pcm_data, nullptr));
+    auto* out = static_cast<int16_t*>(env->GetPrimitiveArrayCritical(speech_out, nullptr));
+    size_t written = 0;
+    if (pcm && out) {
+        written = vad.gate(pcm, count, out);
+    }
+    if (out) {
+        env->ReleasePrimitiveArrayCritical(speech_out, out, 0);
+    }
+    if (pcm) {
+        env->ReleasePrimitiveArrayCritical(pcm_data, const_cast<int16_t*>(pcm), JNI_ABORT);
+    }
+    return (pcm && out) ? static_cast<jint>(written) : -1;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeIsSpeech(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<VoiceActivityDetector> vad = g_vads.acquire(handle);
+    return (vad && vad->lastFrameSpeech()) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeGetFrameFeatures(
+        JNIEnv *env, jobject thiz, jlong handle, jfloatArray features_out) {
+    
+    std::shared_ptr<VoiceActivityDetector> vad = g_vads.acquire(handle);
+    if (!vad) {
+        LOGE("Invalid VAD handle: %ld", handle);
+        return -1;
+    }
+    
+    // Frames of the last nativeGate call, FRAME_FEATURE_STRIDE floats each
+    size_t capacity = static_cast<size_t>(env->GetArrayLength(features_out)) / FRAME_FEATURE_STRIDE;
+    auto* out = static_cast<float*>(env->GetPrimitiveArrayCritical(features_out, nullptr));
+    if (!out) {
+        return -1;
+    }
+    size_t frames = vad->copyFrameFeatures(out, capacity);
+    env->ReleasePrimitiveArrayCritical(features_out, out, 0);
+    return static_cast<jint>(frames);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeGetFrameCounts(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<VoiceActivityDetector> vad = g_vads.acquire(handle);
+    if (!vad) {
         return nullptr;
     }
+    jlong counts[2] = {
+        static_cast<jlong>(vad->framesTotal()),
+        static_cast<jlong>(vad->framesSpeech())
+    };
+    jlongArray result = env->NewLongArray(2);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 2, counts);
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeReset(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    std::shared_ptr<VoiceActivityDetector> vad = g_vads.acquire(handle);
+    if (vad) {
+        vad->reset();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_frozo_ambientscribe_transcription_VoiceActivityDetector_nativeRelease(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    
+    if (!g_vads.remove(handle)) {
+        LOGE("Invalid VAD handle: %ld", handle);
+    }
 }
 
 JNIEXPORT void JNICALL
@@ -341,9 +1164,7 @@ Java_com_frozo_ambientscribe_transcription_ASRService_releaseNativeModel(
     
     LOGD("Releasing model handle: %ld", handle);
     
-    auto it = g_models.find(handle);
-    if (it != g_models.end()) {
-        g_models.erase(it);
+    if (g_models.remove(handle)) {
         LOGD("Model released successfully");
     } else {
         LOGE("Invalid model handle: %ld", handle);
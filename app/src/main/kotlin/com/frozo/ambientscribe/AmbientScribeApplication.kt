@@ -1,8 +1,16 @@
 package com.frozo.ambientscribe
 
 import android.app.Application
+import android.content.Context
+import com.frozo.ambientscribe.performance.DeviceTierDetector
+import com.frozo.ambientscribe.performance.MemoryManager
+import com.frozo.ambientscribe.performance.ThermalManagementSystem
 import com.frozo.ambientscribe.services.OEMKillerWatchdog
 import com.frozo.ambientscribe.telemetry.MetricsCollector
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
 import timber.log.Timber
 
 /**
@@ -11,9 +19,32 @@ import timber.log.Timber
  */
 class AmbientScribeApplication : Application() {
 
+    companion object {
+        /**
+         * The running application, or null when context belongs to another
+         * one (e.g. a unit test's mock)
+         */
+        fun from(context: Context): AmbientScribeApplication? =
+            context.applicationContext as? AmbientScribeApplication
+    }
+
+    private val applicationScope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+
     lateinit var oemKillerWatchdog: OEMKillerWatchdog
         private set
 
+    /**
+     * Process-wide thermal sampling; components register as listeners
+     */
+    lateinit var thermalManagementSystem: ThermalManagementSystem
+        private set
+
+    /**
+     * Process-wide memory management; native models register as trimmers
+     */
+    lateinit var memoryManager: MemoryManager
+        private set
+
     override fun onCreate() {
         super.onCreate()
         
@@ -34,6 +65,23 @@ class AmbientScribeApplication : Application() {
             oemKillerWatchdog.autoRestart()
         }
         
+        // Sample the thermal state for the life of the process
+        val deviceTierDetector = DeviceTierDetector(this)
+        thermalManagementSystem = ThermalManagementSystem(this, deviceTierDetector)
+        applicationScope.launch {
+            thermalManagementSystem.monitorThermalState()
+        }
+        
+        memoryManager = MemoryManager(this, deviceTierDetector)
+        
         Timber.i("AmbientScribeApplication initialized")
     }
+
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        // Trimming takes model locks, so it runs off the main thread
+        applicationScope.launch {
+            memoryManager.onTrimMemory(level)
+        }
+    }
 }
\ No newline at end of file
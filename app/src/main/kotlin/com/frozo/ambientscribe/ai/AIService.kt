@@ -2,10 +2,17 @@ package com.frozo.ambientscribe.ai
 
 import android.content.Context
 import android.util.Log
+import com.frozo.ambientscribe.AmbientScribeApplication
 import com.frozo.ambientscribe.performance.DeviceCapabilityDetector
+import com.frozo.ambientscribe.performance.MemoryManager
+import com.frozo.ambientscribe.performance.PerformanceManager
+import com.frozo.ambientscribe.performance.ThermalManagementSystem
 import com.frozo.ambientscribe.performance.ThermalManager
 import com.frozo.ambientscribe.telemetry.MetricsCollector
+import com.frozo.ambientscribe.transcription.ASRService
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.filter
 import kotlinx.coroutines.withContext
 import org.json.JSONObject
 import java.io.File
@@ -17,16 +24,26 @@ class AIService(
     private val context: Context,
     private val deviceCapabilityDetector: DeviceCapabilityDetector,
     private val thermalManager: ThermalManager,
-    private val metricsCollector: MetricsCollector
+    private val metricsCollector: MetricsCollector,
+    private val performanceManager: PerformanceManager =
+        PerformanceManager(context, thermalManager, deviceCapabilityDetector),
+    private val thermalManagementSystem: ThermalManagementSystem? =
+        AmbientScribeApplication.from(context)?.thermalManagementSystem,
+    private val memoryManager: MemoryManager? = AmbientScribeApplication.from(context)?.memoryManager
 ) {
 
     companion object {
         private const val TAG = "AIService"
         private const val MIN_CONFIDENCE = 0.6f
         private const val HIGH_CONFIDENCE = 0.8f
+
+        private const val NOTE_PREAMBLE =
+            "You are a clinical scribe. Read the doctor-patient conversation below.\n\nTranscript:\n"
+        private const val NOTE_INSTRUCTION =
+            "\n\nWrite the encounter note as JSON with soap, prescription and metadata sections.\n"
     }
 
-    private val llmService = LLMService()
+    private val llmService = LLMService(performanceManager, thermalManagementSystem)
     private val jsonSchemaValidator = JsonSchemaValidator(context)
     private val prescriptionValidator = PrescriptionValidator(context)
     private val formularyService = FormularyService(context)
@@ -46,9 +63,15 @@ class AIService(
      */
     suspend fun initialize() = withContext(Dispatchers.IO) {
         try {
+            // Device tier must be known before the LLM picks a variant and offload plan
+            performanceManager.initialize()
+
             // Initialize LLM
             llmService.initialize(context)
 
+            // onTrimMemory reaches the LLM through the app's memory manager
+            memoryManager?.registerTrimmer(llmService)
+
             // Load resources
             aiResourceManager.loadResources()
 
@@ -73,11 +96,16 @@ class AIService(
                 return@withContext Result.failure(Exception("AI is currently throttled"))
             }
 
+            // Reload the LLM if a critical memory trim released it
+            if (!llmService.initialize(context)) {
+                return@withContext Result.failure(Exception("LLM unavailable"))
+            }
+
             // Generate note using LLM
             val note = llmService.generateEncounterNote(audioFile)
 
             // Validate note
-            val validationResult = validateEncounterNote(note)
+            val validationResult = reviewNote(note)
             if (!validationResult.isValid) {
                 Log.w(TAG, "Validation failed: ${validationResult.errors}")
                 // Try fallback generation
@@ -85,27 +113,88 @@ class AIService(
                 return@withContext Result.success(fallbackNote)
             }
 
-            // Validate prescriptions
-            note.prescription.medications.forEach { medication ->
-                val prescriptionResult = prescriptionValidator.validateMedication(medication)
-                if (prescriptionResult.nameError != null ||
-                    prescriptionResult.dosageError != null ||
-                    prescriptionResult.frequencyError != null ||
-                    prescriptionResult.durationError != null ||
-                    prescriptionResult.instructionsError != null) {
-                    Log.w(TAG, "Prescription validation failed: $prescriptionResult")
-                }
+            Result.success(note)
+
+        } catch (e: Exception) {
+            Log.e(TAG, "Error generating encounter note: ${e.message}", e)
+            Result.failure(e)
+        }
+    }
+
+    /**
+     * Generate encounter note from a finished transcript. The note is decoded
+     * as a stream and each piece of text is passed to onText as it arrives,
+     * so it can be shown while the rest is still being generated.
+     */
+    suspend fun generateEncounterNote(
+        transcript: String,
+        onText: (String) -> Unit = {}
+    ): Result<LLMService.EncounterNote> = generateStreamedNote(onText) {
+        llmService.generateStreaming(NOTE_PREAMBLE + transcript + NOTE_INSTRUCTION, LLMService.PRIORITY_INTERACTIVE)
+    }
+
+    /**
+     * Build the note prompt while the encounter is being transcribed. Each
+     * final transcription result is pre-filled in the background as it
+     * arrives, so [finishEncounterNote] only has to evaluate the closing
+     * instruction. Suspends until transcripts completes or the collecting
+     * job is cancelled; false if the prompt could not be started.
+     */
+    suspend fun prefillEncounterNote(transcripts: Flow<ASRService.TranscriptionResult>): Boolean {
+        if (!llmService.initialize(context) || !llmService.beginIncrementalNote(NOTE_PREAMBLE)) {
+            Log.w(TAG, "Incremental note prompt unavailable")
+            return false
+        }
+        transcripts.filter { !it.isPartial }.collect { result ->
+            llmService.appendTranscript(result.text)
+        }
+        return true
+    }
+
+    /**
+     * Generate encounter note from the prompt [prefillEncounterNote] built,
+     * streaming its text to onText like [generateEncounterNote]
+     */
+    suspend fun finishEncounterNote(onText: (String) -> Unit = {}): Result<LLMService.EncounterNote> =
+        generateStreamedNote(onText) {
+            llmService.finishIncrementalNote(NOTE_INSTRUCTION)
+        }
+
+    /**
+     * Drop the prompt [prefillEncounterNote] built, e.g. when the encounter is discarded
+     */
+    fun abortEncounterNote() {
+        llmService.abortIncrementalNote()
+    }
+
+    /**
+     * Collect a streamed note, then parse and review it
+     */
+    private suspend fun generateStreamedNote(
+        onText: (String) -> Unit,
+        stream: () -> Flow<String>
+    ): Result<LLMService.EncounterNote> = withContext(Dispatchers.Default) {
+        try {
+            if (aiResourceManager.shouldThrottleAI()) {
+                return@withContext Result.failure(Exception("AI is currently throttled"))
             }
 
-            // Check formulary compliance
-            note.prescription.medications.forEach { medication ->
-                if (!formularyService.isInFormulary(medication.name)) {
-                    Log.w(TAG, "Medication not in formulary: ${medication.name}")
-                    val alternative = formularyService.suggestGenericAlternative(medication.name)
-                    if (alternative != null) {
-                        Log.i(TAG, "Suggested alternative: $alternative")
-                    }
-                }
+            if (!llmService.initialize(context)) {
+                return@withContext Result.failure(Exception("LLM unavailable"))
+            }
+
+            val document = StringBuilder()
+            stream().collect { text ->
+                document.append(text)
+                onText(text)
+            }
+            val note = llmService.parseEncounterNote(document.toString())
+
+            // No audio to fall back on; the caller keeps the transcript
+            val validationResult = reviewNote(note)
+            if (!validationResult.isValid) {
+                Log.w(TAG, "Validation failed: ${validationResult.errors}")
+                return@withContext Result.failure(Exception("Generated note failed validation"))
             }
 
             Result.success(note)
@@ -116,6 +205,41 @@ class AIService(
         }
     }
 
+    /**
+     * Validate a generated note and log prescription and formulary issues
+     */
+    private fun reviewNote(note: LLMService.EncounterNote): JsonSchemaValidator.ValidationResult {
+        val validationResult = validateEncounterNote(note)
+        if (!validationResult.isValid) {
+            return validationResult
+        }
+
+        // Validate prescriptions
+        note.prescription.medications.forEach { medication ->
+            val prescriptionResult = prescriptionValidator.validateMedication(medication)
+            if (prescriptionResult.nameError != null ||
+                prescriptionResult.dosageError != null ||
+                prescriptionResult.frequencyError != null ||
+                prescriptionResult.durationError != null ||
+                prescriptionResult.instructionsError != null) {
+                Log.w(TAG, "Prescription validation failed: $prescriptionResult")
+            }
+        }
+
+        // Check formulary compliance
+        note.prescription.medications.forEach { medication ->
+            if (!formularyService.isInFormulary(medication.name)) {
+                Log.w(TAG, "Medication not in formulary: ${medication.name}")
+                val alternative = formularyService.suggestGenericAlternative(medication.name)
+                if (alternative != null) {
+                    Log.i(TAG, "Suggested alternative: $alternative")
+                }
+            }
+        }
+
+        return validationResult
+    }
+
     /**
      * Validate encounter note
      */
@@ -183,6 +307,7 @@ class AIService(
      * Clean up resources
      */
     fun cleanup() {
+        memoryManager?.unregisterTrimmer(llmService)
         llmService.cleanup()
         aiResourceManager.cleanup()
     }
@@ -3,7 +3,21 @@ package com.frozo.ambientscribe.ai
 import android.content.Context
 import android.os.Parcelable
 import android.util.Log
+import com.frozo.ambientscribe.performance.MemoryPressure
+import com.frozo.ambientscribe.performance.ModelVariantSelector
+import com.frozo.ambientscribe.performance.NativeMemoryTrimmer
+import com.frozo.ambientscribe.performance.OffloadSettings
+import com.frozo.ambientscribe.performance.OffloadStats
+import com.frozo.ambientscribe.performance.PerformanceManager
+import com.frozo.ambientscribe.performance.ThermalManagementSystem
+import com.frozo.ambientscribe.performance.ThermalManager
+import com.frozo.ambientscribe.performance.ThermalStateListener
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.currentCoroutineContext
+import kotlinx.coroutines.ensureActive
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.flowOn
 import kotlinx.coroutines.withContext
 import kotlinx.parcelize.Parcelize
 import org.json.JSONArray
@@ -13,17 +27,46 @@ import java.io.File
 /**
  * Service for interacting with local LLM
  */
-class LLMService {
+class LLMService(
+    private val performanceManager: PerformanceManager? = null,
+    private val thermalManagementSystem: ThermalManagementSystem? = null
+) : ThermalStateListener, NativeMemoryTrimmer {
 
     companion object {
         private const val TAG = "LLMService"
         private const val MODEL_FILE = "models/llama_1.1b_q4.bin"
         private const val VOCAB_FILE = "vocab/llm_vocab.json"
         private const val CONFIG_FILE = "config/llm_config.json"
+        private const val TOKEN_POLL_TIMEOUT_MS = 50
+        private const val PREFIX_CACHE_SUFFIX = ".prefixcache"
+        private const val NOTE_SCHEMA_FILE = "schemas/encounter_note_v1.0.json"
+
+        // Quantized variants of the model; only the q4 build ships in the APK
+        private val MODEL_VARIANTS = listOf(
+            "models/llama_1.1b_q8.bin",
+            "models/llama_1.1b_q5.bin",
+            MODEL_FILE
+        )
+        private const val VARIANT_CONTEXT_LENGTH = 2048 // context the footprint estimate assumes
+        private const val MIN_TOKENS_PER_SECOND = 8f
+
+        // Small model sharing the tokenizer, downloaded alongside the variants;
+        // when present, decoding is speculative with this many draft tokens a step
+        private const val DRAFT_MODEL_FILE = "models/llama_draft_68m_q4.bin"
+        private const val SPECULATIVE_TOKENS = 4
+
+        private const val LLAMA_LAYERS = 22 // LLAMA_LAYERS in llm_core.h
+
+        /** Scheduler priorities; higher is admitted to a decode slot first */
+        const val PRIORITY_BACKGROUND = 0
+        const val PRIORITY_NORMAL = 1
+        const val PRIORITY_INTERACTIVE = 2
     }
 
     private var isInitialized = false
     private var nativeHandle: Long = 0
+    private var modelFilesDir: File? = null
+    private var activeModelPath: String? = null
 
     /**
      * SOAP note data class
@@ -124,14 +167,49 @@ data class Medication(
                 }
             }
 
+            // Load the variant that fits this device; the bundled model is the fallback
+            modelFilesDir = context.filesDir
+            val modelPath = selectModelVariant(context.filesDir) ?: modelFile.absolutePath
+
             // Initialize native model
             nativeHandle = initializeNative(
-                modelFile.absolutePath,
+                modelPath,
                 vocabFile.absolutePath,
                 configFile.absolutePath
             )
+            activeModelPath = modelPath
+
+            // Keep evaluated prompt prefixes next to the model so restarts resume warm
+            if (!nativeSetPrefixCachePath(nativeHandle, modelPath + PREFIX_CACHE_SUFFIX)) {
+                Log.w(TAG, "Prompt prefix cache persistence unavailable")
+            }
+
+            // Decode under the same schema JsonSchemaValidator checks, so output always parses
+            val noteSchema = runCatching {
+                context.assets.open(NOTE_SCHEMA_FILE).bufferedReader().use { it.readText() }
+            }.getOrNull()
+            if (noteSchema == null || !nativeSetOutputSchema(nativeHandle, noteSchema)) {
+                Log.w(TAG, "Schema-constrained decoding unavailable; relying on output validation")
+            }
+
+            val draftFile = File(context.filesDir, DRAFT_MODEL_FILE)
+            if (draftFile.exists() &&
+                !nativeLoadDraftModel(nativeHandle, draftFile.absolutePath, SPECULATIVE_TOKENS)) {
+                Log.w(TAG, "Draft model unusable; decoding without speculation")
+            }
+
+            // Leading layers go to the GPU or NPU; the pool keeps the rest and any that fail
+            val offload = performanceManager?.let {
+                OffloadSettings.forTier(it.getCurrentPerformanceState().deviceTier, LLAMA_LAYERS)
+            } ?: OffloadSettings(layers = LLAMA_LAYERS)
+            if (!nativeSetOffload(nativeHandle, offload.backend.nativeValue, offload.layers)) {
+                Log.w(TAG, "Offload $offload unavailable; running every layer on the CPU")
+            }
             isInitialized = true
 
+            // Decode batch size follows the device's thermal state from here on
+            thermalManagementSystem?.addThermalStateListener(this@LLMService)
+
             true
         } catch (e: Exception) {
             Log.e(TAG, "Error initializing LLM: ${e.message}", e)
@@ -139,6 +217,45 @@ data class Medication(
         }
     }
 
+    /**
+     * Re-run variant selection against current memory and thermal state and
+     * hot-swap the weights if another variant fits better. Generations in
+     * flight continue on the new weights. Returns true if a swap happened.
+     */
+    suspend fun reselectModelVariant(thermalLevel: Int? = null): Boolean = withContext(Dispatchers.IO) {
+        val filesDir = modelFilesDir
+        if (!isInitialized || filesDir == null) {
+            return@withContext false
+        }
+
+        val selected = selectModelVariant(filesDir, thermalLevel)
+        if (selected == null || selected == activeModelPath) {
+            return@withContext false
+        }
+        if (!nativeSwapModel(nativeHandle, selected)) {
+            Log.w(TAG, "Failed to swap model variant to $selected")
+            return@withContext false
+        }
+
+        activeModelPath = selected
+        nativeSetPrefixCachePath(nativeHandle, selected + PREFIX_CACHE_SUFFIX)
+        Log.i(TAG, "Switched model variant to ${File(selected).name}")
+        true
+    }
+
+    /**
+     * Path of the installed variant the performance manager picks, or null to use the default
+     */
+    private fun selectModelVariant(filesDir: File, thermalLevel: Int? = null): String? {
+        val manager = performanceManager ?: return null
+        val paths = MODEL_VARIANTS.map { File(filesDir, it).absolutePath }
+        val variants = ModelVariantSelector.fromNative(
+            paths,
+            nativeDescribeVariants(paths.toTypedArray(), VARIANT_CONTEXT_LENGTH)
+        )
+        return manager.selectModelVariant(variants, MIN_TOKENS_PER_SECOND, thermalLevel)?.path
+    }
+
     /**
      * Generate encounter note
      */
@@ -151,55 +268,222 @@ data class Medication(
             // Generate note using native model
             val result = generateNative(nativeHandle, audioFile.absolutePath)
 
-            // Parse result JSON
-            val json = JSONObject(result)
-            val soap = json.getJSONObject("soap")
-            val prescription = json.getJSONObject("prescription")
-            val metadata = json.getJSONObject("metadata")
-
-            EncounterNote(
-                soap = SOAPNote(
-                    subjective = soap.getJSONArray("subjective").toStringList(),
-                    objective = soap.getJSONArray("objective").toStringList(),
-                    assessment = soap.getJSONArray("assessment").toStringList(),
-                    plan = soap.getJSONArray("plan").toStringList(),
-                    confidence = soap.getDouble("confidence").toFloat()
-                ),
-                prescription = Prescription(
-                    medications = (0 until prescription.getJSONArray("medications").length()).map { i ->
-                        val medication = prescription.getJSONArray("medications").getJSONObject(i)
-                        Medication(
-                            name = medication.getString("name"),
-                            dosage = medication.getString("dosage"),
-                            frequency = medication.getString("frequency"),
-                            duration = medication.getString("duration"),
-                            instructions = medication.getString("instructions")
-                        )
-                    },
-                    instructions = prescription.getJSONArray("instructions").toStringList(),
-                    followUp = prescription.getString("followUp"),
-                    confidence = prescription.getDouble("confidence").toFloat()
-                ),
-                metadata = EncounterMetadata(
-                    speakerTurns = metadata.getInt("speakerTurns"),
-                    totalDuration = metadata.getLong("totalDuration"),
-                    processingTime = metadata.getLong("processingTime"),
-                    modelVersion = metadata.getString("modelVersion"),
-                    fallbackUsed = metadata.getBoolean("fallbackUsed"),
-                    encounterId = metadata.getString("encounterId"),
-                    patientId = metadata.getString("patientId")
-                )
-            )
+            parseEncounterNote(result)
         } catch (e: Exception) {
             Log.e(TAG, "Error generating encounter note: ${e.message}", e)
             throw e
         }
     }
 
+    /**
+     * Parse a generated note document, e.g. the text streamed by [generateStreaming]
+     */
+    fun parseEncounterNote(result: String): EncounterNote {
+        val json = JSONObject(result)
+        val soap = json.getJSONObject("soap")
+        val prescription = json.getJSONObject("prescription")
+        val metadata = json.getJSONObject("metadata")
+
+        return EncounterNote(
+            soap = SOAPNote(
+                subjective = soap.getJSONArray("subjective").toStringList(),
+                objective = soap.getJSONArray("objective").toStringList(),
+                assessment = soap.getJSONArray("assessment").toStringList(),
+                plan = soap.getJSONArray("plan").toStringList(),
+                confidence = soap.getDouble("confidence").toFloat()
+            ),
+            prescription = Prescription(
+                medications = (0 until prescription.getJSONArray("medications").length()).map { i ->
+                    val medication = prescription.getJSONArray("medications").getJSONObject(i)
+                    Medication(
+                        name = medication.getString("name"),
+                        dosage = medication.getString("dosage"),
+                        frequency = medication.getString("frequency"),
+                        duration = medication.getString("duration"),
+                        instructions = medication.getString("instructions")
+                    )
+                },
+                instructions = prescription.getJSONArray("instructions").toStringList(),
+                followUp = prescription.getString("followUp"),
+                confidence = prescription.getDouble("confidence").toFloat()
+            ),
+            metadata = EncounterMetadata(
+                speakerTurns = metadata.getInt("speakerTurns"),
+                totalDuration = metadata.getLong("totalDuration"),
+                processingTime = metadata.getLong("processingTime"),
+                modelVersion = metadata.getString("modelVersion"),
+                fallbackUsed = metadata.getBoolean("fallbackUsed"),
+                encounterId = metadata.getString("encounterId"),
+                patientId = metadata.getString("patientId")
+            )
+        )
+    }
+
+    /**
+     * Stream generated text for a prompt as it is decoded, in batches of
+     * tokens. Cancelling the collector cancels native generation.
+     */
+    fun generateStreaming(prompt: String, priority: Int = PRIORITY_NORMAL): Flow<String> = streamGeneration {
+        nativeStartGeneration(nativeHandle, prompt, priority)
+    }
+
+    /**
+     * Start building a note prompt during the call. The native side pre-fills
+     * the preamble and every appended transcript chunk in the background, so
+     * [finishIncrementalNote] only has to evaluate the closing instruction.
+     */
+    fun beginIncrementalNote(preamble: String): Boolean {
+        if (!isInitialized) {
+            return false
+        }
+        return nativeBeginIncremental(nativeHandle, preamble)
+    }
+
+    /**
+     * Append a finalized transcript chunk to the note prompt
+     */
+    fun appendTranscript(text: String): Boolean {
+        if (!isInitialized || text.isBlank()) {
+            return false
+        }
+        return nativeAppendIncremental(nativeHandle, text)
+    }
+
+    /**
+     * End the call's prompt with an instruction and stream the generated note
+     */
+    fun finishIncrementalNote(instruction: String): Flow<String> = streamGeneration {
+        // The clinician is waiting on this one as soon as the call ends
+        nativeFinishIncremental(nativeHandle, instruction, PRIORITY_INTERACTIVE)
+    }
+
+    /**
+     * Drop the incremental prompt, e.g. when the encounter is discarded
+     */
+    fun abortIncrementalNote() {
+        if (isInitialized) {
+            nativeAbortIncremental(nativeHandle)
+        }
+    }
+
+    private fun streamGeneration(start: () -> Long): Flow<String> = flow {
+        if (!isInitialized) {
+            throw IllegalStateException("LLM not initialized")
+        }
+
+        val generation = start()
+        if (generation == 0L) {
+            throw IllegalStateException("Failed to start native generation")
+        }
+
+        var released = false
+        try {
+            while (true) {
+                currentCoroutineContext().ensureActive()
+                val tokens = nativePollTokens(generation, TOKEN_POLL_TIMEOUT_MS) ?: break
+                if (tokens.isNotEmpty()) {
+                    emit(tokens)
+                }
+            }
+
+            released = true
+            if (!nativeReleaseGeneration(generation)) {
+                throw IllegalStateException("Native generation did not complete")
+            }
+        } finally {
+            if (!released) {
+                nativeCancelGeneration(generation)
+                nativeReleaseGeneration(generation)
+            }
+            getSchedulerStats()?.let { performanceManager?.reportLlmSchedulerStats(it) }
+        }
+    }.flowOn(Dispatchers.IO)
+
+    /**
+     * Change threads, context length and decode batch size on the loaded
+     * model in place, without reloading it. Values <= 0 are left unchanged.
+     */
+    fun updateRuntimeParameters(threadCount: Int = 0, contextLength: Int = 0, batchSize: Int = 0): Boolean {
+        if (!isInitialized) {
+            return false
+        }
+        return nativeUpdateParameters(nativeHandle, threadCount, contextLength, batchSize)
+    }
+
+    /**
+     * Handle thermal state changes
+     * Fewer concurrent sequences per decode step; the compute pool threads are
+     * shared with ASR and sized by thermal management, so they are left alone
+     */
+    override fun onThermalStateChanged(state: ThermalManager.ThermalState) {
+        val batchSize = when (state) {
+            ThermalManager.ThermalState.NORMAL -> 4
+            ThermalManager.ThermalState.WARM -> 3
+            ThermalManager.ThermalState.HOT -> 2
+            ThermalManager.ThermalState.CRITICAL -> 1
+        }
+        if (isInitialized && !updateRuntimeParameters(batchSize = batchSize)) {
+            Log.w(TAG, "Failed to update LLM runtime parameters for thermal state $state")
+        }
+    }
+
+    /**
+     * Current native scheduler load, or null if the model is not loaded
+     */
+    fun getSchedulerStats(): PerformanceManager.LlmSchedulerStats? {
+        if (!isInitialized) {
+            return null
+        }
+        val values = nativeGetSchedulerStats(nativeHandle) ?: return null
+        val admitted = values[3]
+        return PerformanceManager.LlmSchedulerStats(
+            queueDepth = values[0].toInt(),
+            activeSequences = values[1].toInt(),
+            completedRequests = values[2],
+            averageQueueWaitMs = if (admitted > 0) values[4] / admitted / 1000 else 0,
+            maxQueueWaitMs = values[5] / 1000,
+            generatedTokens = values[6],
+            decodeSteps = values[7],
+            draftedTokens = values[8],
+            acceptedDraftTokens = values[9]
+        )
+    }
+
+    /**
+     * Where the model's layers ran since load, or null if the model is not loaded
+     */
+    fun getOffloadStats(): OffloadStats? {
+        if (!isInitialized) {
+            return null
+        }
+        return OffloadStats.fromNative(nativeGetOffloadStats(nativeHandle))
+    }
+
+    /**
+     * Give memory back under pressure while staying loaded where possible:
+     * evicted prompt prefixes are re-evaluated and dropped weight pages fault
+     * back in, both far cheaper than a reload. [MemoryPressure.CRITICAL]
+     * releases the model; [initialize] loads it again.
+     */
+    override fun trimMemory(pressure: MemoryPressure): Long {
+        if (!isInitialized) {
+            return 0
+        }
+        val reclaimed = nativeTrimMemory(nativeHandle, pressure.nativeValue)
+        if (pressure == MemoryPressure.CRITICAL) {
+            // The native side released the context along with its memory
+            isInitialized = false
+            nativeHandle = 0
+        }
+        Log.i(TAG, "Trimmed LLM at $pressure pressure: ${reclaimed / 1024} KB reclaimed")
+        return reclaimed
+    }
+
     /**
      * Clean up resources
      */
     fun cleanup() {
+        thermalManagementSystem?.removeThermalStateListener(this)
         if (isInitialized) {
             cleanupNative(nativeHandle)
             isInitialized = false
@@ -220,6 +504,42 @@ data class Medication(
 
     private external fun cleanupNative(handle: Long)
 
+    private external fun nativeSetPrefixCachePath(handle: Long, path: String?): Boolean
+
+    private external fun nativeDescribeVariants(paths: Array<String>, contextLength: Int): DoubleArray?
+
+    private external fun nativeSwapModel(handle: Long, modelPath: String): Boolean
+
+    private external fun nativeUpdateParameters(handle: Long, threadCount: Int, contextLength: Int, batchSize: Int): Boolean
+
+    private external fun nativeSetOutputSchema(handle: Long, schemaJson: String?): Boolean
+
+    private external fun nativeLoadDraftModel(handle: Long, draftPath: String?, draftTokens: Int): Boolean
+
+    private external fun nativeBeginIncremental(handle: Long, preamble: String): Boolean
+
+    private external fun nativeAppendIncremental(handle: Long, text: String): Boolean
+
+    private external fun nativeFinishIncremental(handle: Long, instruction: String, priority: Int): Long
+
+    private external fun nativeAbortIncremental(handle: Long)
+
+    private external fun nativeStartGeneration(handle: Long, prompt: String, priority: Int): Long
+
+    private external fun nativePollTokens(generation: Long, timeoutMs: Int): String?
+
+    private external fun nativeCancelGeneration(generation: Long)
+
+    private external fun nativeReleaseGeneration(generation: Long): Boolean
+
+    private external fun nativeGetSchedulerStats(handle: Long): LongArray?
+
+    private external fun nativeSetOffload(handle: Long, backend: Int, layers: Int): Boolean
+
+    private external fun nativeGetOffloadStats(handle: Long): LongArray?
+
+    private external fun nativeTrimMemory(handle: Long, level: Int): Long
+
     private fun JSONArray.toStringList(): List<String> {
         return List(length()) { getString(it) }
     }
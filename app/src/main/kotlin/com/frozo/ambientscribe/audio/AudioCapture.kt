@@ -5,6 +5,7 @@ import android.media.AudioFormat
 import android.media.AudioRecord
 import android.media.MediaRecorder
 import android.os.Process
+import android.os.Trace
 import android.util.Log
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.Flow
@@ -110,6 +111,8 @@ class AudioCapture(private val context: Context) {
             while (isRecording) {
                 val bytesRead = record.read(buffer, 0, buffer.size)
                 if (bytesRead > 0) {
+                    // Marks each captured buffer on the same system trace as native inference
+                    Trace.beginSection("audio.capture")
                     // Update ring buffer
                     updateRingBuffer(buffer, bytesRead)
                     // Emit buffer
@@ -120,6 +123,7 @@ class AudioCapture(private val context: Context) {
                     }
                     val energyLevel = calculateEnergyLevel(shortBuffer)
                     val isVoiceActive = energyLevel > 0.1f // Simple threshold-based VAD
+                    Trace.endSection()
                     emit(AudioData(
                         samples = shortBuffer,
                         energyLevel = energyLevel,
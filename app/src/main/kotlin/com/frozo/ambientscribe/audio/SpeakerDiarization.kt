@@ -12,10 +12,13 @@ import java.util.concurrent.atomic.AtomicReference
 import kotlin.math.abs
 import kotlin.math.max
 import kotlin.math.min
+import kotlin.math.pow
 
 /**
  * Energy-based speaker diarization system for distinguishing between speakers
- * in a conversation (e.g., doctor and patient).
+ * in a conversation (e.g., doctor and patient). When the native VAD supplies
+ * per-frame pitch, speaker profiles also track it, since pitch separates two
+ * voices far better than loudness does.
  */
 class SpeakerDiarization(
     private val context: Context? = null,
@@ -39,6 +42,16 @@ class SpeakerDiarization(
         
         // Energy window size for analysis
         private const val ENERGY_WINDOW_SIZE = 20
+
+        // Share of profile similarity taken from pitch when both sides have it
+        private const val PITCH_WEIGHT = 0.6f
+
+        // Pitch ratios are raised to this power; a 10% pitch difference is
+        // already a different voice, unlike a 10% energy difference
+        private const val PITCH_SHARPNESS = 4f
+
+        // A voiced utterance this unlike the only known speaker starts the second one
+        private const val NEW_SPEAKER_SIMILARITY = 0.6f
     }
 
     // Speaker state tracking
@@ -57,6 +70,10 @@ class SpeakerDiarization(
     private val energyWindow = mutableListOf<Float>()
     private var baselineEnergy = 0f
     private var peakEnergy = 0f
+
+    // Pitch of the voiced frames in the current utterance
+    private var utterancePitchSum = 0f
+    private var utterancePitchFrames = 0
     
     // Results channel
     private val diarizationResultChannel = Channel<DiarizationResult>(Channel.UNLIMITED)
@@ -68,12 +85,14 @@ class SpeakerDiarization(
         val meanEnergy: Float = 0f,
         val peakEnergy: Float = 0f,
         val minEnergy: Float = 0f,
-        val energySamples: Int = 0
+        val energySamples: Int = 0,
+        val meanPitchHz: Float = 0f,
+        val pitchSamples: Int = 0
     ) {
         /**
-         * Update profile with new energy sample
+         * Update profile with new energy sample and, when voiced, its pitch
          */
-        fun update(energy: Float): SpeakerEnergyProfile {
+        fun update(energy: Float, pitchHz: Float = 0f): SpeakerEnergyProfile {
             val newSamples = energySamples + 1
             val newMean = if (energySamples == 0) {
                 energy
@@ -84,23 +103,38 @@ class SpeakerDiarization(
             val newPeak = max(peakEnergy, energy)
             val newMin = if (energySamples == 0) energy else min(minEnergy, energy)
             
+            val newPitchSamples = if (pitchHz > 0f) pitchSamples + 1 else pitchSamples
+            val newPitch = if (pitchHz > 0f) {
+                (meanPitchHz * pitchSamples + pitchHz) / newPitchSamples
+            } else {
+                meanPitchHz
+            }
+            
             return SpeakerEnergyProfile(
                 meanEnergy = newMean,
                 peakEnergy = newPeak,
                 minEnergy = newMin,
-                energySamples = newSamples
+                energySamples = newSamples,
+                meanPitchHz = newPitch,
+                pitchSamples = newPitchSamples
             )
         }
         
         /**
-         * Calculate similarity with another energy sample
+         * Calculate similarity with another energy sample, blending in pitch
+         * when both the sample and the profile have it
          */
-        fun similarity(energy: Float): Float {
+        fun similarity(energy: Float, pitchHz: Float = 0f): Float {
             if (energySamples == 0) return 0f
             
             // Simple energy ratio similarity
             val ratio = energy / meanEnergy
-            return if (ratio > 1f) 1f / ratio else ratio
+            val energySimilarity = if (ratio > 1f) 1f / ratio else ratio
+            if (pitchHz <= 0f || pitchSamples == 0) return energySimilarity
+            
+            val pitchRatio = pitchHz / meanPitchHz
+            val pitchSimilarity = (if (pitchRatio > 1f) 1f / pitchRatio else pitchRatio).pow(PITCH_SHARPNESS)
+            return energySimilarity * (1f - PITCH_WEIGHT) + pitchSimilarity * PITCH_WEIGHT
         }
     }
     
@@ -117,12 +151,14 @@ class SpeakerDiarization(
     )
     
     /**
-     * Audio data class for diarization
+     * Audio data class for diarization. [pitchHz] is the mean pitch of the
+     * voiced frames in this buffer from the native VAD, or 0 when unknown.
      */
     data class AudioData(
         val timestamp: Long,
         val energyLevel: Float,
-        val isVoiceActive: Boolean
+        val isVoiceActive: Boolean,
+        val pitchHz: Float = 0f
     )
 
     /**
@@ -145,14 +181,21 @@ class SpeakerDiarization(
                 
                 // Reset peak energy for this utterance
                 peakEnergy = energy
+                utterancePitchSum = 0f
+                utterancePitchFrames = 0
             } else {
                 // Continuing speech
                 peakEnergy = max(peakEnergy, energy)
             }
             
+            if (audioData.pitchHz > 0f) {
+                utterancePitchSum += audioData.pitchHz
+                utterancePitchFrames++
+            }
+            
             // Identify speaker if we have enough utterance duration
             if (timestamp - currentUtteranceStartTime >= minUtteranceDurationMs) {
-                identifySpeaker(energy, timestamp)
+                identifySpeaker(energy, utterancePitch(), timestamp)
             }
             
         } else {
@@ -163,7 +206,7 @@ class SpeakerDiarization(
                 
                 // Final speaker identification at the end of utterance
                 if (timestamp - currentUtteranceStartTime >= minUtteranceDurationMs) {
-                    identifySpeaker(peakEnergy, timestamp)
+                    identifySpeaker(peakEnergy, utterancePitch(), timestamp)
                 }
             }
             
@@ -257,6 +300,8 @@ class SpeakerDiarization(
         energyWindow.clear()
         baselineEnergy = 0f
         peakEnergy = 0f
+        utterancePitchSum = 0f
+        utterancePitchFrames = 0
         
         lastSpeakerSwitchTime = 0L
         lastSpeechEndTime = 0L
@@ -342,9 +387,16 @@ class SpeakerDiarization(
     }
     
     /**
-     * Identify speaker based on energy profile
+     * Mean pitch of the current utterance's voiced frames, 0 if none were voiced
+     */
+    private fun utterancePitch(): Float {
+        return if (utterancePitchFrames > 0) utterancePitchSum / utterancePitchFrames else 0f
+    }
+    
+    /**
+     * Identify speaker based on energy and pitch profiles
      */
-    private fun identifySpeaker(energy: Float, timestamp: Long) {
+    private fun identifySpeaker(energy: Float, pitchHz: Float, timestamp: Long) {
         // Don't change speaker if manual assignment is active or too soon after last switch
         // Also don't change if in single-speaker fallback mode
         if (manualRoleAssignment.get() || 
@@ -360,7 +412,7 @@ class SpeakerDiarization(
             patientEnergyProfile.get().energySamples == 0) {
             
             // First speaker is assumed to be the doctor
-            val newProfile = SpeakerEnergyProfile().update(energy)
+            val newProfile = SpeakerEnergyProfile().update(energy, pitchHz)
             doctorEnergyProfile.set(newProfile)
             currentSpeaker.set(SPEAKER_DOCTOR)
             
@@ -372,8 +424,12 @@ class SpeakerDiarization(
         val doctorProfile = doctorEnergyProfile.get()
         val patientProfile = patientEnergyProfile.get()
         
-        val doctorSimilarity = doctorProfile.similarity(energy)
-        val patientSimilarity = patientProfile.similarity(energy)
+        val doctorSimilarity = doctorProfile.similarity(energy, pitchHz)
+        val patientSimilarity = patientProfile.similarity(energy, pitchHz)
+        
+        // A clearly different voice while only the doctor is known is the patient
+        val isUnseenVoice = pitchHz > 0f && doctorProfile.pitchSamples > 0 &&
+                patientProfile.energySamples == 0 && doctorSimilarity < NEW_SPEAKER_SIMILARITY
         
         // Determine if this is a new speaker
         val energyRatio = if (baselineEnergy > 0) energy / baselineEnergy else 1f
@@ -381,6 +437,8 @@ class SpeakerDiarization(
                                  energyRatio < 1f / energyThresholdRatio
         
         val speakerId = when {
+            isUnseenVoice -> SPEAKER_PATIENT
+            
             // Clear doctor match
             doctorSimilarity > patientSimilarity * 1.2f -> SPEAKER_DOCTOR
             
@@ -399,10 +457,10 @@ class SpeakerDiarization(
         // Update speaker profile
         if (speakerId != SPEAKER_UNKNOWN) {
             if (speakerId == SPEAKER_DOCTOR) {
-                val newProfile = doctorProfile.update(energy)
+                val newProfile = doctorProfile.update(energy, pitchHz)
                 doctorEnergyProfile.set(newProfile)
             } else {
-                val newProfile = patientProfile.update(energy)
+                val newProfile = patientProfile.update(energy, pitchHz)
                 patientEnergyProfile.set(newProfile)
             }
         }
@@ -9,6 +9,8 @@ import java.io.File
  */
 class DeviceCapabilityDetector(private val context: Context) {
     
+    private val kernelDispatch: KernelDispatch? by lazy { NativeCpuFeatures.dispatch() }
+
     enum class DeviceTier {
         TIER_A,  // High-end devices (8GB+ RAM, flagship SoCs)
         TIER_B,  // Mid-range devices (4-8GB RAM, mid-range SoCs)  
@@ -77,18 +79,34 @@ class DeviceCapabilityDetector(private val context: Context) {
         return getAvailableMemoryMB() / 1024.0f
     }
     
+    /**
+     * What the native runtime detected and which kernel variants it chose,
+     * or null if it isn't loaded; the has*Support checks fall back to the ABI
+     */
+    fun getKernelDispatch(): KernelDispatch? = kernelDispatch
+
+    /**
+     * Natively detected instruction sets, or null if the runtime isn't loaded
+     */
+    fun getInstructionSets(): Map<String, Boolean>? = kernelDispatch?.instructionSets
+
     fun hasNeonSupport(): Boolean {
+        kernelDispatch?.let { return it.has(KernelDispatch.NEON) }
         return Build.CPU_ABI.contains("arm64") || Build.CPU_ABI.contains("armeabi")
     }
     
     fun hasFp16Support(): Boolean {
+        kernelDispatch?.let { return it.has(KernelDispatch.FP16) }
         return Build.CPU_ABI.contains("arm64")
     }
     
     fun hasSdotSupport(): Boolean {
+        kernelDispatch?.let { return it.has(KernelDispatch.DOTPROD) }
         return Build.CPU_ABI.contains("arm64")
     }
 
+    fun hasI8mmSupport(): Boolean = kernelDispatch?.has(KernelDispatch.I8MM) ?: false
+
     /**
      * Initialize device capability detection
      */
@@ -107,7 +125,10 @@ class DeviceCapabilityDetector(private val context: Context) {
             "cpu_freq_mhz" to getMaxFrequencyMHz(),
             "has_neon" to hasNeonSupport(),
             "has_fp16" to hasFp16Support(),
-            "has_sdot" to hasSdotSupport()
+            "has_sdot" to hasSdotSupport(),
+            "has_i8mm" to hasI8mmSupport(),
+            "resample_kernel" to (kernelDispatch?.resampleVariant ?: "unknown"),
+            "matmul_kernel" to (kernelDispatch?.matmulVariant ?: "unknown")
         )
     }
 }
\ No newline at end of file
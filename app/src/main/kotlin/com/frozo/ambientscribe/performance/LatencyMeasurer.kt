@@ -4,6 +4,7 @@ import android.content.Context
 import android.util.Log
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
+import org.json.JSONArray
 import org.json.JSONObject
 import java.io.File
 import java.util.concurrent.atomic.AtomicLong
@@ -74,7 +75,8 @@ class LatencyMeasurer(
         val targetP95Ms: Long,
         val p50Passed: Boolean,
         val p95Passed: Boolean,
-        val timestamp: Long = System.currentTimeMillis()
+        val timestamp: Long = System.currentTimeMillis(),
+        val nativeStages: List<NativeStageLatency> = emptyList()
     )
 
     /**
@@ -107,6 +109,8 @@ class LatencyMeasurer(
                 MeasurementType.FIRST_TOKEN -> firstTokenMeasurements.clear()
                 MeasurementType.DRAFT_READY -> draftReadyMeasurements.clear()
             }
+            // Native stage histograms cover the same window
+            NativeMetrics.reset()
             
             Log.d(TAG, "Latency measurement started: $type")
             Result.success(Unit)
@@ -139,6 +143,7 @@ class LatencyMeasurer(
                 ?: return@withContext Result.failure(IllegalStateException("No device capabilities found"))
             
             val statistics = calculateLatencyStatistics(measurements, type, capabilities.tier)
+                .copy(nativeStages = NativeMetrics.snapshot())
             
             // Save measurement results
             saveMeasurementResults(statistics)
@@ -484,6 +489,19 @@ class LatencyMeasurer(
                 put("p50Passed", statistics.p50Passed)
                 put("p95Passed", statistics.p95Passed)
                 put("timestamp", statistics.timestamp)
+                put("nativeStages", JSONArray().apply {
+                    statistics.nativeStages.forEach { stage ->
+                        put(JSONObject().apply {
+                            put("stage", stage.stage)
+                            put("count", stage.count)
+                            put("averageUs", stage.averageUs)
+                            put("p50Us", stage.p50Us)
+                            put("p90Us", stage.p90Us)
+                            put("p99Us", stage.p99Us)
+                            put("maxUs", stage.maxUs)
+                        })
+                    }
+                })
             }
             
             resultsFile.writeText(json.toString())
@@ -7,6 +7,7 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import org.json.JSONObject
 import java.io.File
+import java.util.concurrent.CopyOnWriteArrayList
 import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicLong
 
@@ -14,6 +15,10 @@ import java.util.concurrent.atomic.AtomicLong
  * Memory Manager - ST-6.6
  * Implements memory management with LLM unloading when idle
  * Provides intelligent memory management and optimization
+ *
+ * Native models register as [NativeMemoryTrimmer]s and are trimmed by
+ * degrees, from cached state up to releasing the LLM, so memory pressure
+ * rarely costs a full model reload.
  */
 class MemoryManager(
     private val context: Context,
@@ -32,6 +37,7 @@ class MemoryManager(
     private val isMonitoring = AtomicBoolean(false)
     private val lastActivityTime = AtomicLong(System.currentTimeMillis())
     private val isLLMLoaded = AtomicBoolean(false)
+    private val trimmers = CopyOnWriteArrayList<NativeMemoryTrimmer>()
 
     /**
      * Memory usage data class
@@ -53,7 +59,8 @@ class MemoryManager(
         val action: MemoryAction,
         val memoryUsage: MemoryUsage,
         val recommendations: List<String>,
-        val timestamp: Long
+        val timestamp: Long,
+        val reclaimedBytes: Long = 0
     )
 
     /**
@@ -63,11 +70,32 @@ class MemoryManager(
         NONE,
         UNLOAD_LLM,
         REDUCE_CACHE,
+        DROP_MODEL_PAGES,
         CLEAR_TEMP_FILES,
         FORCE_GC,
         EMERGENCY_CLEANUP
     }
 
+    /**
+     * Trim [trimmer] along with the other native models under memory pressure
+     */
+    fun registerTrimmer(trimmer: NativeMemoryTrimmer) {
+        trimmers.addIfAbsent(trimmer)
+    }
+
+    fun unregisterTrimmer(trimmer: NativeMemoryTrimmer) {
+        trimmers.remove(trimmer)
+    }
+
+    /**
+     * Forward an onTrimMemory level to the native models; returns the bytes reclaimed
+     */
+    suspend fun onTrimMemory(level: Int): Long = withContext(Dispatchers.IO) {
+        val pressure = MemoryPressure.fromTrimLevel(level) ?: return@withContext 0L
+        Log.d(TAG, "Trim memory level $level: trimming native models at $pressure pressure")
+        trimNative(pressure)
+    }
+
     /**
      * Start memory monitoring
      */
@@ -257,14 +285,15 @@ class MemoryManager(
             val recommendations = generateMemoryRecommendations(memoryUsage, action)
             
             // Apply memory action
-            applyMemoryAction(action)
+            val reclaimedBytes = applyMemoryAction(action)
 
             val result = MemoryManagementResult(
                 success = true,
                 action = action,
                 memoryUsage = memoryUsage,
                 recommendations = recommendations,
-                timestamp = System.currentTimeMillis()
+                timestamp = System.currentTimeMillis(),
+                reclaimedBytes = reclaimedBytes
             )
 
             // Save memory management result
@@ -310,7 +339,7 @@ class MemoryManager(
     private fun determineMemoryAction(memoryUsage: MemoryUsage, threshold: Float): MemoryAction {
         return when {
             memoryUsage.isLowMemory -> MemoryAction.EMERGENCY_CLEANUP
-            memoryUsage.memoryPressure > 0.9f -> MemoryAction.UNLOAD_LLM
+            memoryUsage.memoryPressure > 0.9f -> MemoryAction.DROP_MODEL_PAGES
             memoryUsage.memoryPressure > threshold -> MemoryAction.REDUCE_CACHE
             memoryUsage.memoryPressure > 0.6f -> MemoryAction.CLEAR_TEMP_FILES
             else -> MemoryAction.NONE
@@ -318,27 +347,34 @@ class MemoryManager(
     }
 
     /**
-     * Apply memory action
+     * Apply memory action; returns the native bytes reclaimed
      */
-    private suspend fun applyMemoryAction(action: MemoryAction) {
-        when (action) {
+    private suspend fun applyMemoryAction(action: MemoryAction): Long {
+        return when (action) {
             MemoryAction.UNLOAD_LLM -> {
                 unloadLLM()
+                0
             }
             MemoryAction.REDUCE_CACHE -> {
                 reduceCacheSize()
             }
+            MemoryAction.DROP_MODEL_PAGES -> {
+                trimNative(MemoryPressure.HIGH)
+            }
             MemoryAction.CLEAR_TEMP_FILES -> {
                 clearTempFiles()
+                0
             }
             MemoryAction.FORCE_GC -> {
                 System.gc()
+                0
             }
             MemoryAction.EMERGENCY_CLEANUP -> {
                 emergencyCleanup()
             }
             MemoryAction.NONE -> {
                 // No action needed
+                0
             }
         }
     }
@@ -358,6 +394,10 @@ class MemoryManager(
                 recommendations.add("Cache size has been reduced to free memory")
                 recommendations.add("Consider closing other apps to free more memory")
             }
+            MemoryAction.DROP_MODEL_PAGES -> {
+                recommendations.add("Model pages have been released; models stay loaded and may run slower")
+                recommendations.add("Consider closing other apps to free more memory")
+            }
             MemoryAction.CLEAR_TEMP_FILES -> {
                 recommendations.add("Temporary files have been cleared")
                 recommendations.add("Consider restarting the app if memory issues persist")
@@ -394,9 +434,33 @@ class MemoryManager(
     /**
      * Reduce cache size
      */
-    private suspend fun reduceCacheSize() {
+    private suspend fun reduceCacheSize(): Long {
         Log.d(TAG, "Reducing cache size")
-        // In real implementation, this would reduce cache sizes
+        return trimNative(MemoryPressure.MODERATE)
+    }
+
+    /**
+     * Trim every registered native model; returns the bytes reclaimed. With
+     * no model registered to trim, high pressure unloads the LLM instead.
+     */
+    private suspend fun trimNative(pressure: MemoryPressure): Long {
+        if (trimmers.isEmpty()) {
+            if (pressure >= MemoryPressure.HIGH) {
+                Log.d(TAG, "No native trimmers registered; unloading LLM at $pressure pressure")
+                unloadLLM()
+            }
+            return 0
+        }
+        var reclaimed = 0L
+        for (trimmer in trimmers) {
+            try {
+                reclaimed += trimmer.trimMemory(pressure)
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to trim native model at $pressure pressure", e)
+            }
+        }
+        Log.d(TAG, "Native trim at $pressure pressure reclaimed ${reclaimed / (1024 * 1024)} MB")
+        return reclaimed
     }
 
     /**
@@ -417,20 +481,19 @@ class MemoryManager(
     /**
      * Emergency cleanup
      */
-    private suspend fun emergencyCleanup() {
+    private suspend fun emergencyCleanup(): Long {
         Log.d(TAG, "Performing emergency cleanup")
         
-        // Unload LLM
+        // Drop native caches and model pages, then release the LLM
+        val reclaimed = trimNative(MemoryPressure.CRITICAL)
         unloadLLM()
         
-        // Clear cache
-        reduceCacheSize()
-        
         // Clear temp files
         clearTempFiles()
         
         // Force garbage collection
         System.gc()
+        return reclaimed
     }
 
     /**
@@ -463,6 +526,7 @@ class MemoryManager(
                 put("action", result.action.name)
                 put("timestamp", result.timestamp)
                 put("recommendations", result.recommendations)
+                put("reclaimedBytes", result.reclaimedBytes)
                 
                 // Memory usage
                 put("totalMemoryMB", result.memoryUsage.totalMemoryMB)
@@ -0,0 +1,48 @@
+package com.frozo.ambientscribe.performance
+
+import android.content.ComponentCallbacks2
+
+/**
+ * How hard native code trims. [nativeValue] matches MemoryPressure in
+ * memory_pressure.h; each level also does everything the ones below do.
+ *
+ * - [MODERATE] drops cached state that is cheap to rebuild (prefix KV cache
+ *   entries, spare arena capacity)
+ * - [HIGH] also drops resident model pages and the speculative draft model;
+ *   the model stays loaded and faults its weights back in from the file
+ * - [CRITICAL] also releases the LLM, which is reloaded on next use
+ */
+enum class MemoryPressure(val nativeValue: Int) {
+    MODERATE(1),
+    HIGH(2),
+    CRITICAL(3);
+
+    companion object {
+        /**
+         * Pressure for an onTrimMemory level, or null for levels that call for
+         * no native trimming (UI hidden). Foreground and cached levels of the
+         * same severity trim alike.
+         */
+        @Suppress("DEPRECATION")
+        fun fromTrimLevel(level: Int): MemoryPressure? = when {
+            level >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE -> CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_MODERATE -> HIGH
+            level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND -> MODERATE
+            level == ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN -> null
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> HIGH
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE -> MODERATE
+            else -> null
+        }
+    }
+}
+
+/**
+ * A native model that can give memory back without being unloaded
+ */
+interface NativeMemoryTrimmer {
+    /**
+     * Free what the model can spare at [pressure]; returns the bytes reclaimed
+     */
+    fun trimMemory(pressure: MemoryPressure): Long
+}
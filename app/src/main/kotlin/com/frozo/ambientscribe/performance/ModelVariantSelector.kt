@@ -0,0 +1,63 @@
+package com.frozo.ambientscribe.performance
+
+/**
+ * Chooses which quantized variant of a model to load. Prefers the most
+ * precise variant that fits the memory budget and still decodes fast
+ * enough; if none is fast enough, the fastest that fits; if none fits,
+ * the smallest, so a low-tier device degrades instead of running out of memory.
+ */
+class ModelVariantSelector {
+
+    companion object {
+        /** Values per path returned by the native nativeDescribeVariants calls */
+        private const val NATIVE_VALUES_PER_VARIANT = 4
+
+        /**
+         * Pair native variant descriptions with the paths they were requested for.
+         * Variants that are not on disk are dropped.
+         */
+        fun fromNative(paths: List<String>, values: DoubleArray?): List<ModelVariant> {
+            if (values == null || values.size != paths.size * NATIVE_VALUES_PER_VARIANT) {
+                return emptyList()
+            }
+            return paths.mapIndexedNotNull { i, path ->
+                val base = i * NATIVE_VALUES_PER_VARIANT
+                ModelVariant(
+                    path = path,
+                    bitsPerWeight = values[base].toFloat(),
+                    weightBytes = values[base + 1].toLong(),
+                    footprintBytes = values[base + 2].toLong(),
+                    expectedTokensPerSecond = values[base + 3].toFloat()
+                ).takeIf { it.weightBytes > 0 }
+            }
+        }
+    }
+
+    /**
+     * One quantized variant of a model, as measured by the native layer
+     */
+    data class ModelVariant(
+        val path: String,
+        val bitsPerWeight: Float,
+        val weightBytes: Long,
+        val footprintBytes: Long,
+        val expectedTokensPerSecond: Float
+    )
+
+    /**
+     * Select a variant for the given memory budget and minimum decode speed
+     */
+    fun select(
+        variants: List<ModelVariant>,
+        memoryBudgetBytes: Long,
+        minTokensPerSecond: Float
+    ): ModelVariant? {
+        val fitting = variants.filter { it.footprintBytes <= memoryBudgetBytes }
+        if (fitting.isEmpty()) {
+            return variants.minByOrNull { it.footprintBytes }
+        }
+        return fitting.filter { it.expectedTokensPerSecond >= minTokensPerSecond }
+            .maxByOrNull { it.bitsPerWeight }
+            ?: fitting.maxByOrNull { it.expectedTokensPerSecond }
+    }
+}
@@ -0,0 +1,63 @@
+package com.frozo.ambientscribe.performance
+
+import android.util.Log
+
+/**
+ * Native compute pool shared by ASR and LLM inference
+ * Workers are pinned to the performance cores; ASR work always runs ahead of
+ * LLM generation and background prefill. Thermal management shrinks the pool
+ * instead of each engine tuning its own thread count.
+ */
+object NativeComputePool {
+
+    private const val TAG = "NativeComputePool"
+
+    private val available: Boolean = try {
+        System.loadLibrary("ambient_runtime")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        Log.e(TAG, "Failed to load native runtime library", e)
+        false
+    }
+
+    /**
+     * Resize the pool; 0 restores one thread per performance core
+     * Returns the thread count applied, or 0 if the native runtime is unavailable
+     */
+    fun setThreadCount(threads: Int): Int {
+        if (!available) return 0
+        val applied = nativeSetThreadCount(threads.coerceAtLeast(0))
+        Log.d(TAG, "Compute pool threads: requested $threads, applied $applied")
+        return applied
+    }
+
+    /**
+     * Threads currently taking work
+     */
+    fun getThreadCount(): Int = if (available) nativeGetThreadCount() else 0
+
+    /**
+     * Performance cores the pool is pinned to by default
+     */
+    fun getPerformanceCoreCount(): Int = if (available) nativeGetPerformanceCoreCount() else 0
+
+    /**
+     * Accelerator delegates model layers can be offloaded to on this device
+     */
+    fun getOffloadBackends(): Set<OffloadBackend> =
+        if (available) OffloadBackend.fromMask(nativeGetOffloadBackends()) else emptySet()
+
+    /**
+     * While suspended every model runs all of its layers on the pool; the
+     * GPU and NPU share the SoC's thermal budget with the CPU
+     */
+    fun setOffloadSuspended(suspended: Boolean) {
+        if (available) nativeSetOffloadSuspended(suspended)
+    }
+
+    private external fun nativeSetThreadCount(threads: Int): Int
+    private external fun nativeGetThreadCount(): Int
+    private external fun nativeGetPerformanceCoreCount(): Int
+    private external fun nativeGetOffloadBackends(): Int
+    private external fun nativeSetOffloadSuspended(suspended: Boolean)
+}
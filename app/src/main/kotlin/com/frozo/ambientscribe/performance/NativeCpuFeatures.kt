@@ -0,0 +1,73 @@
+package com.frozo.ambientscribe.performance
+
+import timber.log.Timber
+
+/**
+ * CPU extensions the native runtime detected (getauxval on arm, cpuid on
+ * x86) and the kernel variants it dispatches to. Both are fixed for the
+ * life of the process.
+ */
+object NativeCpuFeatures {
+
+    private val available: Boolean = try {
+        System.loadLibrary("ambient_runtime")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        Timber.e(e, "Failed to load native runtime library")
+        false
+    }
+
+    /**
+     * Detected features and chosen kernels, or null if the native runtime is unavailable
+     */
+    fun dispatch(): KernelDispatch? =
+        if (available) KernelDispatch.fromNative(nativeGetCpuFeatures(), nativeGetKernelVariants()) else null
+
+    private external fun nativeGetCpuFeatures(): Int
+    private external fun nativeGetKernelVariants(): Array<String>?
+}
+
+/**
+ * [features] holds the CPU_FEATURE_* bits from cpu_features.h; the variant
+ * names are "neon", "sse2" or "scalar" for the ABI baseline, else the
+ * extension the variant was built for ("dotprod", "i8mm", "avx2").
+ */
+data class KernelDispatch(
+    val features: Int,
+    val resampleVariant: String,
+    val matmulVariant: String
+) {
+    fun has(feature: Int): Boolean = (features and feature) == feature
+
+    /** Keyed like [PerformanceManager.PerformanceState.instructionSets] */
+    val instructionSets: Map<String, Boolean>
+        get() = mapOf(
+            "NEON" to has(NEON),
+            "FP16" to has(FP16),
+            "SDOT" to has(DOTPROD),
+            "I8MM" to has(I8MM),
+            "SVE" to has(SVE),
+            "AVX2" to has(AVX2)
+        )
+
+    companion object {
+        const val NEON = 1 shl 0
+        const val DOTPROD = 1 shl 1
+        const val I8MM = 1 shl 2
+        const val FP16 = 1 shl 3
+        const val SVE = 1 shl 4
+        const val SSE2 = 1 shl 5
+        const val AVX2 = 1 shl 6
+        const val FMA = 1 shl 7
+
+        private const val VARIANT_COUNT = 2
+
+        /**
+         * Parse the native report: feature bits and [resample, matmul] variants
+         */
+        fun fromNative(features: Int, variants: Array<String>?): KernelDispatch? {
+            if (variants == null || variants.size < VARIANT_COUNT) return null
+            return KernelDispatch(features, variants[0], variants[1])
+        }
+    }
+}
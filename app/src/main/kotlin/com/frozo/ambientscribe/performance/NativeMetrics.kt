@@ -0,0 +1,37 @@
+package com.frozo.ambientscribe.performance
+
+import android.util.Log
+
+/**
+ * Native hot-path timing shared by ASR and LLM inference
+ * Each native thread records into its own histograms without locking; one
+ * JNI call merges them into per-stage latency summaries.
+ */
+object NativeMetrics {
+
+    private const val TAG = "NativeMetrics"
+
+    private val available: Boolean = try {
+        System.loadLibrary("ambient_runtime")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        Log.e(TAG, "Failed to load native runtime library", e)
+        false
+    }
+
+    /**
+     * Latency of every native stage that has samples since the last reset
+     */
+    fun snapshot(): List<NativeStageLatency> =
+        if (available) NativeStageLatency.fromNative(nativeSnapshot()) else emptyList()
+
+    /**
+     * Start every stage histogram afresh
+     */
+    fun reset() {
+        if (available) nativeReset()
+    }
+
+    private external fun nativeSnapshot(): LongArray?
+    private external fun nativeReset()
+}
@@ -0,0 +1,72 @@
+package com.frozo.ambientscribe.performance
+
+/**
+ * Where native model layers run. [nativeValue] matches BackendKind in
+ * compute_backend.h; [AUTO] lets the native side pick the device's best
+ * delegate for the model (an NPU for the Whisper encoder, the GPU for LLM
+ * decode) and stays on the CPU when there is none.
+ */
+enum class OffloadBackend(val nativeValue: Int) {
+    AUTO(-1),
+    CPU(0),
+    VULKAN(1),
+    NNAPI(2),
+    QNN(3);
+
+    companion object {
+        fun fromNative(value: Int): OffloadBackend? = values().firstOrNull { it.nativeValue == value }
+
+        /** Delegates set in a native availability mask (bit 1 shl kind) */
+        fun fromMask(mask: Int): Set<OffloadBackend> =
+            values().filter { it != AUTO && it != CPU && (mask and (1 shl it.nativeValue)) != 0 }.toSet()
+    }
+}
+
+/**
+ * How many of a model's leading [layers] run on [backend]; the rest stay on
+ * the native compute pool. Native code falls back to the CPU on its own when
+ * a delegate fails, and while thermal management has offload suspended.
+ */
+data class OffloadSettings(
+    val backend: OffloadBackend = OffloadBackend.AUTO,
+    val layers: Int
+) {
+    companion object {
+        /**
+         * Flagships offload every layer. Mid-range GPUs and NPUs keep up with
+         * about half, and entry-level parts are no faster than their CPU while
+         * sharing its memory bandwidth, so they stay on the pool.
+         */
+        fun forTier(tier: DeviceCapabilityDetector.DeviceTier, totalLayers: Int): OffloadSettings = when (tier) {
+            DeviceCapabilityDetector.DeviceTier.TIER_A -> OffloadSettings(layers = totalLayers)
+            DeviceCapabilityDetector.DeviceTier.TIER_B -> OffloadSettings(layers = totalLayers / 2)
+            DeviceCapabilityDetector.DeviceTier.TIER_C -> OffloadSettings(OffloadBackend.CPU, 0)
+        }
+    }
+}
+
+/**
+ * Native offload counters for one model. [backend] is CPU once a delegate
+ * has failed; [cpuPasses] includes passes run while offload was suspended.
+ */
+data class OffloadStats(
+    val backend: OffloadBackend,
+    val layers: Int,
+    val offloadedPasses: Long,
+    val cpuPasses: Long,
+    val failures: Long
+) {
+    companion object {
+        private const val VALUE_COUNT = 5
+
+        /**
+         * Parse the native counters: [backend, layers, offloaded passes, CPU
+         * passes, delegate failures]
+         */
+        fun fromNative(values: LongArray?): OffloadStats? {
+            if (values == null || values.size < VALUE_COUNT) return null
+            val backend = OffloadBackend.fromNative(values[0].toInt()) ?: return null
+            return OffloadStats(backend, values[1].toInt(), values[2], values[3], values[4])
+        }
+    }
+}
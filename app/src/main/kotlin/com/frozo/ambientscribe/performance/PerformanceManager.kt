@@ -1,5 +1,6 @@
 package com.frozo.ambientscribe.performance
 
+import android.app.ActivityManager
 import android.content.Context
 import com.frozo.ambientscribe.performance.DeviceCapabilityDetector
 import kotlinx.coroutines.CoroutineScope
@@ -33,6 +34,8 @@ class PerformanceManager(
     private val currentThreadCount = AtomicInteger(4)
     private val currentContextSize = AtomicInteger(3000)
     
+    private val modelVariantSelector = ModelVariantSelector()
+    
     /**
      * Performance state information
      */
@@ -48,9 +51,37 @@ class PerformanceManager(
             "FP16" to false,
             "SDOT" to false
         ),
+        val llmQueueDepth: Int = 0,
+        val llmActiveSequences: Int = 0,
+        val llmAverageQueueWaitMs: Long = 0,
+        val llmTokensPerDecodeStep: Float = 0f,
+        val llmDraftAcceptanceRate: Float = 0f,
         val timestamp: Long = System.currentTimeMillis()
     )
     
+    /**
+     * Snapshot of the native LLM request scheduler
+     */
+    data class LlmSchedulerStats(
+        val queueDepth: Int,
+        val activeSequences: Int,
+        val completedRequests: Long,
+        val averageQueueWaitMs: Long,
+        val maxQueueWaitMs: Long,
+        val generatedTokens: Long = 0,
+        val decodeSteps: Long = 0,
+        val draftedTokens: Long = 0,
+        val acceptedDraftTokens: Long = 0
+    ) {
+        /** Tokens emitted per batched decode step; above 1 only when decoding speculatively */
+        val tokensPerDecodeStep: Float
+            get() = if (decodeSteps > 0) generatedTokens.toFloat() / decodeSteps else 0f
+
+        /** Share of draft-model tokens the main model accepted */
+        val draftAcceptanceRate: Float
+            get() = if (draftedTokens > 0) acceptedDraftTokens.toFloat() / draftedTokens else 0f
+    }
+    
     /**
      * Interface for components that need performance updates
      */
@@ -71,12 +102,12 @@ class PerformanceManager(
         // Detect device tier
         val deviceTier = deviceCapabilityDetector.getDeviceTier()
         
-        // Detect instruction sets (mock implementation)
-        val instructionSets = mapOf(
-            "NEON" to true,
-            "FP16" to false,
-            "SDOT" to false
-        )
+        // Instruction sets the native runtime detected, else the assumed defaults
+        val instructionSets = deviceCapabilityDetector.getInstructionSets()
+            ?: PerformanceState().instructionSets
+        deviceCapabilityDetector.getKernelDispatch()?.let {
+            Timber.i("Native kernels: resample ${it.resampleVariant}, matmul ${it.matmulVariant}")
+        }
         
         // Set initial thread count based on device capabilities
         val initialThreads = when (deviceTier) {
@@ -135,6 +166,63 @@ class PerformanceManager(
         return performanceState.value
     }
     
+    /**
+     * Record LLM scheduler load so queueing shows up next to thermal and threading state
+     */
+    fun reportLlmSchedulerStats(stats: LlmSchedulerStats) {
+        _performanceState.value = _performanceState.value.copy(
+            llmQueueDepth = stats.queueDepth,
+            llmActiveSequences = stats.activeSequences,
+            llmAverageQueueWaitMs = stats.averageQueueWaitMs,
+            llmTokensPerDecodeStep = stats.tokensPerDecodeStep,
+            llmDraftAcceptanceRate = stats.draftAcceptanceRate,
+            timestamp = System.currentTimeMillis()
+        )
+        
+        if (stats.queueDepth > 0) {
+            Timber.d("LLM scheduler: ${stats.queueDepth} queued, ${stats.activeSequences} active, " +
+                    "avg wait ${stats.averageQueueWaitMs}ms, max wait ${stats.maxQueueWaitMs}ms")
+        }
+    }
+    
+    /**
+     * Choose which quantized model variant to load. Each model may use a
+     * tier-dependent share of the memory available right now, halved at HOT
+     * or worse so a smaller, cooler-running variant is picked. thermalLevel
+     * defaults to the last state this manager saw.
+     */
+    fun selectModelVariant(
+        variants: List<ModelVariantSelector.ModelVariant>,
+        minTokensPerSecond: Float,
+        thermalLevel: Int? = null
+    ): ModelVariantSelector.ModelVariant? {
+        val level = thermalLevel ?: performanceState.value.thermalState
+        val budgetBytes = modelMemoryBudgetBytes(level)
+        val selected = modelVariantSelector.select(variants, budgetBytes, minTokensPerSecond)
+        
+        Timber.d("Model variant ${selected?.path} selected from ${variants.size} " +
+                "(budget ${budgetBytes / (1024 * 1024)}MB, thermal level $level)")
+        return selected
+    }
+    
+    /**
+     * Memory one model may occupy, or unbounded when it cannot be measured
+     */
+    private fun modelMemoryBudgetBytes(thermalLevel: Int): Long {
+        val activityManager = context.getSystemService(Context.ACTIVITY_SERVICE) as? ActivityManager
+            ?: return Long.MAX_VALUE
+        val memoryInfo = ActivityManager.MemoryInfo()
+        activityManager.getMemoryInfo(memoryInfo)
+        
+        val tierShare = when (performanceState.value.deviceTier) {
+            DeviceCapabilityDetector.DeviceTier.TIER_A -> 0.5
+            DeviceCapabilityDetector.DeviceTier.TIER_B -> 0.4
+            DeviceCapabilityDetector.DeviceTier.TIER_C -> 0.3
+        }
+        val thermalShare = if (thermalLevel >= 2) 0.5 else 1.0
+        return (memoryInfo.availMem * tierShare * thermalShare).toLong()
+    }
+    
     /**
      * Check if device supports specific instruction set
      */
@@ -13,7 +13,8 @@ data class PerformanceMetrics(
     val latency: LatencyMetrics,
     val deviceTier: String,
     val isCharging: Boolean = false,
-    val networkType: String = "unknown"
+    val networkType: String = "unknown",
+    val nativeStages: List<NativeStageLatency> = emptyList()
 )
 
 /**
@@ -39,3 +40,54 @@ data class LatencyMetrics(
     val p95Latency: Long,
     val p99Latency: Long
 )
+
+/**
+ * Native hot-path stage latency, read from the native timing histograms
+ * Percentiles are histogram bucket bounds, within 12.5% of the true value
+ */
+data class NativeStageLatency(
+    val stage: String,
+    val count: Long,
+    val averageUs: Long,
+    val p50Us: Long,
+    val p90Us: Long,
+    val p99Us: Long,
+    val maxUs: Long
+) {
+    companion object {
+        /** Stage names in native MetricStage order */
+        val STAGES = listOf(
+            "jni_marshal",
+            "feature_extraction",
+            "encode",
+            "decode",
+            "draft",
+            "token_sampling",
+            "result_build"
+        )
+        private const val VALUES_PER_STAGE = 6
+
+        /**
+         * Parse the native snapshot, [count, total, max, p50, p90, p99] per stage
+         * Stages with no samples are omitted
+         */
+        fun fromNative(values: LongArray?): List<NativeStageLatency> {
+            if (values == null) return emptyList()
+            return STAGES.indices.mapNotNull { index ->
+                val base = index * VALUES_PER_STAGE
+                if (base + VALUES_PER_STAGE > values.size) return@mapNotNull null
+                val count = values[base]
+                if (count <= 0) return@mapNotNull null
+                NativeStageLatency(
+                    stage = STAGES[index],
+                    count = count,
+                    averageUs = values[base + 1] / count,
+                    p50Us = values[base + 3],
+                    p90Us = values[base + 4],
+                    p99Us = values[base + 5],
+                    maxUs = values[base + 2]
+                )
+            }
+        }
+    }
+}
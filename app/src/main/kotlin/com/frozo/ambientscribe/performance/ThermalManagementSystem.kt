@@ -1,16 +1,21 @@
 package com.frozo.ambientscribe.performance
 
 import android.content.Context
+import android.os.Build
 import android.os.PowerManager
+import android.os.Trace
 import android.util.Log
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.withContext
 import org.json.JSONObject
 import java.io.File
 import java.io.RandomAccessFile
+import java.util.concurrent.CopyOnWriteArrayList
 import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.atomic.AtomicReference
 import kotlin.random.Random
 
 /**
@@ -30,6 +35,7 @@ class ThermalManagementSystem(
         private const val THERMAL_HISTORY_SIZE = 120 // 10 minutes of samples
         private const val THERMAL_THROTTLE_DURATION_MS = 30000L // 30 seconds
         private const val THERMAL_RECOVERY_DURATION_MS = 60000L // 1 minute
+        private const val OFFLOAD_SUSPEND_LEVEL = 3 // SEVERE
     }
 
     private val powerManager = context.getSystemService(Context.POWER_SERVICE) as PowerManager
@@ -38,6 +44,8 @@ class ThermalManagementSystem(
     private val thermalHistory = mutableListOf<ThermalSample>()
     private val lastThrottleTime = AtomicLong(0)
     private val lastRecoveryTime = AtomicLong(0)
+    private val listeners = CopyOnWriteArrayList<ThermalStateListener>()
+    private val reportedState = AtomicReference<ThermalManager.ThermalState?>(null)
 
     /**
      * Thermal sample data class
@@ -114,7 +122,7 @@ class ThermalManagementSystem(
             // Initialize thermal state
             val initialSample = getCurrentThermalSample()
             thermalHistory.add(initialSample)
-            currentThermalState.set(initialSample.thermalState)
+            updateThermalState(initialSample.thermalState)
 
             Log.d(TAG, "Thermal monitoring started")
             Result.success(Unit)
@@ -125,6 +133,21 @@ class ThermalManagementSystem(
         }
     }
 
+    /**
+     * Start monitoring and sample the thermal state every
+     * THERMAL_SAMPLE_INTERVAL_MS until monitoring is stopped or the calling
+     * job is cancelled, so listeners hear about changes as they happen
+     */
+    suspend fun monitorThermalState() {
+        if (startThermalMonitoring().isFailure) {
+            return
+        }
+        while (isMonitoring.get()) {
+            delay(THERMAL_SAMPLE_INTERVAL_MS)
+            getCurrentThermalState()
+        }
+    }
+
     /**
      * Stop thermal monitoring
      */
@@ -159,7 +182,7 @@ class ThermalManagementSystem(
                 thermalHistory.removeAt(0)
             }
 
-            currentThermalState.set(sample.thermalState)
+            updateThermalState(sample.thermalState)
             
             val isThrottling = shouldThrottle(sample)
             val recommendations = generateThermalRecommendations(sample, isThrottling)
@@ -199,8 +222,14 @@ class ThermalManagementSystem(
             val currentState = currentThermalState.get()
             val throttleLevel = determineThrottleLevel(currentState)
             
-            // Apply throttling strategies
-            applyThrottlingStrategies(throttleLevel, capabilities)
+            // Apply throttling strategies; marked so system traces line thermal events up with inference
+            Trace.beginSection("thermal.throttle")
+            try {
+                applyThrottlingStrategies(throttleLevel, capabilities)
+            } finally {
+                Trace.endSection()
+            }
+            traceThrottleLevel(throttleLevel)
             
             lastThrottleTime.set(System.currentTimeMillis())
             
@@ -306,6 +335,38 @@ class ThermalManagementSystem(
         }
     }
 
+    /**
+     * Notify listener of thermal state changes, starting with the current
+     * state if one has been sampled
+     */
+    fun addThermalStateListener(listener: ThermalStateListener) {
+        if (listeners.addIfAbsent(listener)) {
+            reportedState.get()?.let { listener.onThermalStateChanged(it) }
+        }
+    }
+
+    fun removeThermalStateListener(listener: ThermalStateListener) {
+        listeners.remove(listener)
+    }
+
+    /**
+     * Record a sampled state (0-4) and tell listeners when it maps to a new
+     * ThermalManager state; the mapping matches ThermalManager's
+     */
+    private fun updateThermalState(thermalState: Int) {
+        currentThermalState.set(thermalState)
+        val state = when (thermalState) {
+            0, 1 -> ThermalManager.ThermalState.NORMAL
+            2 -> ThermalManager.ThermalState.WARM
+            3 -> ThermalManager.ThermalState.HOT
+            else -> ThermalManager.ThermalState.CRITICAL
+        }
+        if (reportedState.getAndSet(state) != state) {
+            Log.d(TAG, "Thermal state changed to $state")
+            listeners.forEach { it.onThermalStateChanged(state) }
+        }
+    }
+
     /**
      * Get current thermal sample
      */
@@ -452,28 +513,46 @@ class ThermalManagementSystem(
 
     /**
      * Apply throttling strategies
+     * Shrinks the native compute pool shared by ASR and LLM, never past the
+     * performance cores it is pinned to
      */
     private fun applyThrottlingStrategies(throttleLevel: Int, capabilities: DeviceTierDetector.DeviceCapabilities) {
         Log.d(TAG, "Applying throttling strategies at level: $throttleLevel")
 
-        when (throttleLevel) {
+        val performanceCores = NativeComputePool.getPerformanceCoreCount()
+        val baseThreads = if (performanceCores > 0) {
+            minOf(capabilities.recommendedSettings.maxConcurrentThreads, performanceCores)
+        } else {
+            capabilities.recommendedSettings.maxConcurrentThreads
+        }
+
+        val threads = when (throttleLevel) {
             1 -> {
                 // Light throttling - reduce thread count slightly
                 Log.d(TAG, "Applying light throttling")
+                baseThreads - 1
             }
             2 -> {
                 // Medium throttling - reduce thread count and cache size
                 Log.d(TAG, "Applying medium throttling")
+                baseThreads / 2
             }
             3 -> {
                 // High throttling - significant reduction in processing
                 Log.d(TAG, "Applying high throttling")
+                2
             }
             4 -> {
                 // Maximum throttling - minimal processing
                 Log.d(TAG, "Applying maximum throttling")
+                1
             }
+            else -> return
         }
+
+        NativeComputePool.setThreadCount(threads.coerceIn(1, maxOf(1, baseThreads)))
+        // From high throttling on, accelerators would only add to the heat
+        NativeComputePool.setOffloadSuspended(throttleLevel >= OFFLOAD_SUSPEND_LEVEL)
     }
 
     /**
@@ -481,7 +560,19 @@ class ThermalManagementSystem(
      */
     private fun applyRecoveryStrategies() {
         Log.d(TAG, "Applying thermal recovery strategies")
-        // Gradually restore performance settings
+        // Restore one compute thread per performance core
+        NativeComputePool.setThreadCount(0)
+        NativeComputePool.setOffloadSuspended(false)
+        traceThrottleLevel(0)
+    }
+
+    /**
+     * Throttle level as a system trace counter track
+     */
+    private fun traceThrottleLevel(level: Int) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            Trace.setCounter("thermal.throttle_level", level.toLong())
+        }
     }
 
     /**
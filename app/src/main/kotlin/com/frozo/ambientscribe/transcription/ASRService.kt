@@ -2,6 +2,13 @@ package com.frozo.ambientscribe.transcription
 
 import android.content.Context
 import android.content.res.AssetManager
+import com.frozo.ambientscribe.AmbientScribeApplication
+import com.frozo.ambientscribe.performance.MemoryManager
+import com.frozo.ambientscribe.performance.MemoryPressure
+import com.frozo.ambientscribe.performance.ModelVariantSelector
+import com.frozo.ambientscribe.performance.NativeMemoryTrimmer
+import com.frozo.ambientscribe.performance.OffloadSettings
+import com.frozo.ambientscribe.performance.OffloadStats
 import com.frozo.ambientscribe.performance.PerformanceManager
 import com.frozo.ambientscribe.performance.ThermalManager
 import com.frozo.ambientscribe.performance.ThermalStateListener
@@ -17,6 +24,7 @@ import java.io.FileOutputStream
 import java.io.IOException
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
+import java.security.SecureRandom
 import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicReference
 import kotlin.math.log10
@@ -30,14 +38,23 @@ class ASRService(
     private val context: Context,
     private val modelName: String = "whisper-tiny-int8",
     private val confidenceThreshold: Float = 0.6f,
-    private val performanceManager: PerformanceManager? = null
-) : ThermalStateListener {
+    private val performanceManager: PerformanceManager? = null,
+    private val inputSampleRate: Int = SAMPLE_RATE,
+    private val audioMemoryCapBytes: Long = DEFAULT_AUDIO_MEMORY_CAP_BYTES,
+    private val memoryManager: MemoryManager? = AmbientScribeApplication.from(context)?.memoryManager
+) : ThermalStateListener, NativeMemoryTrimmer {
     companion object {
         private const val SAMPLE_RATE = 16000
         private const val CHUNK_DURATION_MS = 3000L // 3 second chunks
         private const val CHUNK_SIZE_SAMPLES = (SAMPLE_RATE * CHUNK_DURATION_MS / 1000).toInt()
         private const val OVERLAP_MS = 500L // 0.5 second overlap
         private const val OVERLAP_SAMPLES = (SAMPLE_RATE * OVERLAP_MS / 1000).toInt()
+        private const val MAX_BATCH_WINDOWS = 16 // windows drained per native call
+        private const val MIN_TOKENS_PER_SECOND = 20f // decode speed a variant needs to keep up with speech
+        private const val WHISPER_ENCODER_LAYERS = 4 // WHISPER_ENCODER_LAYERS in whisper_android.cpp
+        private const val DEFAULT_AUDIO_MEMORY_CAP_BYTES = 8L shl 20 // ~4 min of 16 kHz audio before spilling
+        private const val AUDIO_SPILL_FILE = "asr_session_audio.spill"
+        private const val AUDIO_STORE_KEY_BYTES = 32 // CHACHA20_KEY_BYTES in chacha20.h
         
         // Confidence score thresholds
         private const val HIGH_CONFIDENCE = 0.8f
@@ -67,14 +84,31 @@ class ASRService(
     private var modelPath: String? = null
     private var nativeHandle: Long = 0L
     
+    // Raw log probabilities are only returned when evaluation asks for them
+    @Volatile
+    private var logProbFormat = LogProbFormat.NONE
+
+    // Decoding strategy, tuned per device tier at initialization
+    @Volatile
+    private var decoderSettings = DecoderSettings()
+
+    // Encoder layers run on the device's NPU or GPU where it has one
+    private var offloadSettings = OffloadSettings(layers = WHISPER_ENCODER_LAYERS)
+    
     // Adaptive threading parameters
     private var threadCount = 4
     private var contextSize = 3000
+    private var batchSize = MAX_BATCH_WINDOWS
     
-    // Audio buffer for chunked processing
-    private val audioBuffer = mutableListOf<Short>()
+    // Session audio is kept natively: what the stream ring refuses waits in the
+    // store instead of on the Java heap, and the whole session can be replayed
+    @Volatile
+    private var audioStoreOpen = false
     private val bufferLock = Any()
     
+    // Direct int16 staging buffer read in place by native code (guarded by bufferLock)
+    private var pcmStagingBuffer: ByteBuffer? = null
+    
     // Transcription results
     private val transcriptionChannel = Channel<TranscriptionResult>(Channel.UNLIMITED)
     private val currentTranscription = AtomicReference("")
@@ -85,7 +119,9 @@ class ASRService(
     private var lastError: ASRError? = null
     
     /**
-     * Data class representing transcription results with confidence scoring
+     * Data class representing transcription results with confidence scoring.
+     * [meanLogProb], [minLogProb] and [wordConfidence] (mean over aligned
+     * words) come with every result; [logProbs] only while [setLogProbCapture] is enabled.
      */
     data class TranscriptionResult(
         val text: String,
@@ -93,11 +129,17 @@ class ASRService(
         val confidenceLevel: ConfidenceLevel,
         val timestamp: Long,
         val isPartial: Boolean = false,
-        val wordTimestamps: List<WordTimestamp> = emptyList()
+        val wordTimestamps: List<WordTimestamp> = emptyList(),
+        val meanLogProb: Float = 0f,
+        val minLogProb: Float = 0f,
+        val wordConfidence: Float = 0f,
+        val logProbs: FloatArray? = null
     )
     
     /**
-     * Word-level timestamp information
+     * Word-level timestamp information. Times are in seconds: from the start
+     * of the stream for streamed results, whose overlap duplicates are already
+     * merged natively, and from the start of the chunk for batch results.
      */
     data class WordTimestamp(
         val word: String,
@@ -138,22 +180,46 @@ class ASRService(
                 // Get initial performance recommendations
                 threadCount = pm.getRecommendedThreadCount()
                 contextSize = pm.getRecommendedContextSize()
+                decoderSettings = DecoderSettings.forTier(pm.getCurrentPerformanceState().deviceTier)
+                offloadSettings = OffloadSettings.forTier(pm.getCurrentPerformanceState().deviceTier, WHISPER_ENCODER_LAYERS)
                 
                 Timber.d("Initial performance settings - threads: $threadCount, context size: $contextSize")
             }
             
-            // Extract model files from assets
+            // Extract model files from assets, then load the variant that fits this device
             val modelDir = extractModelFromAssets()
-            modelPath = modelDir
+            val selectedDir = selectModelVariant(File(modelDir)) ?: modelDir
+            modelPath = selectedDir
             
             // Initialize native Whisper model with adaptive threading
-            nativeHandle = initializeNativeModel(modelDir, threadCount, contextSize)
+            nativeHandle = initializeNativeModel(selectedDir, threadCount, contextSize)
             
             if (nativeHandle == 0L) {
                 throw RuntimeException("Failed to initialize native Whisper model")
             }
             
+            // Windows of CHUNK_SIZE_SAMPLES with OVERLAP_SAMPLES overlap are cut natively;
+            // capture at any other rate is resampled to SAMPLE_RATE on the way into the stream
+            if (!nativeOpenStream(nativeHandle, CHUNK_SIZE_SAMPLES, OVERLAP_SAMPLES, inputSampleRate)) {
+                throw RuntimeException("Failed to open native Whisper audio stream")
+            }
+            audioStoreOpen = openAudioStore()
+            if (!audioStoreOpen) {
+                Timber.w("Native audio store unavailable; audio the stream refuses will be dropped")
+            }
+            if (logProbFormat != LogProbFormat.NONE) {
+                nativeSetLogProbFormat(nativeHandle, logProbFormat.nativeValue)
+            }
+            if (!applyDecoderSettings(decoderSettings)) {
+                Timber.w("Native decoder rejected $decoderSettings; using its defaults")
+            }
+            if (!applyOffloadSettings(offloadSettings)) {
+                Timber.w("Offload $offloadSettings unavailable; encoding on the CPU")
+            }
+            
             isInitialized.set(true)
+            // onTrimMemory reaches the model through the app's memory manager
+            memoryManager?.registerTrimmer(this@ASRService)
             Timber.i("ASRService initialized successfully with $threadCount threads")
             
             Result.success(Unit)
@@ -171,22 +237,24 @@ class ASRService(
     }
     
     /**
-     * Process audio data and generate transcriptions
+     * Process audio data and generate transcriptions. Only the first [length] samples are used.
+     * Samples are 16-bit PCM at the input sample rate the service was created with.
      */
-    suspend fun processAudio(audioData: ShortArray): Result<Unit> = withContext(Dispatchers.Default) {
+    suspend fun processAudio(
+        audioData: ShortArray,
+        length: Int = audioData.size
+    ): Result<Unit> = withContext(Dispatchers.Default) {
         try {
             if (!isInitialized.get()) {
                 return@withContext Result.failure(IllegalStateException("ASRService not initialized"))
             }
             
             synchronized(bufferLock) {
-                audioBuffer.addAll(audioData.toList())
+                pushToNativeStream(audioData, length)
             }
             
-            // Process chunks when we have enough data
-            if (audioBuffer.size >= CHUNK_SIZE_SAMPLES) {
-                processAudioChunk()
-            }
+            // Run inference on every complete window the native stream has buffered
+            processAudioChunk()
             
             Result.success(Unit)
             
@@ -201,6 +269,22 @@ class ASRService(
         }
     }
     
+    /**
+     * The VAD saw speech end after the audio pushed so far. The native stream
+     * transcribes up to here at once instead of waiting for its window to
+     * fill, and decoding stops at the end of speech rather than running on
+     * into the window's padding.
+     */
+    suspend fun endUtterance() = withContext(Dispatchers.Default) {
+        if (!isInitialized.get()) {
+            return@withContext
+        }
+        synchronized(bufferLock) {
+            nativeEndUtterance(nativeHandle)
+        }
+        processAudioChunk()
+    }
+    
     /**
      * Get flow of transcription results
      */
@@ -223,70 +307,194 @@ class ASRService(
         return currentTranscription.get()
     }
     
+    /**
+     * Return raw token log probabilities with every result, packed natively
+     * in [format], for accuracy evaluation and debugging. [LogProbFormat.NONE]
+     * (the default) returns only the confidence summary. Applies from the
+     * next inference; returns false if the native model rejected the format.
+     */
+    fun setLogProbCapture(format: LogProbFormat): Boolean {
+        logProbFormat = format
+        if (nativeHandle == 0L) {
+            return true
+        }
+        return nativeSetLogProbFormat(nativeHandle, format.nativeValue)
+    }
+    
+    /**
+     * Change how the native decoder searches; applies from the next window.
+     * Returns false if the native model rejected the settings.
+     */
+    fun setDecoderSettings(settings: DecoderSettings): Boolean {
+        decoderSettings = settings
+        if (nativeHandle == 0L) {
+            return true
+        }
+        return applyDecoderSettings(settings)
+    }
+    
+    /**
+     * Decoder work since the model was loaded, or null before initialization
+     */
+    fun getDecodeStats(): DecodeStats? {
+        if (nativeHandle == 0L) {
+            return null
+        }
+        return DecodeStats.fromNative(nativeGetDecodeStats(nativeHandle))
+    }
+    
+    /**
+     * Move encoder layers to or from an accelerator; applies from the next
+     * window. Returns false if the requested delegate is not on this device.
+     */
+    fun setOffloadSettings(settings: OffloadSettings): Boolean {
+        offloadSettings = settings
+        if (nativeHandle == 0L) {
+            return true
+        }
+        return applyOffloadSettings(settings)
+    }
+    
+    /**
+     * Where encoder passes ran since the model was loaded, or null before initialization
+     */
+    fun getOffloadStats(): OffloadStats? {
+        if (nativeHandle == 0L) {
+            return null
+        }
+        return OffloadStats.fromNative(nativeGetOffloadStats(nativeHandle))
+    }
+    
+    /**
+     * Give memory back under pressure. The model stays loaded at every level,
+     * even [MemoryPressure.CRITICAL], so an encounter being transcribed keeps
+     * its stream; from [MemoryPressure.HIGH] its weight pages are dropped and
+     * fault back in on the next window.
+     */
+    override fun trimMemory(pressure: MemoryPressure): Long {
+        if (nativeHandle == 0L) {
+            return 0
+        }
+        val reclaimed = nativeTrimMemory(nativeHandle, pressure.nativeValue)
+        Timber.i("Trimmed ASR at $pressure pressure: ${reclaimed / 1024} KB reclaimed")
+        return reclaimed
+    }
+    
+    private fun applyOffloadSettings(settings: OffloadSettings): Boolean =
+        nativeSetOffload(nativeHandle, settings.backend.nativeValue, settings.layers)
+    
+    private fun applyDecoderSettings(settings: DecoderSettings): Boolean =
+        nativeSetDecoderConfig(
+            nativeHandle,
+            settings.mode.nativeValue,
+            settings.beamSize,
+            settings.widenLogProb,
+            settings.widenEntropy,
+            settings.narrowAfterTokens,
+            settings.earlyExit
+        )
+    
     /**
      * Clear the current transcription buffer
      */
     fun clearTranscription() {
         currentTranscription.set("")
         synchronized(bufferLock) {
-            audioBuffer.clear()
+            if (nativeHandle != 0L) {
+                nativeResetStream(nativeHandle)
+                if (audioStoreOpen) {
+                    nativeResetAudioStore(nativeHandle)
+                }
+            }
         }
         Timber.d("Transcription buffer cleared")
     }
     
     /**
-     * Process a chunk of audio data through the Whisper model
+     * Queue samples on the native stream. With the audio store open native code
+     * keeps whatever the ring refuses and feeds it in as windows are consumed.
+     */
+    private fun pushToNativeStream(audioData: ShortArray, length: Int) {
+        val accepted = nativePushAudio(nativeHandle, stagePcm(audioData, length), length)
+        check(accepted >= 0) { "Native audio stream is not open" }
+        
+        if (accepted < length) {
+            Timber.w("Native stream ring full, dropping ${length - accepted} samples")
+        }
+    }
+    
+    /**
+     * Open the native session audio store with a fresh random key. Keystore
+     * keys never leave secure hardware, so the key lives only in native memory
+     * and spilled audio is unreadable once the session ends.
+     */
+    private fun openAudioStore(): Boolean {
+        val key = ByteArray(AUDIO_STORE_KEY_BYTES)
+        SecureRandom().nextBytes(key)
+        try {
+            val segmentSamples = (inputSampleRate * CHUNK_DURATION_MS / 1000).toInt()
+            val spillFile = File(context.cacheDir, AUDIO_SPILL_FILE)
+            return nativeOpenAudioStore(nativeHandle, spillFile.absolutePath, key, segmentSamples, audioMemoryCapBytes)
+        } finally {
+            key.fill(0)
+        }
+    }
+    
+    /**
+     * Copy samples into the reusable direct buffer, growing it only when a push is larger
+     */
+    private fun stagePcm(samples: ShortArray, length: Int): ByteBuffer {
+        val requiredBytes = length * Short.SIZE_BYTES
+        val buffer = pcmStagingBuffer?.takeIf { it.capacity() >= requiredBytes }
+            ?: ByteBuffer.allocateDirect(max(requiredBytes, CHUNK_SIZE_SAMPLES * Short.SIZE_BYTES))
+                .order(ByteOrder.nativeOrder())
+                .also { pcmStagingBuffer = it }
+        
+        buffer.clear()
+        buffer.asShortBuffer().put(samples, 0, length)
+        return buffer
+    }
+    
+    /**
+     * Drain all complete windows from the native stream through the Whisper model
      */
     private suspend fun processAudioChunk() = withContext(Dispatchers.Default) {
-        if (isProcessing.get()) {
+        if (isProcessing.getAndSet(true)) {
             return@withContext
         }
         
-        isProcessing.set(true)
-        
         try {
-            val chunk: ShortArray
-            synchronized(bufferLock) {
-                if (audioBuffer.size < CHUNK_SIZE_SAMPLES) {
-                    isProcessing.set(false)
-                    return@withContext
+            while (true) {
+                // Backlog held in the store moves into the ring as polls free it
+                if (audioStoreOpen) {
+                    nativeDrainAudioStore(nativeHandle)
+                }
+                val results = runInference()
+                if (results.isEmpty()) {
+                    break
                 }
                 
-                // Extract chunk with overlap
-                val chunkSize = minOf(CHUNK_SIZE_SAMPLES, audioBuffer.size)
-                chunk = audioBuffer.take(chunkSize).toShortArray()
-                
-                // Remove processed samples, keeping overlap
-                val removeCount = maxOf(0, chunkSize - OVERLAP_SAMPLES)
-                repeat(removeCount) {
-                    if (audioBuffer.isNotEmpty()) {
-                        audioBuffer.removeAt(0)
+                for (result in results) {
+                    if (result.text.isBlank()) {
+                        continue
                     }
+                    
+                    // Update current transcription
+                    val current = currentTranscription.get()
+                    val updated = if (current.isEmpty()) {
+                        result.text
+                    } else {
+                        "$current ${result.text}"
+                    }
+                    currentTranscription.set(updated)
+                    
+                    // Send result
+                    transcriptionChannel.trySend(result)
+                    
+                    Timber.d("Transcription: '${result.text}' (confidence: ${result.confidence})")
                 }
             }
             
-            // Convert to float array for model input
-            val floatArray = chunk.map { it.toFloat() / Short.MAX_VALUE }.toFloatArray()
-            
-            // Run inference
-            val result = runInference(floatArray)
-            
-            if (result.text.isNotBlank()) {
-                // Update current transcription
-                val current = currentTranscription.get()
-                val updated = if (current.isEmpty()) {
-                    result.text
-                } else {
-                    "$current ${result.text}"
-                }
-                currentTranscription.set(updated)
-                
-                // Send result
-                transcriptionChannel.trySend(result)
-                
-                Timber.d("Transcription: '${result.text}' (confidence: ${result.confidence})")
-            }
-            
         } catch (e: Exception) {
             Timber.e(e, "Error processing audio chunk")
             
@@ -314,42 +522,142 @@ class ASRService(
     }
     
     /**
-     * Run Whisper inference on audio data
+     * Transcribe already-captured chunks in one native batch, e.g. audio held
+     * back while the device was thermally throttled or after a call has ended
      */
-    private suspend fun runInference(audioData: FloatArray): TranscriptionResult = withContext(Dispatchers.Default) {
+    suspend fun transcribeBatch(chunks: List<ShortArray>): Result<List<TranscriptionResult>> = withContext(Dispatchers.Default) {
+        if (!isInitialized.get()) {
+            return@withContext Result.failure(IllegalStateException("ASRService not initialized"))
+        }
+        if (chunks.isEmpty()) {
+            return@withContext Result.success(emptyList())
+        }
+        
         val startTime = System.currentTimeMillis()
         
         try {
-            // Apply current performance settings
-            val currentThreads = threadCount
-            val currentCtxSize = contextSize
+            // All chunks share one direct buffer; offsets and lengths are in samples
+            val offsets = IntArray(chunks.size)
+            val lengths = IntArray(chunks.size)
+            var totalSamples = 0
+            chunks.forEachIndexed { index, chunk ->
+                offsets[index] = totalSamples
+                lengths[index] = chunk.size
+                totalSamples += chunk.size
+            }
+            
+            val buffer = ByteBuffer.allocateDirect(totalSamples * Short.SIZE_BYTES).order(ByteOrder.nativeOrder())
+            val shorts = buffer.asShortBuffer()
+            chunks.forEach { shorts.put(it) }
+            
+            val nativeResults = nativeInferenceBatch(nativeHandle, buffer, offsets, lengths)
+                ?: throw RuntimeException("Native batched inference failed")
+            
+            val duration = System.currentTimeMillis() - startTime
+            Timber.v("Batched inference of ${chunks.size} chunks completed in ${duration}ms")
             
-            // Call native inference method with adaptive parameters
-            val nativeResult = nativeInference(nativeHandle, audioData, currentThreads, currentCtxSize)
+            Result.success(nativeResults.map { toTranscriptionResult(it, startTime) })
             
-            val text = nativeResult.text.trim()
-            val confidence = calculateConfidence(nativeResult.logProbs)
-            val confidenceLevel = when {
-                confidence >= HIGH_CONFIDENCE -> ConfidenceLevel.HIGH
-                confidence >= MEDIUM_CONFIDENCE -> ConfidenceLevel.MEDIUM
-                else -> ConfidenceLevel.LOW
+        } catch (e: Exception) {
+            Timber.e(e, "Native batched inference failed")
+            emitError(ASRError.DecoderError(
+                message = "Transcription engine error: ${e.message}",
+                cause = e
+            ))
+            Result.failure(e)
+        }
+    }
+    
+    /**
+     * Re-transcribe session audio between [startMs] and [endMs] from the native
+     * store, in CHUNK_DURATION_MS chunks, without copying it back to Java.
+     * Needs capture at SAMPLE_RATE, since the store keeps audio as captured.
+     */
+    suspend fun retranscribeStored(
+        startMs: Long = 0L,
+        endMs: Long = Long.MAX_VALUE
+    ): Result<List<TranscriptionResult>> = withContext(Dispatchers.Default) {
+        if (!isInitialized.get() || !audioStoreOpen) {
+            return@withContext Result.failure(IllegalStateException("Native audio store not open"))
+        }
+        if (inputSampleRate != SAMPLE_RATE) {
+            return@withContext Result.failure(
+                IllegalStateException("Stored audio is at $inputSampleRate Hz; replay needs $SAMPLE_RATE Hz capture")
+            )
+        }
+        
+        val startTime = System.currentTimeMillis()
+        
+        try {
+            val stored = getAudioStoreStats()?.segments ?: 0
+            val first = (startMs.coerceAtLeast(0L) / CHUNK_DURATION_MS).toInt().coerceAtMost(stored)
+            val last = if (endMs == Long.MAX_VALUE) {
+                stored
+            } else {
+                ((endMs + CHUNK_DURATION_MS - 1) / CHUNK_DURATION_MS).toInt().coerceIn(first, stored)
             }
             
-            // Extract word timestamps if available
-            val wordTimestamps = extractWordTimestamps(nativeResult.alignments)
+            val results = mutableListOf<TranscriptionResult>()
+            var segment = first
+            while (segment < last) {
+                val count = minOf(MAX_BATCH_WINDOWS, last - segment)
+                val nativeResults = nativeInferenceStored(nativeHandle, segment, count)
+                    ?: throw RuntimeException("Native stored audio inference failed")
+                nativeResults.mapTo(results) { toTranscriptionResult(it, startTime) }
+                segment += count
+            }
             
-            // Log inference performance
             val duration = System.currentTimeMillis() - startTime
-            Timber.v("Inference completed in ${duration}ms with $currentThreads threads, " +
-                    "ctx size: $currentCtxSize, confidence: $confidence")
-            
-            TranscriptionResult(
-                text = text,
-                confidence = confidence,
-                confidenceLevel = confidenceLevel,
-                timestamp = startTime,
-                wordTimestamps = wordTimestamps
-            )
+            Timber.v("Re-transcribed ${last - first} stored chunks in ${duration}ms")
+            
+            Result.success(results)
+            
+        } catch (e: Exception) {
+            Timber.e(e, "Stored audio re-transcription failed")
+            emitError(ASRError.DecoderError(
+                message = "Transcription engine error: ${e.message}",
+                cause = e
+            ))
+            Result.failure(e)
+        }
+    }
+    
+    /**
+     * Memory and spill use of the native session audio store, or null when it is not open
+     */
+    fun getAudioStoreStats(): AudioStoreStats? {
+        if (nativeHandle == 0L || !audioStoreOpen) {
+            return null
+        }
+        return AudioStoreStats.fromNative(nativeGetAudioStoreStats(nativeHandle))
+    }
+    
+    /**
+     * Run Whisper inference on every buffered window, or return an empty list if none is ready
+     */
+    private suspend fun runInference(): List<TranscriptionResult> = withContext(Dispatchers.Default) {
+        val startTime = System.currentTimeMillis()
+        
+        try {
+            // Parameters are applied to the native handle on change; captured here for logging
+            val currentThreads = threadCount
+            val currentCtxSize = contextSize
+            
+            // The native stream keeps the overlap tail, so only new audio is analysed,
+            // and stitches words across windows, so each result holds only new words
+            val nativeResults = nativePollStreamBatch(nativeHandle, MAX_BATCH_WINDOWS)
+                ?: throw RuntimeException("Native stream inference failed")
+            
+            val results = nativeResults.map { toTranscriptionResult(it, startTime) }
+            
+            // Log inference performance
+            if (results.isNotEmpty()) {
+                val duration = System.currentTimeMillis() - startTime
+                Timber.v("Inference of ${results.size} windows completed in ${duration}ms with " +
+                        "$currentThreads threads, ctx size: $currentCtxSize")
+            }
+            
+            results
             
         } catch (e: Exception) {
             Timber.e(e, "Native inference failed")
@@ -372,43 +680,97 @@ class ASRService(
             
             emitError(error)
             
-            TranscriptionResult(
-                text = "",
-                confidence = 0f,
-                confidenceLevel = ConfidenceLevel.LOW,
-                timestamp = startTime
-            )
+            // Stop draining; the windows stay consumed and the next push retries
+            emptyList()
         }
     }
     
     /**
-     * Calculate confidence score from log probabilities
+     * Convert a native result into a scored transcription result
      */
-    private fun calculateConfidence(logProbs: FloatArray): Float {
-        if (logProbs.isEmpty()) return 0f
-        
-        // Convert log probabilities to confidence score
-        val avgLogProb = logProbs.average().toFloat()
-        val confidence = kotlin.math.exp(avgLogProb.toDouble()).toFloat()
+    private fun toTranscriptionResult(nativeResult: NativeInferenceResult, timestamp: Long): TranscriptionResult {
+        val confidence = nativeResult.confidence
+        val confidenceLevel = when {
+            confidence >= HIGH_CONFIDENCE -> ConfidenceLevel.HIGH
+            confidence >= MEDIUM_CONFIDENCE -> ConfidenceLevel.MEDIUM
+            else -> ConfidenceLevel.LOW
+        }
         
-        // Normalize to 0-1 range with sigmoid-like function
-        return 1f / (1f + kotlin.math.exp((-confidence * 10f + 5f).toDouble())).toFloat()
+        return TranscriptionResult(
+            text = nativeResult.text.trim(),
+            confidence = confidence,
+            confidenceLevel = confidenceLevel,
+            timestamp = timestamp,
+            // Extract word timestamps if available
+            wordTimestamps = extractWordTimestamps(nativeResult),
+            meanLogProb = nativeResult.meanLogProb,
+            minLogProb = nativeResult.minLogProb,
+            wordConfidence = nativeResult.wordConfidence,
+            logProbs = nativeResult.packedLogProbs?.let {
+                LogProbCodec.decode(it, LogProbFormat.fromNative(nativeResult.logProbFormat), nativeResult.logProbScale)
+            }
+        )
     }
     
     /**
      * Extract word-level timestamps from alignment data
      */
-    private fun extractWordTimestamps(alignments: Array<NativeAlignment>): List<WordTimestamp> {
-        return alignments.map { alignment ->
+    private fun extractWordTimestamps(result: NativeInferenceResult): List<WordTimestamp> {
+        return List(result.wordStarts.size) { index ->
             WordTimestamp(
-                word = alignment.word,
-                startTime = alignment.startTime,
-                endTime = alignment.endTime,
-                confidence = alignment.confidence
+                word = result.wordText.substring(result.wordOffsets[index], result.wordOffsets[index + 1]).trim(),
+                startTime = result.wordStarts[index],
+                endTime = result.wordEnds[index],
+                confidence = result.wordConfidences[index]
             )
         }
     }
     
+    /**
+     * Re-run variant selection against current memory and thermal state and
+     * hot-swap the loaded weights if another variant fits better. The audio
+     * stream stays open. Returns true if a swap happened.
+     */
+    suspend fun reselectModelVariant(thermalLevel: Int? = null): Boolean = withContext(Dispatchers.IO) {
+        val current = modelPath
+        if (!isInitialized.get() || current == null) {
+            return@withContext false
+        }
+        
+        val selected = selectModelVariant(File(current), thermalLevel)
+        if (selected == null || selected == current) {
+            return@withContext false
+        }
+        if (!nativeSwapModel(nativeHandle, selected)) {
+            Timber.w("Failed to swap Whisper model variant to $selected")
+            return@withContext false
+        }
+        
+        modelPath = selected
+        Timber.i("Switched Whisper model variant to ${File(selected).name}")
+        true
+    }
+    
+    /**
+     * Path of the installed variant the performance manager picks, or null to keep the default.
+     * Variants are sibling directories differing only in their quantization tag,
+     * e.g. whisper-tiny-int8 and whisper-tiny-f16.
+     */
+    private fun selectModelVariant(modelDir: File, thermalLevel: Int? = null): String? {
+        val manager = performanceManager ?: return null
+        val family = modelName.substringBeforeLast('-') + "-"
+        val paths = modelDir.parentFile
+            ?.listFiles { file -> file.isDirectory && file.name.startsWith(family) && !file.list().isNullOrEmpty() }
+            ?.map { it.absolutePath }
+            ?: return null
+        
+        val variants = ModelVariantSelector.fromNative(
+            paths,
+            nativeDescribeVariants(paths.toTypedArray(), contextSize)
+        )
+        return manager.selectModelVariant(variants, MIN_TOKENS_PER_SECOND, thermalLevel)?.path
+    }
+    
     /**
      * Extract model files from assets to internal storage
      */
@@ -468,13 +830,17 @@ class ASRService(
      * Clean up resources
      */
     fun cleanup() {
+        memoryManager?.unregisterTrimmer(this)
         if (nativeHandle != 0L) {
+            nativeCloseStream(nativeHandle)
             releaseNativeModel(nativeHandle)
             nativeHandle = 0L
         }
         
+        // The spill file is deleted with the native model
+        audioStoreOpen = false
         synchronized(bufferLock) {
-            audioBuffer.clear()
+            pcmStagingBuffer = null
         }
         
         transcriptionChannel.close()
@@ -509,19 +875,32 @@ class ASRService(
             ThermalManager.ThermalState.HOT -> 1000
             ThermalManager.ThermalState.CRITICAL -> 500
         }
+        val newBatchSize = when (state) {
+            ThermalManager.ThermalState.NORMAL -> MAX_BATCH_WINDOWS
+            ThermalManager.ThermalState.WARM -> 8
+            ThermalManager.ThermalState.HOT -> 4
+            ThermalManager.ThermalState.CRITICAL -> 2
+        }
         
         // Only log if values changed
-        if (threadCount != newThreadCount || contextSize != newContextSize) {
+        if (threadCount != newThreadCount || contextSize != newContextSize || batchSize != newBatchSize) {
             Timber.d("Thermal state changed: level=$thermalLevel, " +
                     "threads: $threadCount -> $newThreadCount, " +
-                    "context: $contextSize -> $newContextSize")
+                    "context: $contextSize -> $newContextSize, " +
+                    "batch: $batchSize -> $newBatchSize")
             
             threadCount = newThreadCount
             contextSize = newContextSize
+            batchSize = newBatchSize
             
-            // In a real implementation, we would update the native model parameters
             if (nativeHandle != 0L && isInitialized.get()) {
-                // updateNativeModelParameters(nativeHandle, threadCount, contextSize)
+                // Applied in place on the live model; the thread count resizes the pool shared with the LLM
+                if (!updateNativeModelParameters(nativeHandle, threadCount, contextSize, batchSize)) {
+                    Timber.w("Failed to update native model parameters")
+                }
+                
+                // A hotter device gets a smaller memory budget, so this may step down a variant
+                coroutineScope.launch { reselectModelVariant(thermalLevel) }
             }
             
             // Emit thermal error for severe thermal state
@@ -548,46 +927,67 @@ class ASRService(
     
     // Native method declarations (would be implemented in C++)
     private external fun initializeNativeModel(modelPath: String, threadCount: Int = 4, contextSize: Int = 3000): Long
-    private external fun nativeInference(handle: Long, audioData: FloatArray, threadCount: Int = 4, contextSize: Int = 3000): NativeInferenceResult
+    private external fun nativeInference(handle: Long, audioData: FloatArray): NativeInferenceResult
     private external fun releaseNativeModel(handle: Long)
-    // private external fun updateNativeModelParameters(handle: Long, threadCount: Int, contextSize: Int): Boolean
+    private external fun nativeOpenStream(handle: Long, windowSamples: Int, overlapSamples: Int, inputSampleRate: Int): Boolean
+    private external fun nativePushAudio(handle: Long, pcmBuffer: ByteBuffer, sampleCount: Int): Int
+    private external fun nativePollStreamBatch(handle: Long, maxWindows: Int): Array<NativeInferenceResult>?
+    private external fun nativeInferenceBatch(
+        handle: Long,
+        pcmBuffer: ByteBuffer,
+        chunkOffsets: IntArray,
+        chunkLengths: IntArray
+    ): Array<NativeInferenceResult>?
+    private external fun nativeDescribeVariants(modelPaths: Array<String>, contextSize: Int): DoubleArray?
+    private external fun nativeSwapModel(handle: Long, modelPath: String): Boolean
+    private external fun nativeResetStream(handle: Long)
+    private external fun nativeCloseStream(handle: Long)
+    private external fun nativeSetLogProbFormat(handle: Long, format: Int): Boolean
+    private external fun nativeSetDecoderConfig(
+        handle: Long,
+        mode: Int,
+        beamSize: Int,
+        widenLogProb: Float,
+        widenEntropy: Float,
+        narrowAfter: Int,
+        earlyExit: Boolean
+    ): Boolean
+    private external fun nativeGetDecodeStats(handle: Long): LongArray?
+    private external fun nativeSetOffload(handle: Long, backend: Int, layers: Int): Boolean
+    private external fun nativeGetOffloadStats(handle: Long): LongArray?
+    private external fun nativeTrimMemory(handle: Long, level: Int): Long
+    private external fun nativeEndUtterance(handle: Long)
+    private external fun nativeOpenAudioStore(
+        handle: Long,
+        spillPath: String,
+        key: ByteArray,
+        segmentSamples: Int,
+        memoryCapBytes: Long
+    ): Boolean
+    private external fun nativeDrainAudioStore(handle: Long): Int
+    private external fun nativeResetAudioStore(handle: Long)
+    private external fun nativeInferenceStored(handle: Long, firstSegment: Int, count: Int): Array<NativeInferenceResult>?
+    private external fun nativeGetAudioStoreStats(handle: Long): LongArray?
+    private external fun updateNativeModelParameters(handle: Long, threadCount: Int, contextSize: Int, batchSize: Int): Boolean
     
     /**
-     * Native inference result structure
+     * Native inference result structure. Confidence is reduced natively;
+     * [packedLogProbs] is null unless log-prob capture is on.
      */
-    private data class NativeInferenceResult(
+    private class NativeInferenceResult(
         val text: String,
-        val logProbs: FloatArray,
-        val alignments: Array<NativeAlignment>
-    ) {
-        override fun equals(other: Any?): Boolean {
-            if (this === other) return true
-            if (javaClass != other?.javaClass) return false
-
-            other as NativeInferenceResult
-
-            if (text != other.text) return false
-            if (!logProbs.contentEquals(other.logProbs)) return false
-            if (!alignments.contentEquals(other.alignments)) return false
-
-            return true
-        }
-
-        override fun hashCode(): Int {
-            var result = text.hashCode()
-            result = 31 * result + logProbs.contentHashCode()
-            result = 31 * result + alignments.contentHashCode()
-            return result
-        }
-    }
-    
-    /**
-     * Native alignment structure for word timestamps
-     */
-    private data class NativeAlignment(
-        val word: String,
-        val startTime: Float,
-        val endTime: Float,
-        val confidence: Float
+        val confidence: Float,
+        val meanLogProb: Float,
+        val minLogProb: Float,
+        val wordConfidence: Float,
+        val packedLogProbs: ByteArray?,
+        val logProbFormat: Int,
+        val logProbScale: Float,
+        /** Aligned words joined by spaces; word i spans [wordOffsets[i], wordOffsets[i + 1]) */
+        val wordText: String,
+        val wordOffsets: IntArray,
+        val wordStarts: FloatArray,
+        val wordEnds: FloatArray,
+        val wordConfidences: FloatArray
     )
 }
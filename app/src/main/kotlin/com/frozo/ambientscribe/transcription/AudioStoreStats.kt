@@ -0,0 +1,28 @@
+package com.frozo.ambientscribe.transcription
+
+/**
+ * The native session audio store. [memoryBytes] stays at about the
+ * configured cap however long the session runs; older audio is in the
+ * encrypted spill file ([spilledBytes]). [unreadSamples] is the backlog the
+ * stream ring has not taken yet.
+ */
+data class AudioStoreStats(
+    val storedSamples: Long,
+    val unreadSamples: Long,
+    val memoryBytes: Long,
+    val spilledBytes: Long,
+    val segments: Int
+) {
+    companion object {
+        private const val VALUE_COUNT = 5
+
+        /**
+         * Parse the native counters: [stored samples, unread samples, bytes in
+         * memory, bytes spilled, segments]
+         */
+        fun fromNative(values: LongArray?): AudioStoreStats? {
+            if (values == null || values.size < VALUE_COUNT) return null
+            return AudioStoreStats(values[0], values[1], values[2], values[3], values[4].toInt())
+        }
+    }
+}
@@ -39,6 +39,7 @@ class AudioTranscriptionPipeline(
         performanceManager = performanceManager
     )
     private val speakerDiarization = SpeakerDiarization(context)
+    private val voiceActivityDetector = VoiceActivityDetector()
     private val accuracyEvaluator = ASRAccuracyEvaluator(context, pilotMode)
     private val ephemeralTranscriptManager = EphemeralTranscriptManager(context, metricsCollector)
     
@@ -109,10 +110,18 @@ class AudioTranscriptionPipeline(
                 return Result.failure(exception)
             }
             
+            // Frame-level VAD keeps silence out of the ASR buffer; without it
+            // every sample goes to ASR and the energy threshold drives VAD state
+            if (!voiceActivityDetector.initialize()) {
+                Timber.w("Native VAD unavailable, falling back to energy threshold")
+            }
+            
             // Set up pilot mode
             if (pilotMode) {
                 accuracyEvaluator.setPilotMode(true)
                 metricsCollector.setPilotModeEnabled(true)
+                // Token log probabilities for evaluation; fp16 is plenty for scoring
+                asrService.setLogProbCapture(LogProbFormat.FLOAT16)
                 Timber.i("Pilot mode enabled for metrics collection")
             }
             
@@ -322,6 +331,7 @@ class AudioTranscriptionPipeline(
      */
     fun clearBuffers() {
         asrService.clearTranscription()
+        voiceActivityDetector.reset()
         audioCapture.clearRingBuffer()
         Timber.d("Transcription and audio buffers cleared")
     }
@@ -359,6 +369,7 @@ class AudioTranscriptionPipeline(
         
         audioCapture.cleanup()
         asrService.cleanup()
+        voiceActivityDetector.release()
         performanceManager.cleanup()
         
         // Force purge any ephemeral transcripts
@@ -456,18 +467,33 @@ class AudioTranscriptionPipeline(
             val audioJob = coroutineScope.launch {
                 var lastVadState = vadState.value
                 sharedAudioFlow.collect { samples ->
+                    // Drop silent frames before they reach the ASR buffer
+                    val gated = voiceActivityDetector.process(samples.samples)
+                    
                     // Process audio through ASR
-                    val asrResult = asrService.processAudio(samples.samples)
-                    if (asrResult.isFailure) {
-                        val exception = Exception("ASR processing failed")
-                        Timber.w("ASR processing failed: $exception")
-                        val error = ASRError.fromException(exception)
-                        errorChannel.send(error)
+                    if (gated.sampleCount > 0) {
+                        val asrResult = asrService.processAudio(gated.samples, gated.sampleCount)
+                        if (asrResult.isFailure) {
+                            val exception = Exception("ASR processing failed")
+                            Timber.w("ASR processing failed: $exception")
+                            val error = ASRError.fromException(exception)
+                            errorChannel.send(error)
+                        }
                     }
                     
-                    // Calculate energy level and VAD state
-                    val energyLevel = calculateEnergyLevel(samples.samples)
-                    val isVoiceActive = energyLevel > vadThreshold
+                    // Energy comes from the VAD's frame features; only the
+                    // pass-through fallback scans the samples again
+                    val features = gated.features
+                    val energyLevel = if (features.frameCount > 0) {
+                        features.rms()
+                    } else {
+                        calculateEnergyLevel(samples.samples)
+                    }
+                    val isVoiceActive = if (voiceActivityDetector.isInitialized()) {
+                        gated.isSpeech
+                    } else {
+                        energyLevel > vadThreshold
+                    }
                     val newVadState = if (isVoiceActive) VoiceActivityState.SPEECH else VoiceActivityState.SILENCE
 
                     energyState.value = energyLevel
@@ -475,6 +501,10 @@ class AudioTranscriptionPipeline(
 
                     if (newVadState != lastVadState) {
                         Timber.v("VAD state changed to: $newVadState")
+                        // Transcribe the utterance now rather than when the next one fills the window
+                        if (newVadState == VoiceActivityState.SILENCE) {
+                            asrService.endUtterance()
+                        }
                         lastVadState = newVadState
                     }
                     
@@ -482,7 +512,8 @@ class AudioTranscriptionPipeline(
                     val audioData = SpeakerDiarization.AudioData(
                         timestamp = System.currentTimeMillis(),
                         energyLevel = energyLevel,
-                        isVoiceActive = isVoiceActive
+                        isVoiceActive = isVoiceActive,
+                        pitchHz = features.meanPitchHz()
                     )
                     
                     // Process audio through speaker diarization
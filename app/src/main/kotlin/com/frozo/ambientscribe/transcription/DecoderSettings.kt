@@ -0,0 +1,82 @@
+package com.frozo.ambientscribe.transcription
+
+import com.frozo.ambientscribe.performance.DeviceCapabilityDetector
+
+/**
+ * How the native Whisper decoder searches. [nativeValue] matches DecodeMode
+ * in asr_core.h.
+ */
+enum class DecodeMode(val nativeValue: Int) {
+    GREEDY(0),
+    ADAPTIVE(1),
+    BEAM(2)
+}
+
+/**
+ * Native decoding strategy. In [DecodeMode.ADAPTIVE] every token starts
+ * greedy; a token whose log probability falls below [widenLogProb] or whose
+ * entropy (nats) rises above [widenEntropy] is re-decoded with a wider beam,
+ * doubling up to [beamSize], and the beam drops back to greedy after
+ * [narrowAfterTokens] confident tokens. With [earlyExit], a window cut short
+ * at the end of an utterance is decoded only up to the end of speech.
+ */
+data class DecoderSettings(
+    val mode: DecodeMode = DecodeMode.ADAPTIVE,
+    val beamSize: Int = 5,
+    val widenLogProb: Float = -1.0f,
+    val widenEntropy: Float = 2.5f,
+    val narrowAfterTokens: Int = 4,
+    val earlyExit: Boolean = true
+) {
+    companion object {
+        /**
+         * Slower tiers widen later and less: beam search costs most where
+         * latency already hurts, and most clinic speech decodes greedily anyway
+         */
+        fun forTier(tier: DeviceCapabilityDetector.DeviceTier): DecoderSettings = when (tier) {
+            DeviceCapabilityDetector.DeviceTier.TIER_A -> DecoderSettings()
+            DeviceCapabilityDetector.DeviceTier.TIER_B -> DecoderSettings(
+                beamSize = 4,
+                widenLogProb = -1.3f,
+                widenEntropy = 2.8f,
+                narrowAfterTokens = 3
+            )
+            DeviceCapabilityDetector.DeviceTier.TIER_C -> DecoderSettings(
+                beamSize = 2,
+                widenLogProb = -1.8f,
+                widenEntropy = 3.2f,
+                narrowAfterTokens = 2
+            )
+        }
+    }
+}
+
+/**
+ * Native decoder work since the model was loaded. [hypotheses] is the sum
+ * of the beam width over every decoded token, so [hypothesesPerToken] is
+ * the decoding cost relative to greedy.
+ */
+data class DecodeStats(
+    val chunks: Long,
+    val tokens: Long,
+    val beamTokens: Long,
+    val hypotheses: Long,
+    val earlyExits: Long,
+    val skippedTokens: Long
+) {
+    val hypothesesPerToken: Float
+        get() = if (tokens > 0) hypotheses.toFloat() / tokens else 0f
+
+    companion object {
+        private const val VALUE_COUNT = 6
+
+        /**
+         * Parse the native counters: [chunks, tokens, beam tokens, hypotheses,
+         * early exits, skipped tokens]
+         */
+        fun fromNative(values: LongArray?): DecodeStats? {
+            if (values == null || values.size < VALUE_COUNT) return null
+            return DecodeStats(values[0], values[1], values[2], values[3], values[4], values[5])
+        }
+    }
+}
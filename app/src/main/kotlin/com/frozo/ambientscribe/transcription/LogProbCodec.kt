@@ -0,0 +1,64 @@
+package com.frozo.ambientscribe.transcription
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Encodings the native ASR can return raw token log probabilities in.
+ * [nativeValue] matches LogProbFormat in asr_core.h. With [NONE] (the
+ * default) only the native confidence summary crosses JNI.
+ */
+enum class LogProbFormat(val nativeValue: Int) {
+    NONE(0),
+    FLOAT32(1),
+    FLOAT16(2),
+    INT8(3);
+
+    companion object {
+        fun fromNative(value: Int): LogProbFormat = values().firstOrNull { it.nativeValue == value } ?: NONE
+    }
+}
+
+/**
+ * Unpacks log probabilities packed natively for the evaluation and debug
+ * paths. Packed bytes are in native byte order.
+ */
+object LogProbCodec {
+
+    fun decode(packed: ByteArray, format: LogProbFormat, scale: Float): FloatArray {
+        val buffer = ByteBuffer.wrap(packed).order(ByteOrder.nativeOrder())
+        return when (format) {
+            LogProbFormat.NONE -> FloatArray(0)
+            LogProbFormat.FLOAT32 -> FloatArray(packed.size / Float.SIZE_BYTES) { buffer.getFloat(it * Float.SIZE_BYTES) }
+            LogProbFormat.FLOAT16 -> FloatArray(packed.size / Short.SIZE_BYTES) {
+                halfToFloat(buffer.getShort(it * Short.SIZE_BYTES).toInt() and 0xFFFF)
+            }
+            LogProbFormat.INT8 -> FloatArray(packed.size) { packed[it] * scale }
+        }
+    }
+
+    /**
+     * IEEE 754 half-precision bits to float
+     */
+    fun halfToFloat(bits: Int): Float {
+        val sign = (bits and 0x8000) shl 16
+        val exponent = (bits shr 10) and 0x1F
+        val mantissa = bits and 0x3FF
+        val floatBits = when {
+            exponent == 0x1F -> sign or 0x7F800000 or (mantissa shl 13)
+            exponent != 0 -> sign or ((exponent + 112) shl 23) or (mantissa shl 13)
+            mantissa == 0 -> sign
+            else -> {
+                // Subnormal half: normalise into a float exponent
+                var e = 113
+                var m = mantissa
+                while (m and 0x400 == 0) {
+                    m = m shl 1
+                    e--
+                }
+                sign or (e shl 23) or ((m and 0x3FF) shl 13)
+            }
+        }
+        return java.lang.Float.intBitsToFloat(floatBits)
+    }
+}
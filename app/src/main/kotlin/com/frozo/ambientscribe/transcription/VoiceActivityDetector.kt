@@ -0,0 +1,184 @@
+package com.frozo.ambientscribe.transcription
+
+import timber.log.Timber
+import kotlin.math.sqrt
+
+/**
+ * Frame-level voice activity detector backed by the native Whisper library.
+ * Splits PCM into short frames, classifies each by energy over an adaptive
+ * noise floor and spectral flatness, and keeps only speech frames (plus a
+ * hangover) so silence never reaches the ASR buffer. The features the
+ * detector computes for each frame are returned with the gate result, so
+ * later stages (energy metering, diarization) never rescan the samples.
+ */
+class VoiceActivityDetector(
+    private val sampleRate: Int = 16000,
+    private val frameMs: Int = 30,
+    private val hangoverFrames: Int = 8
+) {
+    companion object {
+        // Layout of one frame in FrameFeatures.values; matches FrameFeatures in
+        // voice_activity_detector.h
+        const val FEATURE_ENERGY_DB = 0
+        const val FEATURE_RMS = 1
+        const val FEATURE_ZERO_CROSSING_RATE = 2
+        const val FEATURE_PITCH_HZ = 3
+        const val FEATURE_VOICING = 4
+        const val FEATURE_SPECTRAL_CENTROID_HZ = 5
+        const val FEATURE_SPECTRAL_FLATNESS = 6
+        const val FEATURE_BAND_ENERGY_DB = 7
+        const val FEATURE_BANDS = 6
+        const val FEATURE_STRIDE = FEATURE_BAND_ENERGY_DB + FEATURE_BANDS
+
+        init {
+            try {
+                System.loadLibrary("whisper_android")
+            } catch (e: UnsatisfiedLinkError) {
+                Timber.e(e, "Failed to load Whisper native library for VAD")
+            }
+        }
+    }
+
+    private var nativeHandle: Long = 0L
+    private var speechBuffer = ShortArray(0)
+    private var featureBuffer = FloatArray(0)
+    private val frameSamples = sampleRate * frameMs / 1000
+
+    /**
+     * Features of the frames completed by one call to [process],
+     * [FEATURE_STRIDE] floats per frame. [values] is reused between calls;
+     * only the first [frameCount] frames are valid.
+     */
+    class FrameFeatures(
+        val values: FloatArray,
+        val frameCount: Int
+    ) {
+        fun get(frame: Int, feature: Int): Float = values[frame * FEATURE_STRIDE + feature]
+
+        /**
+         * RMS over all frames, normalised to [0, 1]
+         */
+        fun rms(): Float {
+            if (frameCount == 0) return 0f
+            var sum = 0.0
+            for (frame in 0 until frameCount) {
+                val rms = get(frame, FEATURE_RMS)
+                sum += rms * rms
+            }
+            return sqrt(sum / frameCount).toFloat()
+        }
+
+        /**
+         * Mean pitch of the voiced frames, 0 when none were voiced
+         */
+        fun meanPitchHz(): Float {
+            var sum = 0f
+            var voiced = 0
+            for (frame in 0 until frameCount) {
+                val pitch = get(frame, FEATURE_PITCH_HZ)
+                if (pitch > 0f) {
+                    sum += pitch
+                    voiced++
+                }
+            }
+            return if (voiced > 0) sum / voiced else 0f
+        }
+
+        companion object {
+            val EMPTY = FrameFeatures(FloatArray(0), 0)
+        }
+    }
+
+    /**
+     * Speech samples kept from one call to [process]. [samples] is reused
+     * between calls; only the first [sampleCount] entries are valid.
+     * [features] is empty when the native detector is unavailable.
+     */
+    class GateResult(
+        val samples: ShortArray,
+        val sampleCount: Int,
+        val isSpeech: Boolean,
+        val features: FrameFeatures = FrameFeatures.EMPTY
+    )
+
+    /**
+     * Create the native detector. Returns false if the native library is unavailable.
+     */
+    fun initialize(): Boolean {
+        if (nativeHandle != 0L) {
+            return true
+        }
+
+        nativeHandle = try {
+            nativeCreate(sampleRate, frameMs, hangoverFrames)
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.w(e, "Native VAD unavailable")
+            0L
+        }
+
+        return nativeHandle != 0L
+    }
+
+    fun isInitialized(): Boolean = nativeHandle != 0L
+
+    /**
+     * Gate samples through the detector. Without a native detector every
+     * sample is passed through unchanged.
+     */
+    fun process(samples: ShortArray): GateResult {
+        if (nativeHandle == 0L) {
+            return GateResult(samples, samples.size, isSpeech = true)
+        }
+
+        val required = samples.size + frameSamples
+        if (speechBuffer.size < required) {
+            speechBuffer = ShortArray(required)
+            featureBuffer = FloatArray((required / frameSamples + 1) * FEATURE_STRIDE)
+        }
+
+        val kept = nativeGate(nativeHandle, samples, samples.size, speechBuffer)
+        if (kept < 0) {
+            Timber.w("Native VAD rejected input, passing audio through")
+            return GateResult(samples, samples.size, isSpeech = true)
+        }
+
+        val frames = nativeGetFrameFeatures(nativeHandle, featureBuffer)
+        val features = if (frames > 0) FrameFeatures(featureBuffer, frames) else FrameFeatures.EMPTY
+
+        return GateResult(speechBuffer, kept, nativeIsSpeech(nativeHandle), features)
+    }
+
+    /**
+     * Total and speech frame counts since the last reset
+     */
+    fun getFrameCounts(): Pair<Long, Long> {
+        if (nativeHandle == 0L) {
+            return 0L to 0L
+        }
+        val counts = nativeGetFrameCounts(nativeHandle) ?: return 0L to 0L
+        return counts[0] to counts[1]
+    }
+
+    fun reset() {
+        if (nativeHandle != 0L) {
+            nativeReset(nativeHandle)
+        }
+    }
+
+    fun release() {
+        if (nativeHandle != 0L) {
+            nativeRelease(nativeHandle)
+            nativeHandle = 0L
+        }
+        speechBuffer = ShortArray(0)
+        featureBuffer = FloatArray(0)
+    }
+
+    private external fun nativeCreate(sampleRate: Int, frameMs: Int, hangoverFrames: Int): Long
+    private external fun nativeGate(handle: Long, pcmData: ShortArray, length: Int, speechOut: ShortArray): Int
+    private external fun nativeIsSpeech(handle: Long): Boolean
+    private external fun nativeGetFrameFeatures(handle: Long, featuresOut: FloatArray): Int
+    private external fun nativeGetFrameCounts(handle: Long): LongArray?
+    private external fun nativeReset(handle: Long)
+    private external fun nativeRelease(handle: Long)
+}
@@ -17,54 +17,6 @@ import kotlin.test.assertTrue
 @RunWith(MockitoJUnitRunner::class)
 class AudioFormatTest {
 
-    @Test
-    fun `AudioResampler should correctly resample audio data`() {
-        // Create resampler for 48kHz to 16kHz
-        val resampler = AudioResampler(48000, 16000)
-        
-        // Create test data (1 second of 48kHz audio)
-        val inputData = ShortArray(48000) { 
-            // Simple sine wave
-            ((Short.MAX_VALUE * kotlin.math.sin(it * 2 * kotlin.math.PI / 48.0)).toInt()).toShort()
-        }
-        
-        // Resample to 16kHz
-        val outputData = resampler.resample(inputData)
-        
-        // Output should be ~1/3 the size of input
-        assertEquals(16000, outputData.size)
-        
-        // Check resampling stats
-        val stats = resampler.getStats()
-        assertEquals(48000, stats["input_sample_rate"])
-        assertEquals(16000, stats["output_sample_rate"])
-        assertEquals(48000L, stats["total_input_samples"])
-        assertEquals(16000L, stats["total_output_samples"])
-        assertEquals(0, stats["underruns"])
-        assertEquals(0, stats["overruns"])
-    }
-    
-    @Test
-    fun `AudioResampler should handle edge cases`() {
-        // Create resampler
-        val resampler = AudioResampler(44100, 16000)
-        
-        // Empty input
-        val emptyInput = ShortArray(0)
-        val emptyOutput = resampler.resample(emptyInput)
-        assertEquals(0, emptyOutput.size)
-        
-        // Single sample input
-        val singleInput = shortArrayOf(16000)
-        val singleOutput = resampler.resample(singleInput)
-        assertTrue(singleOutput.size > 0)
-        
-        // Reset stats
-        resampler.resetStats()
-        val stats = resampler.getStats()
-        assertEquals(0L, stats["total_input_samples"])
-    }
-    
     @Test
     fun `AudioFormatProbe should prefer 16kHz when available`() = runTest {
         // Mock AudioRecord.getMinBufferSize to simulate 16kHz support
@@ -166,6 +166,56 @@ class SpeakerDiarizationTest {
         assertEquals(SpeakerDiarization.SPEAKER_PATIENT, diarization.getCurrentSpeaker())
     }
 
+    @Test
+    fun `should detect speaker change based on pitch at equal energy`() {
+        val timestamp = System.currentTimeMillis()
+        val doctorAudio = createAudioData(
+            isVoiceActive = true,
+            energy = 0.5f,
+            timestamp = timestamp,
+            pitchHz = 120f
+        )
+        
+        repeat(10) {
+            diarization.processAudioData(doctorAudio.copy(timestamp = timestamp + it * 100))
+        }
+        
+        assertEquals(SpeakerDiarization.SPEAKER_DOCTOR, diarization.getCurrentSpeaker())
+        
+        val silenceAudio = createAudioData(
+            isVoiceActive = false,
+            energy = 0.01f,
+            timestamp = timestamp + 1500
+        )
+        repeat(5) {
+            diarization.processAudioData(silenceAudio.copy(timestamp = timestamp + 1500 + it * 100))
+        }
+        
+        // Same loudness, clearly higher voice
+        val patientAudio = createAudioData(
+            isVoiceActive = true,
+            energy = 0.5f,
+            timestamp = timestamp + 2000,
+            pitchHz = 220f
+        )
+        repeat(10) {
+            diarization.processAudioData(patientAudio.copy(timestamp = timestamp + 2000 + it * 100))
+        }
+        
+        assertEquals(SpeakerDiarization.SPEAKER_PATIENT, diarization.getCurrentSpeaker())
+    }
+
+    @Test
+    fun `pitch similarity should favour the closer profile`() {
+        val low = SpeakerDiarization.SpeakerEnergyProfile().update(0.5f, 120f)
+        val high = SpeakerDiarization.SpeakerEnergyProfile().update(0.5f, 220f)
+        
+        assertTrue(low.similarity(0.5f, 125f) > high.similarity(0.5f, 125f))
+        assertTrue(high.similarity(0.5f, 210f) > low.similarity(0.5f, 210f))
+        // Without pitch the profiles are indistinguishable
+        assertEquals(low.similarity(0.5f), high.similarity(0.5f))
+    }
+
     @Test
     fun `should maintain speaker identity during continuous speech`() {
         // Establish doctor profile
@@ -364,12 +414,14 @@ class SpeakerDiarizationTest {
     private fun createAudioData(
         isVoiceActive: Boolean,
         energy: Float,
-        timestamp: Long
+        timestamp: Long,
+        pitchHz: Float = 0f
     ): SpeakerDiarization.AudioData {
         return SpeakerDiarization.AudioData(
             timestamp = timestamp,
             energyLevel = energy,
-            isVoiceActive = isVoiceActive
+            isVoiceActive = isVoiceActive,
+            pitchHz = pitchHz
         )
     }
     
@@ -0,0 +1,39 @@
+package com.frozo.ambientscribe.performance
+
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class KernelDispatchTest {
+
+    @Test
+    fun `fromNative should parse feature bits and kernel variants`() {
+        val features = KernelDispatch.NEON or KernelDispatch.DOTPROD or KernelDispatch.FP16
+        val dispatch = KernelDispatch.fromNative(features, arrayOf("neon", "dotprod"))!!
+
+        assertEquals(KernelDispatch(features, "neon", "dotprod"), dispatch)
+        assertTrue(dispatch.has(KernelDispatch.DOTPROD))
+        assertFalse(dispatch.has(KernelDispatch.I8MM))
+        assertFalse(dispatch.has(KernelDispatch.DOTPROD or KernelDispatch.I8MM))
+    }
+
+    @Test
+    fun `instruction sets should keep the performance state keys`() {
+        val dispatch = KernelDispatch(KernelDispatch.NEON or KernelDispatch.DOTPROD, "neon", "dotprod")
+        val instructionSets = dispatch.instructionSets
+
+        assertTrue(instructionSets.keys.containsAll(PerformanceManager.PerformanceState().instructionSets.keys))
+        assertEquals(true, instructionSets["NEON"])
+        assertEquals(true, instructionSets["SDOT"])
+        assertEquals(false, instructionSets["FP16"])
+        assertEquals(false, instructionSets["I8MM"])
+    }
+
+    @Test
+    fun `fromNative should reject a missing report`() {
+        assertNull(KernelDispatch.fromNative(0, null))
+        assertNull(KernelDispatch.fromNative(0, arrayOf("neon")))
+    }
+}
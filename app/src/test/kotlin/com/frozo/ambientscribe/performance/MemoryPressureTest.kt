@@ -0,0 +1,69 @@
+package com.frozo.ambientscribe.performance
+
+import android.content.ComponentCallbacks2
+import android.content.Context
+import io.mockk.mockk
+import kotlinx.coroutines.test.runTest
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.robolectric.RobolectricTestRunner
+import org.robolectric.RuntimeEnvironment
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+/**
+ * Unit tests for trim-level mapping and native trimming in MemoryManager
+ */
+@RunWith(RobolectricTestRunner::class)
+class MemoryPressureTest {
+
+    private class RecordingTrimmer(private val bytes: Long) : NativeMemoryTrimmer {
+        val calls = mutableListOf<MemoryPressure>()
+
+        override fun trimMemory(pressure: MemoryPressure): Long {
+            calls.add(pressure)
+            return bytes
+        }
+    }
+
+    @Suppress("DEPRECATION")
+    @Test
+    fun `fromTrimLevel should map foreground and cached levels by severity`() {
+        assertEquals(MemoryPressure.MODERATE, MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE))
+        assertEquals(MemoryPressure.HIGH, MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW))
+        assertEquals(MemoryPressure.CRITICAL, MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL))
+        assertNull(MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN))
+        assertEquals(MemoryPressure.MODERATE, MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_BACKGROUND))
+        assertEquals(MemoryPressure.HIGH, MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_MODERATE))
+        assertEquals(MemoryPressure.CRITICAL, MemoryPressure.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_COMPLETE))
+        assertNull(MemoryPressure.fromTrimLevel(0))
+    }
+
+    @Test
+    fun `onTrimMemory should trim every registered model and sum reclaimed bytes`() = runTest {
+        val context: Context = RuntimeEnvironment.getApplication()
+        val memoryManager = MemoryManager(context, mockk(relaxed = true))
+        val llm = RecordingTrimmer(48L shl 20)
+        val asr = RecordingTrimmer(1L shl 20)
+        memoryManager.registerTrimmer(llm)
+        memoryManager.registerTrimmer(asr)
+        memoryManager.registerTrimmer(asr)
+
+        val reclaimed = memoryManager.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW)
+
+        assertEquals(49L shl 20, reclaimed)
+        assertEquals(listOf(MemoryPressure.HIGH), llm.calls)
+        assertEquals(listOf(MemoryPressure.HIGH), asr.calls)
+    }
+
+    @Test
+    fun `onTrimMemory should skip levels without native trimming`() = runTest {
+        val context: Context = RuntimeEnvironment.getApplication()
+        val memoryManager = MemoryManager(context, mockk(relaxed = true))
+        val llm = RecordingTrimmer(1024)
+        memoryManager.registerTrimmer(llm)
+
+        assertEquals(0L, memoryManager.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN))
+        assertEquals(emptyList(), llm.calls)
+    }
+}
@@ -0,0 +1,62 @@
+package com.frozo.ambientscribe.performance
+
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+/**
+ * Unit tests for ModelVariantSelector
+ */
+class ModelVariantSelectorTest {
+
+    private val selector = ModelVariantSelector()
+
+    private val q4 = variant("llama_q4.bin", 4.5f, footprintMB = 700, tokensPerSecond = 30f)
+    private val q5 = variant("llama_q5.bin", 5.5f, footprintMB = 850, tokensPerSecond = 24f)
+    private val q8 = variant("llama_q8.bin", 8.5f, footprintMB = 1250, tokensPerSecond = 16f)
+    private val variants = listOf(q8, q5, q4)
+
+    private fun variant(path: String, bits: Float, footprintMB: Long, tokensPerSecond: Float) =
+        ModelVariantSelector.ModelVariant(
+            path = path,
+            bitsPerWeight = bits,
+            weightBytes = (footprintMB - 50) * MB,
+            footprintBytes = footprintMB * MB,
+            expectedTokensPerSecond = tokensPerSecond
+        )
+
+    @Test
+    fun `select should prefer the most precise variant that fits and is fast enough`() {
+        assertEquals(q8, selector.select(variants, 2048 * MB, minTokensPerSecond = 10f))
+        assertEquals(q5, selector.select(variants, 1024 * MB, minTokensPerSecond = 10f))
+        assertEquals(q5, selector.select(variants, 2048 * MB, minTokensPerSecond = 20f))
+    }
+
+    @Test
+    fun `select should fall back to the fastest fitting variant when none is fast enough`() {
+        assertEquals(q4, selector.select(variants, 2048 * MB, minTokensPerSecond = 100f))
+    }
+
+    @Test
+    fun `select should return the smallest variant when none fits the budget`() {
+        assertEquals(q4, selector.select(variants, 100 * MB, minTokensPerSecond = 10f))
+        assertNull(selector.select(emptyList(), 100 * MB, minTokensPerSecond = 10f))
+    }
+
+    @Test
+    fun `fromNative should drop variants that are not on disk`() {
+        val values = doubleArrayOf(
+            8.5, 0.0, 0.0, 0.0,
+            4.5, 650.0 * MB, 700.0 * MB, 30.0
+        )
+
+        val parsed = ModelVariantSelector.fromNative(listOf("llama_q8.bin", "llama_q4.bin"), values)
+
+        assertEquals(listOf(q4), parsed)
+        assertEquals(emptyList(), ModelVariantSelector.fromNative(listOf("llama_q4.bin"), values))
+    }
+
+    private companion object {
+        const val MB = 1024L * 1024L
+    }
+}
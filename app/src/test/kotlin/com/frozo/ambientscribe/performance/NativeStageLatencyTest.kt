@@ -0,0 +1,30 @@
+package com.frozo.ambientscribe.performance
+
+import org.junit.Test
+import kotlin.test.assertEquals
+
+/**
+ * Unit tests for NativeStageLatency
+ */
+class NativeStageLatencyTest {
+
+    @Test
+    fun `fromNative should parse every stage with samples`() {
+        val values = LongArray(NativeStageLatency.STAGES.size * 6)
+        // encode: 4 samples, 400 us total, max 160, p50 100, p90 150, p99 160
+        longArrayOf(4, 400, 160, 100, 150, 160).copyInto(values, destinationOffset = 2 * 6)
+
+        val stages = NativeStageLatency.fromNative(values)
+
+        assertEquals(
+            listOf(NativeStageLatency("encode", 4, 100, 100, 150, 160, 160)),
+            stages
+        )
+    }
+
+    @Test
+    fun `fromNative should tolerate missing or short snapshots`() {
+        assertEquals(emptyList(), NativeStageLatency.fromNative(null))
+        assertEquals(emptyList(), NativeStageLatency.fromNative(longArrayOf(1, 2, 3)))
+    }
+}
@@ -0,0 +1,46 @@
+package com.frozo.ambientscribe.performance
+
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class OffloadSettingsTest {
+
+    @Test
+    fun `forTier should offload fewer layers on lower tiers`() {
+        assertEquals(
+            OffloadSettings(OffloadBackend.AUTO, 22),
+            OffloadSettings.forTier(DeviceCapabilityDetector.DeviceTier.TIER_A, 22)
+        )
+        assertEquals(
+            OffloadSettings(OffloadBackend.AUTO, 11),
+            OffloadSettings.forTier(DeviceCapabilityDetector.DeviceTier.TIER_B, 22)
+        )
+        assertEquals(
+            OffloadSettings(OffloadBackend.CPU, 0),
+            OffloadSettings.forTier(DeviceCapabilityDetector.DeviceTier.TIER_C, 22)
+        )
+    }
+
+    @Test
+    fun `fromMask should list only accelerator delegates`() {
+        val mask = (1 shl 0) or (1 shl 1) or (1 shl 3)
+
+        assertEquals(setOf(OffloadBackend.VULKAN, OffloadBackend.QNN), OffloadBackend.fromMask(mask))
+        assertEquals(emptySet(), OffloadBackend.fromMask(0))
+    }
+
+    @Test
+    fun `stats fromNative should parse counters`() {
+        val stats = OffloadStats.fromNative(longArrayOf(0, 0, 3, 12, 1))!!
+
+        assertEquals(OffloadStats(OffloadBackend.CPU, 0, 3, 12, 1), stats)
+    }
+
+    @Test
+    fun `stats fromNative should reject a short or unknown report`() {
+        assertNull(OffloadStats.fromNative(null))
+        assertNull(OffloadStats.fromNative(longArrayOf(1, 4, 0)))
+        assertNull(OffloadStats.fromNative(longArrayOf(9, 4, 0, 0, 0)))
+    }
+}
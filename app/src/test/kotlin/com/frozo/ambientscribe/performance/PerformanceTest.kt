@@ -76,6 +76,49 @@ class PerformanceTest {
         assertTrue(supportsNeon)
     }
 
+    @Test
+    fun `reportLlmSchedulerStats should publish queue load in performance state`() {
+        performanceManager.initialize()
+
+        performanceManager.reportLlmSchedulerStats(
+            PerformanceManager.LlmSchedulerStats(
+                queueDepth = 2,
+                activeSequences = 3,
+                completedRequests = 10,
+                averageQueueWaitMs = 120,
+                maxQueueWaitMs = 400
+            )
+        )
+
+        val state = performanceManager.getCurrentPerformanceState()
+        assertEquals(2, state.llmQueueDepth)
+        assertEquals(3, state.llmActiveSequences)
+        assertEquals(120L, state.llmAverageQueueWaitMs)
+    }
+
+    @Test
+    fun `reportLlmSchedulerStats should publish speculative decoding gain`() {
+        performanceManager.initialize()
+
+        performanceManager.reportLlmSchedulerStats(
+            PerformanceManager.LlmSchedulerStats(
+                queueDepth = 0,
+                activeSequences = 1,
+                completedRequests = 1,
+                averageQueueWaitMs = 0,
+                maxQueueWaitMs = 0,
+                generatedTokens = 300,
+                decodeSteps = 100,
+                draftedTokens = 400,
+                acceptedDraftTokens = 300
+            )
+        )
+
+        val state = performanceManager.getCurrentPerformanceState()
+        assertEquals(3f, state.llmTokensPerDecodeStep)
+        assertEquals(0.75f, state.llmDraftAcceptanceRate)
+    }
+
     @Test
     fun `cleanup should release resources`() {
         performanceManager.initialize()
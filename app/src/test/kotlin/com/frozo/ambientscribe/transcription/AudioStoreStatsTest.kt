@@ -0,0 +1,17 @@
+package com.frozo.ambientscribe.transcription
+
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class AudioStoreStatsTest {
+
+    @Test
+    fun `fromNative should parse the native counters in order`() {
+        val stats = AudioStoreStats.fromNative(longArrayOf(480_000, 16_000, 8L shl 20, 96_000, 10))!!
+
+        assertEquals(AudioStoreStats(480_000, 16_000, 8L shl 20, 96_000, 10), stats)
+        assertNull(AudioStoreStats.fromNative(null))
+        assertNull(AudioStoreStats.fromNative(longArrayOf(1, 2, 3)))
+    }
+}
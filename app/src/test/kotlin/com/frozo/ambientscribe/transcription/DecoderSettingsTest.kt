@@ -0,0 +1,45 @@
+package com.frozo.ambientscribe.transcription
+
+import com.frozo.ambientscribe.performance.DeviceCapabilityDetector.DeviceTier
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class DecoderSettingsTest {
+
+    @Test
+    fun `every tier should decode adaptively with early exit`() {
+        for (tier in DeviceTier.values()) {
+            val settings = DecoderSettings.forTier(tier)
+            assertEquals(DecodeMode.ADAPTIVE, settings.mode)
+            assertTrue(settings.earlyExit)
+        }
+    }
+
+    @Test
+    fun `slower tiers should widen the beam later and less`() {
+        val a = DecoderSettings.forTier(DeviceTier.TIER_A)
+        val b = DecoderSettings.forTier(DeviceTier.TIER_B)
+        val c = DecoderSettings.forTier(DeviceTier.TIER_C)
+
+        assertTrue(a.beamSize > b.beamSize && b.beamSize > c.beamSize)
+        assertTrue(a.widenLogProb > b.widenLogProb && b.widenLogProb > c.widenLogProb)
+        assertTrue(a.widenEntropy < b.widenEntropy && b.widenEntropy < c.widenEntropy)
+    }
+
+    @Test
+    fun `mode values should match the native decoder`() {
+        assertEquals(listOf(0, 1, 2), DecodeMode.values().map { it.nativeValue })
+    }
+
+    @Test
+    fun `decode stats should parse native counters`() {
+        val stats = DecodeStats.fromNative(longArrayOf(10, 200, 30, 290, 4, 60))!!
+
+        assertEquals(DecodeStats(10, 200, 30, 290, 4, 60), stats)
+        assertEquals(1.45f, stats.hypothesesPerToken)
+        assertNull(DecodeStats.fromNative(null))
+        assertNull(DecodeStats.fromNative(longArrayOf(1, 2)))
+    }
+}
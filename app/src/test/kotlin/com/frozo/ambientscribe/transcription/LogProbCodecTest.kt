@@ -0,0 +1,66 @@
+package com.frozo.ambientscribe.transcription
+
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class LogProbCodecTest {
+
+    @Test
+    fun `half precision values should decode exactly`() {
+        assertEquals(0f, LogProbCodec.halfToFloat(0x0000))
+        assertEquals(1f, LogProbCodec.halfToFloat(0x3C00))
+        assertEquals(-2.5f, LogProbCodec.halfToFloat(0xC100))
+        assertEquals(65504f, LogProbCodec.halfToFloat(0x7BFF))
+        // Smallest subnormal, 2^-24
+        assertEquals(5.9604645e-8f, LogProbCodec.halfToFloat(0x0001))
+        assertEquals(Float.NEGATIVE_INFINITY, LogProbCodec.halfToFloat(0xFC00))
+        assertTrue(LogProbCodec.halfToFloat(0x7E00).isNaN())
+    }
+
+    @Test
+    fun `float16 payload should decode in native byte order`() {
+        val buffer = ByteBuffer.allocate(6).order(ByteOrder.nativeOrder())
+        buffer.putShort(0xB266.toShort()) // -0.2
+        buffer.putShort(0xBC00.toShort()) // -1.0
+        buffer.putShort(0x0000.toShort())
+
+        val values = LogProbCodec.decode(buffer.array(), LogProbFormat.FLOAT16, 1f)
+
+        assertEquals(3, values.size)
+        assertEquals(-0.2f, values[0], 0.001f)
+        assertEquals(-1f, values[1])
+        assertEquals(0f, values[2])
+    }
+
+    @Test
+    fun `int8 payload should dequantise with the native scale`() {
+        val scale = 5f / 127f
+        val packed = byteArrayOf(-127, -51, 0)
+
+        val values = LogProbCodec.decode(packed, LogProbFormat.INT8, scale)
+
+        assertEquals(-5f, values[0], 0.001f)
+        assertEquals(-2.008f, values[1], 0.001f)
+        assertEquals(0f, values[2])
+    }
+
+    @Test
+    fun `float32 payload should round trip`() {
+        val buffer = ByteBuffer.allocate(8).order(ByteOrder.nativeOrder())
+        buffer.putFloat(-0.15f)
+        buffer.putFloat(-3.25f)
+
+        val values = LogProbCodec.decode(buffer.array(), LogProbFormat.FLOAT32, 1f)
+
+        assertEquals(listOf(-0.15f, -3.25f), values.toList())
+    }
+
+    @Test
+    fun `unknown native format should map to none`() {
+        assertEquals(LogProbFormat.NONE, LogProbFormat.fromNative(42))
+        assertEquals(LogProbFormat.INT8, LogProbFormat.fromNative(3))
+    }
+}
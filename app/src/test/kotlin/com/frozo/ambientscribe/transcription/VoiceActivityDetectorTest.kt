@@ -0,0 +1,82 @@
+package com.frozo.ambientscribe.transcription
+
+import org.junit.After
+import org.junit.Before
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertSame
+import kotlin.test.assertTrue
+
+/**
+ * JVM tests run without the native library, so these cover the pass-through
+ * fallback the pipeline relies on when the native VAD cannot be created.
+ */
+class VoiceActivityDetectorTest {
+
+    private lateinit var detector: VoiceActivityDetector
+
+    @Before
+    fun setUp() {
+        detector = VoiceActivityDetector()
+    }
+
+    @After
+    fun tearDown() {
+        detector.release()
+    }
+
+    @Test
+    fun `initialize should report failure without native library`() {
+        assertFalse(detector.initialize())
+        assertFalse(detector.isInitialized())
+    }
+
+    @Test
+    fun `process should pass all samples through when native VAD is unavailable`() {
+        detector.initialize()
+        val samples = ShortArray(1600) { (it % 128).toShort() }
+
+        val result = detector.process(samples)
+
+        assertSame(samples, result.samples)
+        assertEquals(samples.size, result.sampleCount)
+        assertTrue(result.isSpeech)
+    }
+
+    @Test
+    fun `frame features should be empty when native VAD is unavailable`() {
+        detector.initialize()
+
+        val features = detector.process(ShortArray(1600)).features
+
+        assertEquals(0, features.frameCount)
+        assertEquals(0f, features.rms())
+        assertEquals(0f, features.meanPitchHz())
+    }
+
+    @Test
+    fun `frame features should summarise rms and voiced pitch`() {
+        val stride = VoiceActivityDetector.FEATURE_STRIDE
+        val values = FloatArray(stride * 3)
+        values[VoiceActivityDetector.FEATURE_RMS] = 0.3f
+        values[VoiceActivityDetector.FEATURE_PITCH_HZ] = 100f
+        values[stride + VoiceActivityDetector.FEATURE_RMS] = 0.4f
+        values[stride + VoiceActivityDetector.FEATURE_PITCH_HZ] = 0f
+        values[2 * stride + VoiceActivityDetector.FEATURE_RMS] = 0.5f
+        values[2 * stride + VoiceActivityDetector.FEATURE_PITCH_HZ] = 140f
+
+        val features = VoiceActivityDetector.FrameFeatures(values, 3)
+
+        assertEquals(0.4082f, features.rms(), 0.001f)
+        assertEquals(120f, features.meanPitchHz(), 0.001f)
+    }
+
+    @Test
+    fun `frame counts should be zero when native VAD is unavailable`() {
+        detector.initialize()
+        detector.process(ShortArray(480))
+
+        assertEquals(0L to 0L, detector.getFrameCounts())
+    }
+}
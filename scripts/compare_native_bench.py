@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Native Benchmark Comparator - Diffs two native_bench JSON runs
+
+Usage: compare_native_bench.py BASELINE.json CONTENDER.json [--threshold 0.10]
+
+Prints the relative change of every benchmark present in both runs and exits
+with status 1 when any benchmark got slower than the threshold allows.
+"""
+
+import argparse
+import json
+import sys
+from typing import Dict, Any
+
+
+def load_benchmarks(path: str) -> Dict[str, Dict[str, Any]]:
+    """Benchmarks of one run by name, skipping runs that reported an error"""
+    with open(path) as f:
+        report = json.load(f)
+    return {
+        b["name"]: b
+        for b in report.get("benchmarks", [])
+        if b.get("run_type", "iteration") == "iteration" and not b.get("error_occurred")
+    }
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare two native_bench JSON runs")
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="Largest tolerated slowdown as a fraction (default 0.10)")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="real_time")
+    args = parser.parse_args()
+
+    baseline = load_benchmarks(args.baseline)
+    contender = load_benchmarks(args.contender)
+
+    regressions = []
+    print(f"{'Benchmark':<40} {'Baseline':>14} {'Contender':>14} {'Change':>9}")
+    print("-" * 80)
+    for name, base in baseline.items():
+        other = contender.get(name)
+        if other is None:
+            print(f"{name:<40} {'missing in contender':>39}")
+            continue
+        before = base[args.metric]
+        after = other[args.metric]
+        change = (after - before) / before if before > 0 else 0.0
+        marker = ""
+        if change > args.threshold:
+            regressions.append(name)
+            marker = "  REGRESSION"
+        unit = base.get("time_unit", "ns")
+        print(f"{name:<40} {before:>11.0f} {unit} {after:>11.0f} {unit} {change:>+8.1%}{marker}")
+
+    for name in contender.keys() - baseline.keys():
+        print(f"{name:<40} {'new in contender':>39}")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) slower than {args.threshold:.0%}: {', '.join(regressions)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())